@@ -3,9 +3,16 @@
 #include "global.h"
 #include "engine.h"
 #include "positionman.h"
+#include "position.h"
+#include "trafficreplay.h"
 
 #include <QTimer>
 #include <QThread>
+#include <QSet>
+#include <QUrl>
+#include <QStringList>
+
+#include <limits>
 
 BaseREST::BaseREST( Engine *_engine )
     : QObject( nullptr ),
@@ -13,9 +20,18 @@ BaseREST::BaseREST( Engine *_engine )
 {
     kDebug() << "[BaseREST]";
 
-    // we use this to send the requests at a predictable rate
+    // connection policy, the hosts are added when the exchange is initialized
+    session = new ExchangeSession( this );
+
+    // decodes large replies off the main thread
+    reply_parser = new ReplyParser( this );
+    connect( reply_parser, &ReplyParser::replyParsed, this, &BaseREST::onReplyParsed );
+
+    // this timer is armed whenever a request can be sent, or at send_idle_interval for polling
     send_timer = new QTimer( this );
-    send_timer->setTimerType( Qt::CoarseTimer );
+    send_timer->setSingleShot( true );
+    send_timer->setTimerType( Qt::PreciseTimer );
+    connect( send_timer, &QTimer::timeout, this, &BaseREST::onSendTimer );
 
     // this timer checks for nam requests that have been queued too long
     timeout_timer = new QTimer( this );
@@ -30,6 +46,12 @@ BaseREST::BaseREST( Engine *_engine )
     diverge_converge_timer->setTimerType( Qt::VeryCoarseTimer );
     diverge_converge_timer->start( 100000 );
 
+    // this timer prints a latency summary and ages out old samples
+    latency_timer = new QTimer( this );
+    connect( latency_timer, &QTimer::timeout, this, &BaseREST::onLogLatency );
+    latency_timer->setTimerType( Qt::VeryCoarseTimer );
+    latency_timer->start( LATENCY_TIMER_INTERVAL_LOG );
+
     // this timer reads the lo_sell and hi_buy prices for all coins
     ticker_timer = new QTimer( this );
     ticker_timer->setTimerType( Qt::VeryCoarseTimer );
@@ -45,12 +67,23 @@ BaseREST::~BaseREST()
     keystore.clear();
     request_nonce = 0;
 
+    stopCapture();
+
+    // stop a running replay, it prints its report on the way out
+    delete replay;
+    replay = nullptr;
+
+    // wait for the parser, anything it was working on is dropped
+    delete reply_parser;
+    reply_parser = nullptr;
+
     // stop timers
     send_timer->stop();
     orderbook_timer->stop();
     timeout_timer->stop();
     diverge_converge_timer->stop();
     ticker_timer->stop();
+    latency_timer->stop();
 
     // clear network replies
     for ( QHash<QNetworkReply*,Request*>::const_iterator i = nam_queue_sent.begin(); i != nam_queue_sent.end(); i++ )
@@ -62,19 +95,23 @@ BaseREST::~BaseREST()
 
     // delete nam queues
     while ( !nam_queue.isEmpty() )
-        delete nam_queue.takeFirst();
+        delete nam_queue.takeAny();
 
+    delete session;
     delete send_timer;
     delete orderbook_timer;
     delete timeout_timer;
     delete diverge_converge_timer;
     delete ticker_timer;
+    delete latency_timer;
 
+    session = nullptr;
     send_timer = nullptr;
     orderbook_timer = nullptr;
     timeout_timer = nullptr;
     diverge_converge_timer = nullptr;
     ticker_timer = nullptr;
+    latency_timer = nullptr;
 
     engine = nullptr;
 
@@ -93,7 +130,7 @@ bool BaseREST::yieldToFlowControlSent() const
 
 bool BaseREST::isTickerStale() const
 {
-    return ticker_update_time < QDateTime::currentMSecsSinceEpoch() - 60000;
+    return ticker_update_time < QDateTime::currentMSecsSinceEpoch() - TICKER_STALE_MS;
 }
 
 void BaseREST::sendRequest( QString api_command, QString body, Position *pos, quint16 weight )
@@ -102,10 +139,79 @@ void BaseREST::sendRequest( QString api_command, QString body, Position *pos, qu
     delayed_request->api_command = api_command;
     delayed_request->body = body;
     delayed_request->pos = pos;
+
+    if ( pos != nullptr )
+        delayed_request->pos_handle = pos->handle;
     delayed_request->weight = weight;
+    delayed_request->time_queued_ms = QDateTime::currentMSecsSinceEpoch();
+
+    // add to packet queue
+    nam_queue.push( delayed_request, getRateClass( delayed_request ), getRequestPriority( delayed_request ) );
+
+    // try to send it right away
+    scheduleSend();
+}
+
+bool BaseREST::takeRateTokens( Request *const &request )
+{
+    const RateClass rate_class = getRateClass( request );
+
+    // wait for a reply in this class before spending tokens on another one
+    if ( !session->canSend( rate_class ) )
+        return false;
+
+    return rate_limiter.tryTake( rate_class, qMax<quint16>( request->weight, 1 ), QDateTime::currentMSecsSinceEpoch() );
+}
+
+bool BaseREST::dropStaleRequest( Request *const &request )
+{
+    if ( request->pos == nullptr || engine->getPositionMan()->isValid( request->pos_handle ) )
+        return false;
+
+    kDebug() << getExchangeFancyStr() << "local warning: caught nam request with invalid position";
+
+    // it was never sent, nothing else references it
+    nam_queue.removeOne( request );
+    delete request;
+
+    return true;
+}
+
+qint64 BaseREST::msUntilNextSend()
+{
+    const qint64 current_time = QDateTime::currentMSecsSinceEpoch();
+    qint64 ret = std::numeric_limits<qint64>::max();
+
+    // only the head of each class can be sent next
+    for ( int i = 0; i < RATE_CLASS_COUNT; i++ )
+    {
+        const RateClass rate_class = RateClass( i );
+        Request *const request = nam_queue.top( rate_class );
+
+        // classes at their in-flight limit are woken up by deleteReply()
+        if ( request == nullptr || !session->canSend( rate_class ) )
+            continue;
+
+        ret = qMin( ret, rate_limiter.msUntilAvailable( rate_class, qMax<quint16>( request->weight, 1 ), current_time ) );
+
+        if ( ret == 0 )
+            break;
+    }
+
+    return ret;
+}
+
+void BaseREST::scheduleSend( const qint64 delay_ms )
+{
+    // the exchange hasn't been initialized yet
+    if ( send_timer == nullptr || send_idle_interval <= 0 )
+        return;
+
+    // don't push back a send that is already due sooner
+    if ( send_timer->isActive() && send_timer->remainingTime() <= delay_ms )
+        return;
 
-    // append to packet queue
-    nam_queue.append( delayed_request );
+    send_timer->start( qMax<qint64>( delay_ms, 0 ) );
 }
 
 bool BaseREST::isKeyOrSecretUnset() const
@@ -113,14 +219,9 @@ bool BaseREST::isKeyOrSecretUnset() const
     return keystore.isKeyOrSecretEmpty() ? true : false;
 }
 
-bool BaseREST::isCommandQueued( const QString &api_command_prefix ) const
+bool BaseREST::isCommandQueued( const QString &api_command ) const
 {
-    // check for getopenorders request in nam_queue
-    for ( QQueue<Request*>::const_iterator i = nam_queue.begin(); i != nam_queue.end(); i++ )
-        if ( (*i)->api_command.startsWith( api_command_prefix ) )
-            return true;
-
-    return false;
+    return nam_queue.containsCommand( api_command );
 }
 
 //bool BaseREST::isCommandSent( const QString &api_command_prefix, qint32 min_times ) const
@@ -139,19 +240,11 @@ bool BaseREST::isCommandQueued( const QString &api_command_prefix ) const
 
 void BaseREST::removeRequest( const QString &api_command, const QString &body )
 {
-    QQueue<Request*> removed_requests;
-    for ( QQueue<Request*>::const_iterator i = nam_queue.begin(); i != nam_queue.end(); i++ )
-    {
-        Request *const &req = *i;
+    // remove the requests we matched, they were never sent so nothing else references them
+    const QVector<Request*> removed_requests = nam_queue.takeByCommandAndBody( api_command, body );
 
-        if ( req->api_command == api_command &&
-             req->body == body )
-            removed_requests.append( req );
-    }
-
-    // remove the requests we matched
-    while ( !removed_requests.isEmpty() )
-        nam_queue.removeOne( removed_requests.takeFirst() );
+    for ( QVector<Request*>::const_iterator i = removed_requests.begin(); i != removed_requests.end(); i++ )
+        delete *i;
 }
 
 void BaseREST::deleteReply( QNetworkReply * const &reply, Request * const &request )
@@ -163,6 +256,14 @@ void BaseREST::deleteReply( QNetworkReply * const &reply, Request * const &reque
         return;
     }
 
+    // free the in-flight slot
+    if ( request->rate_class < RATE_CLASS_COUNT )
+        session->onRequestFinished( request->rate_class );
+
+    // the reply was handled, record how long that took
+    if ( request->parse_timer.isValid() )
+        latency.record( LatencyParse, getLatencyLabel( request ), request->parse_timer.nsecsElapsed() / 1000, QDateTime::currentMSecsSinceEpoch() );
+
     delete request;
 
     // if we took it out, it won't be in there. remove incase it's still there.
@@ -174,6 +275,286 @@ void BaseREST::deleteReply( QNetworkReply * const &reply, Request * const &reque
 
     // delete from heap
     reply->deleteLater();
+
+    // a slot in flight opened up, see if we can send more
+    if ( !nam_queue.isEmpty() )
+        scheduleSend();
+}
+
+void BaseREST::batchQueuedCancels( const QString &cancel_command_prefix )
+{
+    if ( !batch_cancels_enabled || nam_queue.size( RateCancel ) < batch_cancel_min )
+        return;
+
+    // we can only rule out foreign orders with a recent open orders snapshot
+    if ( open_orders_request_time < QDateTime::currentMSecsSinceEpoch() - orderbook_stale_tolerance )
+        return;
+
+    PositionMan *const &positions = engine->getPositionMan();
+
+    // group queued cancels for active positions by market
+    QHash<QString, QVector<Request*>> cancels_by_market;
+    QHash<QString, QSet<Position*>> cancelling_by_market;
+
+    const QVector<Request*> &queued_cancels = nam_queue.getClassRequests( RateCancel );
+
+    for ( QVector<Request*>::const_iterator i = queued_cancels.begin(); i != queued_cancels.end(); i++ )
+    {
+        Request *const &request = *i;
+
+        if ( request->pos == nullptr || !request->api_command.startsWith( cancel_command_prefix ) )
+            continue;
+
+        if ( !positions->isValid( request->pos_handle ) || !positions->isActive( request->pos ) )
+            continue;
+
+        cancels_by_market[ request->pos->market ] += request;
+        cancelling_by_market[ request->pos->market ].insert( request->pos );
+    }
+
+    if ( cancels_by_market.isEmpty() )
+        return;
+
+    // batch endpoints cancel everything in the market, so every active order there must be cancelling, and
+    // there must be no queued orders that could land before the batch does
+    QHash<QString, qint32> active_by_market;
+    QSet<QString> markets_with_queued;
+
+    for ( QSet<Position*>::const_iterator i = positions->active().begin(); i != positions->active().end(); i++ )
+        active_by_market[ (*i)->market ]++;
+
+    for ( QSet<Position*>::const_iterator i = positions->queued().begin(); i != positions->queued().end(); i++ )
+        markets_with_queued.insert( (*i)->market );
+
+    for ( QHash<QString, QVector<Request*>>::const_iterator i = cancels_by_market.begin(); i != cancels_by_market.end(); i++ )
+    {
+        const QString &market = i.key();
+        const QVector<Request*> &cancels = i.value();
+        const qint32 cancelling_count = cancelling_by_market.value( market ).size();
+
+        if ( cancelling_count < batch_cancel_min ||
+             cancelling_count != active_by_market.value( market ) ||
+             markets_with_queued.contains( market ) )
+            continue;
+
+        // every order the exchange last listed in this market must be one we're cancelling
+        QSet<QString> cancelling_ids;
+        const QSet<Position*> &cancelling = cancelling_by_market.value( market );
+
+        for ( QSet<Position*>::const_iterator j = cancelling.begin(); j != cancelling.end(); j++ )
+            cancelling_ids.insert( (*j)->order_number );
+
+        if ( !cancelling_ids.contains( open_orders_by_market.value( market ) ) )
+        {
+            kDebug() << getExchangeFancyStr() << "not batching cancels for" << market << "because it has orders that aren't ours";
+            continue;
+        }
+
+        // fall back to per-order cancels if the exchange has no batch endpoint
+        if ( !sendBatchCancel( Market( market ), cancels ) )
+            continue;
+
+        kDebug() << getExchangeFancyStr() << "batched" << cancels.size() << "cancels for" << market;
+
+        // the batch request replaces the per-order requests
+        for ( QVector<Request*>::const_iterator j = cancels.begin(); j != cancels.end(); j++ )
+        {
+            nam_queue.removeOne( *j );
+            delete *j;
+        }
+    }
+}
+
+void BaseREST::initRateLimits( const qreal requests_per_second, const qreal burst )
+{
+    const qint64 current_time = QDateTime::currentMSecsSinceEpoch();
+
+    // cancels and orders are only bound by the exchange limit, polling gets a smaller share so it can't starve them
+    rate_limiter.setExchangeLimit( burst, requests_per_second, current_time );
+    rate_limiter.setClassLimit( RateCancel, burst, 0., current_time );
+    rate_limiter.setClassLimit( RateOrder, burst, 0., current_time );
+    rate_limiter.setClassLimit( RateQuery, qMax( burst / 2., 1. ), requests_per_second / 2., current_time );
+    rate_limiter.setClassLimit( RatePublic, 1., requests_per_second / 4., current_time );
+}
+
+void BaseREST::initSession( const QStringList &urls, const bool http2_allowed )
+{
+    session->setNetworkAccessManager( nam );
+
+    for ( QStringList::const_iterator i = urls.begin(); i != urls.end(); i++ )
+        session->addHost( QUrl( *i ) );
+
+#if defined( NETWORK_HTTP2_ENABLED )
+    session->setHttp2Allowed( http2_allowed );
+#else
+    Q_UNUSED( http2_allowed )
+#endif
+    session->setPipeliningAllowed( true );
+
+    session->setInFlightLimit( RateCancel, limit_in_flight_orders );
+    session->setInFlightLimit( RateOrder, limit_in_flight_orders );
+    session->setInFlightLimit( RateQuery, limit_in_flight_queries );
+    session->setInFlightLimit( RatePublic, limit_in_flight_queries );
+
+    session->startKeepWarm( SESSION_TIMER_INTERVAL_KEEP_WARM );
+}
+
+void BaseREST::trackSentRequest( QNetworkReply *const &reply, Request *const &request )
+{
+    request->rate_class = getRateClass( request );
+    session->onRequestSent( request->rate_class );
+
+    // the queue sequence is unique per exchange, replies find their request by it
+    if ( capture != nullptr )
+        capture->recordRequest( request->queue_sequence, request->api_command, request->body, reply->url().toString(), request->time_sent_ms );
+
+    if ( request->time_queued_ms > 0 )
+        latency.record( LatencyQueue, getLatencyLabel( request ), ( request->time_sent_ms - request->time_queued_ms ) * 1000, request->time_sent_ms );
+
+    nam_queue_sent.insert( reply, request );
+}
+
+QString BaseREST::getLatencyLabel( Request *const &request ) const
+{
+    return request->api_command;
+}
+
+void BaseREST::onReplyReceived( Request *const &request, const QByteArray &data )
+{
+    const qint64 current_time = QDateTime::currentMSecsSinceEpoch();
+
+    if ( capture != nullptr )
+        capture->recordReply( request->queue_sequence, data, current_time );
+
+    request->parse_timer.start();
+    latency.record( LatencyResponse, getLatencyLabel( request ), ( current_time - request->time_sent_ms ) * 1000, current_time );
+}
+
+bool BaseREST::queueReplyParse( Request *const &request, const QByteArray &data, ReplyDecoder decoder )
+{
+    // small replies are cheaper to parse in place than to hand off
+    if ( data.size() < REPLY_PARSER_MIN_BYTES )
+        return false;
+
+    reply_parser->queue( request->api_command, request->time_sent_ms, data, decoder );
+    return true;
+}
+
+void BaseREST::printReplyError( const ParsedReply &reply ) const
+{
+    QByteArray data = reply.data;
+
+    // filter html to reduce spam
+    if ( data.contains( QByteArray( "<html" ) ) || data.contains( QByteArray( "<HTML" ) ) )
+        data = QByteArray( "<html error>" );
+
+    kDebug() << QString( "%1 nam error for %2: %3" )
+                .arg( getExchangeFancyStr() )
+                .arg( reply.api_command )
+                .arg( QString::fromLocal8Bit( data ) );
+}
+
+bool BaseREST::startCapture( QString path )
+{
+    if ( replay != nullptr && replay->isRunning() )
+    {
+        kDebug() << getExchangeFancyStr() << "local error: can't capture while replaying";
+        return false;
+    }
+
+    stopCapture();
+
+    const qint64 current_time = QDateTime::currentMSecsSinceEpoch();
+
+    if ( path.isEmpty() )
+        path = Global::getTraderPath() + QDir::separator() +
+               QString( "capture.%1.%2.bin" ).arg( exchange_string.toLower() )
+                                             .arg( QDateTime::fromMSecsSinceEpoch( current_time ).toString( "yyyyMMdd-HHmmss" ) );
+
+    capture = new TrafficLogWriter();
+
+    if ( !capture->open( path, exchange_string, current_time ) )
+    {
+        delete capture;
+        capture = nullptr;
+        return false;
+    }
+
+    kDebug() << getExchangeFancyStr() << "capturing traffic to" << path;
+    return true;
+}
+
+void BaseREST::stopCapture()
+{
+    if ( capture == nullptr )
+        return;
+
+    kDebug() << getExchangeFancyStr() << "captured" << capture->getRecordCount() << "records," << capture->getSize() << "bytes to" << capture->getPath();
+
+    delete capture;
+    capture = nullptr;
+}
+
+bool BaseREST::startReplay( const QString &path, const qreal speed )
+{
+    // replayed replies would end up in the capture
+    if ( capture != nullptr )
+    {
+        kDebug() << getExchangeFancyStr() << "local error: can't replay while capturing";
+        return false;
+    }
+
+    if ( !isReplaySafe() )
+    {
+        kDebug() << getExchangeFancyStr() << "local error: replay needs a simulator build, or an exchange with no keys and no positions";
+        return false;
+    }
+
+    if ( replay == nullptr )
+        replay = new TrafficReplay( this, this );
+
+    return replay->start( path, speed );
+}
+
+bool BaseREST::isReplaySafe() const
+{
+#if defined( EXCHANGE_SIM_ENABLED )
+    // nothing reaches a real account
+    return true;
+#else
+    // replayed replies go through the live handlers and engine, so they must not meet real orders
+    return isKeyOrSecretUnset() &&
+           !engine->getPositionMan()->hasActivePositions() &&
+           !engine->getPositionMan()->hasQueuedPositions();
+#endif
+}
+
+void BaseREST::onLogLatency()
+{
+    if ( latency.getTotal( LatencyResponse ).merged().getCount() > 0 )
+        kDebug() << getExchangeFancyStr() << latency.getSummary();
+
+    latency.rotate( QDateTime::currentMSecsSinceEpoch() );
+}
+
+void BaseREST::onSendTimer()
+{
+    const qint32 sent_before = nam_queue_sent.size();
+
+    sendNamQueue();
+
+    // nothing left to send, come back later so the exchange can poll
+    if ( nam_queue.isEmpty() )
+    {
+        scheduleSend( send_idle_interval );
+        return;
+    }
+
+    // if we had tokens but sent nothing, we are yielding for another reason (lag or flow control), so back off
+    const qint64 wait_ms = msUntilNextSend();
+    const bool sent_any = nam_queue_sent.size() > sent_before;
+
+    scheduleSend( ( sent_any || wait_ms > 0 ) ? qMin<qint64>( wait_ms, send_idle_interval * 10 ) : send_idle_interval );
 }
 
 void BaseREST::onCheckSentTimeouts()
@@ -4,10 +4,18 @@
 #include "global.h"
 #include "misctypes.h"
 #include "keystore.h"
+#include "market.h"
+#include "ratelimiter.h"
+#include "exchangesession.h"
+#include "latencystats.h"
+#include "requestqueue.h"
+#include "trafficlog.h"
+#include "replyparser.h"
 
 #include <QObject>
-#include <QQueue>
 #include <QHash>
+#include <QVector>
+#include <QStringList>
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 
@@ -18,6 +26,7 @@ class Stats;
 class Engine;
 class QTimer;
 class Position;
+class TrafficReplay;
 
 struct BaseREST : public QObject
 {
@@ -31,26 +40,69 @@ struct BaseREST : public QObject
     bool isTickerStale() const;
 
     void sendRequest( QString api_command, QString body = QLatin1String(), Position *pos = nullptr, quint16 weight = 0 );
+    virtual void sendNamQueue() {}
+
+    // reply and websocket handlers, virtual so captured traffic can be replayed through them
+    virtual void onNamReply( QNetworkReply *const &reply ) { Q_UNUSED( reply ) }
+    virtual void wssTextMessageReceived( const QString &msg ) { Q_UNUSED( msg ) }
+
+    // large hot replies are decoded on reply_parser and applied when they come back on the main thread
+    bool queueReplyParse( Request *const &request, const QByteArray &data, ReplyDecoder decoder );
+    virtual void onReplyParsed( const ParsedReply &reply ) { Q_UNUSED( reply ) }
+    void printReplyError( const ParsedReply &reply ) const;
+
+    // rate limiting, sends are scheduled as soon as the next queued request has tokens
+    virtual RateClass getRateClass( Request *const &request ) const { Q_UNUSED( request ) return RateQuery; }
+    bool takeRateTokens( Request *const &request );
+    bool dropStaleRequest( Request *const &request ); // removes and deletes a queued request whose position is gone
+    qint64 msUntilNextSend();
+    void scheduleSend( const qint64 delay_ms = 0 );
+    void initRateLimits( const qreal requests_per_second, const qreal burst );
+
+    // send order within a rate class, computed once when the request is queued
+    virtual Coin getRequestPriority( Request *const &request ) const { Q_UNUSED( request ) return Coin(); }
+
+    // connection session, warm connections to the exchange hosts and in-flight limits per rate class
+    void initSession( const QStringList &urls, const bool http2_allowed );
+    void trackSentRequest( QNetworkReply *const &reply, Request *const &request );
+
+    // latency metrics, labels group requests per api command
+    virtual QString getLatencyLabel( Request *const &request ) const;
+    void onReplyReceived( Request *const &request, const QByteArray &data );
+
+    // traffic capture, requests, reply bodies and wss frames are logged for offline replay (see TrafficReplay)
+    bool startCapture( QString path = QString() );
+    void stopCapture();
+    void captureWssFrame( const QString &msg ) { if ( capture != nullptr ) capture->recordWssFrame( msg, QDateTime::currentMSecsSinceEpoch() ); }
+    bool startReplay( const QString &path, const qreal speed );
+    bool isReplaySafe() const;
 
     bool isKeyOrSecretUnset() const;
-    bool isCommandQueued( const QString &api_command_prefix ) const;
+    bool isCommandQueued( const QString &api_command ) const;
 //    bool isCommandSent( const QString &api_command_prefix, qint32 min_times = 1 ) const;
     void removeRequest( const QString &api_command, const QString &body );
     void deleteReply( QNetworkReply *const &reply, Request *const &request );
 
+    // batching stage, coalesces queued cancels per market into an exchange batch endpoint
+    void batchQueuedCancels( const QString &cancel_command_prefix );
+    virtual bool sendBatchCancel( const Market &market, const QVector<Request*> &cancels ) { Q_UNUSED( market ) Q_UNUSED( cancels ) return false; }
+
     QString getExchangeStr() const { return exchange_string; }
     QString getExchangeFancyStr() const { return QString( "[REST %1]" ).arg( exchange_string ); }
 
 public Q_SLOTS:
     void onCheckSentTimeouts();
+    void onSendTimer();
+    void onLogLatency();
 
 public:
 
-    QQueue<Request*> nam_queue; // queue for requests so we can load balance timestamp/hmac generation
+    RequestQueue nam_queue; // queue for requests so we can load balance timestamp/hmac generation
     QHash<QNetworkReply*,Request*> nam_queue_sent; // request tracking queue
 
     KeyStore keystore;
-    AvgResponseTime avg_response_time;
+    RateLimiter rate_limiter;
+    LatencyStats latency;
     QString exchange_string;
 
     qint64 request_nonce{ 0 }; // nonce (except for trex which uses time atm)
@@ -58,6 +110,8 @@ public:
 
     qint64 orderbook_update_time{ 0 }; // most recent trade time
     qint64 orderbook_update_request_time{ 0 };
+    qint64 open_orders_request_time{ 0 }; // when the latest open orders snapshot was requested
+    QHash<QString, QSet<QString>> open_orders_by_market; // order ids in the latest open orders snapshot, by local market
     qint64 ticker_update_time{ 0 };
     qint64 ticker_update_request_time{ 0 };
     qint32 limit_commands_queued{ 20 }; // stop checks if we are over this many commands queued
@@ -65,6 +119,11 @@ public:
     qint32 limit_commands_sent{ 100 }; // stop checks if we are over this many commands sent
     qint32 limit_timeout_yield{ 5 };
     qint32 market_cancel_thresh{ 300 }; // limit for market order total for weighting cancels to be sent first
+    bool batch_cancels_enabled{ false }; // opt-in, batch endpoints cancel every order in the market, ours or not
+    qint32 batch_cancel_min{ 3 }; // minimum queued cancels in one market before we use a batch cancel endpoint
+    qint32 send_idle_interval{ 0 }; // send_timer interval while nothing is sendable, 0 until the exchange is initialized
+    qint32 limit_in_flight_orders{ 8 }; // concurrent cancels and orders in flight, 0 is unlimited
+    qint32 limit_in_flight_queries{ 2 }; // concurrent polling requests in flight, 0 is unlimited
 
     qint64 slippage_stale_time{ 500 }; // quiet time before we allow an order to be included in slippage price calculations
     qint64 orderbook_stale_tolerance{ 10000 }; // only accept orderbooks sent within this time
@@ -76,7 +135,12 @@ public:
     QTimer *ticker_timer{ nullptr };
     QTimer *timeout_timer{ nullptr };
     QTimer *diverge_converge_timer{ nullptr };
+    QTimer *latency_timer{ nullptr };
 
+    ExchangeSession *session{ nullptr };
+    ReplyParser *reply_parser{ nullptr };
+    TrafficLogWriter *capture{ nullptr };
+    TrafficReplay *replay{ nullptr };
     QNetworkAccessManager *nam{ nullptr };
     Engine *engine{ nullptr };
 };
@@ -2,6 +2,7 @@
 #include "engine.h"
 #include "position.h"
 #include "positionman.h"
+#include "jsonreader.h"
 
 #include <QTimer>
 #include <QNetworkAccessManager>
@@ -27,13 +28,24 @@ BncREST::BncREST( Engine *_engine , QNetworkAccessManager *_nam )
 BncREST::~BncREST()
 {
     exchangeinfo_timer->stop();
-    ratelimit_timer->stop();
+    wss_timer->stop();
 
     delete exchangeinfo_timer;
-    delete ratelimit_timer;
+    delete wss_timer;
 
     exchangeinfo_timer = nullptr;
-    ratelimit_timer = nullptr;
+    wss_timer = nullptr;
+
+    // dispose of websocket
+    if ( wss )
+    {
+        // disconnect wss so we don't call wssCheckConnection()
+        disconnect( wss, &QWebSocket::disconnected, this, &BncREST::wssCheckConnection );
+
+        wss->abort();
+        delete wss;
+        wss = nullptr;
+    }
 
     kDebug() << getExchangeFancyStr() << "done.";
 }
@@ -41,9 +53,11 @@ BncREST::~BncREST()
 void BncREST::init()
 {
     BaseREST::market_cancel_thresh = 300; // limit for market order total for weighting cancels to be sent first
+    BaseREST::send_idle_interval = BINANCE_TIMER_INTERVAL_NAM_SEND;
 
-    connect( send_timer, &QTimer::timeout, this, &BncREST::sendNamQueue );
-    send_timer->start( BINANCE_TIMER_INTERVAL_NAM_SEND ); // minimum threshold 200 or so
+    setRateLimits();
+    initSession( QStringList() << BNC_URL, true );
+    scheduleSend();
 
     connect( ticker_timer, &QTimer::timeout, this, &BncREST::onCheckTicker );
     ticker_timer->start( BINANCE_TIMER_INTERVAL_TICKER );
@@ -54,11 +68,17 @@ void BncREST::init()
     exchangeinfo_timer->setTimerType( Qt::VeryCoarseTimer );
     exchangeinfo_timer->start( 60000 ); // 1 minute (turns to 1 hour after first parse)
 
-    // this timer sets the network rate, fee, price ticksizes, and quantity ticksizes
-    ratelimit_timer = new QTimer( this );
-    connect( exchangeinfo_timer, &QTimer::timeout, this, &BncREST::onCheckRateLimit );
-    ratelimit_timer->setTimerType( Qt::VeryCoarseTimer );
-    ratelimit_timer->start( BINANCE_RATELIMIT_WINDOW ); // window is 1 minute
+    // create websocket for the bookTicker and user data streams
+    wss = new QWebSocket();
+    connect( wss, &QWebSocket::connected, this, &BncREST::wssConnected );
+    connect( wss, &QWebSocket::disconnected, this, &BncREST::wssCheckConnection );
+    connect( wss, &QWebSocket::textMessageReceived, this, &BncREST::wssTextMessageReceived );
+    connect( wss, &QWebSocket::pong, this, &BncREST::wssPong );
+
+    // check websocket frequently (started after we have market aliases)
+    wss_timer = new QTimer( this );
+    connect( wss_timer, &QTimer::timeout, this, &BncREST::wssCheckConnection );
+    wss_timer->setTimerType( Qt::VeryCoarseTimer );
 
 #if !defined( BINANCE_TICKER_ONLY )
     keystore.setKeys( BINANCE_KEY, BINANCE_SECRET );
@@ -83,107 +103,134 @@ void BncREST::sendNamQueue()
     if ( yieldToFlowControlSent() )
         return;
 
-    // normalize ratelimit by our timer
-    const qint32 ratelimit_window = ratelimit_minute;
-    if ( binance_weight > ratelimit_window )
-    {
-        kDebug() << getExchangeFancyStr() << "local warning: hit ratelimit_window" << ratelimit_window;
-        return;
-    }
+    // coalesce cancels for the same symbol into one DELETE openOrders
+    batchQueuedCancels( BNC_COMMAND_CANCEL );
 
-    QMultiMap<Coin/*weight*/,Request*> sorted_nam_queue;
-
-    // insert into auto sorted map sorted by weight
-    for ( QQueue<Request*>::const_iterator i = nam_queue.begin(); i != nam_queue.end(); i++ )
+    // if the orderbook is stale, we can assume the server is down and we let the orders timeout
+    // only poll orders until the orderbook is responded to
+    if ( yieldToLag() )
     {
-        Request *const &request = *i;
-        Position *const &pos = request->pos;
+        const QVector<Request*> order_requests = nam_queue.getByCommand( BNC_COMMAND_GETORDERS );
 
-        // check for valid pos
-        if ( pos == nullptr || !engine->getPositionMan()->isValid( pos ) )
+        for ( QVector<Request*>::const_iterator i = order_requests.begin(); i != order_requests.end(); i++ )
         {
-            sorted_nam_queue.insert( Coin(), request );
-            continue;
-        }
+            if ( dropStaleRequest( *i ) )
+                continue;
 
-        // check for cancel
-        if ( request->api_command == BNC_COMMAND_CANCEL &&
-             engine->getPositionMan()->getMarketOrderTotal( pos->market ) >= market_cancel_thresh )
-        {
-            // expedite the cancel
-            sorted_nam_queue.insert( CoinAmount::COIN, request );
-            continue;
-        }
+            if ( !takeRateTokens( *i ) )
+                break;
 
-        if ( request->api_command == BNC_COMMAND_GETTICKER ||
-             request->api_command == BNC_COMMAND_GETORDERS )
-        {
-            sorted_nam_queue.insert( Coin(), request );
-            continue;
-        }
-
-        // new hi/lo buy or sell, we should value this at 0 because it's not a reactive order
-        if ( pos->is_new_hilo_order )
-        {
-            sorted_nam_queue.insert( Coin(), request );
-            continue;
-        }
+            sendNamRequest( *i );
 
-        // check for not buy/sell command
-        if ( request->api_command != BNC_COMMAND_BUYSELL )
-        {
-            sorted_nam_queue.insert( Coin(), request );
-            continue;
+            if ( yieldToFlowControlSent() )
+                return;
         }
 
-        sorted_nam_queue.insert( pos->per_trade_profit, request );
+        return;
     }
 
-    // go through orders, ranked from highest weight to lowest
-    for ( QMultiMap<Coin,Request*>::const_iterator i = sorted_nam_queue.end() -1; i != sorted_nam_queue.begin() -1; i-- )
+    // send everything we have tokens for, highest weight first within each class (cancels, orders, polling)
+    for ( int i = 0; i < RATE_CLASS_COUNT; i++ )
     {
-        Request *const &request = i.value();
+        const RateClass rate_class = RateClass( i );
+        Request *request;
 
-        // check if we received the orderbook in the timeframe of an order timeout grace period
-        // if it's stale, we can assume the server is down and we let the orders timeout
-        if ( yieldToLag() && request->api_command != BNC_COMMAND_GETORDERS )
+        while ( ( request = nam_queue.top( rate_class ) ) != nullptr )
         {
-            // let this request hang around until the orderbook is responded to
-            continue;
-        }
+            // the position is gone, drop it before it costs tokens
+            if ( dropStaleRequest( request ) )
+                continue;
 
-        // track orders total and continue if we're over it
-        if ( request->api_command.endsWith( "post-order" ) )
-        {
-            QString mdy_str = Global::getDateStringMDY();
-            qint32 orders_today = daily_orders.value( mdy_str );
+            // check the daily order limit before taking tokens
+            const bool is_new_order = request->api_command.endsWith( "post-order" );
+            const QString mdy_str = is_new_order ? Global::getDateStringMDY() : QString();
 
-            if ( orders_today >= ratelimit_day )
+            if ( is_new_order && daily_orders.value( mdy_str ) >= ratelimit_day )
             {
                 kDebug() << getExchangeFancyStr() << "local warning: we are over the daily order ratelimit" << ratelimit_day;
-                continue;
+                break;
             }
 
-            daily_orders[ mdy_str ]++;
-        }
+            // wait for this class (or the minute weight) to refill, lower priority classes may still fit
+            if ( !takeRateTokens( request ) )
+                break;
 
-        sendNamRequest( request );
-        // the request is added to sent_nam_queue and thus not deleted until the response is met
-        return;
+            // track orders total
+            if ( is_new_order )
+                daily_orders[ mdy_str ]++;
+
+            sendNamRequest( request );
+            // the request is added to sent_nam_queue and thus not deleted until the response is met
+
+            if ( yieldToFlowControlSent() )
+                return;
+
+            // the request couldn't be sent, try again next time
+            if ( nam_queue.contains( request ) )
+                break;
+        }
     }
 }
 
+Coin BncREST::getRequestPriority( Request *const &request ) const
+{
+    Position *const &pos = request->pos;
+
+    // check for valid pos
+    if ( pos == nullptr || !engine->getPositionMan()->isValid( request->pos_handle ) )
+        return Coin();
+
+    // check for cancel
+    if ( request->api_command == BNC_COMMAND_CANCEL &&
+         engine->getPositionMan()->getMarketOrderTotal( pos->market ) >= market_cancel_thresh )
+        return CoinAmount::COIN; // expedite the cancel
+
+    // new hi/lo buy or sell, we should value this at 0 because it's not a reactive order
+    if ( pos->is_new_hilo_order )
+        return Coin();
+
+    // check for not buy/sell command
+    if ( request->api_command != BNC_COMMAND_BUYSELL )
+        return Coin();
+
+    return pos->per_trade_profit;
+}
+
+RateClass BncREST::getRateClass( Request *const &request ) const
+{
+    const QString &api_command = request->api_command;
+
+    if ( api_command == BNC_COMMAND_CANCEL || api_command == BNC_COMMAND_CANCEL_ALL )
+        return RateCancel;
+    else if ( api_command == BNC_COMMAND_BUYSELL )
+        return RateOrder;
+    else if ( api_command.startsWith( "sign-" ) || api_command.startsWith( "key-" ) )
+        return RateQuery;
+
+    return RatePublic;
+}
+
+void BncREST::setRateLimits()
+{
+    const qint64 current_time = QDateTime::currentMSecsSinceEpoch();
+
+    // request weight is shared by everything, allow a burst of 10 seconds worth
+    rate_limiter.setExchangeLimit( ratelimit_minute / 6., ratelimit_minute / 60., current_time );
+
+    // cancels only count towards weight, new orders also count towards the order limit
+    rate_limiter.setClassLimit( RateCancel, 1., 0., current_time );
+    rate_limiter.setClassLimit( RateOrder, ratelimit_second, ratelimit_second, current_time );
+
+    // keep polling from eating the weight that orders need
+    rate_limiter.setClassLimit( RateQuery, 5., 2., current_time );
+    rate_limiter.setClassLimit( RatePublic, 3., 1., current_time );
+}
+
 void BncREST::sendNamRequest( Request *const &request )
 {
     // check for valid pos
-    if ( request->pos != nullptr && !engine->getPositionMan()->isValid( request->pos ) )
-    {
-        kDebug() << getExchangeFancyStr() << "local warning: caught nam request with invalid position";
-        nam_queue.removeOne( request );
+    if ( dropStaleRequest( request ) )
         return;
-    }
-
-    binance_weight += request->weight;
 
     const qint64 current_time = QDateTime::currentMSecsSinceEpoch();
 
@@ -227,6 +274,7 @@ void BncREST::sendNamRequest( Request *const &request )
     QByteArray query_bytes;
 
     nam_request.setRawHeader( CONTENT_TYPE, CONTENT_TYPE_ARGS ); // add content header
+    session->prepareRequest( nam_request );
 
     // add to sent queue so we can check if it timed out
     request->time_sent_ms = current_time;
@@ -237,13 +285,22 @@ void BncREST::sendNamRequest( Request *const &request )
 
         query.addQueryItem( BNC_RECVWINDOW, "120000" ); // 2 minutes recvWindow because we aren't bad
         query.addQueryItem( BNC_TIMESTAMP, request_nonce_str );
-        query.addQueryItem( BNC_SIGNATURE, Global::getBncSignature( query.toString().toUtf8(), keystore.getSecret() ) ); // add signature header
+        query.addQueryItem( BNC_SIGNATURE, keystore.getSignature( query.toString().toUtf8(), QCryptographicHash::Sha256 ).toHex() ); // add signature header
 
         // add signature to query
         query_bytes = query.toString().toUtf8();
 
         nam_request.setRawHeader( BNC_APIKEY, keystore.getKey() ); // add key header
     }
+    // api key only, no signature (user data stream)
+    else if ( api_command.startsWith( "key-" ) )
+    {
+        api_command.remove( 0, 4 ); // remove "key-" string
+
+        query_bytes = query.toString().toUtf8();
+
+        nam_request.setRawHeader( BNC_APIKEY, keystore.getKey() ); // add key header
+    }
 
     QNetworkReply *reply = nullptr;
     // GET
@@ -287,6 +344,16 @@ void BncREST::sendNamRequest( Request *const &request )
         nam_request.setUrl( public_url );
         reply = nam->sendCustomRequest( nam_request, "DELETE", query_bytes );
     }
+    // PUT
+    else if ( api_command.startsWith( "put-" ) )
+    {
+        api_command.remove( 0, 4 ); // remove "put-"
+
+        QUrl public_url( BNC_URL + api_command );
+
+        nam_request.setUrl( public_url );
+        reply = nam->sendCustomRequest( nam_request, "PUT", query_bytes );
+    }
 
     if ( reply == nullptr )
     {
@@ -294,7 +361,7 @@ void BncREST::sendNamRequest( Request *const &request )
         return;
     }
 
-    nam_queue_sent.insert( reply, request );
+    trackSentRequest( reply, request );
     nam_queue.removeOne( request );
 
     last_request_sent_ms = current_time;
@@ -354,6 +421,26 @@ void BncREST::sendCancel( const QString &_order_id, Position *const &pos )
     }
 }
 
+bool BncREST::sendBatchCancel( const Market &market, const QVector<Request*> &cancels )
+{
+    const qint64 current_time = QDateTime::currentMSecsSinceEpoch();
+
+    // flag the positions as cancelling, the same way a single cancel would on send
+    for ( QVector<Request*>::const_iterator i = cancels.begin(); i != cancels.end(); i++ )
+    {
+        Position *const &pos = (*i)->pos;
+
+        pos->is_cancelling = true;
+        pos->order_cancel_time = current_time;
+    }
+
+    QUrlQuery query;
+    query.addQueryItem( "symbol", market.toExchangeString( ENGINE_BINANCE ) );
+
+    sendRequest( BNC_COMMAND_CANCEL_ALL, query.toString(), nullptr, 1 );
+    return true;
+}
+
 void BncREST::sendGetOrder( const QString &_order_id, Position * const &pos )
 {
     // extract market from orderid (binance only)
@@ -392,14 +479,25 @@ void BncREST::onNamReply( QNetworkReply *const &reply )
     // reference the object we made during the request
     Request *const &request = nam_queue_sent.take( reply );
     const QString &api_command = request->api_command;
-    const qint64 response_time = QDateTime::currentMSecsSinceEpoch() - request->time_sent_ms;
-
-    avg_response_time.addResponseTime( response_time );
+    onReplyReceived( request, data );
 
     //kDebug() << api_command << data;
 
     //kDebug() << "got reply for" << api_command;
 
+    // the hot replies are read without building a document, large ones on the parser thread
+    if ( api_command == BNC_COMMAND_GETORDERS || api_command == BNC_COMMAND_GETTICKER )
+    {
+        const ReplyDecoder decoder = ( api_command == BNC_COMMAND_GETORDERS ) ? &BncREST::decodeOpenOrders :
+                                                                                &BncREST::decodeTicker;
+
+        if ( !queueReplyParse( request, data, decoder ) )
+            onReplyParsed( ReplyParser::decode( decoder, api_command, request->time_sent_ms, data ) );
+
+        deleteReply( reply, request );
+        return;
+    }
+
     // parse any possible json in the body
     QJsonDocument body_json = QJsonDocument::fromJson( data );
     QJsonObject body_obj;
@@ -465,15 +563,7 @@ void BncREST::onNamReply( QNetworkReply *const &reply )
                     .arg( QString::fromLocal8Bit( data ) );
     }
 
-    if ( api_command == BNC_COMMAND_GETORDERS )
-    {
-        parseOpenOrders( body_arr, request->time_sent_ms );
-    }
-    else if ( api_command == BNC_COMMAND_GETTICKER )
-    {
-        parseTicker( body_arr, request->time_sent_ms );
-    }
-    else if ( api_command == BNC_COMMAND_GETEXCHANGEINFO )
+    if ( api_command == BNC_COMMAND_GETEXCHANGEINFO )
     {
         parseExchangeInfo( body_obj );
     }
@@ -485,10 +575,32 @@ void BncREST::onNamReply( QNetworkReply *const &reply )
     {
         parseCancelOrder( request, body_obj );
     }
+    else if ( api_command == BNC_COMMAND_CANCEL_ALL )
+    {
+        // on error we get an object back, the orders will time out and be cancelled individually
+        if ( is_body_array )
+            parseCancelAll( body_arr );
+        else
+            kDebug() << getExchangeFancyStr() << "local error: batch cancel failed:" << body_obj;
+    }
     else if ( api_command == BNC_COMMAND_GETBALANCES )
     {
         parseReturnBalances( body_obj );
     }
+    else if ( api_command == BNC_COMMAND_GETLISTENKEY )
+    {
+        parseListenKey( body_obj );
+    }
+    else if ( api_command == BNC_COMMAND_KEEPALIVE )
+    {
+        // an empty object means success, otherwise the key expired and we need a new one
+        if ( !body_obj.isEmpty() || is_json_invalid )
+        {
+            kDebug() << getExchangeFancyStr() << "(wss) listen key keepalive failed:" << body_obj;
+            listen_key.clear();
+            wss_1000_state = false;
+        }
+    }
     else
     {
         // parse unknown command
@@ -516,9 +628,6 @@ void BncREST::onCheckBotOrders()
 
 void BncREST::onCheckTicker()
 {
-    // check if wss disconnected
-    wssCheckConnection();
-
     if ( isCommandQueued( BNC_COMMAND_GETTICKER ) )
         return;
 
@@ -534,32 +643,386 @@ void BncREST::onCheckExchangeInfo()
     sendRequest( BNC_COMMAND_GETEXCHANGEINFO, "", nullptr, 1 );
 }
 
-void BncREST::onCheckRateLimit()
-{ // happens every minute
-    binance_weight = 0;
-}
-
 void BncREST::wssConnected()
 {
+    kDebug() << getExchangeFancyStr() << "(wss) connected";
+
     wssSendSubscriptions();
 }
 
 void BncREST::wssSendSubscriptions()
 {
+    if ( wss == nullptr || !wss->isValid() )
+        return;
+
+    const qint64 current_time = QDateTime::currentMSecsSinceEpoch();
+
+    // subscribe to the user data stream
+    if ( !wss_1000_state &&
+         !listen_key.isEmpty() &&
+         wss_1000_subscribe_try_time < current_time - 30000 )
+    {
+        const QJsonObject subscribe_user_data
+        {
+            { "method", "SUBSCRIBE" },
+            { "params", QJsonArray{ listen_key } },
+            { "id", 1000 }
+        };
+
+        kDebug() << getExchangeFancyStr() << "(wss) sending user data subscribe";
+        wssSendJsonObj( subscribe_user_data );
+
+        wss_1000_subscribe_try_time = current_time;
+    }
+
+    // subscribe to bookTicker for any markets we are trading that we haven't subscribed to
+    const QSet<QString> wanted_streams = getWssTickerStreams();
+    QJsonArray new_streams;
+
+    for ( QSet<QString>::const_iterator i = wanted_streams.begin(); i != wanted_streams.end(); i++ )
+        if ( !wss_ticker_streams.contains( *i ) )
+            new_streams += *i;
+
+    // send in chunks to stay under the message size and incoming message limits
+    static const int streams_per_message = 100;
+    for ( int i = 0; i < new_streams.size(); i += streams_per_message )
+    {
+        QJsonArray params;
+        for ( int j = i; j < qMin( i + streams_per_message, new_streams.size() ); j++ )
+        {
+            params += new_streams.at( j );
+            wss_ticker_streams += new_streams.at( j ).toString();
+        }
+
+        const QJsonObject subscribe_tickers
+        {
+            { "method", "SUBSCRIBE" },
+            { "params", params },
+            { "id", 1002 }
+        };
+
+        kDebug() << getExchangeFancyStr() << "(wss) sending bookTicker subscribe for" << params.size() << "markets";
+        wssSendJsonObj( subscribe_tickers );
+    }
 }
 
 void BncREST::wssSendJsonObj( const QJsonObject &obj )
 {
-    Q_UNUSED( obj )
+    const QJsonDocument doc = QJsonDocument( obj );
+    const QString data_str = doc.toJson( QJsonDocument::Compact );
+
+    //kDebug() << "(wss) sending" << data_str;
+
+    wss->sendTextMessage( data_str );
+}
+
+QSet<QString> BncREST::getWssTickerStreams() const
+{
+    QSet<QString> ret;
+
+    // markets with a ping-pong index
+    const QHash<QString, MarketInfo> &market_info = engine->getMarketInfoStructure();
+    for ( QHash<QString, MarketInfo>::const_iterator i = market_info.begin(); i != market_info.end(); i++ )
+        if ( !i.value().position_index.isEmpty() )
+            ret += Market( i.key() ).toExchangeString( ENGINE_BINANCE ).toLower() + "@bookTicker";
+
+    // markets with orders
+    for ( QSet<Position*>::const_iterator i = engine->getPositionMan()->all().begin(); i != engine->getPositionMan()->all().end(); i++ )
+        ret += (*i)->market.toExchangeString( ENGINE_BINANCE ).toLower() + "@bookTicker";
+
+    return ret;
+}
+
+void BncREST::wssCheckListenKey()
+{
+#if !defined( BINANCE_TICKER_ONLY )
+    if ( isKeyOrSecretUnset() ||
+         isCommandQueued( BNC_COMMAND_GETLISTENKEY ) ||
+         isCommandQueued( BNC_COMMAND_KEEPALIVE ) )
+        return;
+
+    const qint64 current_time = QDateTime::currentMSecsSinceEpoch();
+
+    // get a new key
+    if ( listen_key.isEmpty() )
+    {
+        sendRequest( BNC_COMMAND_GETLISTENKEY, "", nullptr, 1 );
+        return;
+    }
+
+    // keys expire after 60 minutes without a keepalive
+    if ( listen_key_time < current_time - BINANCE_LISTENKEY_KEEPALIVE )
+    {
+        QUrlQuery query;
+        query.addQueryItem( "listenKey", listen_key );
+
+        sendRequest( BNC_COMMAND_KEEPALIVE, query.toString(), nullptr, 1 );
+        listen_key_time = current_time;
+    }
+#endif
+}
+
+void BncREST::parseListenKey( const QJsonObject &obj )
+{
+    const QString new_listen_key = obj.value( "listenKey" ).toString();
+
+    if ( new_listen_key.isEmpty() )
+    {
+        kDebug() << getExchangeFancyStr() << "local warning: failed to get listen key:" << obj;
+        return;
+    }
+
+    // if the key changed, the old subscription is dead
+    if ( new_listen_key != listen_key )
+    {
+        listen_key = new_listen_key;
+        wss_1000_state = false;
+        wss_1000_subscribe_try_time = 0;
+    }
+
+    listen_key_time = QDateTime::currentMSecsSinceEpoch();
+
+    wssSendSubscriptions();
 }
 
 void BncREST::wssCheckConnection()
 {
+    if ( wss == nullptr || market_aliases.isEmpty() )
+        return;
+
+    const qint64 current_time = QDateTime::currentMSecsSinceEpoch();
+    const qint64 wss_timeout = 30000;
+
+    wssCheckListenKey();
+
+    // check for connected, and back off exponentially while the connection keeps failing
+    if ( ( !wss->isValid() ||  // socket is invalid OR
+           wss_heartbeat_time < current_time - wss_timeout ) && // we stopped receiving data
+         wss_connect_try_time < current_time - wss_reconnect_backoff ) // last time we tried to connect is stale
+    {
+        kDebug() << getExchangeFancyStr() << "(wss-reconnect) next retry in" << wss_reconnect_backoff * 2 << "ms";
+
+        // update the time now incase open() is blocking when another disconnected() event fires
+        wss_connect_try_time = current_time;
+        wss_reconnect_backoff = qMin<qint64>( wss_reconnect_backoff * 2, BINANCE_WSS_BACKOFF_MAX );
+        wss_1000_state = false;
+        wss_1002_state = false;
+        wss_1000_subscribe_try_time = 0;
+        wss_ticker_streams.clear();
+
+        wss->abort();
+        wss->open( QUrl( BNC_URL_WSS ) );
+    }
+    else if ( wss->isValid() )
+    {
+        // if we are connected, keep the connection alive and make sure feeds are active
+        wss->ping();
+        wssSendSubscriptions();
+    }
+
+    // fall back to rest polling if the websocket feeds are down
+    const bool wss_account_feed_is_up_to_date = wss_1000_state && wss_heartbeat_time > current_time - wss_timeout;
+    const bool wss_ticker_feed_is_up_to_date = wss_1002_state && wss_heartbeat_time > current_time - wss_timeout;
+
+    if ( wss_account_feed_is_up_to_date &&
+         orderbook_timer->interval() < BINANCE_TIMER_INTERVAL_ORDERBOOK * 3 )
+    {
+        orderbook_timer->setInterval( BINANCE_TIMER_INTERVAL_ORDERBOOK * 3 );
+        kDebug() << getExchangeFancyStr() << "(wss) slowed down orderbook timer";
+    }
+    else if ( !wss_account_feed_is_up_to_date &&
+              orderbook_timer->interval() > BINANCE_TIMER_INTERVAL_ORDERBOOK )
+    {
+        orderbook_timer->setInterval( BINANCE_TIMER_INTERVAL_ORDERBOOK );
+        kDebug() << getExchangeFancyStr() << "(wss) restored orderbook timer";
+    }
+
+    if ( wss_ticker_feed_is_up_to_date &&
+         ticker_timer->interval() < BINANCE_TIMER_INTERVAL_TICKER * 4 )
+    {
+        ticker_timer->setInterval( BINANCE_TIMER_INTERVAL_TICKER * 4 );
+        kDebug() << getExchangeFancyStr() << "(wss) slowed down ticker timer";
+    }
+    else if ( !wss_ticker_feed_is_up_to_date &&
+              ticker_timer->interval() > BINANCE_TIMER_INTERVAL_TICKER )
+    {
+        ticker_timer->setInterval( BINANCE_TIMER_INTERVAL_TICKER );
+        kDebug() << getExchangeFancyStr() << "(wss) restored ticker timer";
+    }
+}
+
+void BncREST::wssPong( quint64 elapsed_time )
+{
+    Q_UNUSED( elapsed_time )
+
+    wss_heartbeat_time = QDateTime::currentMSecsSinceEpoch();
 }
 
 void BncREST::wssTextMessageReceived( const QString &msg )
 {
-    Q_UNUSED( msg )
+    captureWssFrame( msg );
+
+    const QByteArray msg_utf8 = msg.toUtf8();
+
+    //kDebug() << "wss in:" << msg;
+
+    // bookTicker updates are most of the traffic, try them first without building a document
+    const bool is_book_ticker = wssParseBookTicker( msg_utf8 );
+
+    if ( is_book_ticker )
+    {
+        wss_heartbeat_time = QDateTime::currentMSecsSinceEpoch();
+        wss_reconnect_backoff = BINANCE_WSS_BACKOFF_MIN;
+        return;
+    }
+
+    const QJsonDocument doc = QJsonDocument::fromJson( msg_utf8 );
+
+    if ( !doc.isObject() )
+        return;
+
+    const QJsonObject obj = doc.object();
+    const qint64 current_time = QDateTime::currentMSecsSinceEpoch();
+
+    // any message means the connection is healthy
+    wss_heartbeat_time = current_time;
+    wss_reconnect_backoff = BINANCE_WSS_BACKOFF_MIN;
+
+    // subscription response {"result":null,"id":1002}
+    if ( obj.contains( "id" ) )
+    {
+        const qint32 id = obj.value( "id" ).toInt();
+        const bool success = obj.contains( "result" ) && !obj.contains( "error" );
+
+        if ( id == 1000 )
+        {
+            wss_1000_state = success;
+
+            if ( success )
+                kDebug() << getExchangeFancyStr() << "(wss) user data feed active";
+            else
+                kDebug() << getExchangeFancyStr() << "(wss) user data subscribe failed:" << msg;
+        }
+        else if ( id == 1002 )
+        {
+            // mark the feed active after any successful subscribe, failed streams are retried on the next check
+            if ( success )
+                wss_1002_state = true;
+            else
+            {
+                kDebug() << getExchangeFancyStr() << "(wss) bookTicker subscribe failed:" << msg;
+                wss_ticker_streams.clear();
+            }
+        }
+
+        return;
+    }
+
+    // combined stream payload {"stream":"<name>","data":<payload>}
+    const QString &stream = obj.value( "stream" ).toString();
+    const QJsonObject &data = obj.value( "data" ).toObject();
+
+    if ( !listen_key.isEmpty() && stream == listen_key )
+    {
+        wssParseUserData( data );
+        return;
+    }
+
+    // print unhandled message
+    kDebug() << getExchangeFancyStr() << "unhandled wss:" << msg;
+}
+
+bool BncREST::wssParseBookTicker( const QByteArray &msg )
+{
+    // {"stream":"bnbusdt@bookTicker","data":{"u":400900217,"s":"BNBUSDT","b":"25.35190000","B":"31.21000000","a":"25.36520000","A":"40.66000000"}}
+    JsonReader reader( msg );
+    QLatin1String key, stream, symbol;
+    Coin bid, ask;
+
+    if ( !reader.beginObject() )
+        return false;
+
+    while ( reader.nextKey( key ) )
+    {
+        // the stream name comes first, bail out early on anything that isn't a bookTicker
+        if ( key == QLatin1String( "stream" ) )
+        {
+            if ( !reader.readStringView( stream ) || !stream.endsWith( QLatin1String( "@bookTicker" ) ) )
+                return false;
+        }
+        else if ( key == QLatin1String( "data" ) && stream.size() > 0 )
+        {
+            if ( !reader.beginObject() )
+                return false;
+
+            while ( reader.nextKey( key ) )
+            {
+                if ( key == QLatin1String( "s" ) )
+                    reader.readStringView( symbol );
+                else if ( key == QLatin1String( "b" ) )
+                    reader.readCoin( bid );
+                else if ( key == QLatin1String( "a" ) )
+                    reader.readCoin( ask );
+                else
+                    reader.skipValue();
+            }
+        }
+        else if ( !reader.skipValue() )
+        {
+            return false;
+        }
+    }
+
+    if ( reader.hasError() || stream.size() == 0 )
+        return false;
+
+    const QString &market = market_aliases.value( QString( symbol ) );
+
+    // the message was a bookTicker, even if we can't use it
+    if ( market.isEmpty() ||
+         bid.isZeroOrLess() ||
+         ask.isZeroOrLess() )
+        return true;
+
+    QMap<QString, Spread> ticker_info;
+    ticker_info.insert( market, Spread( bid, ask ) );
+    engine->processTicker( this, ticker_info );
+    return true;
+}
+
+void BncREST::wssParseUserData( const QJsonObject &data )
+{
+    const QString &event = data.value( "e" ).toString();
+
+    wss_account_feed_update_time = QDateTime::currentMSecsSinceEpoch();
+
+    // our key expired, get a new one on the next check
+    if ( event == "listenKeyExpired" )
+    {
+        kDebug() << getExchangeFancyStr() << "(wss) listen key expired";
+        listen_key.clear();
+        wss_1000_state = false;
+        return;
+    }
+
+    if ( event != "executionReport" )
+        return;
+
+    // only full fills, cancels are picked up by the cancel replies and openOrders
+    if ( data.value( "X" ).toString() != "FILLED" )
+        return;
+
+    const QString order_id = data.value( "s" ).toString() + data.value( "i" ).toVariant().toString();
+    Position *const &pos = engine->getPositionMan()->getByOrderID( order_id );
+
+    // make sure pos is valid
+    if ( pos == nullptr || pos->is_cancelling )
+        return;
+
+    QVector<Position*> filled_orders;
+    filled_orders += pos;
+
+    engine->processFilledOrders( filled_orders, FILL_WSS );
 }
 
 void BncREST::parseBuySell( Request *const &request, const QJsonObject &response )
@@ -653,13 +1116,103 @@ void BncREST::parseCancelOrder( Request *const &request, const QJsonObject &resp
     engine->processCancelledOrder( pos );
 }
 
-void BncREST::parseOpenOrders( const QJsonArray &markets, qint64 request_time_sent_ms )
+void BncREST::parseCancelAll( const QJsonArray &response )
 {
-    //kDebug() << "got openOrders" << markets;
+    for ( QJsonArray::const_iterator i = response.begin(); i != response.end(); i++ )
+    {
+        const QJsonObject &order = (*i).toObject();
+
+        if ( order.value( "status" ).toString() != "CANCELED" )
+        {
+            kDebug() << getExchangeFancyStr() << "local error: batch cancel failed for order:" << order;
+            continue;
+        }
+
+        // order ids are prefixed with the symbol locally
+        const QString order_number = order.value( "symbol" ).toString() + order.value( "orderId" ).toVariant().toString();
+        Position *const &pos = engine->getPositionMan()->getByOrderID( order_number );
 
+        if ( pos == nullptr || !engine->getPositionMan()->isActive( pos ) )
+        {
+            kDebug() << getExchangeFancyStr() << "successfully cancelled non-local order:" << order;
+            continue;
+        }
+
+        engine->processCancelledOrder( pos );
+    }
+
+    kDebug() << getExchangeFancyStr() << "successfully batch cancelled" << response.size() << "orders";
+}
+
+bool BncREST::decodeOpenOrders( const QByteArray &data, ParsedReply &out )
+{
+    //kDebug() << "got openOrders" << data;
+
+    // [{"symbol":"LTCBTC","orderId":1,"price":"0.1","origQty":"1.0","side":"BUY",...},...]
+    JsonReader reader( data );
+    QLatin1String key;
+
+    if ( !reader.beginArray() )
+        return false;
+
+    while ( reader.nextElement() )
+    {
+        if ( reader.peekType() != JsonReader::TypeObject )
+        {
+            reader.skipValue();
+            continue;
+        }
+
+        QLatin1String market, side;
+        qint64 order_id = -1;
+        Coin price, original_quantity;
+
+        reader.beginObject();
+        while ( reader.nextKey( key ) )
+        {
+            if ( key == QLatin1String( "symbol" ) )
+                reader.readStringView( market );
+            else if ( key == QLatin1String( "orderId" ) )
+                reader.readInt64( order_id );
+            else if ( key == QLatin1String( "side" ) )
+                reader.readStringView( side );
+            else if ( key == QLatin1String( "price" ) )
+                reader.readCoin( price );
+            else if ( key == QLatin1String( "origQty" ) )
+                reader.readCoin( original_quantity );
+            else
+                reader.skipValue();
+        }
+
+        const Coin amount = price * original_quantity;
+
+        // check for missing information
+        if ( market.size() == 0 ||
+             order_id < 0 ||
+             side.size() == 0 ||
+             price.isZeroOrLess() ||
+             amount.isZeroOrLess() )
+            continue;
+
+        ParsedOrder order;
+        order.market = QString( market );
+        order.order_number = order.market + QString::number( order_id );
+        order.side = ( side == QLatin1String( "BUY" ) ) ? SIDE_BUY :
+                     ( side == QLatin1String( "SELL" ) ) ? SIDE_SELL : 0;
+        order.price = price;
+        order.amount = amount;
+
+        out.orders += order;
+    }
+
+    // don't act on a partial list
+    return !reader.hasError();
+}
+
+void BncREST::applyOpenOrders( const ParsedReply &reply )
+{
     const qint64 current_time = QDateTime::currentMSecsSinceEpoch(); // cache time
-    QVector<QString> order_numbers; // keep track of order numbers
-    QMultiHash<QString, OrderInfo> orders;
+    const qint64 &request_time_sent_ms = reply.request_time_sent_ms;
 
     // is the orderbook is too old to be safe? check the stale tolerance
     if ( request_time_sent_ms < current_time - orderbook_stale_tolerance )
@@ -672,41 +1225,32 @@ void BncREST::parseOpenOrders( const QJsonArray &markets, qint64 request_time_se
     if ( request_time_sent_ms < orderbook_update_request_time )
         return;
 
-    // set the timestamp of orderbook update if we saw any orders
-    orderbook_update_time = current_time;
-    orderbook_update_request_time = request_time_sent_ms;
+    QVector<QString> order_numbers; // keep track of order numbers
+    QMultiHash<QString, OrderInfo> orders;
+    order_numbers.reserve( reply.orders.size() );
+    open_orders_by_market.clear();
 
-    for ( QJsonArray::const_iterator i = markets.begin(); i != markets.end(); i++ )
+    for ( QVector<ParsedOrder>::const_iterator i = reply.orders.begin(); i != reply.orders.end(); i++ )
     {
-        // the first level is arrays of orders
-        if ( !(*i).isObject() )
-            continue;
+        const ParsedOrder &order = *i;
 
-        const QJsonObject &order = (*i).toObject();
-        const QString &market = order.value( "symbol" ).toString();
-        const QString &order_number = market + order.value( "orderId" ).toVariant().toString();
-        const QString &side = order.value( "side" ).toString().toLower();
-        const Coin &price = order.value( "price" ).toString();
-        const Coin &original_quantity = order.value( "origQty" ).toString();
-        const Coin &amount = price * original_quantity;
-
-        //kDebug() << market << order_number << side << price << amount;
-
-        // check for missing information
-        if ( market.isEmpty()||
-             order_number.isEmpty() ||
-             side.isEmpty() ||
-             price.isZeroOrLess() ||
-             amount.isZeroOrLess() )
-            continue;
+        //kDebug() << order.market << order.order_number << order.side << order.price << order.amount;
 
         // insert into seen orders
-        order_numbers += order_number;
+        order_numbers += order.order_number;
 
         // insert (market, order)
-        orders.insert( market, OrderInfo( order_number, side == BUY ? SIDE_BUY : side == SELL ? SIDE_SELL : 0, price, amount ) );
+        orders.insert( order.market, OrderInfo( order.order_number, order.side, order.price, order.amount ) );
+
+        // remember every order id for the batch cancel check, keyed by local market
+        open_orders_by_market[ market_aliases.value( order.market, order.market ) ].insert( order.order_number );
     }
 
+    // set the timestamp of orderbook update if we saw any orders
+    orderbook_update_time = current_time;
+    orderbook_update_request_time = request_time_sent_ms;
+    open_orders_request_time = request_time_sent_ms;
+
     engine->processOpenOrders( order_numbers, orders, request_time_sent_ms );
 }
 
@@ -761,19 +1305,57 @@ void BncREST::parseReturnBalances( const QJsonObject &obj )
     kDebug() << "total btc value:" << total_btc_value;
 }
 
-void BncREST::parseTicker( const QJsonArray &info, qint64 request_time_sent_ms )
+bool BncREST::decodeTicker( const QByteArray &data, ParsedReply &out )
 {
-    //kDebug() << info;
+    //kDebug() << data;
 
-    // check for data
-    if ( info.isEmpty() )
-        return;
+    // iterate through each market object, every symbol is kept so we can check it against our aliases
+    // [{"symbol":"LTCBTC","bidPrice":"4.00000000","bidQty":"431.0","askPrice":"4.00000200","askQty":"9.0"},...]
+    JsonReader reader( data );
+    QLatin1String key;
+
+    if ( !reader.beginArray() )
+        return false;
+
+    while ( reader.nextElement() )
+    {
+        if ( reader.peekType() != JsonReader::TypeObject )
+        {
+            reader.skipValue();
+            continue;
+        }
 
+        QLatin1String market_dirty;
+        Coin ask_price, bid_price;
+        out.market_count++;
+
+        reader.beginObject();
+        while ( reader.nextKey( key ) )
+        {
+            if ( key == QLatin1String( "symbol" ) )
+                reader.readStringView( market_dirty );
+            else if ( key == QLatin1String( "askPrice" ) )
+                reader.readCoin( ask_price );
+            else if ( key == QLatin1String( "bidPrice" ) )
+                reader.readCoin( bid_price );
+            else
+                reader.skipValue();
+        }
+
+        out.spreads.insert( QString( market_dirty ), Spread( bid_price, ask_price ) );
+    }
+
+    return !reader.hasError();
+}
+
+void BncREST::applyTicker( const ParsedReply &reply )
+{
     // if we don't have any market aliases loaded, skip for now (wait for getExchangeInfo)
     if ( market_aliases.isEmpty() )
         return;
 
     const qint64 current_time = QDateTime::currentMSecsSinceEpoch();
+    const qint64 &request_time_sent_ms = reply.request_time_sent_ms;
 
     // is the orderbook is too old to be safe? check the stale tolerance
     if ( request_time_sent_ms < current_time - orderbook_stale_tolerance )
@@ -786,20 +1368,17 @@ void BncREST::parseTicker( const QJsonArray &info, qint64 request_time_sent_ms )
     if ( request_time_sent_ms < ticker_update_request_time )
         return;
 
-    ticker_update_request_time = request_time_sent_ms;
+    // check for data
+    if ( reply.market_count == 0 )
+        return;
 
-    // iterate through each market object
     QMap<QString, Spread> ticker_info;
     QVector<QString> market_aliases_not_found;
 
-    for ( QJsonArray::const_iterator i = info.begin(); i != info.end(); i++ )
+    for ( QMap<QString, Spread>::const_iterator i = reply.spreads.begin(); i != reply.spreads.end(); i++ )
     {
-        if ( !(*i).isObject() )
-            continue;
-
-        // read object and key
-        const QJsonObject &market_obj = (*i).toObject();
-        const QString &market_dirty = market_obj[ "symbol" ].toString();
+        const QString &market_dirty = i.key();
+        const Spread &spread = i.value();
 
         if ( !market_aliases.contains( market_dirty ) )
         {
@@ -809,25 +1388,19 @@ void BncREST::parseTicker( const QJsonArray &info, qint64 request_time_sent_ms )
 
         const QString &market = market_aliases.value( market_dirty );
 
-        if ( !market_obj.contains( "askPrice" ) ||
-             !market_obj.contains( "bidPrice" ) )
-            continue;
-
-        // the object has two arrays of arrays [[1,2],[3,4]]
-        const Coin ask_price = market_obj[ "askPrice" ].toString();
-        const Coin bid_price = market_obj[ "bidPrice" ].toString();
-
-        //kDebug() << market << bid_price << ask_price;
+        //kDebug() << market << spread.bid << spread.ask;
 
         // update our maps
         if ( !market.isEmpty() &&
-             bid_price.isGreaterThanZero() &&
-             ask_price.isGreaterThanZero() )
+             spread.bid.isGreaterThanZero() &&
+             spread.ask.isGreaterThanZero() )
         {
-            ticker_info.insert( market, Spread( bid_price, ask_price ) );
+            ticker_info.insert( market, spread );
         }
     }
 
+    ticker_update_request_time = request_time_sent_ms;
+
     if ( !market_aliases_not_found.isEmpty() )
     {
         kDebug() << getExchangeFancyStr() << "local warning: couldn't find market alias for markets" << market_aliases_not_found;
@@ -837,6 +1410,21 @@ void BncREST::parseTicker( const QJsonArray &info, qint64 request_time_sent_ms )
     engine->processTicker( this, ticker_info, request_time_sent_ms );
 }
 
+void BncREST::onReplyParsed( const ParsedReply &reply )
+{
+    if ( reply.ok )
+    {
+        if ( reply.api_command == BNC_COMMAND_GETORDERS )
+            applyOpenOrders( reply );
+        else if ( reply.api_command == BNC_COMMAND_GETTICKER )
+            applyTicker( reply );
+
+        return;
+    }
+
+    printReplyError( reply );
+}
+
 void BncREST::parseExchangeInfo( const QJsonObject &obj )
 {
     const QJsonArray &rate_limits = obj[ "rateLimits" ].toArray();
@@ -861,8 +1449,6 @@ void BncREST::parseExchangeInfo( const QJsonObject &obj )
         else if ( interval == "SECOND" && limit > 3 )
         {
             ratelimit_second = limit - 2; // be nice, subtract 2 from limit
-            send_timer->setInterval( 1000 / ( ratelimit_second ) );
-            //qDebug() << "send_timer interval set to" << send_timer->interval();
         }
         else if ( interval == "DAY" && limit > 101 )
         {
@@ -870,6 +1456,8 @@ void BncREST::parseExchangeInfo( const QJsonObject &obj )
         }
     }
 
+    setRateLimits();
+
     for ( QJsonArray::const_iterator i = symbols.begin(); i != symbols.end(); i++ )
     {
         if ( !(*i).isObject() )
@@ -902,7 +1490,10 @@ void BncREST::parseExchangeInfo( const QJsonObject &obj )
                 //qDebug() << "price ticksize" << price_tick;
 
                 if ( price_tick.isGreaterThanZero() )
+                {
                     market_info.price_ticksize = price_tick;
+                    market_info.position_index.setPriceTicksize( price_tick );
+                }
                 else
                     kDebug() << getExchangeFancyStr() << "local error: failed to parse 'tickSize'" << filter;
             }
@@ -939,5 +1530,11 @@ void BncREST::parseExchangeInfo( const QJsonObject &obj )
     {
         exchangeinfo_timer->setInterval( exchangeinfo_interval );
         onCheckTicker();
+
+#if !defined( EXCHANGE_SIM_ENABLED )
+        // now that we have market aliases, start the websocket
+        wss_timer->start( BINANCE_TIMER_INTERVAL_WSS_CHECK );
+        wssCheckConnection();
+#endif
     }
 }
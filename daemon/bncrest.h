@@ -5,6 +5,7 @@
 #include <QQueue>
 #include <QHash>
 #include <QMap>
+#include <QSet>
 
 #include "global.h"
 #include "position.h"
@@ -32,30 +33,46 @@ public:
     void sendNamRequest( Request *const &request );
     void sendBuySell( Position *const &pos, bool quiet = true );
     void sendCancel( const QString &_order_id, Position *const &pos = nullptr );
+    bool sendBatchCancel( const Market &market, const QVector<Request*> &cancels ) override;
     void sendGetOrder( const QString &_order_id, Position *const &pos = nullptr );
     void parseBuySell( Request *const &request, const QJsonObject &response );
     void parseCancelOrder( Request *const &request, const QJsonObject &response );
-    void parseOpenOrders( const QJsonArray &markets, qint64 request_time_sent_ms );
+    void parseCancelAll( const QJsonArray &response );
+    static bool decodeOpenOrders( const QByteArray &data, ParsedReply &out );
+    void applyOpenOrders( const ParsedReply &reply );
     void parseReturnBalances( const QJsonObject &obj );
-    void parseTicker( const QJsonArray &info, qint64 request_time_sent_ms );
+    static bool decodeTicker( const QByteArray &data, ParsedReply &out );
+    void applyTicker( const ParsedReply &reply );
     void parseExchangeInfo( const QJsonObject &obj );
+    void parseListenKey( const QJsonObject &obj );
     void wssSendJsonObj( const QJsonObject &obj );
+    bool wssParseBookTicker( const QByteArray &msg );
+    void wssParseUserData( const QJsonObject &data );
+    void wssCheckListenKey();
+    QSet<QString> getWssTickerStreams() const;
+
+    bool getWSS1000State() const { return wss_1000_state; }
 
     void checkBotOrders( bool ignore_flow_control = false );
 
+    RateClass getRateClass( Request *const &request ) const override;
+    Coin getRequestPriority( Request *const &request ) const override;
+    void setRateLimits();
+
 public Q_SLOTS:
-    void sendNamQueue();
-    void onNamReply( QNetworkReply *const &reply );
+    void sendNamQueue() override;
+    void onNamReply( QNetworkReply *const &reply ) override;
+    void onReplyParsed( const ParsedReply &reply ) override;
 
-    void onCheckRateLimit();
     void onCheckBotOrders();
     void onCheckTicker();
     void onCheckExchangeInfo();
 
     void wssConnected();
     void wssCheckConnection();
-    void wssTextMessageReceived( const QString &msg );
+    void wssTextMessageReceived( const QString &msg ) override;
     void wssSendSubscriptions();
+    void wssPong( quint64 elapsed_time );
 
 private:
     QMap<QString, QString> market_aliases;
@@ -64,19 +81,25 @@ private:
     qint64 wss_connect_try_time{ 0 },
            wss_heartbeat_time{ 0 },
            wss_account_feed_update_time{ 0 },
-           wss_safety_delay_time{ 2000 }; // only detect a wss filled order after this amount of time - for possible wss lag
+           wss_safety_delay_time{ 2000 }, // only detect a wss filled order after this amount of time - for possible wss lag
+           wss_reconnect_backoff{ BINANCE_WSS_BACKOFF_MIN },
+           wss_1000_subscribe_try_time{ 0 },
+           listen_key_time{ 0 }; // last time the listen key was created or kept alive
 
     bool wss_1000_state{ false }, // account subscription
          wss_1002_state{ false }; // ticker subscription
 
+    QString listen_key; // user data stream key
+    QSet<QString> wss_ticker_streams; // bookTicker streams we have subscribed to
+
     // rate limit stuff
-    qint32 binance_weight{ 0 }, // current weight
-           ratelimit_second{ 10 }, // orders limit
+    qint32 ratelimit_second{ 10 }, // orders limit
            ratelimit_minute{ 600 }, // weight limit
            ratelimit_day{ 100000 }; // orders limit
 
     QTimer *exchangeinfo_timer{ nullptr };
-    QTimer *ratelimit_timer{ nullptr };
+    QTimer *wss_timer{ nullptr };
+    QWebSocket *wss{ nullptr };
 };
 
 #endif // BNCREST_H
@@ -15,6 +15,14 @@
 #define POLONIEX_TICKER_ONLY
 //#define WAVES_TICKER_ONLY
 
+/// network options
+#define NETWORK_HTTP2_ENABLED // multiplex requests over one connection per host, for exchanges that support it
+#define NETWORK_PER_EXCHANGE_ENABLED // give each exchange its own network manager, so replies are read on its own http thread
+//#define ENGINE_THREADS_ENABLED // run each exchange's engine and rest module on its own thread with its own network manager (see enginethread.h)
+
+/// offline testing
+//#define EXCHANGE_SIM_ENABLED // answer exchange requests with the local simulator instead of the network (see simexchange.h)
+
 /// where to print logs
 #define PRINT_LOGS_TO_CONSOLE
 //#define PRINT_LOGS_TO_FILE
@@ -27,6 +35,7 @@
 //#define PRINT_LOGS_WITH_FUNCTION_NAMES
 #define PRINT_ENABLED_SSL_CIPHERS
 //#define PRINT_DISABLED_SSL_CIPHERS
+//#define PRINT_STARTUP_BENCHMARKS // time the hot codecs against their reference implementations after the tests pass
 
 /// spread expansion on fill
 #define SPREAD_EXPAND_FULL // expand to trade price
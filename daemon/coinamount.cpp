@@ -6,7 +6,7 @@
 
 #include <QString>
 #include <QDebug>
-#include <QThread>
+#include <QVarLengthArray>
 
 static inline QString qrealToSubsatoshis( qreal r )
 {
@@ -308,9 +308,8 @@ Coin::operator QString() const
 
 QString Coin::toString( const int decimals = Coin::subsatoshi_decimals ) const
 {
-    // thread-safe static opt
-    static QMap<Qt::HANDLE, std::vector<char>> buffer_map;
-    std::vector<char> &buffer = buffer_map[ QThread::currentThreadId() ];
+    // thread-safe static opt, one buffer per thread
+    static thread_local std::vector<char> buffer;
 
     // resize the buffer to how many base10 bytes we'll need
     size_t buffer_size = mpz_sizeinbase( b, Coin::str_base ) +2; // "two extra bytes for a possible minus sign, and null-terminator."
@@ -529,3 +528,57 @@ Coin Coin::ticksizeFromDecimals( int dec )
 
     return ret;
 }
+
+bool Coin::fromDecimal( const char *data, const int size, Coin &out )
+{
+    // sign, integer digits and subsatoshi fraction digits, in mpz_set_str format
+    QVarLengthArray<char, 64> digits;
+    bool has_digit = false;
+    int i = 0;
+
+    if ( size > 0 && data[ 0 ] == '-' )
+    {
+        digits.append( '-' );
+        i++;
+    }
+
+    // integer part
+    for ( ; i < size && data[ i ] >= '0' && data[ i ] <= '9'; i++ )
+    {
+        digits.append( data[ i ] );
+        has_digit = true;
+    }
+
+    // fraction part, truncated to subsatoshi precision
+    int fraction_digits = 0;
+    if ( i < size && data[ i ] == '.' )
+    {
+        for ( i++; i < size && data[ i ] >= '0' && data[ i ] <= '9'; i++ )
+        {
+            has_digit = true;
+
+            if ( fraction_digits < Coin::subsatoshi_decimals )
+            {
+                digits.append( data[ i ] );
+                fraction_digits++;
+            }
+        }
+    }
+
+    // leave scientific notation to the string path
+    if ( has_digit && i < size && ( data[ i ] == 'e' || data[ i ] == 'E' ) )
+    {
+        out = QString::fromLatin1( data, size );
+        return true;
+    }
+
+    if ( !has_digit || i != size )
+        return false;
+
+    for ( ; fraction_digits < Coin::subsatoshi_decimals; fraction_digits++ )
+        digits.append( '0' );
+
+    digits.append( '\0' );
+
+    return mpz_set_str( out.b, digits.constData(), Coin::str_base ) == 0;
+}
@@ -79,6 +79,9 @@ public:
     Coin truncatedByTicksize( QString ticksize );
     static Coin ticksizeFromDecimals( int dec );
 
+    // parse a plain decimal straight from bytes without the QString round trip, returns false on junk
+    static bool fromDecimal( const char *data, const int size, Coin &out );
+
     static const int str_base = 10;
     static const int subsatoshi_decimals = 16;
     static const int satoshi_decimals = 8;
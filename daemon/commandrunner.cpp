@@ -1,6 +1,7 @@
 #include "commandrunner.h"
 #include "global.h"
 #include "engine.h"
+#include "enginethread.h"
 #include "enginesettings.h"
 #include "trexrest.h"
 #include "polorest.h"
@@ -13,6 +14,8 @@
 #include "spruceoverseer.h"
 #include "priceaggregator.h"
 #include "coinamount.h"
+#include "position.h"
+#include "tradingsnapshot.h"
 
 #include <functional>
 #include <QString>
@@ -23,6 +26,9 @@
 #include <QHash>
 #include <QObject>
 #include <QTimer>
+#include <QThread>
+#include <QMetaObject>
+#include <QDebug>
 
 CommandRunner::CommandRunner( const quint8 _engine_type, Engine *_e, QVector<BaseREST*> _rest_arr, QObject *parent )
     : QObject( parent ),
@@ -83,6 +89,7 @@ CommandRunner::CommandRunner( const quint8 _engine_type, Engine *_e, QVector<Bas
     command_map.insert( "setslippagestaletime", std::bind( &CommandRunner::command_setslippagestaletime, this, _1 ) );
     command_map.insert( "setqueuedcommandsmax", std::bind( &CommandRunner::command_setqueuedcommandsmax, this, _1 ) );
     command_map.insert( "setqueuedcommandsmaxdc", std::bind( &CommandRunner::command_setqueuedcommandsmaxdc, this, _1 ) );
+    command_map.insert( "setbatchcancels", std::bind( &CommandRunner::command_setbatchcancels, this, _1 ) );
     command_map.insert( "setsentcommandsmax", std::bind( &CommandRunner::command_setsentcommandsmax, this, _1 ) );
     command_map.insert( "settimeoutyield", std::bind( &CommandRunner::command_settimeoutyield, this, _1 ) );
     command_map.insert( "setrequesttimeout", std::bind( &CommandRunner::command_setrequesttimeout, this, _1 ) );
@@ -115,9 +122,13 @@ CommandRunner::CommandRunner( const quint8 _engine_type, Engine *_e, QVector<Bas
     command_map.insert( "getstatus", std::bind( &CommandRunner::command_getstatus, this, _1 ) );
     command_map.insert( "getconfig", std::bind( &CommandRunner::command_getconfig, this, _1 ) );
     command_map.insert( "getinternal", std::bind( &CommandRunner::command_getinternal, this, _1 ) );
+    command_map.insert( "getlatency", std::bind( &CommandRunner::command_getlatency, this, _1 ) );
+    command_map.insert( "setcapture", std::bind( &CommandRunner::command_setcapture, this, _1 ) );
+    command_map.insert( "replaycapture", std::bind( &CommandRunner::command_replaycapture, this, _1 ) );
     command_map.insert( "setmaintenancetime", std::bind( &CommandRunner::command_setmaintenancetime, this, _1 ) );
     command_map.insert( "clearallstats", std::bind( &CommandRunner::command_clearallstats, this, _1 ) );
     command_map.insert( "savemarket", std::bind( &CommandRunner::command_savemarket, this, _1 ) );
+    command_map.insert( "savemarkets", std::bind( &CommandRunner::command_savemarkets, this, _1 ) );
     command_map.insert( "save", std::bind( &CommandRunner::command_save, this, _1 ) );
     command_map.insert( "sendcommand", std::bind( &CommandRunner::command_sendcommand, this, _1 ) );
     command_map.insert( "setchatty", std::bind( &CommandRunner::command_setchatty, this, _1 ) );
@@ -137,6 +148,19 @@ CommandRunner::~CommandRunner()
 
 void CommandRunner::runCommandChunk( QString &s )
 {
+#if defined( ENGINE_THREADS_ENABLED )
+    // the engine's settings chunk is emitted on its thread from init(), the trader runs it here once init() is done
+    if ( QThread::currentThread() != thread() )
+    {
+        deferred_chunks += s;
+        return;
+    }
+#endif
+
+    // commands run here on the main thread. only this runner's engine is parked, so they can read it while the other
+    // engines keep going, and engine commands run on its thread (see isMainThreadCommand())
+    EngineParkLock engine_lock( engine );
+
     QQueue<QStringList> commands;
     QMap<QString, qint32> times_called; // count of commands called
     QMap<QString, qint32> positions_added; // count of positions set in each market
@@ -205,9 +229,17 @@ void CommandRunner::runCommandChunk( QString &s )
         if ( args.size() > 1 && cmd == "setorder" )
             positions_added[ args.value( 1 ) ]++;
 
+        // only commands that can change the state make the next read rebuild the snapshot
+        if ( SnapshotReader::isStateChangingCommand( cmd ) )
+            snapshot_dirty = true;
+
         // run command
         std::function<void(QStringList&)> _func = command_map.value( cmd );
-        _func( args );
+
+        if ( isMainThreadCommand( cmd ) )
+            _func( args );
+        else
+            engine->runOnEngineThread( [&]() { _func( args ); } );
     }
 
     // avoid addPosition() spam by logging stuff about 'setorder' here
@@ -225,6 +257,34 @@ void CommandRunner::runCommandChunk( QString &s )
     }
 }
 
+void CommandRunner::runDeferredChunks()
+{
+    while ( !deferred_chunks.isEmpty() )
+    {
+        QString chunk = deferred_chunks.takeFirst();
+        runCommandChunk( chunk );
+    }
+}
+
+bool CommandRunner::isMainThreadCommand( const QString &command )
+{
+    // strategy, alpha, snapshot and exit commands stay on the main thread with the objects they use. everything else
+    // can send requests or touch the rest module's timers, so it runs where the engine lives.
+    return SnapshotReader::isReadOnlyCommand( command ) ||
+           command.startsWith( QLatin1String( "setspruce" ) ) ||
+           command.startsWith( QLatin1String( "getspruce" ) ) ||
+           command == QLatin1String( "spruceup" ) ||
+           command == QLatin1String( "setpricetracking" ) ||
+           command == QLatin1String( "getmidspreadstatus" ) ||
+           command == QLatin1String( "getbuyselltotal" ) ||
+           command == QLatin1String( "getdailyvolume" ) ||
+           command == QLatin1String( "setalphamanual" ) ||
+           command == QLatin1String( "save" ) ||
+           command == QLatin1String( "exit" ) ||
+           command == QLatin1String( "stop" ) ||
+           command == QLatin1String( "quit" );
+}
+
 bool CommandRunner::checkArgs( const QStringList &args, qint32 expected_args_min, qint32 expected_args_max )
 {
     expected_args_min++; // add one for command arg
@@ -256,6 +316,190 @@ bool CommandRunner::checkArgs( const QStringList &args, qint32 expected_args_min
     return true;
 }
 
+void CommandRunner::serveFromSnapshot( QStringList &args )
+{
+    // normalize the market arg here, the reader only compares strings
+    if ( args.size() > 1 && !args.at( 1 ).isEmpty() && args.at( 1 ) != ALL )
+        args[ 1 ] = Market( args.at( 1 ) );
+
+    // every read in the chunk is served from one snapshot, once the chunk is done
+    if ( pending_reads.isEmpty() )
+        QTimer::singleShot( 0, this, &CommandRunner::onPublishSnapshot );
+
+    pending_reads += args;
+    pending_sections |= SnapshotReader::getSections( args.value( 0 ).toLower() );
+}
+
+void CommandRunner::onPublishSnapshot()
+{
+    // the snapshot only reads the engine, parking it is enough
+    EngineParkLock engine_lock( engine );
+
+    const TradingSnapshotPtr current = snapshot_publisher.acquire();
+
+    // reuse the last snapshot if nothing changed it, it's recent, and it has what the reads need
+    if ( !current ||
+         snapshot_dirty ||
+         QDateTime::currentMSecsSinceEpoch() - current->time_ms >= TRADING_SNAPSHOT_MAX_AGE_MS ||
+         ( current->sections & pending_sections ) != pending_sections )
+        publishSnapshot( pending_sections );
+
+    for ( QVector<QStringList>::const_iterator i = pending_reads.begin(); i != pending_reads.end(); i++ )
+    {
+        // no reader thread, format here
+        if ( snapshot_reader == nullptr )
+        {
+            const QStringList lines = SnapshotReader::format( *snapshot_publisher.acquire(), *i );
+
+            for ( QStringList::const_iterator j = lines.begin(); j != lines.end(); j++ )
+                kDebug() << *j;
+
+            continue;
+        }
+
+        snapshot_reader->serve( &snapshot_publisher, *i );
+    }
+
+    pending_reads.clear();
+    pending_sections = 0;
+}
+
+void CommandRunner::publishSnapshot( const quint8 sections )
+{
+    std::shared_ptr<TradingSnapshot> snapshot = std::make_shared<TradingSnapshot>();
+    snapshot->engine_type = engine_type;
+    snapshot->sections = sections;
+    snapshot->sequence = ++snapshot_sequence;
+    snapshot->time_ms = QDateTime::currentMSecsSinceEpoch();
+
+    /// ticker status
+    if ( sections & SnapshotTickerStatus )
+    {
+        const qint64 time_thresh = snapshot->time_ms -
+                                  ( BITTREX_TIMER_INTERVAL_TICKER +
+                                    BINANCE_TIMER_INTERVAL_TICKER +
+                                    POLONIEX_TIMER_INTERVAL_TICKER );
+
+        for ( int i = 0; i < rest_arr.size(); i++ )
+        {
+            if ( rest_arr.at( i ) != nullptr )
+                snapshot->ticker_status += QString( "%1%2%3 | " )
+                                           .arg( rest_arr.at( i )->ticker_update_time > time_thresh ? COLOR_GREEN : COLOR_RED )
+                                           .arg( rest_arr.at( i )->exchange_string )
+                                           .arg( COLOR_NONE );
+        }
+
+        if ( !snapshot->ticker_status.isEmpty() )
+            snapshot->ticker_status.chop( 3 );
+    }
+
+    /// market config
+    if ( sections & ( SnapshotMarketConfig | SnapshotPositions ) )
+    {
+        const QHash<QString, MarketInfo> &market_info = engine->getMarketInfoStructure();
+        for ( QHash<QString, MarketInfo>::const_iterator i = market_info.begin(); i != market_info.end(); i++ )
+        {
+            MarketSnapshot &m = snapshot->markets[ i.key() ];
+            m.ping_pong_indices = i.value().position_index.size();
+
+            if ( sections & SnapshotMarketConfig )
+                m.config = i.value();
+        }
+    }
+
+    if ( sections & SnapshotPositions )
+        fillPositionsSnapshot( *snapshot );
+
+    if ( sections & SnapshotInternal )
+        fillInternalSnapshot( *snapshot );
+
+    /// spruce targets and alpha
+    if ( sections & SnapshotSpruceTargets )
+    {
+        QString line;
+        QDebug( &line ).noquote() << "target" << spruce_overseer->spruce->getBaseCurrency() << "amounts:"
+                                  << spruce_overseer->spruce->getTargetAmounts();
+        snapshot->spruce_targets += line;
+        line.clear();
+
+        QDebug( &line ).noquote() << "target percentages:" << spruce_overseer->spruce->getTargetPercentages();
+        snapshot->spruce_targets += line;
+    }
+
+    if ( sections & SnapshotAlpha )
+        snapshot->alpha = engine->alpha->getAlphaReadout();
+
+    snapshot_publisher.publish( std::move( snapshot ) );
+    snapshot_dirty = false;
+}
+
+void CommandRunner::fillPositionsSnapshot( TradingSnapshot &snapshot )
+{
+    /// positions, in one pass
+    PositionMan *positions = engine->getPositionMan();
+    QHash<QString, Coin> hi_buys, lo_sells;
+
+    for ( QSet<Position*>::const_iterator i = positions->all().begin(); i != positions->all().end(); i++ )
+    {
+        Position *const &pos = *i;
+        const QString market = pos->market;
+        MarketSnapshot &m = snapshot.markets[ market ];
+
+        if ( pos->is_onetime )
+            m.onetime++;
+
+        if ( positions->isQueued( *i ) )
+        {
+            m.queued++;
+            continue;
+        }
+
+        if ( pos->side == SIDE_BUY )
+        {
+            m.active_buys++;
+
+            if ( !hi_buys.contains( market ) || pos->price > hi_buys.value( market ) )
+                hi_buys[ market ] = pos->price;
+        }
+        else
+        {
+            m.active_sells++;
+
+            if ( !lo_sells.contains( market ) || pos->price < lo_sells.value( market ) )
+                lo_sells[ market ] = pos->price;
+        }
+    }
+
+    for ( QHash<QString, Coin>::const_iterator i = hi_buys.begin(); i != hi_buys.end(); i++ )
+        snapshot.markets[ i.key() ].hi_buy = i.value();
+
+    for ( QHash<QString, Coin>::const_iterator i = lo_sells.begin(); i != lo_sells.end(); i++ )
+        snapshot.markets[ i.key() ].lo_sell = i.value();
+}
+
+void CommandRunner::fillInternalSnapshot( TradingSnapshot &snapshot )
+{
+    /// internal state
+    BaseREST *rest = rest_arr.value( engine_type );
+
+    snapshot.internal += engine->getInternalReadout();
+    snapshot.internal += QString( "nam_queue size: %1" ).arg( rest->nam_queue.size() );
+    snapshot.internal += QString( "nam_queue_sent size: %1" ).arg( rest->nam_queue_sent.size() );
+    snapshot.internal += QString( "orderbook_update_time: %1" ).arg( QDateTime::fromMSecsSinceEpoch( rest->orderbook_update_time ).toString() );
+    snapshot.internal += QString( "orderbook_update_request_time: %1" ).arg( QDateTime::fromMSecsSinceEpoch( rest->orderbook_update_request_time ).toString() );
+    snapshot.internal += QString( "ticker_update_time: %1" ).arg( QDateTime::fromMSecsSinceEpoch( rest->ticker_update_time ).toString() );
+    snapshot.internal += QString( "ticker_update_request_time: %1" ).arg( QDateTime::fromMSecsSinceEpoch( rest->ticker_update_request_time ).toString() );
+    snapshot.internal += rest->latency.getSummary();
+    snapshot.internal += QString( "orders_stale_trip_count: %1" ).arg( rest->orders_stale_trip_count );
+    snapshot.internal += QString( "books_stale_trip_count: %1" ).arg( rest->books_stale_trip_count );
+    snapshot.internal += QString( "request nonce: %1" ).arg( rest->request_nonce );
+    snapshot.internal += Global::getBuildString();
+
+    QString line;
+    QDebug( &line ).noquote() << spruce_overseer->spruce->getMarketsBeta();
+    snapshot.internal += line;
+}
+
 void CommandRunner::command_getbalances( QStringList & )
 {
     if ( engine_type == ENGINE_BITTREX )
@@ -401,8 +645,7 @@ void CommandRunner::command_getorders( QStringList &args )
 
 void CommandRunner::command_getpositions( QStringList &args )
 {
-    Q_UNUSED( args )
-    //stats->printPositions( Market( args.value( 1 ) ) );
+    serveFromSnapshot( args );
 }
 
 void CommandRunner::command_getordersbyindex( QStringList &args )
@@ -550,8 +793,7 @@ void CommandRunner::command_getdailyfills( QStringList &args )
 
 void CommandRunner::command_getalpha( QStringList &args )
 {
-    Q_UNUSED( args )
-    kDebug() << engine->alpha->getAlphaReadout();
+    serveFromSnapshot( args );
 }
 
 void CommandRunner::command_setalphamanual( QStringList &args )
@@ -811,6 +1053,14 @@ void CommandRunner::command_setqueuedcommandsmaxdc( QStringList &args )
     kDebug() << "limit_commands_queued_dc_check set to" << rest_arr.at( engine_type )->limit_commands_queued_dc_check;
 }
 
+void CommandRunner::command_setbatchcancels( QStringList &args )
+{
+    if ( !checkArgs( args, 1 ) ) return;
+
+    rest_arr.at( engine_type )->batch_cancels_enabled = args.value( 1 ) == "true" ? true : false;
+    kDebug() << "batch_cancels_enabled set to" << rest_arr.at( engine_type )->batch_cancels_enabled;
+}
+
 void CommandRunner::command_setsentcommandsmax( QStringList &args )
 {
     if ( !checkArgs( args, 1 ) ) return;
@@ -870,6 +1120,18 @@ void CommandRunner::command_setsprucebasecurrency( QStringList &args )
 
     spruce_overseer->spruce->setBaseCurrency( args.value( 1 ) );
     kDebug() << "spruce base currency is now" << spruce_overseer->spruce->getBaseCurrency();
+
+    // every engine prices its fills in it, hand each one a copy on its own thread
+    const QString base_currency = spruce_overseer->spruce->getBaseCurrency();
+
+    for ( QVector<BaseREST*>::const_iterator i = rest_arr.begin(); i != rest_arr.end(); i++ )
+    {
+        if ( *i == nullptr )
+            continue;
+
+        Engine *rest_engine = (*i)->engine;
+        rest_engine->runOnEngineThread( [rest_engine, base_currency]() { rest_engine->spruce_base_currency = base_currency; } );
+    }
 }
 
 void CommandRunner::command_setspruceqty( QStringList &args )
@@ -1127,11 +1389,7 @@ void CommandRunner::command_getsprucebasecapital( QStringList &args )
 
 void CommandRunner::command_getsprucetargets( QStringList &args )
 {
-    Q_UNUSED( args )
-
-    kDebug() << "target" << spruce_overseer->spruce->getBaseCurrency() << "amounts:"
-             << spruce_overseer->spruce->getTargetAmounts();
-    kDebug() << "target percentages:" << spruce_overseer->spruce->getTargetPercentages();
+    serveFromSnapshot( args );
 }
 
 void CommandRunner::command_getmidspreadstatus( QStringList &args )
@@ -1146,50 +1404,12 @@ void CommandRunner::command_getmidspreadstatus( QStringList &args )
 
 void CommandRunner::command_getstatus( QStringList &args )
 {
-    Q_UNUSED( args )
-
-    const qint64 current_time = QDateTime::currentMSecsSinceEpoch();
-    const qint64 time_thresh = current_time -
-                              ( BITTREX_TIMER_INTERVAL_TICKER +
-                                BINANCE_TIMER_INTERVAL_TICKER +
-                                POLONIEX_TIMER_INTERVAL_TICKER );
-
-    QString ticker_status;
-
-    for ( int i = 0; i < rest_arr.size(); i++ )
-    {
-        if ( rest_arr.at( i ) != nullptr )
-            ticker_status += QString( "%1%2%3 | " )
-                             .arg( rest_arr.at( i )->ticker_update_time > time_thresh ? COLOR_GREEN : COLOR_RED )
-                             .arg( rest_arr.at( i )->exchange_string )
-                             .arg( COLOR_NONE );
-    }
-
-    if ( !ticker_status.isEmpty() )
-        ticker_status.chop( 3 );
-
-    kDebug() << ticker_status;
+    serveFromSnapshot( args );
 }
 
 void CommandRunner::command_getconfig( QStringList &args )
 {
-    QString market = Market( args.value( 1 ) );
-
-    // print all market options
-    if ( market.isEmpty() || market == ALL )
-    {
-        for ( QHash<QString, MarketInfo>::iterator i = engine->getMarketInfoStructure().begin(); i != engine->getMarketInfoStructure().end(); i++ )
-        {
-            kDebug() << QString( "%1 %2" )
-                        .arg( i.key(), -10 )
-                        .arg( i.value() );
-        }
-    }
-    else // print only one market, and return (we supplied a market, don't print global options)
-    {
-        kDebug() << engine->getMarketInfoStructure().value( market );
-        return;
-    }
+    serveFromSnapshot( args );
 
 //    kDebug() << "limit_commands_queued =" << rest->limit_commands_queued;
 //    kDebug() << "limit_commands_queued_dc_check =" << rest->limit_commands_queued_dc_check;
@@ -1221,25 +1441,50 @@ void CommandRunner::command_getconfig( QStringList &args )
 }
 
 void CommandRunner::command_getinternal( QStringList &args )
+{
+    serveFromSnapshot( args );
+}
+
+void CommandRunner::command_getlatency( QStringList &args )
 {
     Q_UNUSED( args )
-    engine->printInternal();
 
     BaseREST *rest = rest_arr.value( engine_type );
+    const QStringList lines = rest->latency.getReport( QDateTime::currentMSecsSinceEpoch() );
 
-    kDebug() << "nam_queue size:" << rest->nam_queue.size();
-    kDebug() << "nam_queue_sent size:" << rest->nam_queue_sent.size();
-    kDebug() << "orderbook_update_time:" << QDateTime::fromMSecsSinceEpoch( rest->orderbook_update_time ).toString();
-    kDebug() << "orderbook_update_request_time:" << QDateTime::fromMSecsSinceEpoch( rest->orderbook_update_request_time ).toString();
-    kDebug() << "ticker_update_time:" << QDateTime::fromMSecsSinceEpoch( rest->ticker_update_time ).toString();
-    kDebug() << "ticker_update_request_time:" << QDateTime::fromMSecsSinceEpoch( rest->ticker_update_request_time ).toString();
-    kDebug() << "avg response time:" << rest->avg_response_time.avgResponseTime();
-    kDebug() << "orders_stale_trip_count: " << rest->orders_stale_trip_count;
-    kDebug() << "books_stale_trip_count: " << rest->books_stale_trip_count;
-    kDebug() << "request nonce:" << rest->request_nonce;
-    kDebug() << Global::getBuildString();
+    for ( QStringList::const_iterator i = lines.begin(); i != lines.end(); i++ )
+        kDebug() << *i;
 
-    kDebug() << spruce_overseer->spruce->getMarketsBeta();
+    kDebug() << QString( "in flight: cancel %1/%2 order %3/%4 query %5/%6 public %7/%8" )
+                .arg( rest->session->getInFlight( RateCancel ) )
+                .arg( rest->session->getInFlightLimit( RateCancel ) )
+                .arg( rest->session->getInFlight( RateOrder ) )
+                .arg( rest->session->getInFlightLimit( RateOrder ) )
+                .arg( rest->session->getInFlight( RateQuery ) )
+                .arg( rest->session->getInFlightLimit( RateQuery ) )
+                .arg( rest->session->getInFlight( RatePublic ) )
+                .arg( rest->session->getInFlightLimit( RatePublic ) );
+}
+
+void CommandRunner::command_setcapture( QStringList &args )
+{
+    if ( !checkArgs( args, 1, 2 ) ) return;
+
+    BaseREST *rest = rest_arr.value( engine_type );
+
+    // setcapture true [path], the default path is in the trader directory
+    if ( args.value( 1 ) == "true" )
+        rest->startCapture( args.value( 2 ) );
+    else
+        rest->stopCapture();
+}
+
+void CommandRunner::command_replaycapture( QStringList &args )
+{
+    if ( !checkArgs( args, 1, 2 ) ) return;
+
+    // replaycapture <path> [speed], a speed of 0 (the default) replays as fast as possible
+    rest_arr.value( engine_type )->startReplay( args.value( 1 ), args.value( 2 ).toDouble() );
 }
 
 void CommandRunner::command_setmaintenancetime( QStringList &args )
@@ -1268,6 +1513,11 @@ void CommandRunner::command_savemarket( QStringList &args )
     engine->saveMarket( Market( args.value( 1 ) ), args.value( 2 ).toInt() );
 }
 
+void CommandRunner::command_savemarkets( QStringList &args )
+{
+    engine->saveMarkets( args.value( 1 ).toInt() );
+}
+
 void CommandRunner::command_save( QStringList &args )
 {
     Q_UNUSED( args )
@@ -1293,5 +1543,11 @@ void CommandRunner::command_setchatty( QStringList &args )
 void CommandRunner::command_exit( QStringList &args )
 {
     Q_UNUSED( args )
+
+#if defined( ENGINE_THREADS_ENABLED )
+    // the trader deletes the engine threads, let the chunk finish and unpark the engine first
+    QMetaObject::invokeMethod( this, [this]() { emit exitSignal(); }, Qt::QueuedConnection );
+#else
     emit exitSignal();
+#endif
 }
@@ -1,6 +1,8 @@
 #ifndef COMMANDRUNNER_H
 #define COMMANDRUNNER_H
 
+#include "tradingsnapshot.h"
+
 #include <functional>
 
 #include <QObject>
@@ -35,9 +37,19 @@ signals:
 public slots:
     void runCommandChunk( QString &s );
 
+public:
+    void runDeferredChunks(); // runs the chunks an engine emitted from its own thread
+
 private:
+    static bool isMainThreadCommand( const QString &command );
     bool checkArgs( const QStringList &args, qint32 expected_args_min, qint32 expected_args_max = -1 ); // -1 sets max=min
 
+    void serveFromSnapshot( QStringList &args ); // queues the command until the chunk has run
+    void onPublishSnapshot(); // serves the queued commands, rebuilding only if we must
+    void publishSnapshot( const quint8 sections );
+    void fillPositionsSnapshot( TradingSnapshot &snapshot );
+    void fillInternalSnapshot( TradingSnapshot &snapshot );
+
     void command_getbalances( QStringList &args );
     void command_getlastprices( QStringList &args );
     void command_getbuyselltotal( QStringList &args );
@@ -89,6 +101,7 @@ private:
     void command_setslippagestaletime( QStringList &args );
     void command_setqueuedcommandsmax( QStringList &args );
     void command_setqueuedcommandsmaxdc( QStringList &args );
+    void command_setbatchcancels( QStringList &args );
     void command_setsentcommandsmax( QStringList &args );
     void command_settimeoutyield( QStringList &args );
     void command_setrequesttimeout( QStringList &args );
@@ -122,9 +135,13 @@ private:
     void command_getstatus( QStringList &args );
     void command_getconfig( QStringList &args );
     void command_getinternal( QStringList &args );
+    void command_getlatency( QStringList &args );
+    void command_setcapture( QStringList &args );
+    void command_replaycapture( QStringList &args );
     void command_setmaintenancetime( QStringList &args );
     void command_clearallstats( QStringList &args );
     void command_savemarket( QStringList &args );
+    void command_savemarkets( QStringList &args );
     void command_save( QStringList &args );
     void command_sendcommand( QStringList &args );
     void command_setchatty( QStringList &args );
@@ -138,6 +155,15 @@ private:
     Engine *engine{ nullptr };
     SpruceOverseer *spruce_overseer{ nullptr };
     PriceAggregator *price_aggregator{ nullptr };
+    QStringList deferred_chunks; // with ENGINE_THREADS_ENABLED, settings chunks emitted during init()
+
+    // read-only commands are formatted from a snapshot on the reader thread
+    SnapshotReader *snapshot_reader{ nullptr };
+    SnapshotPublisher snapshot_publisher;
+    QVector<QStringList> pending_reads; // read-only commands waiting for onPublishSnapshot()
+    quint8 pending_sections{ 0 }; // the sections they read
+    quint64 snapshot_sequence{ 0 };
+    bool snapshot_dirty{ true }; // a command that may have changed the state ran since the last snapshot
 };
 
 #endif // COMMANDRUNNER_H
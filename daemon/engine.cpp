@@ -9,6 +9,8 @@
 #include "market.h"
 #include "alphatracker.h"
 #include "sprucev2.h"
+#include "priceaggregator.h"
+#include "enginethread.h"
 
 #include <algorithm>
 #include <QtMath>
@@ -23,6 +25,10 @@
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QTimer>
+#include <QSaveFile>
+#include <QBitArray>
+#include <QMetaObject>
+#include <QCoreApplication>
 
 Engine::Engine( const quint8 _engine_type )
     : QObject( nullptr ),
@@ -220,8 +226,8 @@ Position *Engine::addPosition( QString market_input, quint8 side, QString buy_pr
     if ( !is_onetime && !is_active )
         return nullptr;
 
-    // make position object
-    Position *const &pos = new Position( market, side, buy_price, sell_price, order_size, strategy_tag, indices, landmark, this );
+    // make position object inside the pool
+    Position *const &pos = positions->getPool().create( market, side, buy_price, sell_price, order_size, strategy_tag, indices, landmark, this );
 
     // check for correctly loaded position data and size
     if (  pos == nullptr ||
@@ -232,7 +238,7 @@ Position *Engine::addPosition( QString market_input, quint8 side, QString buy_pr
     {
         kDebug() << getEngineTypeFancyStr() << "local warning: failed to set order because of invalid value:" << market << pos->side << pos->buy_price << pos->sell_price << pos->amount << pos->quantity << indices << landmark;
         if ( pos != nullptr )
-            delete pos;
+            positions->getPool().release( pos );
 
         return nullptr;
     }
@@ -247,6 +253,7 @@ Position *Engine::addPosition( QString market_input, quint8 side, QString buy_pr
     if ( pos->amount < minimum_order_size - CoinAmount::SATOSHI )
     {
         kDebug() << getEngineTypeFancyStr() << "local warning: failed to set order: size" << pos->amount << "is under the minimum size" << minimum_order_size;
+        positions->getPool().release( pos );
         return nullptr;
     }
 
@@ -263,7 +270,7 @@ Position *Engine::addPosition( QString market_input, quint8 side, QString buy_pr
         {
             if ( pos->is_onetime ) // if ping-pong, don't warn
                 kDebug() << getEngineTypeFancyStr() << "local warning: hit PERCENT_PRICE limit for" << market << buy_limit << sell_limit << "for pos" << pos->stringifyOrderWithoutOrderID();
-            delete pos;
+            positions->getPool().release( pos );
             return nullptr;
         }
     }
@@ -391,6 +398,8 @@ void Engine::fillNQ( const QString &order_id, qint8 fill_type , quint8 extra_dat
             info.spread.bid = new_price;
         else if ( pos->side == SIDE_SELL && pos->price > info.spread.ask )
             info.spread.ask = new_price;
+
+        pushSpread( pos->market, info.spread );
     }
 
     // increment ping-pong "alternate_size" variable to take the place of order_size after 1 fill
@@ -401,7 +410,7 @@ void Engine::fillNQ( const QString &order_id, qint8 fill_type , quint8 extra_dat
             continue;
 
         // increment fill count and resize by alternate size if one exists
-        info.position_index[ pos->market_indices.value( i ) ].iterateFillCount();
+        info.position_index.iterateFillCount( pos->market_indices.value( i ) );
     }
 
     QString fill_str = fill_strings.value( fill_type -1, "unknown" );
@@ -427,7 +436,8 @@ void Engine::updateStatsAndPrintFill( const QString &fill_type, Market market, c
                                       const QString &strategy_tag, Coin amount, Coin quantity, Coin price,
                                       const Coin &btc_commission )
 {
-    const QString base_currency = ( spruce->getBaseCurrency() == "disabled" ) ? "BTC" : spruce->getBaseCurrency();
+    // spruce lives on the main thread, use our own copy of its base currency
+    const QString base_currency = ( spruce_base_currency.isEmpty() || spruce_base_currency == "disabled" ) ? "BTC" : spruce_base_currency;
 
     // check for valid inputs. amount or quantity must exist, and all others must be valid
     if ( amount.isZeroOrLess() && quantity.isZeroOrLess() )
@@ -506,36 +516,44 @@ void Engine::updateStatsAndPrintFill( const QString &fill_type, Market market, c
         quantity = amount / price;
     }
 
-    // add stats changes to alpha tracker (note: volume before commission is used)
-    alpha->addAlpha( market, side, amount, price );
-    alpha->addDailyVolume( QDateTime::currentSecsSinceEpoch(), amount );
+    // alpha and spruce live on the main thread. this is a direct call unless the engine has its own thread
+    AlphaTracker *const alpha_tracker = alpha;
+    SpruceV2 *const spruce_strategy = spruce;
+    const qint64 fill_time = QDateTime::currentSecsSinceEpoch();
 
-//    if ( strategy_tag.contains( "flux" ) )
-//    {
-    // beta order, adjust both quantities. assume all fills are strategy orders
-    if ( alpha_market_0.isValid() && alpha_market_1.isValid() )
+    QMetaObject::invokeMethod( QCoreApplication::instance(), [=]()
     {
-        const Coin quantity_offset_0 = ( side == SIDE_BUY ) ? -market_0_quantity
-                                                            :  market_0_quantity;
-        const Coin quantity_offset_1 = ( side == SIDE_BUY ) ?  quantity
-                                                            : -quantity;
+        // add stats changes to alpha tracker (note: volume before commission is used)
+        alpha_tracker->addAlpha( market, side, amount, price );
+        alpha_tracker->addDailyVolume( fill_time, amount );
 
-        spruce->adjustCurrentQty( alpha_market_0.getQuote(), quantity_offset_0 );
-        spruce->adjustCurrentQty( alpha_market_1.getQuote(), quantity_offset_1 );
-    }
-    // normal order, subtract the qty of the alt (base doesn't need changing)
-    else
-    {
-        // add qty changes to spruce strat
-        const Coin quantity_offset = ( side == SIDE_BUY ) ?  quantity
-                                                          : -quantity;
-        const Coin amount_offset = ( side == SIDE_BUY ) ? -amount
-                                                        :  amount;
+//        if ( strategy_tag.contains( "flux" ) )
+//        {
+        // beta order, adjust both quantities. assume all fills are strategy orders
+        if ( alpha_market_0.isValid() && alpha_market_1.isValid() )
+        {
+            const Coin quantity_offset_0 = ( side == SIDE_BUY ) ? -market_0_quantity
+                                                                :  market_0_quantity;
+            const Coin quantity_offset_1 = ( side == SIDE_BUY ) ?  quantity
+                                                                : -quantity;
 
-        spruce->adjustCurrentQty( market.getQuote(), quantity_offset );
-        spruce->adjustCurrentQty( market.getBase(), amount_offset );
-    }
-//    }
+            spruce_strategy->adjustCurrentQty( alpha_market_0.getQuote(), quantity_offset_0 );
+            spruce_strategy->adjustCurrentQty( alpha_market_1.getQuote(), quantity_offset_1 );
+        }
+        // normal order, subtract the qty of the alt (base doesn't need changing)
+        else
+        {
+            // add qty changes to spruce strat
+            const Coin quantity_offset = ( side == SIDE_BUY ) ?  quantity
+                                                              : -quantity;
+            const Coin amount_offset = ( side == SIDE_BUY ) ? -amount
+                                                            :  amount;
+
+            spruce_strategy->adjustCurrentQty( market.getQuote(), quantity_offset );
+            spruce_strategy->adjustCurrentQty( market.getBase(), amount_offset );
+        }
+//        }
+    } );
 
     if ( getVerbosity() > 0 )
     {
@@ -796,6 +814,39 @@ void Engine::processOpenOrders( QVector<QString> &order_numbers, QMultiHash<QStr
     }
 }
 
+void Engine::pushSpread( const QString &market, const Spread &spread )
+{
+    if ( price_aggregator == nullptr )
+        return;
+
+#if defined( ENGINE_THREADS_ENABLED )
+    // the aggregator is on the main thread, send the spreads from this event together once it's handled
+    if ( pending_spreads.isEmpty() )
+        QMetaObject::invokeMethod( this, [this]() { flushSpreads(); }, Qt::QueuedConnection );
+
+    pending_spreads[ market ] = spread;
+#else
+    price_aggregator->onExchangeSpread( engine_type, market, spread );
+#endif
+}
+
+void Engine::flushSpreads()
+{
+    if ( pending_spreads.isEmpty() )
+        return;
+
+    PriceAggregator *const aggregator = price_aggregator;
+    const quint8 type = engine_type;
+    const QMap<QString, Spread> spreads = pending_spreads;
+    pending_spreads.clear();
+
+    QMetaObject::invokeMethod( aggregator, [aggregator, type, spreads]()
+    {
+        for ( QMap<QString, Spread>::const_iterator i = spreads.begin(); i != spreads.end(); i++ )
+            aggregator->onExchangeSpread( type, i.key(), i.value() );
+    }, Qt::QueuedConnection );
+}
+
 void Engine::processTicker( BaseREST *base_rest_module, const QMap<QString, Spread> &ticker_data, qint64 request_time_sent_ms )
 {
     const qint64 current_time = QDateTime::currentMSecsSinceEpoch();
@@ -803,12 +854,22 @@ void Engine::processTicker( BaseREST *base_rest_module, const QMap<QString, Spre
     // update ticker update time
     base_rest_module->ticker_update_time = current_time;
 
+    // direct unless the engine has its own thread
+    if ( price_aggregator != nullptr )
+    {
+        PriceAggregator *const aggregator = price_aggregator;
+        const quint8 type = engine_type;
+
+        QMetaObject::invokeMethod( aggregator, [aggregator, type, current_time]() { aggregator->onExchangeTicker( type, current_time ); } );
+    }
+
 //    kDebug() << getEngineTypeFancyStr() << "processing ticker" << ticker_data.keys();
 
-    // store deleted positions, because we can't delete and iterate a hash<>
+    // markets whose spread moved since the last ticker
+    QVector<QString> changed_markets;
+
     for ( QMap<QString, Spread>::const_iterator i = ticker_data.begin(); i != ticker_data.end(); i++ )
     {
-        const Market market = i.key();
         const Spread &spread = i.value();
         const Coin &ask = spread.ask;
         const Coin &bid = spread.bid;
@@ -817,17 +878,25 @@ void Engine::processTicker( BaseREST *base_rest_module, const QMap<QString, Spre
         if ( ask.isZeroOrLess() || bid.isZeroOrLess() )
             continue;
 
-        // update values for market
-        MarketInfo &info = market_info[ market ];
+        MarketInfo &info = market_info[ i.key() ];
+
+        // skip unchanged markets, the inverse cross below is still valid
+        if ( info.is_tradeable &&
+             info.spread.bid == bid &&
+             info.spread.ask == ask )
+            continue;
 
+        // update values for market
         info.spread.bid = bid;
         info.spread.ask = ask;
         info.is_tradeable = true;
 
-        // TODO: make this faster
+        changed_markets += i.key();
+        pushSpread( i.key(), info.spread );
+
         // update values for inverse market, if it is not tradeable
-        Market market_inverse = market.getInverse();
-        MarketInfo &info_inverse = market_info[ market_inverse ];
+        const Market market = i.key();
+        MarketInfo &info_inverse = market_info[ market.getInverse() ];
 
         // if it doesn't have an active ticker, update it with the inverse market ticker
         if ( !info_inverse.is_tradeable )
@@ -835,6 +904,7 @@ void Engine::processTicker( BaseREST *base_rest_module, const QMap<QString, Spre
             // cross prices
             info_inverse.spread.bid = CoinAmount::COIN / ask;
             info_inverse.spread.ask = CoinAmount::COIN / bid;
+            pushSpread( market.getInverse(), info_inverse.spread );
 
             // cross ticksizes (probably not needed)
 //            info_inverse.price_ticksize = info.quantity_ticksize;
@@ -842,21 +912,52 @@ void Engine::processTicker( BaseREST *base_rest_module, const QMap<QString, Spre
         }
     }
 
+    // when we skip the fill check, the next ticker won't see these as moved, so remember the ones we have orders in
+    auto rememberChangedMarkets = [ this, &changed_markets ]()
+    {
+        for ( QVector<QString>::const_iterator i = changed_markets.begin(); i != changed_markets.end(); i++ )
+            if ( !positions->activeByMarket( *i ).isEmpty() )
+                ticker_recheck_markets.insert( *i );
+    };
+
     // if this is a ticker feed, just process the ticker data. the fill feed will cause false fills when the ticker comes in just as new positions were set,
     // because we have no request time to compare the position set time to.
     if ( request_time_sent_ms <= 0 )
+    {
+        rememberChangedMarkets();
         return;
+    }
 
     if ( engine_type == ENGINE_POLONIEX )
     {
         // if we read the ticker from anywhere and the websocket account feed is active, prevent it from filling positions (websocket feed is instant for fill notifications anyways)
         if ( reinterpret_cast<PoloREST*>( rest_arr.value( ENGINE_POLONIEX ) )->getWSS1000State() )
+        {
+            rememberChangedMarkets(); // in case the feed drops
             return;
+        }
+    }
+    else if ( engine_type == ENGINE_BINANCE )
+    {
+        // same for the binance user data stream
+        if ( reinterpret_cast<BncREST*>( rest_arr.value( ENGINE_BINANCE ) )->getWSS1000State() )
+        {
+            rememberChangedMarkets(); // in case the feed drops
+            return;
+        }
     }
 
     if ( engine_type == ENGINE_POLONIEX ||
          engine_type == ENGINE_BINANCE )
     {
+        // besides moved markets, recheck markets with orders set since the last check or orders we skipped as too new
+        QSet<QString> check_markets = positions->takeActivatedMarkets();
+        check_markets.unite( ticker_recheck_markets );
+        ticker_recheck_markets.clear();
+
+        for ( QVector<QString>::const_iterator i = changed_markets.begin(); i != changed_markets.end(); i++ )
+            check_markets.insert( *i );
+
         QVector<Position*> filled_orders;
 
         // did we find bid == ask (we shouldn't have)
@@ -864,14 +965,10 @@ void Engine::processTicker( BaseREST *base_rest_module, const QMap<QString, Spre
 
         // check for any orders that could've been filled
         // (note: removed because ping-pong is deprecated, history-fill is preferred)
-        for ( QSet<Position*>::const_iterator j = positions->active().begin(); j != positions->active().end(); j++ )
+        for ( QSet<QString>::const_iterator i = check_markets.begin(); i != check_markets.end(); i++ )
         {
-            Position *const &pos = *j;
+            const QString &market = *i;
 
-            if ( pos == nullptr )
-                continue;
-
-            const QString &market = pos->market;
             if ( market.isEmpty() || !ticker_data.contains( market ) )
                 continue;
 
@@ -880,6 +977,15 @@ void Engine::processTicker( BaseREST *base_rest_module, const QMap<QString, Spre
             const Coin &ask = spread.ask;
             const Coin &bid = spread.bid;
 
+            // check for missing information
+            if ( ask.isZeroOrLess() || bid.isZeroOrLess() )
+                continue;
+
+            const QSet<Position*> market_positions = positions->activeByMarket( market );
+
+            if ( market_positions.isEmpty() )
+                continue;
+
             // check for equal bid/ask
             if ( ask <= bid )
             {
@@ -887,37 +993,42 @@ void Engine::processTicker( BaseREST *base_rest_module, const QMap<QString, Spre
                 continue;
             }
 
-            // check for missing information
-            if ( ask.isZeroOrLess() || bid.isZeroOrLess() )
-                continue;
-
-            // check for position price collision with ticker prices
-            quint8 fill_details = 0;
-            if      ( pos->side == SIDE_SELL && pos->sell_price <= bid ) // sell price <= hi buy
-                fill_details = 1;
-            else if ( pos->side == SIDE_BUY  && pos->buy_price >= ask ) // buy price => lo sell
-                fill_details = 2;
-            else if ( pos->side == SIDE_SELL && pos->sell_price < ask ) // sell price < lo sell
-                fill_details = 3;
-            else if ( pos->side == SIDE_BUY  && pos->buy_price > bid ) // buy price > hi buy
-                fill_details = 4;
-
-            if ( fill_details > 0 )
+            for ( QSet<Position*>::const_iterator j = market_positions.begin(); j != market_positions.end(); j++ )
             {
-                // is the order pretty new?
-                if ( pos->order_set_time > request_time_sent_ms - settings->ticker_safety_delay_time || // if the request time is supplied, check that we didn't send the ticker command before the position was set
-                     pos->order_set_time > current_time - settings->ticker_safety_delay_time ) // allow for a safe period to avoid orders we just set possibly not showing up yet
+                Position *const &pos = *j;
+
+                // check for position price collision with ticker prices
+                quint8 fill_details = 0;
+                if      ( pos->side == SIDE_SELL && pos->sell_price <= bid ) // sell price <= hi buy
+                    fill_details = 1;
+                else if ( pos->side == SIDE_BUY  && pos->buy_price >= ask ) // buy price => lo sell
+                    fill_details = 2;
+                else if ( pos->side == SIDE_SELL && pos->sell_price < ask ) // sell price < lo sell
+                    fill_details = 3;
+                else if ( pos->side == SIDE_BUY  && pos->buy_price > bid ) // buy price > hi buy
+                    fill_details = 4;
+
+                if ( fill_details > 0 )
                 {
-                    // skip the order until it's a few seconds older
-                    continue;
-                }
+                    // is the order pretty new?
+                    if ( pos->order_set_time > request_time_sent_ms - settings->ticker_safety_delay_time || // if the request time is supplied, check that we didn't send the ticker command before the position was set
+                         pos->order_set_time > current_time - settings->ticker_safety_delay_time ) // allow for a safe period to avoid orders we just set possibly not showing up yet
+                    {
+                        // skip the order until it's a few seconds older, and look at this market again next time even if the spread doesn't move
+                        ticker_recheck_markets.insert( market );
+                        continue;
+                    }
 
-                // check that we weren't cancelling the order
-                if ( pos->order_cancel_time > 0 || pos->is_cancelling )
-                    continue;
+                    // check that we weren't cancelling the order, and look again next time in case the cancel fails
+                    if ( pos->order_cancel_time > 0 || pos->is_cancelling )
+                    {
+                        ticker_recheck_markets.insert( market );
+                        continue;
+                    }
 
-                // add to filled orders
-                filled_orders += pos;
+                    // add to filled orders
+                    filled_orders += pos;
+                }
             }
         }
 
@@ -949,7 +1060,7 @@ void Engine::processCancelledOrder( Position * const &pos )
         }
         else
         {
-            const PositionData &new_pos = market_info[ pos->market ].position_index.value( pos->market_indices.value( 0 ) );
+            const PositionData new_pos = market_info[ pos->market ].position_index.value( pos->market_indices.value( 0 ) );
 
             addPosition( pos->market, pos->side, new_pos.buy_price, new_pos.sell_price, new_pos.order_size, ACTIVE, "",
                          pos->market_indices, false, true );
@@ -1039,7 +1150,7 @@ void Engine::cancelOrderMeatDCOrder( Position * const &pos )
                     continue;
 
                 // get position data
-                const PositionData &data = info.position_index.value( idx );
+                const PositionData data = info.position_index.value( idx );
 
                 // create a list with one single index, we can't use the constructor because it's an int
                 QVector<qint32> new_index_single;
@@ -1067,112 +1178,197 @@ void Engine::saveMarket( QString market, qint32 num_orders )
     if ( num_orders < 15 )
         num_orders = 15;
 
-    // open dump file
-    QString path = Global::getTraderPath() + QDir::separator() + QString( "index-%1.txt" ).arg( market );
-    QFile savefile( path );
+    // mark active indices in one pass over the positions
+    const QHash<QString, MarketSaveState> states = collectMarketSaveStates( market );
 
-    if ( !savefile.open( QIODevice::WriteOnly | QIODevice::Text ) )
+    QString out;
+    qint32 saved_market_count = 0;
+    for ( QHash<QString, MarketInfo>::const_iterator i = market_info.begin(); i != market_info.end(); i++ )
     {
-        kDebug() << getEngineTypeFancyStr() << "local error: couldn't open savemarket file" << path;
+        const QString &current_market = i.key();
+
+        // apply our market filter
+        if ( market != ALL && current_market != market )
+            continue;
+
+        if ( current_market.isEmpty() || i.value().position_index.isEmpty() )
+            continue;
+
+        if ( appendMarketSave( out, current_market, i.value().position_index, states.value( current_market ), num_orders ) > 0 )
+            saved_market_count++;
+    }
+
+    // if we didn't save any markets, just exit
+    if ( saved_market_count == 0 )
+    {
+        kDebug() << getEngineTypeFancyStr() << "no markets saved";
         return;
     }
 
-    QTextStream out_savefile( &savefile );
+    writeSaveFile( Global::getTraderPath() + QDir::separator() + QString( "index-%1.txt" ).arg( market ), out );
+}
+
+void Engine::saveMarkets( qint32 num_orders )
+{
+    // enforce minimum orders
+    if ( num_orders < 15 )
+        num_orders = 15;
+
+    // mark active indices for every market in one pass over the positions
+    const QHash<QString, MarketSaveState> states = collectMarketSaveStates( ALL );
 
     qint32 saved_market_count = 0;
+    QString out;
     for ( QHash<QString, MarketInfo>::const_iterator i = market_info.begin(); i != market_info.end(); i++ )
     {
         const QString &current_market = i.key();
-        const MarketInfo &info = i.value();
-        const QVector<PositionData> &list = info.position_index;
 
-        // apply our market filter
-        if ( market != ALL && current_market != market )
+        if ( current_market.isEmpty() || i.value().position_index.isEmpty() )
+            continue;
+
+        // reuse the buffer's allocation between markets
+        out.resize( 0 );
+
+        if ( appendMarketSave( out, current_market, i.value().position_index, states.value( current_market ), num_orders ) == 0 )
             continue;
 
-        if ( current_market.isEmpty() || list.isEmpty() )
+        if ( writeSaveFile( Global::getTraderPath() + QDir::separator() + QString( "index-%1.txt" ).arg( current_market ), out ) )
+            saved_market_count++;
+    }
+
+    kDebug() << getEngineTypeFancyStr() << "saved" << saved_market_count << "markets";
+}
+
+QHash<QString, MarketSaveState> Engine::collectMarketSaveStates( const QString &market_filter ) const
+{
+    QHash<QString, MarketSaveState> states;
+
+    for ( QSet<Position*>::const_iterator j = positions->all().begin(); j != positions->all().end(); j++ )
+    {
+        Position *const &pos = *j;
+
+        // apply our market filter
+        if ( market_filter != ALL && pos->market != market_filter )
             continue;
 
-        // store buy and sell indices
-        qint32 highest_sell_idx = 0, lowest_sell_idx = std::numeric_limits<qint32>::max();
-        QVector<qint32> buys, sells;
+        const bool is_sell = ( pos->side == SIDE_SELL );
 
-        for ( QSet<Position*>::const_iterator j = positions->all().begin(); j != positions->all().end(); j++ )
+        // size the bitsets to the index on first sight of this market
+        QHash<QString, MarketSaveState>::iterator state_it = states.find( pos->market );
+        if ( state_it == states.end() )
         {
-            Position *const &pos = *j;
+            const QHash<QString, MarketInfo>::const_iterator info_it = market_info.constFind( pos->market );
+            const qint32 index_size = ( info_it == market_info.constEnd() ) ? 0 : info_it.value().position_index.size();
 
-            // skip other markets
-            if ( pos->market != current_market )
-                continue;
+            state_it = states.insert( pos->market, MarketSaveState() );
+            state_it.value().buys.resize( index_size );
+            state_it.value().sells.resize( index_size );
+        }
 
-            bool is_sell = ( pos->side == SIDE_SELL );
+        MarketSaveState &state = state_it.value();
 
-            for ( QVector<qint32>::const_iterator k = pos->market_indices.begin(); k != pos->market_indices.end(); k++ )
+        for ( QVector<qint32>::const_iterator k = pos->market_indices.begin(); k != pos->market_indices.end(); k++ )
+        {
+            const qint32 idx = *k;
+            state.has_indices = true;
+
+            if ( is_sell )
             {
-                if ( is_sell )
-                {
-                    sells.append( *k );
-                    if ( *k > highest_sell_idx ) highest_sell_idx = *k;
-                    if ( *k < lowest_sell_idx ) lowest_sell_idx = *k;
-                }
-                else
-                    buys.append( *k );
+                if ( idx > state.highest_sell_idx ) state.highest_sell_idx = idx;
+                if ( idx < state.lowest_sell_idx ) state.lowest_sell_idx = idx;
             }
-        }
 
-        // bad index check
-        if ( buys.isEmpty() && sells.isEmpty() )
-        {
-            kDebug() << getEngineTypeFancyStr() << "local error: couldn't buy or sell indices for market" << current_market;
-            continue;
+            // indices outside of the grid can't be saved
+            if ( idx < 0 || idx >= state.buys.size() )
+                continue;
+
+            if ( is_sell )
+                state.sells.setBit( idx );
+            else
+                state.buys.setBit( idx );
         }
+    }
 
-        // save each index as setorder
-        qint32 current_index = 0;
-        for ( QVector<PositionData>::const_iterator j = list.begin(); j != list.end(); j++ )
-        {
-            const PositionData &pos_data = *j;
+    return states;
+}
+
+qint32 Engine::appendMarketSave( QString &out, const QString &market, const PositionIndex &list, const MarketSaveState &state, const qint32 num_orders ) const
+{
+    // bad index check
+    if ( !state.has_indices )
+    {
+        kDebug() << getEngineTypeFancyStr() << "local error: couldn't buy or sell indices for market" << market;
+        return 0;
+    }
+
+    const qint32 bits_size = state.buys.size();
+
+    // each line is roughly "setorder <market> sell <price> <price> <size>/<size> active\n"
+    out.reserve( out.size() + list.size() * ( market.size() + 80 ) );
 
-            bool is_active = ( sells.contains( current_index ) || buys.contains( current_index ) ) &&
-                             current_index > lowest_sell_idx - num_orders &&
-                             current_index < lowest_sell_idx + num_orders;
+    // save each index as setorder
+    qint32 current_index = 0;
+    for ( ; current_index < list.size(); current_index++ )
+    {
+        const bool in_bits = current_index < bits_size;
+        const bool is_active_sell = in_bits && state.sells.testBit( current_index );
+        const bool is_active_buy = in_bits && state.buys.testBit( current_index );
 
-            bool is_sell = sells.contains( current_index ) || // is active sell
-                        ( current_index > highest_sell_idx && highest_sell_idx > 0 ); // is ghost sell
+        const bool is_active = ( is_active_sell || is_active_buy ) &&
+                               current_index > state.lowest_sell_idx - num_orders &&
+                               current_index < state.lowest_sell_idx + num_orders;
 
-            // if the order has an "alternate_size", append it to preserve the state
-            QString order_size = pos_data.order_size;
-            if ( !pos_data.alternate_size.isEmpty() )
-                order_size += QString( "/%1" ).arg( pos_data.alternate_size );
+        const bool is_sell = is_active_sell || // is active sell
+                           ( current_index > state.highest_sell_idx && state.highest_sell_idx > 0 ); // is ghost sell
 
-            out_savefile << QString( "setorder %1 %2 %3 %4 %5 %6\n" )
-                            .arg( current_market )
-                            .arg( is_sell ? SELL : BUY )
-                            .arg( pos_data.buy_price )
-                            .arg( pos_data.sell_price )
-                            .arg( order_size )
-                            .arg( is_active ? ACTIVE : GHOST );
+        out += QLatin1String( "setorder " );
+        out += market;
+        out += QChar( ' ' );
+        out += is_sell ? SELL : BUY;
+        out += QChar( ' ' );
+        PositionIndex::appendSatoshis( out, list.buyPrice( current_index ) );
+        out += QChar( ' ' );
+        PositionIndex::appendSatoshis( out, list.sellPrice( current_index ) );
+        out += QChar( ' ' );
+        PositionIndex::appendSatoshis( out, list.orderSize( current_index ) );
 
-            current_index++;
+        // if the order has an "alternate_size", append it to preserve the state
+        if ( list.alternateSize( current_index ) > 0 )
+        {
+            out += QChar( '/' );
+            PositionIndex::appendSatoshis( out, list.alternateSize( current_index ) );
         }
 
-        // track number of saved markets
-        if ( current_index > 0 )
-            saved_market_count++;
+        out += QChar( ' ' );
+        out += is_active ? ACTIVE : GHOST;
+        out += QChar( '\n' );
+    }
+
+    kDebug() << getEngineTypeFancyStr() << "saved market" << market << "with" << current_index << "indices";
 
-        kDebug() << getEngineTypeFancyStr() << "saved market" << current_market << "with" << current_index << "indices";
+    return current_index;
+}
+
+bool Engine::writeSaveFile( const QString &path, const QString &data ) const
+{
+    // write to a temporary file and rename it over the old one on commit
+    QSaveFile savefile( path );
+
+    if ( !savefile.open( QIODevice::WriteOnly | QIODevice::Text ) )
+    {
+        kDebug() << getEngineTypeFancyStr() << "local error: couldn't open savemarket file" << path;
+        return false;
     }
 
-    // if we didn't save any markets, just exit
-    if ( saved_market_count == 0 )
+    const QByteArray bytes = data.toUtf8();
+
+    if ( savefile.write( bytes ) != bytes.size() || !savefile.commit() )
     {
-        kDebug() << getEngineTypeFancyStr() << "no markets saved";
-        return;
+        kDebug() << getEngineTypeFancyStr() << "local error: couldn't write savemarket file" << path << savefile.errorString();
+        return false;
     }
 
-    // save the buffer
-    out_savefile.flush();
-    savefile.close();
+    return true;
 }
 
 void Engine::loadSettings()
@@ -1217,7 +1413,7 @@ void Engine::flipPosition( Position *const &pos )
     else // normal pos
     {
         // we could use the same prices, but instead we reset the data incase there was slippage
-        const PositionData &new_data = market_info[ pos->market ].position_index.value( pos->market_indices.value( 0 ) );
+        const PositionData new_data = market_info[ pos->market ].position_index.value( pos->market_indices.value( 0 ) );
 
         addPosition( pos->market, pos->side, new_data.buy_price, new_data.sell_price, new_data.order_size, ACTIVE, "",
                      pos->market_indices, false, true );
@@ -1263,13 +1459,36 @@ void Engine::checkMaintenance()
     kDebug() << getEngineTypeFancyStr() << "maintenance routine finished";
 }
 
-void Engine::printInternal()
+QStringList Engine::getInternalReadout() const
 {
-    kDebug() << "maintenance_time:" << maintenance_time;
-    kDebug() << "maintenance_triggered:" << maintenance_triggered;
+    QStringList ret;
+    QString line;
 
-    kDebug() << "diverge_converge: " << positions->getDCPending();
-    kDebug() << "diverging_converging: " << positions->getDCMap();
+    QDebug( &line ).noquote() << "maintenance_time:" << maintenance_time;
+    ret += line;
+    line.clear();
+
+    QDebug( &line ).noquote() << "maintenance_triggered:" << maintenance_triggered;
+    ret += line;
+    line.clear();
+
+    QDebug( &line ).noquote() << "diverge_converge: " << positions->getDCPending();
+    ret += line;
+    line.clear();
+
+    QDebug( &line ).noquote() << "diverging_converging: " << positions->getDCMap();
+    ret += line;
+
+    return ret;
+}
+
+void Engine::runOnEngineThread( const std::function<void()> &job )
+{
+    // anything that sends requests has to run where the rest module lives
+    if ( engine_thread == nullptr )
+        job();
+    else
+        engine_thread->runJob( job );
 }
 
 bool Engine::isOrderBookResponsive() const
@@ -1333,6 +1552,8 @@ void Engine::findBetterPrice( Position *const &pos )
         // avoid collision
         if ( info.spread.ask <= info.spread.bid )
             info.spread.bid = info.spread.ask - info.price_ticksize;
+
+        pushSpread( market, info.spread );
     }
     // adjust hi_buy
     else if ( settings->should_adjust_hibuy_losell &&
@@ -1351,6 +1572,8 @@ void Engine::findBetterPrice( Position *const &pos )
         // avoid collision
         if ( info.spread.bid >= info.spread.ask )
             info.spread.ask = info.spread.bid + info.price_ticksize;
+
+        pushSpread( market, info.spread );
     }
 
     quint8 haggle_type = 0;
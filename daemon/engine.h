@@ -6,28 +6,44 @@
 #include "baserest.h"
 #include "coinamount.h"
 
+#include <functional>
+
 #include <QString>
+#include <QStringList>
 #include <QVector>
 #include <QMap>
 #include <QHash>
 #include <QMultiHash>
+#include <QSet>
 #include <QObject>
 #include <QNetworkReply>
 #include <QDateTime>
+#include <QBitArray>
 
 class SpruceV2;
 class CommandRunner;
 class CommandListener;
 class AlphaTracker;
+class PriceAggregator;
 class QTimer;
 class PositionMan;
 class EngineSettings;
+class EngineThread;
 
 class TrexREST;
 class BncREST;
 class PoloREST;
 class WavesREST;
 
+// active ping-pong indices of one market, collected in a single pass over the positions for saveMarket()
+struct MarketSaveState
+{
+    QBitArray buys, sells;
+    qint32 highest_sell_idx{ 0 };
+    qint32 lowest_sell_idx{ std::numeric_limits<qint32>::max() };
+    bool has_indices{ false };
+};
+
 class Engine : public QObject
 {
     Q_OBJECT
@@ -52,6 +68,7 @@ public:
     void processCancelledOrder( Position *const &pos );
 
     void saveMarket( QString market, qint32 num_orders = 15 );
+    void saveMarkets( qint32 num_orders = 15 );
     void loadSettings();
 
     QString getEngineTypeFancyStr() const { return QString( "[Engine %1]" ).arg( engine_type_str ); }
@@ -66,7 +83,7 @@ public:
                                              engine_type == ENGINE_WAVES    ? Global::getWavesSettingsPath() :
                                                                                QString(); }
 
-    void printInternal();
+    QStringList getInternalReadout() const;
 
     void setMaintenanceTime( qint64 time ) { maintenance_time = time; }
     qint64 getMaintenanceTime() const { return maintenance_time; }
@@ -102,13 +119,18 @@ public:
 
     BaseREST *getRestBase() const { return rest_arr.value( engine_type ); }
 
+    void runOnEngineThread( const std::function<void()> &job );
+
     QVector<QString/*order_id*/> orders_for_polling;
 
     QString engine_type_str;
     quint8 engine_type{ 0 };
     SpruceV2 *spruce{ nullptr };
+    QString spruce_base_currency; // a copy of spruce's base currency, set by setsprucebasecurrency on our thread
     QVector<BaseREST*> rest_arr;
     AlphaTracker *alpha{ nullptr };
+    PriceAggregator *price_aggregator{ nullptr };
+    EngineThread *engine_thread{ nullptr }; // set with ENGINE_THREADS_ENABLED
 
 signals:
     void newEngineMessage( QString &str ); // new wss message
@@ -123,14 +145,23 @@ private:
     void cleanGraceTimes();
     void checkMaintenance();
 
+    // savemarket routines
+    QHash<QString, MarketSaveState> collectMarketSaveStates( const QString &market_filter ) const;
+    qint32 appendMarketSave( QString &out, const QString &market, const PositionIndex &list, const MarketSaveState &state, const qint32 num_orders ) const;
+    bool writeSaveFile( const QString &path, const QString &data ) const;
+
     void addLandmarkPositionFor( Position *const &pos );
     void flipPosition( Position *const &pos );
     void cancelOrderMeatDCOrder( Position *const &pos );
     bool tryMoveOrder( Position *const &pos );
     void fillNQ( const QString &order_id, qint8 fill_type, quint8 extra_data = 0 );
+    void pushSpread( const QString &market, const Spread &spread );
+    void flushSpreads();
 
     QHash<QString, MarketInfo> market_info;
     QHash<QString/*order_id*/, qint64/*seen_time*/> order_grace_times; // record "seen" time to allow for stray grace period
+    QSet<QString> ticker_recheck_markets; // markets to collision check on the next ticker, even if their spread didn't move
+    QMap<QString, Spread> pending_spreads; // spreads for the price aggregator, sent once per event with ENGINE_THREADS_ENABLED
 
     QMap<QString, qint64> m_flux_currency_ban_time;
 
@@ -91,7 +91,7 @@ void EngineTest::test( Engine *e )
     //assert( p2.profit_margin == "2.31344963" );
 
     // test landmark position using the engine
-    QVector<PositionData> &test_index = e->getMarketInfo( TEST_MARKET ).position_index;
+    PositionIndex &test_index = e->getMarketInfo( TEST_MARKET ).position_index;
     test_index += PositionData( "0.00000005", "0.00000050", "0.01", QLatin1String() ); // idx 0
     test_index += PositionData( "0.00000005", "0.00000060", "0.02", QLatin1String() ); // idx 1
     test_index += PositionData( "0.00000005", "0.00000070", "0.03", QLatin1String() ); // idx 2
@@ -125,12 +125,38 @@ void EngineTest::test( Engine *e )
     assert( p4->amount == "0.02000000" );
     assert( p4->quantity == "200000.00000000" );
 
+    // test pool handles
+    const PositionHandle h4 = p4->handle;
+    assert( !h4.isNull() );
+    assert( e->positions->isValid( h4 ) );
+    assert( e->positions->getByHandle( h4 ) == p4 );
+
+    // queue a request for p4, it's kept while p4 is alive
+    BaseREST *rest = e->rest_arr.value( e->engine_type );
+    Request *stale_request = new Request();
+    stale_request->api_command = "test-stale";
+    stale_request->pos = p4;
+    stale_request->pos_handle = h4;
+    rest->nam_queue.push( stale_request, RateCancel, Coin() );
+    assert( !rest->dropStaleRequest( stale_request ) );
+    assert( rest->nam_queue.contains( stale_request ) );
+    const qint32 queued_with_stale = rest->nam_queue.size();
+
     // Engine::deletePosition
     e->positions->cancelLocal();
     assert( e->positions->all().size() == 0 );
+    assert( e->positions->getPool().size() == 0 );
+
+    // the freed slot gets reused, but the old handle must stay stale
+    assert( !e->positions->isValid( h4 ) );
+    assert( e->positions->getByHandle( h4 ) == nullptr );
+
+    // the request for p4 is dropped (and deleted) before it can take rate tokens
+    assert( rest->dropStaleRequest( stale_request ) );
+    assert( rest->nam_queue.size() == queued_with_stale -1 );
 
     // test non-zero landmark buy price because of shim
-    QVector<PositionData> &test_index_1 = e->getMarketInfo( TEST_MARKET ).position_index;
+    PositionIndex &test_index_1 = e->getMarketInfo( TEST_MARKET ).position_index;
     test_index_1 += PositionData( "0.00000001", "0.00000050", "0.01", QLatin1String() ); // idx 0
     test_index_1 += PositionData( "0.00000001", "0.00000060", "0.02", QLatin1String() ); // idx 1
     test_index_1 += PositionData( "0.00000001", "0.00000070", "0.03", QLatin1String() ); // idx 2
@@ -143,13 +169,43 @@ void EngineTest::test( Engine *e )
     assert( p5->sell_price == "0.00000063" );
     assert( p5->strategy_tag == "test-strat" );
 
+    // p5 took the slot p4 freed, h4 must not resolve to it
+    assert( p5->handle.index == h4.index );
+    assert( p5->handle.generation != h4.generation );
+    assert( e->positions->getByHandle( h4 ) == nullptr );
+    assert( e->positions->getByHandle( p5->handle ) == p5 );
+
     // test getBuyTotal/getSellTotal
     assert( e->positions->getTotalOrdersForSide( TEST_MARKET, SIDE_BUY  ) == 1 );
     assert( e->positions->getTotalOrdersForSide( TEST_MARKET, SIDE_SELL ) == 0 );
 
+    // test active positions by market index
+    e->positions->takeActivatedMarkets();
+    assert( e->positions->activeByMarket( TEST_MARKET ).isEmpty() );
+    e->positions->activate( p5, "test-order-5" );
+    assert( e->positions->activeByMarket( TEST_MARKET ).contains( p5 ) );
+    assert( e->positions->takeActivatedMarkets().contains( TEST_MARKET ) );
+    assert( e->positions->takeActivatedMarkets().isEmpty() );
+
+    // test active positions by strategy index
+    const qint32 test_strat_id = e->positions->findStrategyId( "test-strat" );
+    assert( test_strat_id >= 0 );
+    assert( e->positions->getStrategyId( "test-strat" ) == test_strat_id );
+    assert( e->positions->activeByStrategy( test_strat_id, TEST_MARKET, SIDE_BUY ) == QVector<Position*>() << p5 );
+    assert( e->positions->activeByStrategy( test_strat_id, TEST_MARKET, SIDE_SELL ).isEmpty() );
+
+    // retagging moves the position to the new tag
+    e->positions->setStrategyTag( p5, "test-strat-2" );
+    const qint32 test_strat_2_id = e->positions->findStrategyId( "test-strat-2" );
+    assert( test_strat_2_id >= 0 && test_strat_2_id != test_strat_id );
+    assert( e->positions->activeByStrategy( test_strat_id, TEST_MARKET, SIDE_BUY ).isEmpty() );
+    assert( e->positions->activeByStrategy( test_strat_2_id, TEST_MARKET, SIDE_BUY ) == QVector<Position*>() << p5 );
+
     // cancel positions and clear mappings
     e->positions->cancelLocal();
     assert( e->positions->all().size() == 0 );
+    assert( e->positions->activeByMarket( TEST_MARKET ).isEmpty() );
+    assert( e->positions->activeByStrategy( test_strat_2_id, TEST_MARKET, SIDE_BUY ).isEmpty() );
 
     /// run basic ping-pong test for sell price equal to ticker ask price
     ///
@@ -391,6 +447,23 @@ void EngineTest::test( Engine *e )
     assert( e->positions->all().size() == 0 );
     ///
 
+    // test PositionIndex columns, tick truncation, and alternate size
+    PositionIndex grid;
+    grid += PositionData( "0.00012345", "0.00023456", "1.5", "0.25" );
+    assert( grid.buyPrice( 0 ) == 12345 );
+    assert( grid.value( 0 ).buy_price == "0.00012345" );
+    assert( grid.value( 0 ).order_size == "1.50000000" );
+    assert( grid.value( 0 ).alternate_size == "0.25000000" );
+    grid.setPriceTicksize( Coin( "0.00001" ) );
+    assert( grid.value( 0 ).buy_price == "0.00012000" );
+    assert( grid.value( 0 ).sell_price == "0.00023000" );
+    assert( grid.buyPrice( 0 ) == 12345 ); // raw price is preserved for saving
+    grid.iterateFillCount( 0 );
+    assert( grid.fillCount( 0 ) == 1 );
+    assert( grid.value( 0 ).order_size == "0.25000000" );
+    assert( grid.value( 0 ).alternate_size.isEmpty() );
+    assert( grid.value( 1 ).buy_price.isEmpty() );
+
     // clear some stuff and disable test mode
     e->getMarketInfoStructure().clear(); // clear TEST_MARKET market from market settings
     e->positions->diverge_converge.clear(); // clear TEST_MARKET from dc market index
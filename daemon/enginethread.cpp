@@ -0,0 +1,192 @@
+#include "enginethread.h"
+#include "engine.h"
+#include "baserest.h"
+
+#include <QMetaObject>
+#include <QMutexLocker>
+#include <QNetworkAccessManager>
+
+QVector<EngineThread*> EngineThread::threads;
+qint32 EngineThreadLock::depth = 0;
+
+EngineThread::EngineThread( Engine *_engine, BaseREST *_rest )
+    : QThread( nullptr ),
+      engine( _engine ),
+      rest( _rest ),
+      nam( _rest->nam )
+{
+    setObjectName( QString( "Engine %1" ).arg( engine->getEngineTypeStr() ) );
+
+    // the parked loop runs on its own context, the engine can be deleted from inside it
+    context = new QObject();
+    context->moveToThread( this );
+
+    // children and running timers move along with them
+    engine->moveToThread( this );
+    rest->moveToThread( this );
+    nam->moveToThread( this );
+
+    engine->engine_thread = this;
+    threads += this;
+
+    start();
+}
+
+EngineThread::~EngineThread()
+{
+    threads.removeOne( this );
+
+    // delete them on the thread they live on, the engine goes first like it did on the main thread
+    runJob( [this]()
+    {
+        delete engine;
+        delete rest;
+        delete nam;
+    } );
+
+    quit();
+    wait();
+
+    delete context;
+}
+
+void EngineThread::park()
+{
+    QMutexLocker locker( &mutex );
+
+    if ( is_parked )
+        return;
+
+    // the event loop picks this up once the engine is done with the event it's handling
+    QMetaObject::invokeMethod( context, [this]() { parkedLoop(); }, Qt::QueuedConnection );
+
+    while ( !is_parked )
+        state_changed.wait( &mutex );
+}
+
+void EngineThread::runJob( const std::function<void()> &job )
+{
+    // already on this thread, or it hasn't started
+    if ( QThread::currentThread() == this || !isRunning() )
+    {
+        job();
+        return;
+    }
+
+    // park for just this job if the caller didn't
+    mutex.lock();
+    const bool was_parked = is_parked;
+    mutex.unlock();
+
+    if ( !was_parked )
+        park();
+
+    {
+        QMutexLocker locker( &mutex );
+
+        pending_job = job;
+        has_job = true;
+        state_changed.wakeAll();
+
+        while ( has_job )
+            state_changed.wait( &mutex );
+    }
+
+    if ( !was_parked )
+        resume();
+}
+
+void EngineThread::resume()
+{
+    QMutexLocker locker( &mutex );
+
+    if ( !is_parked )
+        return;
+
+    is_resuming = true;
+    state_changed.wakeAll();
+
+    // wait for the loop to return, so a park() right after this one doesn't see it still parked
+    while ( is_parked )
+        state_changed.wait( &mutex );
+}
+
+bool EngineThread::isParked()
+{
+    QMutexLocker locker( &mutex );
+    return is_parked;
+}
+
+void EngineThread::parkedLoop()
+{
+    QMutexLocker locker( &mutex );
+
+    is_parked = true;
+    state_changed.wakeAll();
+
+    while ( !is_resuming )
+    {
+        if ( !has_job )
+        {
+            state_changed.wait( &mutex );
+            continue;
+        }
+
+        // run the job unlocked, the caller is waiting on has_job
+        locker.unlock();
+        pending_job();
+        locker.relock();
+
+        pending_job = nullptr;
+        has_job = false;
+        state_changed.wakeAll();
+    }
+
+    is_parked = false;
+    is_resuming = false;
+    state_changed.wakeAll();
+}
+
+EngineParkLock::EngineParkLock( Engine *engine )
+    : engine_thread( engine->engine_thread )
+{
+    // parking our own thread would wait forever
+    if ( engine_thread == nullptr || QThread::currentThread() == engine_thread || !engine_thread->isRunning() )
+    {
+        engine_thread = nullptr;
+        return;
+    }
+
+    was_parked = engine_thread->isParked();
+
+    if ( !was_parked )
+        engine_thread->park();
+}
+
+EngineParkLock::~EngineParkLock()
+{
+    if ( engine_thread != nullptr && !was_parked )
+        engine_thread->resume();
+}
+
+EngineThreadLock::EngineThreadLock()
+{
+    if ( depth++ > 0 )
+        return;
+
+    const QVector<EngineThread*> &threads = EngineThread::getThreads();
+
+    for ( QVector<EngineThread*>::const_iterator i = threads.begin(); i != threads.end(); i++ )
+        (*i)->park();
+}
+
+EngineThreadLock::~EngineThreadLock()
+{
+    if ( --depth > 0 )
+        return;
+
+    const QVector<EngineThread*> &threads = EngineThread::getThreads();
+
+    for ( QVector<EngineThread*>::const_iterator i = threads.begin(); i != threads.end(); i++ )
+        (*i)->resume();
+}
@@ -0,0 +1,87 @@
+#ifndef ENGINETHREAD_H
+#define ENGINETHREAD_H
+
+#include <functional>
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QVector>
+
+class Engine;
+class BaseREST;
+class QNetworkAccessManager;
+
+//
+// EngineThread, runs one exchange's engine, rest module and network manager off the main thread (ENGINE_THREADS_ENABLED)
+//
+// spruce, alpha, the price aggregator, the overseer and the command runners stay on the main thread. the engine posts
+// to them with queued calls, and the main thread only touches an engine while it's parked: park() waits until the
+// engine thread is idle between events, runJob() runs a job on it while the caller waits, and resume() lets it go.
+// the main thread reads a parked engine directly, but anything that can start a timer or send a request is a job.
+//
+class EngineThread : public QThread
+{
+public:
+    explicit EngineThread( Engine *_engine, BaseREST *_rest ); // takes over the rest module's network manager
+    ~EngineThread(); // deletes the engine, rest module and network manager on this thread, then stops it
+
+    void park();
+    void runJob( const std::function<void()> &job );
+    void resume();
+    bool isParked();
+
+    static const QVector<EngineThread*> &getThreads() { return threads; }
+
+private:
+    void parkedLoop(); // runs on this thread until resume()
+
+    Engine *engine{ nullptr };
+    BaseREST *rest{ nullptr };
+    QNetworkAccessManager *nam{ nullptr };
+    QObject *context{ nullptr }; // lives on this thread
+
+    QMutex mutex;
+    QWaitCondition state_changed;
+    std::function<void()> pending_job;
+    bool is_parked{ false };
+    bool has_job{ false };
+    bool is_resuming{ false };
+
+    static QVector<EngineThread*> threads; // every running engine thread, only changed on the main thread
+};
+
+//
+// EngineParkLock, parks one engine's thread for its lifetime so the caller can read that engine, the others keep running
+//
+// nests with itself, and can be taken inside an EngineThreadLock. an engine that was already parked stays parked.
+// does nothing without engine threads, or on the engine's own thread.
+//
+class EngineParkLock
+{
+public:
+    explicit EngineParkLock( Engine *engine );
+    ~EngineParkLock();
+
+private:
+    EngineThread *engine_thread{ nullptr };
+    bool was_parked{ false };
+};
+
+//
+// EngineThreadLock, parks every engine thread for its lifetime so the caller can read and change any engine
+//
+// locks nest, only the outermost one parks and resumes. does nothing without engine threads. only used at startup,
+// the overseer and the command runners park one engine at a time with EngineParkLock.
+//
+class EngineThreadLock
+{
+public:
+    explicit EngineThreadLock();
+    ~EngineThreadLock();
+
+private:
+    static qint32 depth;
+};
+
+#endif // ENGINETHREAD_H
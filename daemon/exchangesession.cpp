@@ -0,0 +1,124 @@
+#include "exchangesession.h"
+#include "global.h"
+
+#include <QNetworkAccessManager>
+#include <QNetworkRequest>
+#include <QSslConfiguration>
+#include <QTimer>
+#include <QUrl>
+
+ExchangeSession::ExchangeSession( QObject *parent )
+    : QObject( parent )
+{
+    // this timer reopens connections the server closed while we were idle
+    keep_warm_timer = new QTimer( this );
+    keep_warm_timer->setTimerType( Qt::VeryCoarseTimer );
+    connect( keep_warm_timer, &QTimer::timeout, this, &ExchangeSession::onKeepWarm );
+}
+
+ExchangeSession::~ExchangeSession()
+{
+    keep_warm_timer->stop();
+    delete keep_warm_timer;
+    keep_warm_timer = nullptr;
+
+    nam = nullptr;
+}
+
+void ExchangeSession::addHost( const QUrl &url )
+{
+    if ( url.host().isEmpty() )
+        return;
+
+    const QPair<QString, quint16> host( url.host(), quint16( url.port( 443 ) ) );
+
+    if ( !hosts.contains( host ) )
+        hosts += host;
+}
+
+void ExchangeSession::setInFlightLimit( const RateClass rate_class, const qint32 limit )
+{
+    if ( rate_class >= RATE_CLASS_COUNT )
+        return;
+
+    in_flight_limit[ rate_class ] = qMax( limit, 0 );
+}
+
+void ExchangeSession::startKeepWarm( const qint32 interval_ms )
+{
+    keep_warm_interval = interval_ms;
+
+    warmConnections();
+    keep_warm_timer->start( interval_ms );
+}
+
+void ExchangeSession::prepareRequest( QNetworkRequest &nam_request ) const
+{
+    // http/2 multiplexes everything in flight over one connection, otherwise let qt pipeline over its pool
+    nam_request.setAttribute( QNetworkRequest::Http2AllowedAttribute, http2_allowed );
+    nam_request.setAttribute( QNetworkRequest::HttpPipeliningAllowedAttribute, pipelining_allowed && !http2_allowed );
+}
+
+bool ExchangeSession::canSend( const RateClass rate_class ) const
+{
+    if ( rate_class >= RATE_CLASS_COUNT )
+        return false;
+
+    return in_flight_limit[ rate_class ] == 0 || in_flight[ rate_class ] < in_flight_limit[ rate_class ];
+}
+
+void ExchangeSession::onRequestSent( const RateClass rate_class )
+{
+    if ( rate_class >= RATE_CLASS_COUNT )
+        return;
+
+    in_flight[ rate_class ]++;
+    last_activity_time = QDateTime::currentMSecsSinceEpoch();
+}
+
+void ExchangeSession::onRequestFinished( const RateClass rate_class )
+{
+    if ( rate_class >= RATE_CLASS_COUNT )
+        return;
+
+    in_flight[ rate_class ] = qMax( in_flight[ rate_class ] - 1, 0 );
+    last_activity_time = QDateTime::currentMSecsSinceEpoch();
+}
+
+void ExchangeSession::warmConnections()
+{
+    if ( nam == nullptr )
+        return;
+
+#if defined( EXCHANGE_SIM_ENABLED )
+    // the simulator answers in-process, there's nothing to connect to
+    return;
+#endif
+
+    // resolve and handshake ahead of time, qt keeps the connection in its pool for the next request to the host
+    for ( QVector<QPair<QString, quint16>>::const_iterator i = hosts.begin(); i != hosts.end(); i++ )
+    {
+#if QT_VERSION >= QT_VERSION_CHECK( 5, 13, 0 )
+        QSslConfiguration ssl_config = QSslConfiguration::defaultConfiguration();
+
+        // advertise h2 so the warm connection can be reused by http/2 requests
+        if ( http2_allowed )
+            ssl_config.setAllowedNextProtocols( { QSslConfiguration::ALPNProtocolHTTP2, QSslConfiguration::NextProtocolHttp1_1 } );
+
+        nam->connectToHostEncrypted( i->first, i->second, ssl_config );
+#else
+        nam->connectToHostEncrypted( i->first, i->second );
+#endif
+    }
+
+    last_activity_time = QDateTime::currentMSecsSinceEpoch();
+}
+
+void ExchangeSession::onKeepWarm()
+{
+    // requests keep the connections open on their own
+    if ( last_activity_time > QDateTime::currentMSecsSinceEpoch() - keep_warm_interval )
+        return;
+
+    warmConnections();
+}
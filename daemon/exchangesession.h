@@ -0,0 +1,64 @@
+#ifndef EXCHANGESESSION_H
+#define EXCHANGESESSION_H
+
+#include "ratelimiter.h"
+
+#include <QObject>
+#include <QVector>
+#include <QPair>
+#include <QString>
+
+class QNetworkAccessManager;
+class QNetworkRequest;
+class QTimer;
+class QUrl;
+
+//
+// ExchangeSession, connection policy for one exchange
+//
+// keeps encrypted connections to the exchange hosts open so a burst after an idle period doesn't wait on dns, tcp
+// and tls setup, allows http/2 (or http/1.1 pipelining) on outgoing requests, and caps the number of requests in
+// flight per rate class. the rate limiter decides how often we send, this decides how many can be outstanding.
+//
+class ExchangeSession : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ExchangeSession( QObject *parent = nullptr );
+    ~ExchangeSession();
+
+    void setNetworkAccessManager( QNetworkAccessManager *_nam ) { nam = _nam; }
+    void addHost( const QUrl &url );
+    void setHttp2Allowed( const bool allowed ) { http2_allowed = allowed; }
+    void setPipeliningAllowed( const bool allowed ) { pipelining_allowed = allowed; }
+    void setInFlightLimit( const RateClass rate_class, const qint32 limit );
+    void startKeepWarm( const qint32 interval_ms );
+
+    void prepareRequest( QNetworkRequest &nam_request ) const;
+
+    // in-flight accounting, a limit of 0 is unlimited
+    bool canSend( const RateClass rate_class ) const;
+    void onRequestSent( const RateClass rate_class );
+    void onRequestFinished( const RateClass rate_class );
+    qint32 getInFlight( const RateClass rate_class ) const { return rate_class < RATE_CLASS_COUNT ? in_flight[ rate_class ] : 0; }
+    qint32 getInFlightLimit( const RateClass rate_class ) const { return rate_class < RATE_CLASS_COUNT ? in_flight_limit[ rate_class ] : 0; }
+
+public Q_SLOTS:
+    void warmConnections();
+    void onKeepWarm();
+
+private:
+    QVector<QPair<QString, quint16>> hosts;
+    qint32 in_flight[ RATE_CLASS_COUNT ]{ 0 };
+    qint32 in_flight_limit[ RATE_CLASS_COUNT ]{ 0 };
+    qint64 last_activity_time{ 0 };
+    qint32 keep_warm_interval{ 0 };
+    bool http2_allowed{ false };
+    bool pipelining_allowed{ false };
+
+    QTimer *keep_warm_timer{ nullptr };
+    QNetworkAccessManager *nam{ nullptr };
+};
+
+#endif // EXCHANGESESSION_H
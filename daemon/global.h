@@ -16,6 +16,8 @@
 #include <QMessageAuthenticationCode>
 //#include <QSslSocket>
 #include <QDebug>
+#include <QMutex>
+#include <QMutexLocker>
 
 #define kDebug QMessageLogger( __FILE__, __LINE__, Q_FUNC_INFO ).debug().noquote
 
@@ -24,6 +26,7 @@ static const quint8 ENGINE_BITTREX                          ( 0 );
 static const quint8 ENGINE_BINANCE                          ( 1 );
 static const quint8 ENGINE_POLONIEX                         ( 2 );
 static const quint8 ENGINE_WAVES                            ( 3 );
+static const quint8 ENGINE_COUNT                            ( 4 );
 
 static const quint8 SIDE_BUY                                ( 1 );
 static const quint8 SIDE_SELL                               ( 2 );
@@ -71,6 +74,12 @@ static const QLatin1String COLOR_RED                        ( ">>>red<<<" );
 static const QLatin1String COLOR_GREEN                      ( ">>>grn<<<" );
 static const QLatin1String COLOR_NONE                       ( ">>>none<<<" );
 
+static const int SESSION_TIMER_INTERVAL_KEEP_WARM           ( 30000 );
+static const qint64 TICKER_STALE_MS                         ( 60000 );
+static const qint64 TRADING_SNAPSHOT_MAX_AGE_MS             ( 1000 ); // read-only commands reuse an unchanged snapshot younger than this
+static const int REPLY_PARSER_MIN_BYTES                     ( 16384 ); // hot replies at least this big are parsed off the main thread
+static const int LATENCY_TIMER_INTERVAL_LOG                 ( 60000 * 10 );
+
 // trex symbols
 static const QLatin1String BITTREX_DEFAULT_FEERATE          ( "0.0015" );
 static const QLatin1String BITTREX_MINIMUM_ORDER_SIZE       ( "0.00100000" );
@@ -103,17 +112,23 @@ static const int BINANCE_TIMER_INTERVAL_NAM_SEND            ( 111 );
 static const int BINANCE_TIMER_INTERVAL_ORDERBOOK           ( 50000 );
 static const int BINANCE_TIMER_INTERVAL_TICKER              ( 15000 );
 static const int BINANCE_SAFETY_DELAY                       ( 2000 );
-static const int BINANCE_RATELIMIT_WINDOW                   ( 60000 );
+static const int BINANCE_TIMER_INTERVAL_WSS_CHECK           ( 10000 );
+static const int BINANCE_LISTENKEY_KEEPALIVE                ( 60000 * 30 );
+static const int BINANCE_WSS_BACKOFF_MIN                    ( 5000 );
+static const int BINANCE_WSS_BACKOFF_MAX                    ( 60000 * 5 );
 
 static const QLatin1String BNC_URL                          ( "https://api.binance.com/api/v3/" );
-static const QLatin1String BNC_URL_WSS                      ( "wss://api.binance.com" );
+static const QLatin1String BNC_URL_WSS                      ( "wss://stream.binance.com:9443/stream" );
 static const QLatin1String BNC_COMMAND_GETORDERS            ( "sign-get-openOrders" );
 static const QLatin1String BNC_COMMAND_BUYSELL              ( "sign-post-order" );
 static const QLatin1String BNC_COMMAND_CANCEL               ( "sign-delete-order" );
+static const QLatin1String BNC_COMMAND_CANCEL_ALL           ( "sign-delete-openOrders" );
 static const QLatin1String BNC_COMMAND_GETORDER             ( "sign-get-order" );
 static const QLatin1String BNC_COMMAND_GETTICKER            ( "get-ticker/bookTicker" );
 static const QLatin1String BNC_COMMAND_GETEXCHANGEINFO      ( "get-v1-exchangeInfo" );
 static const QLatin1String BNC_COMMAND_GETBALANCES          ( "sign-get-account" );
+static const QLatin1String BNC_COMMAND_GETLISTENKEY         ( "key-post-userDataStream" );
+static const QLatin1String BNC_COMMAND_KEEPALIVE            ( "key-put-userDataStream" );
 static const QLatin1String BNC_RECVWINDOW                   ( "recvWindow" );
 static const QLatin1String BNC_TIMESTAMP                    ( "timestamp" );
 static const QLatin1String BNC_SIGNATURE                    ( "signature" );
@@ -153,6 +168,17 @@ static const int WAVES_TIMER_INTERVAL_MARKET_DATA_INITIAL   ( 60000 );
 static const int WAVES_TIMER_INTERVAL_MARKET_DATA           ( 60000 * 60 * 24 );
 static const int WAVES_TIMER_INTERVAL_TICKER                ( 1000 );
 static const int WAVES_TIMER_INTERVAL_CHECK_MY_ORDERS       ( 20000 );
+static const int WAVES_TIMER_INTERVAL_WSS_CHECK             ( 10000 );
+static const int WAVES_WSS_BACKOFF_MIN                      ( 5000 );
+static const int WAVES_WSS_BACKOFF_MAX                      ( 60000 * 5 );
+static const int WAVES_WSS_ORDERBOOK_DEPTH                  ( 10 );
+static const int WAVES_WSS_CANCEL_QUERY_DELAY               ( 15000 ); // poll a cancelling order after this long without an account update
+static const int WAVES_TOKEN_LIFETIME_SECS                  ( 60 * 60 * 24 * 7 );
+static const int WAVES_TOKEN_RENEW_MARGIN                   ( 60000 * 60 ); // renew the token this long before it expires
+static const int WAVES_SIGNING_THREADS                      ( 2 ); // signing workers, at most the ideal thread count
+static const QLatin1String WAVES_URL_WSS                    ( "wss://matcher.waves.exchange/ws/v0" );
+static const QLatin1String WAVES_API_URL                    ( "https://api.waves.exchange/" );
+static const QLatin1String WAVES_OAUTH_CLIENT_ID            ( "waves.exchange" );
 
 static const QLatin1String WAVES_COMMAND_GET_MATCHER_PUBKEY ( "pk-get-matcher" );
 static const QLatin1String WAVES_COMMAND_GET_MARKET_DATA    ( "md-get-matcher/orderbook" );
@@ -160,7 +186,9 @@ static const QLatin1String WAVES_COMMAND_GET_MARKET_STATUS  ( "ms-get-matcher/or
 static const QLatin1String WAVES_COMMAND_GET_ORDER_STATUS   ( "os-get-matcher/orderbook/%1/%2/%3" );
 static const QLatin1String WAVES_COMMAND_GET_MY_ORDERS      ( "om-get-matcher/orderbook/%1" );
 static const QLatin1String WAVES_COMMAND_POST_ORDER_CANCEL  ( "oc-post-matcher/orderbook/%1/%2/cancel" );
+static const QLatin1String WAVES_COMMAND_POST_CANCEL_ALL    ( "ob-post-matcher/orderbook/%1/%2/cancel" );
 static const QLatin1String WAVES_COMMAND_POST_ORDER_NEW     ( "on-post-matcher/orderbook" );
+static const QLatin1String WAVES_COMMAND_POST_TOKEN         ( "jt-post-v1/oauth2/token" );
 
 namespace Global {
 
@@ -285,18 +313,6 @@ static inline QString getDateStringFull()
     return QDateTime::currentDateTime().toString( "MM-dd-yy HH:mm:ss" );
 }
 
-static inline QByteArray getBittrexPoloSignature( const QByteArray &body, const QByteArray &secret )
-{
-    // sign hmac-sha512
-    return QMessageAuthenticationCode::hash( body, secret, QCryptographicHash::Sha512 ).toHex();
-}
-
-static inline QByteArray getBncSignature( const QByteArray &body, const QByteArray &secret )
-{
-    // sign hmac-sha256
-    return QMessageAuthenticationCode::hash( body, secret, QCryptographicHash::Sha256 ).toHex();
-}
-
 static inline const QString getConfigPath()
 {
     return QStandardPaths::writableLocation( QStandardPaths::ConfigLocation );
@@ -401,6 +417,12 @@ static void messageOutput( QtMsgType type, const QMessageLogContext &context, co
     Q_UNUSED( messageOutput )
     Q_UNUSED( context )
 
+#if defined( ENGINE_THREADS_ENABLED )
+    // engines log from their own threads. recursive, opening the log prints to it
+    static QMutex log_mutex( QMutex::Recursive );
+    QMutexLocker log_locker( &log_mutex );
+#endif
+
     // add a logfile tag for test build
     static QString log_file_path = QString( getTraderPath() + QDir::separator() + "log.%1.txt" )
                                     .arg( QDateTime::currentSecsSinceEpoch() );
@@ -0,0 +1,210 @@
+#include "hmacutil.h"
+
+#include <assert.h>
+
+#include <QByteArray>
+#include <QCryptographicHash>
+
+extern "C" int crypto_hashblocks_sha512( unsigned char *statebytes, const unsigned char *in, uint64_t inlen );
+
+namespace
+{
+
+static const int SHA256_BLOCK_SIZE = 64;
+static const int SHA256_STATE_SIZE = 32;
+static const int SHA512_BLOCK_SIZE = 128;
+static const int SHA512_STATE_SIZE = 64;
+
+static const quint32 sha256_k[ 64 ] =
+{
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static const quint8 sha256_iv[ SHA256_STATE_SIZE ] =
+{
+    0x6a, 0x09, 0xe6, 0x67, 0xbb, 0x67, 0xae, 0x85, 0x3c, 0x6e, 0xf3, 0x72, 0xa5, 0x4f, 0xf5, 0x3a,
+    0x51, 0x0e, 0x52, 0x7f, 0x9b, 0x05, 0x68, 0x8c, 0x1f, 0x83, 0xd9, 0xab, 0x5b, 0xe0, 0xcd, 0x19
+};
+
+static const quint8 sha512_iv[ SHA512_STATE_SIZE ] =
+{
+    0x6a, 0x09, 0xe6, 0x67, 0xf3, 0xbc, 0xc9, 0x08, 0xbb, 0x67, 0xae, 0x85, 0x84, 0xca, 0xa7, 0x3b,
+    0x3c, 0x6e, 0xf3, 0x72, 0xfe, 0x94, 0xf8, 0x2b, 0xa5, 0x4f, 0xf5, 0x3a, 0x5f, 0x1d, 0x36, 0xf1,
+    0x51, 0x0e, 0x52, 0x7f, 0xad, 0xe6, 0x82, 0xd1, 0x9b, 0x05, 0x68, 0x8c, 0x2b, 0x3e, 0x6c, 0x1f,
+    0x1f, 0x83, 0xd9, 0xab, 0xfb, 0x41, 0xbd, 0x6b, 0x5b, 0xe0, 0xcd, 0x19, 0x13, 0x7e, 0x21, 0x79
+};
+
+static inline quint32 loadBigEndian32( const quint8 *x )
+{
+    return quint32( x[ 0 ] ) << 24 | quint32( x[ 1 ] ) << 16 | quint32( x[ 2 ] ) << 8 | quint32( x[ 3 ] );
+}
+
+static inline void storeBigEndian32( quint8 *x, const quint32 u )
+{
+    x[ 0 ] = quint8( u >> 24 );
+    x[ 1 ] = quint8( u >> 16 );
+    x[ 2 ] = quint8( u >> 8 );
+    x[ 3 ] = quint8( u );
+}
+
+static inline quint32 rotr32( const quint32 x, const int c )
+{
+    return ( x >> c ) | ( x << ( 32 - c ) );
+}
+
+// sha256 compression over whole blocks, same byte-state convention as crypto_hashblocks_sha512()
+static void hashBlocksSha256( quint8 *statebytes, const quint8 *in, qint64 inlen )
+{
+    quint32 state[ 8 ];
+    for ( int i = 0; i < 8; i++ )
+        state[ i ] = loadBigEndian32( statebytes + i * 4 );
+
+    quint32 w[ 64 ];
+
+    for ( ; inlen >= SHA256_BLOCK_SIZE; inlen -= SHA256_BLOCK_SIZE, in += SHA256_BLOCK_SIZE )
+    {
+        for ( int i = 0; i < 16; i++ )
+            w[ i ] = loadBigEndian32( in + i * 4 );
+
+        for ( int i = 16; i < 64; i++ )
+        {
+            const quint32 s0 = rotr32( w[ i -15 ], 7 ) ^ rotr32( w[ i -15 ], 18 ) ^ ( w[ i -15 ] >> 3 );
+            const quint32 s1 = rotr32( w[ i -2 ], 17 ) ^ rotr32( w[ i -2 ], 19 ) ^ ( w[ i -2 ] >> 10 );
+            w[ i ] = w[ i -16 ] + s0 + w[ i -7 ] + s1;
+        }
+
+        quint32 a = state[ 0 ], b = state[ 1 ], c = state[ 2 ], d = state[ 3 ],
+                e = state[ 4 ], f = state[ 5 ], g = state[ 6 ], h = state[ 7 ];
+
+        for ( int i = 0; i < 64; i++ )
+        {
+            const quint32 t1 = h + ( rotr32( e, 6 ) ^ rotr32( e, 11 ) ^ rotr32( e, 25 ) ) + ( ( e & f ) ^ ( ~e & g ) ) + sha256_k[ i ] + w[ i ];
+            const quint32 t2 = ( rotr32( a, 2 ) ^ rotr32( a, 13 ) ^ rotr32( a, 22 ) ) + ( ( a & b ) ^ ( a & c ) ^ ( b & c ) );
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+
+        state[ 0 ] += a; state[ 1 ] += b; state[ 2 ] += c; state[ 3 ] += d;
+        state[ 4 ] += e; state[ 5 ] += f; state[ 6 ] += g; state[ 7 ] += h;
+    }
+
+    for ( int i = 0; i < 8; i++ )
+        storeBigEndian32( statebytes + i * 4, state[ i ] );
+}
+
+static inline void hashBlocks( quint8 *statebytes, const quint8 *in, const qint64 inlen, const bool is_sha512 )
+{
+    if ( is_sha512 )
+        crypto_hashblocks_sha512( statebytes, in, uint64_t( inlen ) );
+    else
+        hashBlocksSha256( statebytes, in, inlen );
+}
+
+// hashes the message into a state that has already consumed one key block, then pads and finalizes it in place
+static void finalize( quint8 *statebytes, const quint8 *in, const qint64 inlen, const bool is_sha512 )
+{
+    const int block_size = is_sha512 ? SHA512_BLOCK_SIZE : SHA256_BLOCK_SIZE;
+    const int length_size = is_sha512 ? 16 : 8;
+
+    const qint64 full_len = inlen - ( inlen % block_size );
+    hashBlocks( statebytes, in, full_len, is_sha512 );
+
+    const int tail_len = int( inlen - full_len );
+    quint8 padded[ SHA512_BLOCK_SIZE * 2 ] = {};
+
+    for ( int i = 0; i < tail_len; i++ )
+        padded[ i ] = in[ full_len + i ];
+
+    padded[ tail_len ] = 0x80;
+
+    const int padded_len = ( tail_len + 1 + length_size <= block_size ) ? block_size : block_size * 2;
+
+    // message length in bits, including the key block
+    const quint64 bits = quint64( inlen + block_size ) << 3;
+    for ( int i = 0; i < 8; i++ )
+        padded[ padded_len -1 - i ] = quint8( bits >> ( i * 8 ) );
+
+    hashBlocks( statebytes, padded, padded_len, is_sha512 );
+}
+
+} // namespace
+
+int HmacUtil::getBlockSize( const QCryptographicHash::Algorithm algo )
+{
+    return algo == QCryptographicHash::Sha512 ? SHA512_BLOCK_SIZE : SHA256_BLOCK_SIZE;
+}
+
+int HmacUtil::getStateSize( const QCryptographicHash::Algorithm algo )
+{
+    return algo == QCryptographicHash::Sha512 ? SHA512_STATE_SIZE : SHA256_STATE_SIZE;
+}
+
+QByteArray HmacUtil::getMidstate( const QByteArray &key, const QCryptographicHash::Algorithm algo )
+{
+    assert( algo == QCryptographicHash::Sha256 || algo == QCryptographicHash::Sha512 );
+
+    const bool is_sha512 = algo == QCryptographicHash::Sha512;
+    const int block_size = getBlockSize( algo );
+    const int state_size = getStateSize( algo );
+
+    // keys longer than a block are hashed first
+    QByteArray key_block = key.size() > block_size ? QCryptographicHash::hash( key, algo ) : key;
+    key_block.append( QByteArray( block_size - key_block.size(), char( 0 ) ) );
+
+    QByteArray ipad_block( block_size, char( 0 ) ), opad_block( block_size, char( 0 ) );
+    for ( int i = 0; i < block_size; i++ )
+    {
+        ipad_block[ i ] = char( key_block.at( i ) ^ 0x36 );
+        opad_block[ i ] = char( key_block.at( i ) ^ 0x5c );
+    }
+
+    const quint8 *iv = is_sha512 ? sha512_iv : sha256_iv;
+    QByteArray ret( reinterpret_cast<const char*>( iv ), state_size );
+    ret.append( reinterpret_cast<const char*>( iv ), state_size );
+
+    quint8 *states = reinterpret_cast<quint8*>( ret.data() );
+    hashBlocks( states, reinterpret_cast<const quint8*>( ipad_block.constData() ), block_size, is_sha512 );
+    hashBlocks( states + state_size, reinterpret_cast<const quint8*>( opad_block.constData() ), block_size, is_sha512 );
+
+    // wipe the padded key copies
+    key_block.fill( char( 0 ) );
+    ipad_block.fill( char( 0 ) );
+    opad_block.fill( char( 0 ) );
+
+    return ret;
+}
+
+QByteArray HmacUtil::sign( const QByteArray &midstate, const QByteArray &message, const QCryptographicHash::Algorithm algo )
+{
+    const bool is_sha512 = algo == QCryptographicHash::Sha512;
+    const int state_size = getStateSize( algo );
+
+    if ( midstate.size() != state_size * 2 )
+        return QByteArray();
+
+    quint8 inner[ SHA512_STATE_SIZE ], outer[ SHA512_STATE_SIZE ];
+    for ( int i = 0; i < state_size; i++ )
+    {
+        inner[ i ] = quint8( midstate.at( i ) );
+        outer[ i ] = quint8( midstate.at( state_size + i ) );
+    }
+
+    // inner = H( k^ipad || message ), outer = H( k^opad || inner )
+    finalize( inner, reinterpret_cast<const quint8*>( message.constData() ), message.size(), is_sha512 );
+    finalize( outer, inner, state_size, is_sha512 );
+
+    return QByteArray( reinterpret_cast<const char*>( outer ), state_size );
+}
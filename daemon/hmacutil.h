@@ -0,0 +1,23 @@
+#ifndef HMACUTIL_H
+#define HMACUTIL_H
+
+#include <QByteArray>
+#include <QCryptographicHash>
+
+//
+// HmacUtil, hmac-sha256/hmac-sha512 with precomputed key schedules
+//
+// getMidstate() runs the ipad and opad key blocks through the compression function once and returns both
+// chaining states (inner then outer). sign() resumes from those states, so each signature only hashes the message
+// and the inner digest instead of re-deriving the padded key every time.
+//
+namespace HmacUtil
+{
+    int getBlockSize( const QCryptographicHash::Algorithm algo );
+    int getStateSize( const QCryptographicHash::Algorithm algo );
+
+    QByteArray getMidstate( const QByteArray &key, const QCryptographicHash::Algorithm algo );
+    QByteArray sign( const QByteArray &midstate, const QByteArray &message, const QCryptographicHash::Algorithm algo );
+}
+
+#endif // HMACUTIL_H
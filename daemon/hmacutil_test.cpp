@@ -0,0 +1,64 @@
+#include "hmacutil_test.h"
+#include "hmacutil.h"
+#include "keystore.h"
+
+#include <assert.h>
+
+#include <QByteArray>
+#include <QVector>
+#include <QCryptographicHash>
+#include <QMessageAuthenticationCode>
+
+void HmacUtilTest::test()
+{
+    /// test rfc 4231 case 2
+    const QByteArray rfc_key = "Jefe";
+    const QByteArray rfc_msg = "what do ya want for nothing?";
+
+    assert( HmacUtil::sign( HmacUtil::getMidstate( rfc_key, QCryptographicHash::Sha256 ), rfc_msg, QCryptographicHash::Sha256 ).toHex() ==
+            "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843" );
+    assert( HmacUtil::sign( HmacUtil::getMidstate( rfc_key, QCryptographicHash::Sha512 ), rfc_msg, QCryptographicHash::Sha512 ).toHex() ==
+            "164b7a7bfcf819e2e395fbe73b56e0a387bd64222e831fd610270cd7ea250554"
+            "9758bf75c05a994a6d034f65f8f0e6fdcaeab1a34d4a6b4b636e070a38bce737" );
+
+    /// test key and message sizes around the block boundaries against qt
+    const QVector<int> key_sizes = { 0, 1, 32, 63, 64, 65, 127, 128, 129, 200 };
+    const QVector<int> msg_sizes = { 0, 1, 55, 56, 63, 64, 111, 112, 127, 128, 129, 300 };
+
+    for ( QVector<int>::const_iterator k = key_sizes.begin(); k != key_sizes.end(); k++ )
+    {
+        QByteArray key;
+        for ( int i = 0; i < *k; i++ )
+            key += char( i * 7 + *k );
+
+        const QByteArray midstate_256 = HmacUtil::getMidstate( key, QCryptographicHash::Sha256 );
+        const QByteArray midstate_512 = HmacUtil::getMidstate( key, QCryptographicHash::Sha512 );
+
+        for ( QVector<int>::const_iterator m = msg_sizes.begin(); m != msg_sizes.end(); m++ )
+        {
+            QByteArray msg;
+            for ( int i = 0; i < *m; i++ )
+                msg += char( i * 13 + *m );
+
+            assert( HmacUtil::sign( midstate_256, msg, QCryptographicHash::Sha256 ) ==
+                    QMessageAuthenticationCode::hash( msg, key, QCryptographicHash::Sha256 ) );
+            assert( HmacUtil::sign( midstate_512, msg, QCryptographicHash::Sha512 ) ==
+                    QMessageAuthenticationCode::hash( msg, key, QCryptographicHash::Sha512 ) );
+        }
+    }
+
+    /// test keystore signing
+    KeyStore keystore;
+    keystore.setKeys( "key", "secret" );
+
+    assert( keystore.getSignature( "body", QCryptographicHash::Sha256 ) ==
+            QMessageAuthenticationCode::hash( "body", "secret", QCryptographicHash::Sha256 ) );
+    assert( keystore.getSignature( "body", QCryptographicHash::Sha512 ) ==
+            QMessageAuthenticationCode::hash( "body", "secret", QCryptographicHash::Sha512 ) );
+
+    // wrong midstate size
+    assert( HmacUtil::sign( QByteArray(), "body", QCryptographicHash::Sha256 ).isEmpty() );
+
+    keystore.clear();
+    assert( keystore.getSignature( "body", QCryptographicHash::Sha512 ).isEmpty() );
+}
@@ -0,0 +1,9 @@
+#ifndef HMACUTIL_TEST_H
+#define HMACUTIL_TEST_H
+
+struct HmacUtilTest
+{
+    void test();
+};
+
+#endif // HMACUTIL_TEST_H
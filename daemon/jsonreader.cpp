@@ -0,0 +1,419 @@
+#include "jsonreader.h"
+
+JsonReader::JsonReader( const QByteArray &data )
+    : p( data.constData() ),
+      end( data.constData() + data.size() )
+{
+}
+
+JsonReader::JsonReader( const char *data, const int size )
+    : p( data ),
+      end( data + size )
+{
+}
+
+JsonReader::Type JsonReader::peekType()
+{
+    skipWhitespace();
+
+    if ( p >= end )
+        return has_error ? TypeInvalid : TypeEnd;
+
+    switch ( *p )
+    {
+    case '{':
+        return TypeObject;
+    case '[':
+        return TypeArray;
+    case '"':
+        return TypeString;
+    case 't':
+    case 'f':
+        return TypeBool;
+    case 'n':
+        return TypeNull;
+    default:
+        break;
+    }
+
+    if ( *p == '-' || ( *p >= '0' && *p <= '9' ) )
+        return TypeNumber;
+
+    return TypeInvalid;
+}
+
+bool JsonReader::beginObject()
+{
+    skipWhitespace();
+
+    if ( p >= end || *p != '{' )
+        return fail();
+
+    p++;
+    return true;
+}
+
+bool JsonReader::beginArray()
+{
+    skipWhitespace();
+
+    if ( p >= end || *p != '[' )
+        return fail();
+
+    p++;
+    return true;
+}
+
+bool JsonReader::nextKey( QLatin1String &key )
+{
+    skipWhitespace();
+
+    if ( p < end && *p == ',' )
+    {
+        p++;
+        skipWhitespace();
+    }
+
+    if ( p >= end )
+        return fail();
+
+    if ( *p == '}' )
+    {
+        p++;
+        return false;
+    }
+
+    const char *begin;
+    int size;
+    bool has_escapes;
+
+    if ( !scanString( begin, size, has_escapes ) )
+        return false;
+
+    skipWhitespace();
+
+    if ( p >= end || *p != ':' )
+        return fail();
+
+    p++;
+    key = QLatin1String( begin, size );
+    return true;
+}
+
+bool JsonReader::nextElement()
+{
+    skipWhitespace();
+
+    if ( p < end && *p == ',' )
+    {
+        p++;
+        skipWhitespace();
+    }
+
+    if ( p >= end )
+        return fail();
+
+    if ( *p == ']' )
+    {
+        p++;
+        return false;
+    }
+
+    return true;
+}
+
+bool JsonReader::readStringView( QLatin1String &out )
+{
+    if ( peekType() != TypeString )
+    {
+        skipValue();
+        return false;
+    }
+
+    const char *begin;
+    int size;
+    bool has_escapes;
+
+    if ( !scanString( begin, size, has_escapes ) )
+        return false;
+
+    out = QLatin1String( begin, size );
+    return true;
+}
+
+QString JsonReader::readString()
+{
+    if ( peekType() != TypeString )
+    {
+        skipValue();
+        return QString();
+    }
+
+    const char *begin;
+    int size;
+    bool has_escapes;
+
+    if ( !scanString( begin, size, has_escapes ) )
+        return QString();
+
+    if ( !has_escapes )
+        return QString::fromUtf8( begin, size );
+
+    // decode escapes
+    QString ret;
+    ret.reserve( size );
+
+    const char *segment = begin;
+    const char *const string_end = begin + size;
+
+    for ( const char *c = begin; c < string_end; c++ )
+    {
+        if ( *c != '\\' )
+            continue;
+
+        ret += QString::fromUtf8( segment, c - segment );
+
+        if ( ++c >= string_end )
+            break;
+
+        switch ( *c )
+        {
+        case 'b': ret += QChar( '\b' ); break;
+        case 'f': ret += QChar( '\f' ); break;
+        case 'n': ret += QChar( '\n' ); break;
+        case 'r': ret += QChar( '\r' ); break;
+        case 't': ret += QChar( '\t' ); break;
+        case 'u':
+            if ( string_end - c > 4 )
+            {
+                bool ok = false;
+                const ushort code_unit = QByteArray( c + 1, 4 ).toUShort( &ok, 16 );
+
+                if ( ok )
+                    ret += QChar( code_unit );
+
+                c += 4;
+            }
+            break;
+        default: ret += QChar( *c ); break; // \" \\ \/
+        }
+
+        segment = c + 1;
+    }
+
+    ret += QString::fromUtf8( segment, string_end - segment );
+    return ret;
+}
+
+bool JsonReader::readCoin( Coin &out )
+{
+    const char *begin;
+    int size;
+    bool is_null;
+
+    if ( !scanScalar( begin, size, is_null ) || is_null )
+        return false;
+
+    return Coin::fromDecimal( begin, size, out );
+}
+
+bool JsonReader::readInt64( qint64 &out )
+{
+    const char *begin;
+    int size;
+    bool is_null;
+
+    if ( !scanScalar( begin, size, is_null ) || is_null || size < 1 )
+        return false;
+
+    const char *c = begin;
+    const char *const number_end = begin + size;
+    const bool negative = *c == '-';
+
+    if ( negative )
+        c++;
+
+    if ( c >= number_end )
+        return false;
+
+    qint64 ret = 0;
+    for ( ; c < number_end; c++ )
+    {
+        if ( *c < '0' || *c > '9' )
+            return false;
+
+        ret = ret * 10 + ( *c - '0' );
+    }
+
+    out = negative ? -ret : ret;
+    return true;
+}
+
+bool JsonReader::readBool( bool &out )
+{
+    skipWhitespace();
+
+    if ( p >= end || ( *p != 't' && *p != 'f' ) )
+    {
+        skipValue();
+        return false;
+    }
+
+    out = *p == 't';
+    return scanLiteral();
+}
+
+bool JsonReader::skipValue()
+{
+    const Type type = peekType();
+
+    if ( type == TypeString )
+    {
+        const char *begin;
+        int size;
+        bool has_escapes;
+
+        return scanString( begin, size, has_escapes );
+    }
+    else if ( type == TypeNumber )
+    {
+        const char *begin;
+        int size;
+
+        return scanNumber( begin, size );
+    }
+    else if ( type == TypeBool || type == TypeNull )
+    {
+        return scanLiteral();
+    }
+    else if ( type != TypeObject && type != TypeArray )
+    {
+        return fail();
+    }
+
+    // walk over the container, only strings need special care
+    qint32 depth = 0;
+    do
+    {
+        if ( p >= end )
+            return fail();
+
+        if ( *p == '"' )
+        {
+            const char *begin;
+            int size;
+            bool has_escapes;
+
+            if ( !scanString( begin, size, has_escapes ) )
+                return false;
+
+            continue;
+        }
+
+        if ( *p == '{' || *p == '[' )
+            depth++;
+        else if ( *p == '}' || *p == ']' )
+            depth--;
+
+        p++;
+    }
+    while ( depth > 0 );
+
+    return true;
+}
+
+void JsonReader::skipWhitespace()
+{
+    while ( p < end && ( *p == ' ' || *p == '\n' || *p == '\r' || *p == '\t' ) )
+        p++;
+}
+
+bool JsonReader::scanString( const char *&begin, int &size, bool &has_escapes )
+{
+    if ( p >= end || *p != '"' )
+        return fail();
+
+    begin = ++p;
+    has_escapes = false;
+
+    while ( p < end && *p != '"' )
+    {
+        if ( *p == '\\' )
+        {
+            has_escapes = true;
+            p++;
+        }
+
+        p++;
+    }
+
+    if ( p >= end )
+        return fail();
+
+    size = p - begin;
+    p++; // closing quote
+    return true;
+}
+
+bool JsonReader::scanNumber( const char *&begin, int &size )
+{
+    begin = p;
+
+    while ( p < end && ( ( *p >= '0' && *p <= '9' ) || *p == '-' || *p == '+' || *p == '.' || *p == 'e' || *p == 'E' ) )
+        p++;
+
+    size = p - begin;
+
+    if ( size == 0 )
+        return fail();
+
+    return true;
+}
+
+bool JsonReader::scanLiteral()
+{
+    const char *begin = p;
+
+    while ( p < end && *p >= 'a' && *p <= 'z' )
+        p++;
+
+    const QLatin1String literal( begin, p - begin );
+
+    if ( literal != QLatin1String( "true" ) &&
+         literal != QLatin1String( "false" ) &&
+         literal != QLatin1String( "null" ) )
+        return fail();
+
+    return true;
+}
+
+bool JsonReader::scanScalar( const char *&begin, int &size, bool &is_null )
+{
+    const Type type = peekType();
+    is_null = false;
+
+    if ( type == TypeString )
+    {
+        bool has_escapes;
+        return scanString( begin, size, has_escapes );
+    }
+    else if ( type == TypeNumber )
+    {
+        return scanNumber( begin, size );
+    }
+    else if ( type == TypeNull )
+    {
+        is_null = true;
+        return scanLiteral();
+    }
+
+    skipValue();
+    return false;
+}
+
+bool JsonReader::fail()
+{
+    has_error = true;
+    p = end;
+    return false;
+}
@@ -0,0 +1,72 @@
+#ifndef JSONREADER_H
+#define JSONREADER_H
+
+#include "coinamount.h"
+
+#include <QByteArray>
+#include <QLatin1String>
+#include <QString>
+
+//
+// JsonReader, forward-only pull reader over a utf-8 json buffer
+//
+// values are read in place instead of building a QJsonDocument tree. keys and plain strings come back as views
+// into the buffer, and numbers (bare or quoted, as exchanges like to send them) go straight into a Coin. the buffer
+// must outlive the reader and any views taken from it.
+//
+// usage:
+//   JsonReader r( data );
+//   if ( r.beginArray() )
+//       while ( r.nextElement() )
+//           r.skipValue();
+//   if ( r.hasError() ) ...
+//
+class JsonReader
+{
+public:
+    enum Type : quint8
+    {
+        TypeInvalid = 0,
+        TypeObject,
+        TypeArray,
+        TypeString,
+        TypeNumber,
+        TypeBool,
+        TypeNull,
+        TypeEnd
+    };
+
+    explicit JsonReader( const QByteArray &data );
+    explicit JsonReader( const char *data, const int size );
+
+    bool hasError() const { return has_error; }
+    Type peekType();
+
+    // containers, nextKey() and nextElement() return false after consuming the closing bracket
+    bool beginObject();
+    bool beginArray();
+    bool nextKey( QLatin1String &key );
+    bool nextElement();
+
+    // values, these consume the value even if it's the wrong type
+    bool readStringView( QLatin1String &out ); // raw contents, escapes are not decoded
+    QString readString();
+    bool readCoin( Coin &out );
+    bool readInt64( qint64 &out );
+    bool readBool( bool &out );
+    bool skipValue();
+
+private:
+    void skipWhitespace();
+    bool scanString( const char *&begin, int &size, bool &has_escapes );
+    bool scanNumber( const char *&begin, int &size );
+    bool scanLiteral();
+    bool scanScalar( const char *&begin, int &size, bool &is_null );
+    bool fail();
+
+    const char *p{ nullptr };
+    const char *end{ nullptr };
+    bool has_error{ false };
+};
+
+#endif // JSONREADER_H
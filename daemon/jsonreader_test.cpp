@@ -0,0 +1,140 @@
+#include "jsonreader_test.h"
+#include "jsonreader.h"
+#include "coinamount.h"
+
+#include <assert.h>
+
+void JsonReaderTest::test()
+{
+    /// test Coin::fromDecimal
+    Coin c;
+    assert( Coin::fromDecimal( "0.00012345", 10, c ) && c == "0.00012345" );
+    assert( Coin::fromDecimal( "-12.5", 5, c ) && c == "-12.5" );
+    assert( Coin::fromDecimal( "42", 2, c ) && c == "42" );
+    assert( Coin::fromDecimal( ".5", 2, c ) && c == "0.5" );
+    assert( Coin::fromDecimal( "1e-8", 4, c ) && c == CoinAmount::SATOSHI );
+    assert( Coin::fromDecimal( "0.00000000000000019", 19, c ) && c == CoinAmount::SUBSATOSHI );
+    assert( !Coin::fromDecimal( "", 0, c ) );
+    assert( !Coin::fromDecimal( "-", 1, c ) );
+    assert( !Coin::fromDecimal( "1.2.3", 5, c ) );
+    assert( !Coin::fromDecimal( "12abc", 5, c ) );
+
+    /// test object walk with mixed value types
+    {
+        const QByteArray data( " { \"symbol\": \"BTCUSDT\", \"orderId\": 28, \"price\": \"0.10000000\", \"qty\": 1.5,"
+                               " \"isWorking\": true, \"stop\": null, \"fills\": [ { \"a\": [ 1, 2 ] }, \"]\" ], \"n\": \"a\\\"b\" } " );
+        JsonReader r( data );
+
+        QLatin1String key, symbol;
+        qint64 order_id = 0;
+        Coin price, qty;
+        bool working = false;
+        QString n;
+        int keys = 0;
+
+        assert( r.beginObject() );
+        while ( r.nextKey( key ) )
+        {
+            keys++;
+
+            if ( key == QLatin1String( "symbol" ) )
+                assert( r.readStringView( symbol ) );
+            else if ( key == QLatin1String( "orderId" ) )
+                assert( r.readInt64( order_id ) );
+            else if ( key == QLatin1String( "price" ) )
+                assert( r.readCoin( price ) );
+            else if ( key == QLatin1String( "qty" ) )
+                assert( r.readCoin( qty ) );
+            else if ( key == QLatin1String( "isWorking" ) )
+                assert( r.readBool( working ) );
+            else if ( key == QLatin1String( "stop" ) )
+                assert( !r.readCoin( price ) ); // null is consumed but not read
+            else if ( key == QLatin1String( "n" ) )
+                n = r.readString();
+            else
+                assert( r.skipValue() );
+        }
+
+        assert( !r.hasError() );
+        assert( r.peekType() == JsonReader::TypeEnd );
+        assert( keys == 8 );
+        assert( symbol == QLatin1String( "BTCUSDT" ) );
+        assert( order_id == 28 );
+        assert( price == "0.1" );
+        assert( qty == "1.5" );
+        assert( working );
+        assert( n == "a\"b" );
+    }
+
+    /// test nested arrays, like an orderbook side
+    {
+        const QByteArray data( "[[\"0.1\",\"2\"],[\"0.2\",\"3\"],[]]" );
+        JsonReader r( data );
+
+        Coin total;
+        int rows = 0;
+
+        assert( r.beginArray() );
+        while ( r.nextElement() )
+        {
+            assert( r.beginArray() );
+
+            Coin price, qty;
+            int col = 0;
+            while ( r.nextElement() )
+            {
+                if ( col == 0 )
+                    assert( r.readCoin( price ) );
+                else
+                    assert( r.readCoin( qty ) );
+
+                col++;
+            }
+
+            total += price * qty;
+            rows++;
+        }
+
+        assert( !r.hasError() );
+        assert( rows == 3 );
+        assert( total == "0.8" );
+    }
+
+    /// test truncated and malformed input sets the error state
+    {
+        const QByteArray data( "{\"a\": [1, 2" );
+        JsonReader r( data );
+        QLatin1String key;
+
+        assert( r.beginObject() );
+        assert( r.nextKey( key ) );
+        assert( !r.skipValue() );
+        assert( r.hasError() );
+        assert( !r.nextKey( key ) );
+    }
+    {
+        const QByteArray data( "{\"a\" 1}" );
+        JsonReader r( data );
+        QLatin1String key;
+
+        assert( r.beginObject() );
+        assert( !r.nextKey( key ) );
+        assert( r.hasError() );
+    }
+    {
+        const QByteArray data( "[tru]" );
+        JsonReader r( data );
+        bool b;
+
+        assert( r.beginArray() );
+        assert( r.nextElement() );
+        assert( !r.readBool( b ) );
+        assert( r.hasError() );
+    }
+    {
+        const QByteArray data( "{}" );
+        JsonReader r( data );
+        assert( !r.beginArray() );
+        assert( r.hasError() );
+    }
+}
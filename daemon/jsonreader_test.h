@@ -0,0 +1,9 @@
+#ifndef JSONREADER_TEST_H
+#define JSONREADER_TEST_H
+
+struct JsonReaderTest
+{
+    void test();
+};
+
+#endif // JSONREADER_TEST_H
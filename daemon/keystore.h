@@ -1,9 +1,12 @@
 #ifndef KEYSTORE_H
 #define KEYSTORE_H
 
+#include "hmacutil.h"
+
 #include <assert.h>
 
 #include <QByteArray>
+#include <QCryptographicHash>
 #include <QPair>
 #include <QVector>
 #include <QRandomGenerator>
@@ -44,6 +47,10 @@ public:
         const QByteArray &pad_to_use = m_getPad();
         m_key = xorDecodeEncode( key, pad_to_use );
         m_secret = xorDecodeEncode( secret, pad_to_use );
+
+        // precompute hmac key schedules so signing never has to decode the secret
+        m_sha256_midstate = xorDecodeEncode( HmacUtil::getMidstate( secret, QCryptographicHash::Sha256 ), pad_to_use );
+        m_sha512_midstate = xorDecodeEncode( HmacUtil::getMidstate( secret, QCryptographicHash::Sha512 ), pad_to_use );
     }
 
     void test()
@@ -62,6 +69,8 @@ public:
         m_pad.clear();
         m_key.clear();
         m_secret.clear();
+        m_sha256_midstate.clear();
+        m_sha512_midstate.clear();
         m_offset = 0;
     }
 
@@ -70,10 +79,10 @@ public:
         if ( k.isEmpty() || m.isEmpty() )
             return QByteArray();
 
-        QByteArray ret;
+        QByteArray ret( m.size(), char( 0 ) );
         const int k_size = k.size();
         for ( int i = 0; i < m.size(); i++ )
-            ret += m[ i ] ^ k.at( i % k_size );
+            ret[ i ] = m.at( i ) ^ k.at( i % k_size );
 
         assert( ret.size() == m.size() );
         return ret;
@@ -83,10 +92,18 @@ public:
     QByteArray getKey() const { return xorDecodeEncode( m_key, m_getPad() ); }
     QByteArray getSecret() const { return xorDecodeEncode( m_secret, m_getPad() ); }
 
+    // hmac signature of message keyed with the secret, algo is Sha256 or Sha512
+    QByteArray getSignature( const QByteArray &message, const QCryptographicHash::Algorithm algo ) const
+    {
+        const QByteArray &midstate = ( algo == QCryptographicHash::Sha512 ) ? m_sha512_midstate : m_sha256_midstate;
+        return HmacUtil::sign( xorDecodeEncode( midstate, m_getPad() ), message, algo );
+    }
+
 private:
     const QByteArray m_getPad() const { return m_pad.mid( m_offset, pad_size ); }
 
     QByteArray m_key, m_secret, m_pad;
+    QByteArray m_sha256_midstate, m_sha512_midstate;
     quint16 m_offset;
 };
 
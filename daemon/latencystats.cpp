@@ -0,0 +1,195 @@
+#include "latencystats.h"
+
+#include <QtAlgorithms>
+#include <QtMath>
+#include <QDateTime>
+
+void LatencyHistogram::clear()
+{
+    for ( int i = 0; i < bucket_count; i++ )
+        buckets[ i ] = 0;
+
+    count = 0;
+    total = 0;
+    max = 0;
+}
+
+void LatencyHistogram::record( qint64 value_us )
+{
+    value_us = qMax<qint64>( value_us, 0 );
+
+    buckets[ bucketIndex( value_us ) ]++;
+    count++;
+    total += quint64( value_us );
+    max = qMax( max, value_us );
+}
+
+void LatencyHistogram::add( const LatencyHistogram &other )
+{
+    for ( int i = 0; i < bucket_count; i++ )
+        buckets[ i ] += other.buckets[ i ];
+
+    count += other.count;
+    total += other.total;
+    max = qMax( max, other.max );
+}
+
+qint64 LatencyHistogram::getPercentile( const qreal percentile ) const
+{
+    if ( count == 0 )
+        return 0;
+
+    // find the bucket holding the nth sample, and report its upper bound
+    const quint64 target = qMax<quint64>( 1, quint64( qCeil( qBound( 0., percentile, 100. ) / 100. * count ) ) );
+    quint64 seen = 0;
+
+    for ( int i = 0; i < bucket_count; i++ )
+    {
+        seen += buckets[ i ];
+
+        if ( seen >= target )
+            return qMin( bucketUpperBound( i ), max );
+    }
+
+    return max;
+}
+
+int LatencyHistogram::bucketIndex( qint64 value_us )
+{
+    // clamp to the tracked range
+    value_us = qMin<qint64>( value_us, ( Q_INT64_C( 1 ) << ( magnitude_count + sub_bucket_bits ) ) -1 );
+
+    if ( value_us < ( 1 << sub_bucket_bits ) )
+        return int( value_us );
+
+    // shift the value down until it has sub_bucket_bits bits left, the shift picks the magnitude
+    const int shift = 63 - qCountLeadingZeroBits( quint64( value_us ) ) - ( sub_bucket_bits -1 );
+
+    return shift * half_count + int( value_us >> shift );
+}
+
+qint64 LatencyHistogram::bucketUpperBound( const int index )
+{
+    if ( index < ( 1 << sub_bucket_bits ) )
+        return index;
+
+    const int shift = index / half_count -1;
+    const qint64 sub_bucket = index - shift * half_count;
+
+    return ( ( sub_bucket +1 ) << shift ) -1;
+}
+
+void LatencyWindow::rotate( const qint64 now_ms )
+{
+    previous = current;
+    previous_start_ms = current_start_ms;
+
+    current.clear();
+    current_start_ms = now_ms;
+}
+
+LatencyHistogram LatencyWindow::merged() const
+{
+    LatencyHistogram ret = current;
+    ret.add( previous );
+    return ret;
+}
+
+qreal LatencyWindow::getRate( const qint64 now_ms ) const
+{
+    const qint64 start_ms = previous_start_ms > 0 ? previous_start_ms : current_start_ms;
+    const qint64 elapsed_ms = now_ms - start_ms;
+
+    if ( start_ms <= 0 || elapsed_ms <= 0 )
+        return 0.;
+
+    return qreal( current.getCount() + previous.getCount() ) * 1000. / elapsed_ms;
+}
+
+void LatencyStats::record( const LatencyKind kind, const QString &label, const qint64 value_us, const qint64 now_ms )
+{
+    if ( kind >= LATENCY_KIND_COUNT )
+        return;
+
+    LatencyWindow &window = by_label[ kind ][ label ];
+
+    // start the window at the first sample
+    if ( window.current_start_ms == 0 )
+        window.current_start_ms = now_ms;
+    if ( total[ kind ].current_start_ms == 0 )
+        total[ kind ].current_start_ms = now_ms;
+
+    window.record( value_us );
+    total[ kind ].record( value_us );
+}
+
+void LatencyStats::rotate( const qint64 now_ms )
+{
+    for ( int kind = 0; kind < LATENCY_KIND_COUNT; kind++ )
+    {
+        total[ kind ].rotate( now_ms );
+
+        for ( QMap<QString, LatencyWindow>::iterator i = by_label[ kind ].begin(); i != by_label[ kind ].end(); i++ )
+            i.value().rotate( now_ms );
+    }
+}
+
+QStringList LatencyStats::getReport( const qint64 now_ms ) const
+{
+    QStringList ret;
+
+    for ( int kind = 0; kind < LATENCY_KIND_COUNT; kind++ )
+    {
+        const QString kind_str = getKindStr( LatencyKind( kind ) );
+
+        ret += formatLine( kind_str + " all", total[ kind ].merged(), total[ kind ].getRate( now_ms ) );
+
+        for ( QMap<QString, LatencyWindow>::const_iterator i = by_label[ kind ].begin(); i != by_label[ kind ].end(); i++ )
+            ret += formatLine( QString( "%1 %2" ).arg( kind_str ).arg( i.key() ), i.value().merged(), i.value().getRate( now_ms ) );
+    }
+
+    return ret;
+}
+
+QString LatencyStats::getSummary() const
+{
+    const LatencyHistogram response = total[ LatencyResponse ].merged();
+    const LatencyHistogram queue = total[ LatencyQueue ].merged();
+    const LatencyHistogram parse = total[ LatencyParse ].merged();
+
+    return QString( "latency: response p50 %1ms p99 %2ms p999 %3ms (%4 samples), queue p99 %5ms, parse p99 %6us" )
+            .arg( response.getPercentile( 50. ) / 1000 )
+            .arg( response.getPercentile( 99. ) / 1000 )
+            .arg( response.getPercentile( 99.9 ) / 1000 )
+            .arg( response.getCount() )
+            .arg( queue.getPercentile( 99. ) / 1000 )
+            .arg( parse.getPercentile( 99. ) );
+}
+
+QString LatencyStats::getKindStr( const LatencyKind kind )
+{
+    switch ( kind )
+    {
+    case LatencyResponse:
+        return "response";
+    case LatencyQueue:
+        return "queue";
+    case LatencyParse:
+        return "parse";
+    default:
+        return "unknown";
+    }
+}
+
+QString LatencyStats::formatLine( const QString &name, const LatencyHistogram &h, const qreal rate )
+{
+    // parse times are small, print everything in microseconds and let the reader divide
+    return QString( "%1 n: %2 rate: %3/s p50: %4us p99: %5us p999: %6us max: %7us" )
+            .arg( name, -36 )
+            .arg( h.getCount(), -8 )
+            .arg( rate, -6, 'f', 2 )
+            .arg( h.getPercentile( 50. ), -9 )
+            .arg( h.getPercentile( 99. ), -9 )
+            .arg( h.getPercentile( 99.9 ), -9 )
+            .arg( h.getMax() );
+}
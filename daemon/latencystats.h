@@ -0,0 +1,91 @@
+#ifndef LATENCYSTATS_H
+#define LATENCYSTATS_H
+
+#include <QtGlobal>
+#include <QString>
+#include <QStringList>
+#include <QMap>
+
+//
+// LatencyHistogram, log-linear buckets in microseconds
+//
+// values below 2^sub_bucket_bits are exact, above that every power of two is split into half_count linear
+// buckets, so a recorded value is off by at most 1/half_count (~3%) no matter the magnitude.
+//
+class LatencyHistogram
+{
+public:
+    explicit LatencyHistogram() { clear(); }
+
+    void clear();
+    void record( qint64 value_us );
+    void add( const LatencyHistogram &other );
+
+    quint64 getCount() const { return count; }
+    qint64 getMax() const { return max; }
+    qint64 getMean() const { return count == 0 ? 0 : qint64( total / count ); }
+    qint64 getPercentile( const qreal percentile ) const; // 0-100
+
+    static const int sub_bucket_bits = 5;
+    static const int half_count = 1 << ( sub_bucket_bits -1 );
+    static const int magnitude_count = 36; // up to 2^40us
+    static const int bucket_count = ( magnitude_count +2 ) * half_count;
+
+    static int bucketIndex( qint64 value_us );
+    static qint64 bucketUpperBound( const int index );
+
+private:
+    quint32 buckets[ bucket_count ];
+    quint64 count{ 0 };
+    quint64 total{ 0 };
+    qint64 max{ 0 };
+};
+
+//
+// LatencyWindow, two histograms that are rotated so old samples age out
+//
+struct LatencyWindow
+{
+    void record( const qint64 value_us ) { current.record( value_us ); }
+    void rotate( const qint64 now_ms );
+
+    LatencyHistogram merged() const;
+    qreal getRate( const qint64 now_ms ) const; // samples per second over the window
+
+    LatencyHistogram current, previous;
+    qint64 previous_start_ms{ 0 };
+    qint64 current_start_ms{ 0 };
+};
+
+enum LatencyKind : quint8
+{
+    LatencyResponse = 0, // request sent to reply received
+    LatencyQueue, // request queued to request sent
+    LatencyParse, // reply received to reply handled
+    LATENCY_KIND_COUNT
+};
+
+//
+// LatencyStats, latency windows per exchange, per kind and per api command
+//
+class LatencyStats
+{
+public:
+    explicit LatencyStats() {}
+
+    void record( const LatencyKind kind, const QString &label, const qint64 value_us, const qint64 now_ms );
+    void rotate( const qint64 now_ms );
+
+    QStringList getReport( const qint64 now_ms ) const;
+    QString getSummary() const;
+    const LatencyWindow &getTotal( const LatencyKind kind ) const { return total[ kind ]; }
+
+    static QString getKindStr( const LatencyKind kind );
+    static QString formatLine( const QString &name, const LatencyHistogram &h, const qreal rate );
+
+private:
+    QMap<QString, LatencyWindow> by_label[ LATENCY_KIND_COUNT ];
+    LatencyWindow total[ LATENCY_KIND_COUNT ];
+};
+
+#endif // LATENCYSTATS_H
@@ -0,0 +1,71 @@
+#include "latencystats_test.h"
+#include "latencystats.h"
+
+#include <assert.h>
+
+void LatencyStatsTest::test()
+{
+    /// test bucket boundaries
+    assert( LatencyHistogram::bucketIndex( 0 ) == 0 );
+    assert( LatencyHistogram::bucketIndex( 31 ) == 31 );
+    assert( LatencyHistogram::bucketIndex( 32 ) == 32 );
+    assert( LatencyHistogram::bucketIndex( 33 ) == 32 );
+    assert( LatencyHistogram::bucketIndex( 34 ) == 33 );
+    assert( LatencyHistogram::bucketUpperBound( 31 ) == 31 );
+    assert( LatencyHistogram::bucketUpperBound( 32 ) == 33 );
+    assert( LatencyHistogram::bucketIndex( Q_INT64_C( 1 ) << 50 ) == LatencyHistogram::bucket_count -1 );
+
+    // buckets stay within ~3% at any magnitude
+    for ( qint64 v = 1; v < Q_INT64_C( 1 ) << 40; v = v * 3 + 1 )
+    {
+        const qint64 upper = LatencyHistogram::bucketUpperBound( LatencyHistogram::bucketIndex( v ) );
+        assert( upper >= v );
+        assert( upper - v <= v / LatencyHistogram::half_count );
+    }
+
+    /// test percentiles
+    LatencyHistogram h;
+    for ( qint64 v = 1; v <= 100; v++ )
+        h.record( v );
+
+    assert( h.getCount() == 100 );
+    assert( h.getMax() == 100 );
+    assert( h.getMean() == 50 );
+    assert( h.getPercentile( 50. ) == 51 );
+    assert( h.getPercentile( 99. ) == 99 );
+    assert( h.getPercentile( 100. ) == 100 ); // capped by max
+
+    // one slow sample shows up in the tail but not the median
+    h.record( 5000000 );
+    assert( h.getPercentile( 50. ) == 51 );
+    assert( h.getPercentile( 99.9 ) >= 5000000 );
+
+    /// test window rotation ages out old samples
+    const qint64 t0 = 1000000;
+    LatencyWindow window;
+    window.current_start_ms = t0;
+
+    for ( int i = 0; i < 10; i++ )
+        window.record( 1000 );
+
+    window.rotate( t0 + 1000 );
+    for ( int i = 0; i < 10; i++ )
+        window.record( 2000 );
+
+    assert( window.merged().getCount() == 20 );
+    assert( window.getRate( t0 + 2000 ) == 10. );
+
+    window.rotate( t0 + 2000 );
+    assert( window.merged().getCount() == 10 );
+    assert( window.merged().getMax() == 2000 );
+
+    /// test stats per label
+    LatencyStats stats;
+    stats.record( LatencyResponse, "order", 100000, t0 );
+    stats.record( LatencyResponse, "cancel", 200000, t0 );
+    stats.record( LatencyParse, "order", 50, t0 );
+
+    assert( stats.getTotal( LatencyResponse ).merged().getCount() == 2 );
+    assert( stats.getTotal( LatencyParse ).merged().getCount() == 1 );
+    assert( stats.getReport( t0 + 1000 ).size() == LATENCY_KIND_COUNT + 3 );
+}
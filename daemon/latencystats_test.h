@@ -0,0 +1,9 @@
+#ifndef LATENCYSTATS_TEST_H
+#define LATENCYSTATS_TEST_H
+
+struct LatencyStatsTest
+{
+    void test();
+};
+
+#endif // LATENCYSTATS_TEST_H
@@ -83,7 +83,7 @@ struct MarketInfo
     Spread spread;
 
     // ping-pong settings
-    QVector<PositionData> /*position_index*/ position_index;
+    PositionIndex /*position_index*/ position_index;
     qint32 /*order count limit*/ order_min{ 5 };
     qint32 /*order count limit*/ order_max{ 10 };
     qint32 /*order count combine*/ order_dc{ 1 };
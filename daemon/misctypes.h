@@ -2,23 +2,44 @@
 #define MISCTYPES_H
 
 #include "coinamount.h"
+#include "ratelimiter.h"
 
 #include <QString>
 #include <QByteArray>
 #include <QVector>
 #include <QQueue>
+#include <QElapsedTimer>
 
 class Position;
 
+// index+generation reference into PositionPool, stays safe to test after the position is gone
+struct PositionHandle
+{
+    quint32 index{ 0 };
+    quint32 generation{ 0 }; // 0 is never issued, so a default handle is null
+
+    bool isNull() const { return generation == 0; }
+    bool operator==( const PositionHandle &other ) const { return index == other.index && generation == other.generation; }
+    bool operator!=( const PositionHandle &other ) const { return !( *this == other ); }
+};
+
 struct Request
 {
     explicit Request() {}
 
     QString api_command;
     QString body;
+    qint64 time_queued_ms{ 0 }; // queue wait latency
     qint64 time_sent_ms{ 0 }; // track timeouts
+    QElapsedTimer parse_timer; // started when the reply arrives
     quint16 weight{ 0 }; // for binance, command weight
+    RateClass rate_class{ RATE_CLASS_COUNT }; // set while the request is in flight
+    RateClass queue_class{ RATE_CLASS_COUNT }; // set while the request is queued
+    qint32 queue_index{ -1 }; // heap slot in RequestQueue, -1 if not queued
+    quint64 queue_sequence{ 0 }; // fifo order for equal priority
+    Coin priority; // send order within the rate class, highest first
     Position *pos{ nullptr };
+    PositionHandle pos_handle; // checked before pos is dereferenced
 };
 
 struct OrderInfo
@@ -61,23 +82,6 @@ struct Spread
     Coin ask;
 };
 
-class AvgResponseTime
-{
-public:
-    explicit AvgResponseTime() {}
-
-    void addResponseTime( quint64 time )
-    {
-        total += time;
-        iterations++;
-    }
-    quint64 avgResponseTime() const { return iterations == 0 ? 0 : total / iterations; }
-
-private:
-    quint64 total{ 0 },
-            iterations{ 0 };
-};
-
 class CoinAverage
 {
 public:
@@ -4,6 +4,7 @@
 #include "engine.h"
 #include "enginesettings.h"
 #include "coinamount.h"
+#include "jsonreader.h"
 
 #include <QTimer>
 #include <QNetworkAccessManager>
@@ -59,9 +60,14 @@ void PoloREST::init()
     // setup currency ids
     setupCurrencyMap( currency_name_by_id );
 
-    // we use this to send the requests at a predictable rate
-    connect( send_timer, &QTimer::timeout, this, &PoloREST::sendNamQueue );
-    send_timer->start( POLONIEX_TIMER_INTERVAL_NAM_SEND ); // minimum threshold 200 or so
+    // send requests as soon as we have tokens, at up to 5 per second
+    BaseREST::send_idle_interval = POLONIEX_TIMER_INTERVAL_NAM_SEND;
+    initRateLimits( 1000. / POLONIEX_TIMER_INTERVAL_NAM_SEND, 3. );
+
+    // trading api nonces have to arrive in order, so keep few private requests in flight
+    BaseREST::limit_in_flight_orders = 3;
+    initSession( QStringList() << POLO_URL_TRADE << POLO_URL_PUBLIC, true );
+    scheduleSend();
 
     connect( ticker_timer, &QTimer::timeout, this, &PoloREST::onCheckTicker );
     ticker_timer->start( POLONIEX_TIMER_INTERVAL_TICKER );
@@ -110,12 +116,8 @@ bool PoloREST::yieldToLag() const
 void PoloREST::sendNamRequest( Request *const &request )
 {
     // check for valid pos
-    if ( request->pos != nullptr && !engine->getPositionMan()->isValid( request->pos ) )
-    {
-        kDebug() << getExchangeFancyStr() << "local warning: caught nam request with invalid position";
-        nam_queue.removeOne( request );
+    if ( dropStaleRequest( request ) )
         return;
-    }
 
     const qint64 current_time = QDateTime::currentMSecsSinceEpoch();
 
@@ -152,12 +154,13 @@ void PoloREST::sendNamRequest( Request *const &request )
 
     // add content header
     nam_request.setRawHeader( CONTENT_TYPE, CONTENT_TYPE_ARGS );
+    session->prepareRequest( nam_request );
 
     // incase we have POLONIEX_TICKER_ONLY enabled, don't sign a ticker request blank
     if ( request->api_command != POLO_COMMAND_GETBOOKS )
     {
         nam_request.setRawHeader( KEY, keystore.getKey() ); // add key header
-        nam_request.setRawHeader( SIGN, Global::getBittrexPoloSignature( query_bytes, keystore.getSecret() ) ); // add signature header
+        nam_request.setRawHeader( SIGN, keystore.getSignature( query_bytes, QCryptographicHash::Sha512 ).toHex() ); // add signature header
     }
 
     // add to sent queue so we can check if it timed out
@@ -190,7 +193,7 @@ void PoloREST::sendNamRequest( Request *const &request )
         return;
     }
 
-    nam_queue_sent.insert( reply, request );
+    trackSentRequest( reply, request );
     nam_queue.removeOne( request );
 
     last_request_sent_ms = current_time;
@@ -286,64 +289,120 @@ void PoloREST::parseCancelOrder( Request *const &request, const QJsonObject &res
     engine->processCancelledOrder( pos );
 }
 
-void PoloREST::parseOpenOrders( const QJsonObject &markets, qint64 request_time_sent_ms )
+bool PoloREST::decodeOpenOrders( const QByteArray &data, ParsedReply &out )
 {
-    const qint64 current_time = QDateTime::currentMSecsSinceEpoch(); // cache time
-    QVector<QString> order_numbers; // keep track of order numbers
-    QMultiHash<QString, OrderInfo> orders;
+    // {"BTC_ETH":[{"orderNumber":"120466","type":"sell","rate":"0.025","amount":"100","total":"2.5"},...],"BTC_XMR":[],...}
+    JsonReader reader( data );
+    QLatin1String market_key, key;
 
-    // is the orderbook is too old to be safe? check the stale tolerance
-    if ( request_time_sent_ms < current_time - orderbook_stale_tolerance )
-    {
-        orders_stale_trip_count++;
-        return;
-    }
+    if ( !reader.beginObject() )
+        return false;
 
-    // don't accept responses for requests sooner than the latest response request_time_sent_ms
-    if ( request_time_sent_ms < orderbook_update_request_time )
-        return;
+    while ( reader.nextKey( market_key ) )
+    {
+        // let the caller handle errors
+        if ( market_key == QLatin1String( "error" ) )
+            return false;
 
-    // set the timestamp of orderbook update if we saw any orders
-    orderbook_update_time = current_time;
-    orderbook_update_request_time = request_time_sent_ms;
+        out.market_count++;
 
-    for ( QJsonObject::const_iterator i = markets.begin(); i != markets.end(); i++ )
-    {
         // the first level is arrays of orders
-        if ( !i.value().isArray() )
+        if ( reader.peekType() != JsonReader::TypeArray )
+        {
+            reader.skipValue();
             continue;
+        }
 
-        const QString &market = i.key();
-        const QJsonArray &exchange_orders = i.value().toArray();
+        const QString market = QString( market_key );
 
-        for ( int j = 0; j < exchange_orders.size(); ++j )
+        reader.beginArray();
+        while ( reader.nextElement() )
         {
             // the second level is arrays of objects
-            if ( !exchange_orders[j].isObject() )
+            if ( reader.peekType() != JsonReader::TypeObject )
+            {
+                reader.skipValue();
                 continue;
+            }
 
-            const QJsonObject &order = exchange_orders[j].toObject();
-            const QString &order_number = order.value( "orderNumber" ).toString();
-            const QString &side = order.value( "type" ).toString();
-            const QString &price = Coin( order.value( "rate" ).toString() ); // reformat into padded
-            const QString &amount = Coin( order.value( "total" ).toString() ); // reformat into padded
+            QString order_number;
+            QLatin1String side;
+            Coin price, amount;
+
+            reader.beginObject();
+            while ( reader.nextKey( key ) )
+            {
+                if ( key == QLatin1String( "orderNumber" ) )
+                    order_number = reader.readString();
+                else if ( key == QLatin1String( "type" ) )
+                    reader.readStringView( side );
+                else if ( key == QLatin1String( "rate" ) )
+                    reader.readCoin( price );
+                else if ( key == QLatin1String( "total" ) )
+                    reader.readCoin( amount );
+                else
+                    reader.skipValue();
+            }
 
             // check for missing information
             if ( market.isEmpty() ||
                  order_number.isEmpty() ||
-                 side.isEmpty() ||
-                 price.isEmpty() ||
-                 amount.isEmpty() )
+                 side.size() == 0 ||
+                 price.isZeroOrLess() ||
+                 amount.isZeroOrLess() )
                 continue;
 
-            // insert into seen orders
-            order_numbers.append( order_number );
+            ParsedOrder order;
+            order.market = market;
+            order.order_number = order_number;
+            order.side = ( side == BUY ) ? SIDE_BUY :
+                         ( side == SELL ) ? SIDE_SELL : 0;
+            order.price = price;
+            order.amount = amount;
 
-            // insert (market, order)
-            orders.insert( market, OrderInfo( order_number, side == BUY ? SIDE_BUY : side == SELL ? SIDE_SELL : 0, price, amount ) );
+            out.orders += order;
         }
     }
 
+    // a blank or partial reply is treated as invalid
+    return !reader.hasError() && out.market_count > 0;
+}
+
+void PoloREST::applyOpenOrders( const ParsedReply &reply )
+{
+    const qint64 current_time = QDateTime::currentMSecsSinceEpoch(); // cache time
+    const qint64 &request_time_sent_ms = reply.request_time_sent_ms;
+
+    // is the orderbook is too old to be safe? check the stale tolerance
+    if ( request_time_sent_ms < current_time - orderbook_stale_tolerance )
+    {
+        orders_stale_trip_count++;
+        return;
+    }
+
+    // don't accept responses for requests sooner than the latest response request_time_sent_ms
+    if ( request_time_sent_ms < orderbook_update_request_time )
+        return;
+
+    QVector<QString> order_numbers; // keep track of order numbers
+    QMultiHash<QString, OrderInfo> orders;
+    order_numbers.reserve( reply.orders.size() );
+
+    for ( QVector<ParsedOrder>::const_iterator i = reply.orders.begin(); i != reply.orders.end(); i++ )
+    {
+        const ParsedOrder &order = *i;
+
+        // insert into seen orders
+        order_numbers.append( order.order_number );
+
+        // insert (market, order)
+        orders.insert( order.market, OrderInfo( order.order_number, order.side, order.price, order.amount ) );
+    }
+
+    // set the timestamp of orderbook update if we saw any orders
+    orderbook_update_time = current_time;
+    orderbook_update_request_time = request_time_sent_ms;
+
     engine->processOpenOrders( order_numbers, orders, request_time_sent_ms );
 }
 
@@ -404,8 +463,10 @@ void PoloREST::parseFeeInfo( const QJsonObject &info )
                              .arg( ( taker * 100 ).toAmountString().mid( 0, 4 ) )
                              .arg( thirty_day_volume );
 
+#if !defined( EXCHANGE_SIM_ENABLED )
         wss_timer->start( 30000 );
         wssCheckConnection(); // piggyback, submit wss stuff after first command sent
+#endif
     }
     else
     {
@@ -413,88 +474,129 @@ void PoloREST::parseFeeInfo( const QJsonObject &info )
     }
 }
 
-void PoloREST::parseOrderBook( const QJsonObject &info, qint64 request_time_sent_ms )
+bool PoloREST::decodeOrderBook( const QByteArray &data, ParsedReply &out )
 {
-    //kDebug() << info;
-
-    // check for data
-    if ( info.isEmpty() )
-        return;
+    //kDebug() << data;
 
-    const qint64 current_time = QDateTime::currentMSecsSinceEpoch();
+    // {"BTC_ETH":{"asks":[["0.03",1.5],...],"bids":[["0.02",3],...],"isFrozen":"0","seq":123},...}
+    JsonReader reader( data );
+    QLatin1String market_key, key;
 
-    // is the orderbook is too old to be safe? check the stale tolerance
-    if ( request_time_sent_ms < current_time - orderbook_stale_tolerance )
+    // walk one side of the book, each entry is [price, amount]
+    auto readBestPrice = [ &reader ]( Coin &best, const bool lowest )
     {
-        books_stale_trip_count++;
-        return;
-    }
-
-    // don't accept responses for requests sooner than the latest response request_time_sent_ms
-    if ( request_time_sent_ms < ticker_update_request_time )
-        return;
-
-    ticker_update_request_time = request_time_sent_ms;
+        if ( !reader.beginArray() )
+            return;
 
-    // iterate through each market object
-    for ( QJsonObject::const_iterator i = info.begin(); i != info.end(); i++ )
-    {
-        if ( !i.value().isObject() )
-            continue;
+        while ( reader.nextElement() )
+        {
+            if ( reader.peekType() != JsonReader::TypeArray )
+            {
+                reader.skipValue();
+                continue;
+            }
 
-        // read object and key
-        const QString &market = i.key();
-        const QJsonObject &market_obj = i.value().toObject();
+            Coin price;
+            bool is_price = true; // price is first item
 
-        if ( !market_obj.contains( "asks" ) ||
-             !market_obj.contains( "bids" ) )
-            continue;
+            reader.beginArray();
+            while ( reader.nextElement() )
+            {
+                if ( is_price )
+                    reader.readCoin( price );
+                else
+                    reader.skipValue();
 
-        // the object has two arrays of arrays [[1,2],[3,4]]
-        const QJsonArray &asks = market_obj[ "asks" ].toArray();
-        const QJsonArray &bids = market_obj[ "bids" ].toArray();
+                is_price = false;
+            }
 
-        Coin hi_buy, lo_sell = CoinAmount::A_LOT;
+            if ( price.isGreaterThanZero() && ( lowest ? price < best : price > best ) )
+                best = price;
+        }
+    };
 
-        // walk asks
-        for ( QJsonArray::const_iterator j = asks.begin(); j != asks.end(); j++ )
-        {
-            if ( !(*j).isArray() )
-                continue;
+    if ( !reader.beginObject() )
+        return false;
 
-            const QJsonArray asks_current = (*j).toArray();
-            const Coin price = asks_current.at( 0 ).toString();
+    // iterate through each market object
+    while ( reader.nextKey( market_key ) )
+    {
+        // let the caller handle errors
+        if ( market_key == QLatin1String( "error" ) )
+            return false;
 
-            if ( price < lo_sell )
-                lo_sell = price;
-        }
+        out.market_count++;
 
-        // walk bids
-        for ( QJsonArray::const_iterator j = bids.begin(); j != bids.end(); j++ )
+        if ( reader.peekType() != JsonReader::TypeObject )
         {
-            if ( !(*j).isArray() )
-                continue;
+            reader.skipValue();
+            continue;
+        }
 
-            const QJsonArray bids_current = (*j).toArray();
-            const Coin price = bids_current.at( 0 ).toString(); // price is first item
+        Coin hi_buy, lo_sell = CoinAmount::A_LOT;
 
-            if ( price > hi_buy )
-                hi_buy = price;
+        reader.beginObject();
+        while ( reader.nextKey( key ) )
+        {
+            if ( key == QLatin1String( "asks" ) )
+                readBestPrice( lo_sell, true );
+            else if ( key == QLatin1String( "bids" ) )
+                readBestPrice( hi_buy, false );
+            else
+                reader.skipValue();
         }
 
-//        kDebug() << market << "highest buy:" << toSatoshiFormat( hi_buy );
-//        kDebug() << market << "lowest sell:" << toSatoshiFormat( lo_sell );
+//        kDebug() << market_key << "highest buy:" << hi_buy << "lowest sell:" << lo_sell;
 
         // update our maps
-        if ( !market.isEmpty() &&
+        if ( market_key.size() > 0 &&
              hi_buy.isGreaterThanZero() &&
              lo_sell < CoinAmount::A_LOT )
         {
-            QMap<QString, Spread> ticker_info;
-            ticker_info.insert( market, Spread( hi_buy, lo_sell ) );
-            engine->processTicker( this, ticker_info, request_time_sent_ms );
+            out.spreads.insert( QString( market_key ), Spread( hi_buy, lo_sell ) );
         }
     }
+
+    // a blank or partial reply is treated as invalid
+    return !reader.hasError() && out.market_count > 0;
+}
+
+void PoloREST::applyOrderBook( const ParsedReply &reply )
+{
+    const qint64 current_time = QDateTime::currentMSecsSinceEpoch();
+    const qint64 &request_time_sent_ms = reply.request_time_sent_ms;
+
+    // is the orderbook is too old to be safe? check the stale tolerance
+    if ( request_time_sent_ms < current_time - orderbook_stale_tolerance )
+    {
+        books_stale_trip_count++;
+        return;
+    }
+
+    // don't accept responses for requests sooner than the latest response request_time_sent_ms
+    if ( request_time_sent_ms < ticker_update_request_time )
+        return;
+
+    ticker_update_request_time = request_time_sent_ms;
+
+    if ( !reply.spreads.isEmpty() )
+        engine->processTicker( this, reply.spreads, request_time_sent_ms );
+}
+
+void PoloREST::onReplyParsed( const ParsedReply &reply )
+{
+    if ( reply.ok )
+    {
+        if ( reply.api_command == POLO_COMMAND_GETORDERS )
+            applyOpenOrders( reply );
+        else if ( reply.api_command == POLO_COMMAND_GETBOOKS )
+            applyOrderBook( reply );
+
+        return;
+    }
+
+    // large replies that didn't decode end up here, the hot commands aren't resent
+    printReplyError( reply );
 }
 
 void PoloREST::sendNamQueue()
@@ -513,74 +615,96 @@ void PoloREST::sendNamQueue()
     if ( current_time < poloniex_throttle_time )
         return;
 
-    QMultiMap<Coin/*weight*/,Request*> sorted_nam_queue;
-
-    // insert into auto sorted map sorted by weight
-    for ( QQueue<Request*>::const_iterator i = nam_queue.begin(); i != nam_queue.end(); i++ )
+    // if the orderbook is stale, we can assume the server is down and we let the orders timeout
+    // only poll orders until the orderbook is responded to
+    if ( yieldToLag() )
     {
-        Request *const &request = *i;
-        Position *const &pos = request->pos;
+        const QVector<Request*> lag_requests = nam_queue.getByCommand( POLO_COMMAND_GETORDERS );
 
-        // check for valid pos
-        if ( pos == nullptr || !engine->getPositionMan()->isValid( pos ) )
+        for ( QVector<Request*>::const_iterator i = lag_requests.begin(); i != lag_requests.end(); i++ )
         {
-            sorted_nam_queue.insert( Coin(), request );
-            continue;
-        }
+            if ( dropStaleRequest( *i ) )
+                continue;
 
-        // check for cancel
-        if ( request->api_command == POLO_COMMAND_CANCEL &&
-             engine->getPositionMan()->getMarketOrderTotal( pos->market ) >= market_cancel_thresh )
-        {
-            // expedite the cancel
-            sorted_nam_queue.insert( CoinAmount::COIN, request );
-            continue;
-        }
+            if ( !takeRateTokens( *i ) )
+                break;
 
-        if ( request->api_command == POLO_COMMAND_GETBOOKS ||
-             request->api_command == POLO_COMMAND_GETORDERS )
-        {
-            sorted_nam_queue.insert( Coin(), request );
-            continue;
-        }
+            sendNamRequest( *i );
 
-        // new hi/lo buy or sell, we should value this at 0 because it's not a reactive order
-        if ( pos->is_new_hilo_order )
-        {
-            sorted_nam_queue.insert( Coin(), request );
-            continue;
-        }
-
-        // check for not buy/sell command
-        if ( request->api_command != BUY &&
-             request->api_command != SELL )
-        {
-            sorted_nam_queue.insert( Coin(), request );
-            continue;
+            if ( yieldToFlowControlSent() )
+                return;
         }
 
-        sorted_nam_queue.insert( pos->per_trade_profit, request );
+        return;
     }
 
-    // go through orders, ranked from highest weight to lowest
-    for ( QMultiMap<Coin,Request*>::const_iterator i = sorted_nam_queue.end() -1; i != sorted_nam_queue.begin() -1; i-- )
+    // send everything we have tokens for, highest weight first within each class (cancels, orders, polling)
+    for ( int i = 0; i < RATE_CLASS_COUNT; i++ )
     {
-        Request *const &request = i.value();
+        const RateClass rate_class = RateClass( i );
+        Request *request;
 
-        // check if we received the orderbook in the timeframe of an order timeout grace period
-        // if it's stale, we can assume the server is down and we let the orders timeout
-        if ( yieldToLag() && request->api_command != POLO_COMMAND_GETORDERS )
+        while ( ( request = nam_queue.top( rate_class ) ) != nullptr )
         {
-            // let this request hang around until the orderbook is responded to
-            continue;
-        }
+            // the position is gone, drop it before it costs tokens
+            if ( dropStaleRequest( request ) )
+                continue;
 
-        sendNamRequest( request );
-        // the request is added to sent_nam_queue and thus not deleted until the response is met
-        return;
+            if ( !takeRateTokens( request ) )
+                break;
+
+            sendNamRequest( request );
+            // the request is added to sent_nam_queue and thus not deleted until the response is met
+
+            if ( yieldToFlowControlSent() )
+                return;
+
+            // the request couldn't be sent, try again next time
+            if ( nam_queue.contains( request ) )
+                break;
+        }
     }
 }
 
+Coin PoloREST::getRequestPriority( Request *const &request ) const
+{
+    Position *const &pos = request->pos;
+
+    // check for valid pos
+    if ( pos == nullptr || !engine->getPositionMan()->isValid( request->pos_handle ) )
+        return Coin();
+
+    // check for cancel
+    if ( request->api_command == POLO_COMMAND_CANCEL &&
+         engine->getPositionMan()->getMarketOrderTotal( pos->market ) >= market_cancel_thresh )
+        return CoinAmount::COIN; // expedite the cancel
+
+    // new hi/lo buy or sell, we should value this at 0 because it's not a reactive order
+    if ( pos->is_new_hilo_order )
+        return Coin();
+
+    // check for not buy/sell command
+    if ( request->api_command != BUY &&
+         request->api_command != SELL )
+        return Coin();
+
+    return pos->per_trade_profit;
+}
+
+RateClass PoloREST::getRateClass( Request *const &request ) const
+{
+    const QString &api_command = request->api_command;
+
+    if ( api_command == POLO_COMMAND_CANCEL )
+        return RateCancel;
+    else if ( api_command == BUY || api_command == SELL )
+        return RateOrder;
+    else if ( api_command == POLO_COMMAND_GETBOOKS )
+        return RatePublic;
+
+    return RateQuery;
+}
+
 void PoloREST::checkBotOrders( bool ignore_flow_control )
 {
     // return on unset key/secret, or if we already queued this command
@@ -620,12 +744,34 @@ void PoloREST::onNamReply( QNetworkReply *const &reply )
     // reference the object we made during the request
     Request *const &request = nam_queue_sent.take( reply );
     const QString &api_command = request->api_command;
-    const qint64 response_time = QDateTime::currentMSecsSinceEpoch() - request->time_sent_ms;
-
-    avg_response_time.addResponseTime( response_time );
+    onReplyReceived( request, data );
 
     //kDebug() << "got reply for" << api_command;
 
+    // the hot replies are read without building a document, large ones on the parser thread. small replies that
+    // don't decode fall through to the error handling below.
+    if ( api_command == POLO_COMMAND_GETORDERS || api_command == POLO_COMMAND_GETBOOKS )
+    {
+        const ReplyDecoder decoder = ( api_command == POLO_COMMAND_GETORDERS ) ? &PoloREST::decodeOpenOrders :
+                                                                                 &PoloREST::decodeOrderBook;
+        bool handled = queueReplyParse( request, data, decoder );
+
+        if ( !handled )
+        {
+            const ParsedReply parsed = ReplyParser::decode( decoder, api_command, request->time_sent_ms, data );
+            handled = parsed.ok;
+
+            if ( handled )
+                onReplyParsed( parsed );
+        }
+
+        if ( handled )
+        {
+            deleteReply( reply, request );
+            return;
+        }
+    }
+
     // parse any possible json in the body
     QJsonDocument body_json = QJsonDocument::fromJson( data );
     QJsonObject body_obj;
@@ -706,6 +852,7 @@ void PoloREST::onNamReply( QNetworkReply *const &reply )
         {
             kDebug() << getExchangeFancyStr() << "throttling send queue for 3.5 seconds...";
             poloniex_throttle_time = QDateTime::currentMSecsSinceEpoch() + 3500;
+            rate_limiter.drain( QDateTime::currentMSecsSinceEpoch() );
         }
 
         // look for post-only error
@@ -715,7 +862,7 @@ void PoloREST::onNamReply( QNetworkReply *const &reply )
             Position *const &pos = request->pos;
 
             // prevent unallocated access (if we are cancelling it should be an active order)
-            if ( pos == nullptr || !engine->getPositionMan()->isValid( pos ) ) // check positions_all, these should be queued not active
+            if ( pos == nullptr || !engine->getPositionMan()->isValid( request->pos_handle ) ) // check the pool handle, these should be queued not active
             {
                 kDebug() << getExchangeFancyStr() << "unknown" << api_command << "reply:" << data;
                 deleteReply( reply, request );
@@ -853,13 +1000,10 @@ void PoloREST::onNamReply( QNetworkReply *const &reply )
         return;
     }
 
-    if ( api_command == POLO_COMMAND_GETORDERS )
-    {
-        parseOpenOrders( body_obj, request->time_sent_ms );
-    }
-    else if ( api_command == POLO_COMMAND_GETBOOKS )
+    if ( api_command == POLO_COMMAND_GETORDERS || api_command == POLO_COMMAND_GETBOOKS )
     {
-        parseOrderBook( body_obj, request->time_sent_ms );
+        // valid json that the reader couldn't make sense of
+        kDebug() << getExchangeFancyStr() << "local warning: unexpected reply for" << api_command << data;
     }
     else if ( api_command == BUY || api_command == SELL )
     {
@@ -901,7 +1045,7 @@ void PoloREST::wssSendSubscriptions()
          wss_1000_subscribe_try_time < current_time - 30000 )
     {
         const QString nonce_payload = QString( "nonce=%1" ).arg( ++request_nonce );
-        const QString sign = Global::getBittrexPoloSignature( nonce_payload.toUtf8(), keystore.getSecret() );
+        const QString sign = keystore.getSignature( nonce_payload.toUtf8(), QCryptographicHash::Sha512 ).toHex();
 
         const QJsonObject subscribe_account_notifications
         {
@@ -1109,24 +1253,25 @@ void PoloREST::wssCheckConnection()
 
 void PoloREST::wssTextMessageReceived( const QString &msg )
 {
-    static QJsonDocument doc;
-    doc = QJsonDocument::fromJson( msg.toLocal8Bit() );
+    captureWssFrame( msg );
 
-    //kDebug() << "wss in:" << msg;
+    const QByteArray msg_utf8 = msg.toUtf8();
+    JsonReader reader( msg_utf8 );
 
-    // check for array
-    if ( !doc.isArray() )
-        return;
+    //kDebug() << "wss in:" << msg;
 
     // parse the outer array
     // [1002,null,[179,0.44761404,0.44971726,0.44761404,-0.01142671,363.24909103,820.07867271,0,0.45800334,0.42984444]])
-    static QJsonArray arr;
-    arr = doc.array();
+    qint64 message_type = 0, status = 0;
 
-    const qint32 message_type = arr.at( 0 ).toVariant().toInt(); // occasionally, this is a string
-    //message_type = message_type > 0 ? message_type : arr.at( 0 ).toString().toInt();
+    // check for array, the message type is occasionally a string
+    if ( !reader.beginArray() ||
+         !reader.nextElement() ||
+         !reader.readInt64( message_type ) )
+        return;
 
-    const qint32 status = arr.at( 1 ).toInt();
+    if ( reader.nextElement() )
+        reader.readInt64( status );
 
     // update heartbeat time for any message
     const qint64 current_time = QDateTime::currentMSecsSinceEpoch();
@@ -1140,7 +1285,7 @@ void PoloREST::wssTextMessageReceived( const QString &msg )
     if ( message_type == 1010 )
         return;
 
-    //kDebug() << message_type <<  arr.at( 1 ).toInt() ;
+    //kDebug() << message_type << status;
 
     if ( message_type == 1000 && status > 0 )
     {
@@ -1156,48 +1301,72 @@ void PoloREST::wssTextMessageReceived( const QString &msg )
         return;
     }
 
+    const bool has_data = reader.nextElement() && reader.peekType() == JsonReader::TypeArray;
+
     // check for account info data
-    if ( message_type == 1000 && arr.at( 2 ).isArray() )
+    if ( message_type == 1000 && has_data )
     {
         //kDebug() << "wss-1000 in:" << msg;
 
         QVector<Position*> filled_orders;
-        const QJsonArray &updates = arr.at( 2 ).toArray();
 
-        for ( QJsonArray::const_iterator i = updates.begin(); i != updates.end(); i++ )
+        reader.beginArray();
+        while ( reader.nextElement() )
         {
-            //kDebug() << (*i);
-            if ( !(*i).isArray() )
+            if ( reader.peekType() != JsonReader::TypeArray )
+            {
+                reader.skipValue();
                 continue;
+            }
 
-            const QJsonArray &info = (*i).toArray();
+            // ["o",<order number>,"<new amount>"]
+            QLatin1String update_type, new_amount;
+            qint64 order_number = -1;
+            qint32 idx = 0;
 
-            // look for order fill
-            if ( info.at( 0 ).toString() == "o" &&
-                 info.at( 2 ).toString() == "0.00000000" )
+            reader.beginArray();
+            while ( reader.nextElement() )
             {
-                const QString &order_id = info.at( 1 ).toVariant().toString();
+                if ( idx == 0 )
+                    reader.readStringView( update_type );
+                else if ( idx == 1 )
+                    reader.readInt64( order_number );
+                else if ( idx == 2 )
+                    reader.readStringView( new_amount );
+                else
+                    reader.skipValue();
+
+                idx++;
+            }
+
+            // look for order fill
+            if ( update_type != QLatin1String( "o" ) ||
+                 new_amount != QLatin1String( "0.00000000" ) )
+                continue;
 
-                //kDebug() << "order filled or cancelled:" << order_id;
+            //kDebug() << "order filled or cancelled:" << order_number;
 
-                // make sure order number is valid
-                if ( order_id.isEmpty() )
-                    continue;
+            // make sure order number is valid
+            if ( order_number < 0 )
+                continue;
 
-                Position *const &pos = engine->getPositionMan()->getByOrderID( order_id );
+            Position *const &pos = engine->getPositionMan()->getByOrderID( QString::number( order_number ) );
 
-                // make sure pos is valid
-                if ( pos == nullptr )
-                    continue;
+            // make sure pos is valid
+            if ( pos == nullptr )
+                continue;
 
-                if ( pos->is_cancelling )
-                    continue;
+            if ( pos->is_cancelling )
+                continue;
 
-                // add order ids to process
-                filled_orders += pos;
-            }
+            // add order ids to process
+            filled_orders += pos;
         }
 
+        // don't act on a partial message
+        if ( reader.hasError() )
+            return;
+
         // process the orders
         engine->processFilledOrders( filled_orders, FILL_WSS );
 
@@ -1205,27 +1374,39 @@ void PoloREST::wssTextMessageReceived( const QString &msg )
     }
 
     // check for non-ticker message
-    if ( message_type == 1002 && arr.at( 2 ).isArray() )
+    if ( message_type == 1002 && has_data )
     {
-        // parse the inner array
-        const QJsonArray &data = arr.at( 2 ).toArray();
-
         // data format from polo documentation:
         // [ <currency pair id>, "<last trade price>", "<lowest ask>", "<highest bid>",
         // "<percent change in last 24 hours>", "<base currency volume in last 24 hours>",
         // "<quote currency volume in last 24 hours>", <is frozen>, "<highest trade price in last 24 hours>",
         // "<lowest trade price in last 24 hours>" ]
+        qint64 currency_pair = 0;
+        Coin ask, bid;
+        qint32 idx = 0;
+
+        // parse the inner array
+        reader.beginArray();
+        while ( reader.nextElement() )
+        {
+            if ( idx == 0 )
+                reader.readInt64( currency_pair );
+            else if ( idx == 2 )
+                reader.readCoin( ask );
+            else if ( idx == 3 )
+                reader.readCoin( bid );
+            else
+                reader.skipValue();
 
-        //kDebug() << "bid_str:" << data.at( 3 ).toString() << "ask_str:" << data.at( 2 ).toString();
+            idx++;
+        }
 
-        const qint32 currency_pair = data.at( 0 ).toInt();
-        const QString &market = currency_name_by_id.value( currency_pair );
-        const Coin ask = data.at( 2 ).toString();
-        const Coin bid = data.at( 3 ).toString();
+        const QString &market = currency_name_by_id.value( static_cast<qint32>( currency_pair ) );
 
         //kDebug() << bid << ask;
 
-        if ( !market.isEmpty() &&
+        if ( !reader.hasError() &&
+             !market.isEmpty() &&
              bid.isGreaterThanZero() &&
              ask.isGreaterThanZero() )
         {
@@ -36,10 +36,12 @@ public:
 
     void parseBuySell( Request *const &request, const QJsonObject &response );
     void parseCancelOrder( Request *const &request, const QJsonObject &response );
-    void parseOpenOrders( const QJsonObject &markets, qint64 request_time_sent_ms );
+    static bool decodeOpenOrders( const QByteArray &data, ParsedReply &out );
+    void applyOpenOrders( const ParsedReply &reply );
     void parseReturnBalances( const QJsonObject &balances );
     void parseFeeInfo( const QJsonObject &info );
-    void parseOrderBook( const QJsonObject &info, qint64 request_time_sent_ms );
+    static bool decodeOrderBook( const QByteArray &data, ParsedReply &out );
+    void applyOrderBook( const ParsedReply &reply );
 
     void wssSendJsonObj( const QJsonObject &obj );
     void setupCurrencyMap( QMap<qint32, QString> &m );
@@ -48,21 +50,24 @@ public:
     qreal getSlippageMul( const QString &market ) const { return slippage_multiplier.value( market, 0.005 ); }
 
     void checkBotOrders( bool ignore_flow_control = false );
+    RateClass getRateClass( Request *const &request ) const override;
+    Coin getRequestPriority( Request *const &request ) const override;
 
 public Q_SLOTS:
     // timer slots
-    void sendNamQueue();
+    void sendNamQueue() override;
     void onCheckBotOrders();
     void onCheckTicker();
     void onCheckFee();
 
     // nam slots
-    void onNamReply( QNetworkReply *const &reply );
+    void onNamReply( QNetworkReply *const &reply ) override;
+    void onReplyParsed( const ParsedReply &reply ) override;
 
     // websockets slots
     void wssConnected();
     void wssCheckConnection();
-    void wssTextMessageReceived( const QString &msg );
+    void wssTextMessageReceived( const QString &msg ) override;
     void wssSendSubscriptions();
 
 private:
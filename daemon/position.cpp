@@ -31,6 +31,7 @@ Position::Position( QString _market, quint8 _side, QString _buy_price, QString _
     price_reset_count = 0;
     max_age_epoch = 0;
     strategy_tag = _strategy_tag;
+    strategy_id = -1;
 
     if ( engine != nullptr && is_landmark && market_indices.size() > 1 )
     {
@@ -42,12 +43,13 @@ Position::Position( QString _market, quint8 _side, QString _buy_price, QString _
         // track weight totals for lo/hi price
         Coin hi_price_weight_total, lo_price_weight_total;
 
+        const PositionIndex &index = engine->getMarketInfo( market ).position_index;
+
         // measure the lowest amount supplied
         int i;
         for ( i = 0; i < market_indices.size(); i++ )
         {
-            const PositionData &data = engine->getMarketInfo( market ).position_index[ market_indices.value( i ) ];
-            Coin ordersize = data.order_size;
+            const Coin ordersize = PositionIndex::toCoin( index.orderSize( market_indices.value( i ) ) );
 
             // measure lowest order size
             if ( ordersize < lo_ordersize )
@@ -60,21 +62,21 @@ Position::Position( QString _market, quint8 _side, QString _buy_price, QString _
         // use the lowest amount as weight 1 and size others correspondingly
         for ( i = 0; i < market_indices.size(); i++ )
         {
-            const PositionData &data = engine->getMarketInfo( market ).position_index[ market_indices.value( i ) ];
+            const qint32 idx = market_indices.value( i );
 
             Coin current_weight;
             if ( lo_ordersize < CoinAmount::A_LOT )
-                current_weight = Coin( data.order_size ) / lo_ordersize;
+                current_weight = PositionIndex::toCoin( index.orderSize( idx ) ) / lo_ordersize;
 
-            //kDebug() << "idx:" << i << "price:" << data.order_size;
+            //kDebug() << "idx:" << i << "price:" << index.orderSize( idx );
 
             // calculate ordersize weight
             ordersize_weight_total += current_weight;
             ordersize_weights.insert( i, current_weight );
 
             // add to price weight totals
-            hi_price_weight_total += Coin( data.sell_price ) * current_weight;
-            lo_price_weight_total += Coin( data.buy_price ) * current_weight;
+            hi_price_weight_total += PositionIndex::toCoin( index.sellPrice( idx ) ) * current_weight;
+            lo_price_weight_total += PositionIndex::toCoin( index.buyPrice( idx ) ) * current_weight;
         }
 
         //kDebug() << "hi_price_weight_total:" << hi_price_weight_total;
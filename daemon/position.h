@@ -4,6 +4,7 @@
 #include "global.h"
 #include "coinamount.h"
 #include "market.h"
+#include "misctypes.h"
 
 #include <QVector>
 
@@ -36,6 +37,9 @@ public:
     qint32 getLowestMarketIndex() const;
     qint32 getHighestMarketIndex() const;
 
+    // slot in the owning PositionPool, null for positions made outside of the pool
+    PositionHandle handle;
+
     // exchange data
     Market market; // BTC_CLAM...
     QString order_number;
@@ -58,6 +62,7 @@ public:
     quint32 price_reset_count;
     qint64 max_age_epoch; // epoch time of when we should cancel the order
     QString strategy_tag; // tag for short/long
+    qint32 strategy_id; // interned strategy_tag, set by PositionMan while active
 
     // track indices for market map
     QVector<qint32> market_indices;
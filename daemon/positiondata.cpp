@@ -0,0 +1,133 @@
+#include "positiondata.h"
+
+void PositionIndex::clear()
+{
+    buy_price.clear();
+    sell_price.clear();
+    buy_price_ticked.clear();
+    sell_price_ticked.clear();
+    order_size.clear();
+    alternate_size.clear();
+    fill_count.clear();
+}
+
+void PositionIndex::append( const PositionData &data )
+{
+    const qint64 buy = Coin( data.buy_price ).toIntSatoshis();
+    const qint64 sell = Coin( data.sell_price ).toIntSatoshis();
+
+    buy_price.append( buy );
+    sell_price.append( sell );
+    buy_price_ticked.append( truncateBuyPrice( buy ) );
+    sell_price_ticked.append( truncateByTicksize( sell ) );
+    order_size.append( Coin( data.order_size ).toIntSatoshis() );
+    alternate_size.append( data.alternate_size.isEmpty() ? 0 : Coin( data.alternate_size ).toIntSatoshis() );
+    fill_count.append( data.fill_count );
+}
+
+PositionData PositionIndex::value( const qint32 idx ) const
+{
+    if ( idx < 0 || idx >= size() )
+        return PositionData();
+
+    PositionData ret( formatSatoshis( buy_price_ticked.at( idx ) ),
+                      formatSatoshis( sell_price_ticked.at( idx ) ),
+                      formatSatoshis( order_size.at( idx ) ),
+                      alternate_size.at( idx ) > 0 ? formatSatoshis( alternate_size.at( idx ) ) : QString() );
+    ret.fill_count = fill_count.at( idx );
+
+    return ret;
+}
+
+void PositionIndex::iterateFillCount( const qint32 idx )
+{
+    if ( idx < 0 || idx >= size() )
+        return;
+
+    fill_count[ idx ]++;
+
+    // after the first fill, the alternate size takes the place of order_size
+    if ( alternate_size.at( idx ) > 0 )
+    {
+        order_size[ idx ] = alternate_size.at( idx );
+        alternate_size[ idx ] = 0;
+    }
+}
+
+void PositionIndex::setPriceTicksize( const Coin &ticksize )
+{
+    const qint64 new_ticksize = ticksize.toIntSatoshis();
+
+    // like Coin::truncateByTicksize(), truncate to the decimal place of the first '1' in the ticksize
+    const QString ticksize_str = ticksize.toAmountString();
+    const int one_idx = ticksize_str.indexOf( CoinAmount::one_exp );
+
+    qint64 new_truncate = 1;
+    if ( one_idx >= 0 )
+    {
+        const int decimals_kept = qMax( one_idx - 1, 0 );
+        for ( int i = decimals_kept; i < Coin::satoshi_decimals; i++ )
+            new_truncate *= 10;
+    }
+
+    if ( new_ticksize == price_ticksize && new_truncate == price_truncate )
+        return;
+
+    price_ticksize = new_ticksize;
+    price_truncate = new_truncate;
+
+    // rebuild the truncated columns
+    for ( int i = 0; i < size(); i++ )
+    {
+        buy_price_ticked[ i ] = truncateBuyPrice( buy_price.at( i ) );
+        sell_price_ticked[ i ] = truncateByTicksize( sell_price.at( i ) );
+    }
+}
+
+qint64 PositionIndex::truncateByTicksize( const qint64 satoshis ) const
+{
+    return satoshis - ( satoshis % price_truncate );
+}
+
+qint64 PositionIndex::truncateBuyPrice( const qint64 satoshis ) const
+{
+    const qint64 ret = truncateByTicksize( satoshis );
+
+    // prevent buy price from being less than ticksize
+    return ( price_ticksize > 0 && ret < price_ticksize ) ? price_ticksize : ret;
+}
+
+Coin PositionIndex::toCoin( const qint64 satoshis )
+{
+    if ( satoshis < 0 )
+        return -( CoinAmount::SATOSHI * quint64( -satoshis ) );
+
+    return CoinAmount::SATOSHI * quint64( satoshis );
+}
+
+void PositionIndex::appendSatoshis( QString &out, qint64 satoshis )
+{
+    if ( satoshis < 0 )
+    {
+        out += CoinAmount::minus_exp;
+        satoshis = -satoshis;
+    }
+
+    // integer part, then the 8 fractional digits zero-padded
+    out += QString::number( satoshis / 100000000 );
+    out += CoinAmount::decimal_exp;
+
+    const QString frac = QString::number( satoshis % 100000000 );
+    for ( int i = frac.size(); i < Coin::satoshi_decimals; i++ )
+        out += CoinAmount::zero_exp;
+    out += frac;
+}
+
+QString PositionIndex::formatSatoshis( const qint64 satoshis )
+{
+    QString ret;
+    ret.reserve( 20 );
+    appendSatoshis( ret, satoshis );
+
+    return ret;
+}
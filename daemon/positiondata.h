@@ -1,8 +1,14 @@
 #ifndef POSITIONDATA_H
 #define POSITIONDATA_H
 
+#include "coinamount.h"
+
 #include <QString>
+#include <QVector>
 
+//
+// PositionData, one ping-pong grid level in string form. used to add levels and to read them back out.
+//
 struct PositionData
 {
     explicit PositionData() {}
@@ -15,18 +21,56 @@ struct PositionData
         fill_count = 0;
     }
 
-    void iterateFillCount()
-    {
-        fill_count++;
-        if ( !alternate_size.isEmpty() )
-        {
-            order_size = alternate_size;
-            alternate_size.clear();
-        }
-    }
-
     QString buy_price, sell_price, order_size, alternate_size;
-    quint32 fill_count;
+    quint32 fill_count{ 0 };
+};
+
+//
+// PositionIndex, the ping-pong grid of a market stored as fixed-point satoshi columns
+//
+// prices are also kept pre-truncated by the market price ticksize, so flipping a level doesn't need to touch gmp.
+// strings are only produced when a level is read back as PositionData or written out by saveMarket.
+//
+class PositionIndex
+{
+public:
+    explicit PositionIndex() {}
+
+    qint32 size() const { return buy_price.size(); }
+    bool isEmpty() const { return buy_price.isEmpty(); }
+    void clear();
+
+    void append( const PositionData &data );
+    PositionIndex &operator +=( const PositionData &data ) { append( data ); return *this; }
+
+    // returns the level at idx formatted with tick-truncated prices, or an empty PositionData if out of range
+    PositionData value( const qint32 idx ) const;
+
+    void iterateFillCount( const qint32 idx );
+    void setPriceTicksize( const Coin &ticksize );
+
+    // raw column access
+    qint64 buyPrice( const qint32 idx ) const { return buy_price.value( idx ); }
+    qint64 sellPrice( const qint32 idx ) const { return sell_price.value( idx ); }
+    qint64 orderSize( const qint32 idx ) const { return order_size.value( idx ); }
+    qint64 alternateSize( const qint32 idx ) const { return alternate_size.value( idx ); }
+    quint32 fillCount( const qint32 idx ) const { return fill_count.value( idx ); }
+
+    static Coin toCoin( const qint64 satoshis );
+    static void appendSatoshis( QString &out, qint64 satoshis );
+    static QString formatSatoshis( const qint64 satoshis );
+
+private:
+    qint64 truncateByTicksize( const qint64 satoshis ) const;
+    qint64 truncateBuyPrice( const qint64 satoshis ) const;
+
+    QVector<qint64> buy_price, sell_price;
+    QVector<qint64> buy_price_ticked, sell_price_ticked;
+    QVector<qint64> order_size, alternate_size; // alternate_size is 0 when unset
+    QVector<quint32> fill_count;
+
+    qint64 price_ticksize{ 1 }; // in satoshis
+    qint64 price_truncate{ 1 }; // power of ten at or below the ticksize, in satoshis
 };
 
 #endif // POSITIONDATA_H
@@ -27,30 +27,61 @@ PositionMan::~PositionMan()
         remove( *positions_all.begin() );
 }
 
-QVector<Position*> PositionMan::activeBySetTime() const
+QVector<Position*> PositionMan::activeByStrategy( const qint32 strategy_id, const QString &market, const quint8 side ) const
 {
-    QMultiMap<qint64, Position*> positions_by_time;
+    // oldest set first. slippage resets bump order_set_time without moving the position, which is fine for callers
+    return positions_active_by_strategy.value( StrategyIndexKey( strategy_id, market, side ) );
+}
 
-    const QSet<Position*>::const_iterator begin_active = positions_active.begin(),
-                                          end_active = positions_active.end();
-    for ( QSet<Position*>::const_iterator i = begin_active; i != end_active; i++ )
-    {
-        Position *const &pos = *i;
+qint32 PositionMan::getStrategyId( const QString &strategy_tag )
+{
+    QHash<QString, qint32>::const_iterator i = strategy_ids.find( strategy_tag );
 
-        positions_by_time.insert( pos->order_set_time, pos );
-    }
+    if ( i != strategy_ids.end() )
+        return i.value();
 
-    // return positions_by_time values from latest to soonest
-    QVector<Position*> ret;
-    const QMultiMap<qint64, Position*>::const_iterator begin = positions_by_time.begin(),
-                                                       end = positions_by_time.end();
+    const qint32 id = strategy_ids.size();
+    strategy_ids.insert( strategy_tag, id );
+    return id;
+}
 
-    for ( QMultiMap<qint64, Position*>::const_iterator i = end -1; i != begin -1; i-- )
-    {
-        Position *const &pos = *i;
+void PositionMan::setStrategyTag( Position *const &pos, const QString &strategy_tag )
+{
+    const bool is_active = positions_active.contains( pos );
 
-        ret += pos;
-    }
+    // keep the index in step with the tag
+    if ( is_active )
+        removeFromStrategyIndex( pos );
+
+    pos->strategy_tag = strategy_tag;
+
+    if ( is_active )
+        addToStrategyIndex( pos );
+}
+
+void PositionMan::addToStrategyIndex( Position *const &pos )
+{
+    pos->strategy_id = getStrategyId( pos->strategy_tag );
+    positions_active_by_strategy[ StrategyIndexKey( pos->strategy_id, pos->market, pos->side ) ].append( pos );
+}
+
+void PositionMan::removeFromStrategyIndex( Position *const &pos )
+{
+    QHash<StrategyIndexKey, QVector<Position*>>::iterator by_strategy = positions_active_by_strategy.find( StrategyIndexKey( pos->strategy_id, pos->market, pos->side ) );
+
+    if ( by_strategy == positions_active_by_strategy.end() )
+        return;
+
+    by_strategy.value().removeOne( pos );
+
+    if ( by_strategy.value().isEmpty() )
+        positions_active_by_strategy.erase( by_strategy );
+}
+
+QSet<QString> PositionMan::takeActivatedMarkets()
+{
+    QSet<QString> ret;
+    ret.swap( markets_activated );
 
     return ret;
 }
@@ -587,15 +618,18 @@ qint32 PositionMan::getMarketOrderTotal( const QString &market, bool onetime_onl
     if ( market.isEmpty() )
         return 0;
 
+    // the total is kept up to date by add() and remove()
+    if ( !onetime_only )
+        return market_order_totals.value( market );
+
     qint32 total = 0;
 
-    // get total order count for a market
+    // get onetime order count for a market
     for ( QSet<Position*>::const_iterator i = positions_all.begin(); i != positions_all.end(); i++ )
     {
         const Position *const &pos = *i;
 
-        // onetime_only, only include onetime orders
-        if ( onetime_only && !pos->is_onetime )
+        if ( !pos->is_onetime )
             continue;
 
         if ( pos->market == market )
@@ -635,7 +669,7 @@ void PositionMan::flipLoSellIndex( const QString &market, QString tag )
     if ( !isActive( pos ) )
         return;
 
-    pos->strategy_tag = tag;
+    setStrategyTag( pos, tag );
     pos->per_trade_profit = Coin(); // clear trade profit from message
     kDebug() << QString( "queued long     %1" )
                   .arg( pos->stringifyPositionChange() );
@@ -661,7 +695,7 @@ void PositionMan::flipHiBuyPrice( const QString &market, QString tag )
     if ( !isActive( pos ) )
         return;
 
-    pos->strategy_tag = tag;
+    setStrategyTag( pos, tag );
     pos->per_trade_profit = Coin(); // clear trade profit from message
     kDebug() << QString( "queued short    %1" )
                   .arg( pos->stringifyPositionChange() );
@@ -677,7 +711,7 @@ void PositionMan::flipHiBuyIndex( const QString &market, QString tag )
     if ( !isActive( pos ) )
         return;
 
-    pos->strategy_tag = tag;
+    setStrategyTag( pos, tag );
     pos->per_trade_profit = Coin(); // clear trade profit from message
     kDebug() << QString( "queued short    %1" )
                   .arg( pos->stringifyPositionChange() );
@@ -693,7 +727,7 @@ void PositionMan::flipLoSellPrice( const QString &market, QString tag )
     if ( !isActive( pos ) )
         return;
 
-    pos->strategy_tag = tag;
+    setStrategyTag( pos, tag );
     pos->per_trade_profit = Coin(); // clear trade profit from message
     kDebug() << QString( "queued long     %1" )
                   .arg( pos->stringifyPositionChange() );
@@ -705,6 +739,7 @@ void PositionMan::add( Position * const &pos )
 {
     positions_queued.insert( pos );
     positions_all.insert( pos );
+    market_order_totals[ pos->market ]++;
 }
 
 void PositionMan::activate( Position * const &pos, const QString &order_number )
@@ -722,9 +757,14 @@ void PositionMan::activate( Position * const &pos, const QString &order_number )
     pos->is_new_hilo_order = false;
 
     // insert our order number into positions
+    if ( !positions_active.contains( pos ) )
+        addToStrategyIndex( pos );
+
     positions_queued.remove( pos );
     positions_active.insert( pos );
+    positions_active_by_market[ pos->market ].insert( pos );
     positions_by_number.insert( order_number, pos );
+    markets_activated.insert( pos->market );
 
     if ( engine->isTesting() )
     {
@@ -778,11 +818,11 @@ void PositionMan::remove( Position * const &pos )
     {
         const Request *const &req = i.value();
 
-        if ( req->pos == nullptr )
+        if ( req->pos_handle.isNull() )
             continue;
 
         // if we found -this- position, add it to deleted queue
-        if ( req->pos == pos )
+        if ( req->pos_handle == pos->handle )
             deleted_queue.append( qMakePair( i.key(), i.value() ) );
     }
 
@@ -795,13 +835,32 @@ void PositionMan::remove( Position * const &pos )
     }
 
     /// step 3: remove from maps/containers
-    positions_active.remove( pos ); // remove from active ptr list
+    if ( positions_active.remove( pos ) ) // remove from active ptr list
+    {
+        removeFromStrategyIndex( pos );
+
+        QHash<QString, QSet<Position*>>::iterator by_market = positions_active_by_market.find( pos->market );
+
+        if ( by_market != positions_active_by_market.end() )
+        {
+            by_market.value().remove( pos );
+
+            if ( by_market.value().isEmpty() )
+                positions_active_by_market.erase( by_market );
+        }
+    }
     positions_queued.remove( pos ); // remove from tracking queue
-    positions_all.remove( pos ); // remove from all
+    if ( positions_all.remove( pos ) ) // remove from all
+    {
+        QHash<QString, qint32>::iterator total = market_order_totals.find( pos->market );
+
+        if ( total != market_order_totals.end() && --total.value() < 1 )
+            market_order_totals.erase( total );
+    }
     positions_by_number.remove( pos->order_number ); // remove order from positions
     engine->getMarketInfoStructure()[ pos->market ].order_prices.removeOne( pos->price ); // remove from prices
 
-    delete pos; // we're done with this on the heap
+    pool.release( pos ); // we're done with this slot
 }
 
 void PositionMan::removeFromDC( Position * const &pos )
@@ -1515,7 +1574,7 @@ void PositionMan::setNextLowest( const QString &market, quint8 side, bool landma
         return;
 
     // get the index data
-    const PositionData &data = info.position_index.value( indices.value( 0 ) );
+    const PositionData data = info.position_index.value( indices.value( 0 ) );
 
 //    kDebug() << "adding idx" << indices.value( 0 ) << "from indices" << indices;
 //    kDebug() << "adding next lo pos" << market << side << data.buy_price << data.sell_price << data.order_size;
@@ -1605,7 +1664,7 @@ void PositionMan::setNextHighest( const QString &market, quint8 side, bool landm
         return;
 
     // get the index data
-    const PositionData &data = info.position_index.value( indices.value( 0 ) );
+    const PositionData data = info.position_index.value( indices.value( 0 ) );
 
 //    kDebug() << "adding next hi pos" << market << side << data.buy_price << data.sell_price << data.order_size;
 
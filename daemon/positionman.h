@@ -4,6 +4,7 @@
 #include "global.h"
 #include "coinamount.h"
 #include "market.h"
+#include "positionpool.h"
 
 #include <QObject>
 #include <QMap>
@@ -15,6 +16,32 @@
 class Position;
 class Engine;
 
+// key for active positions by strategy tag (interned), market and side
+struct StrategyIndexKey
+{
+    explicit StrategyIndexKey( const qint32 _strategy_id, const QString &_market, const quint8 _side )
+        : strategy_id( _strategy_id ),
+          side( _side ),
+          market( _market )
+    {}
+
+    bool operator ==( const StrategyIndexKey &other ) const
+    {
+        return strategy_id == other.strategy_id &&
+               side == other.side &&
+               market == other.market;
+    }
+
+    qint32 strategy_id;
+    quint8 side;
+    QString market;
+};
+
+inline uint qHash( const StrategyIndexKey &key, uint seed = 0 )
+{
+    return qHash( key.market, seed ) ^ ( uint( key.strategy_id ) << 1 ) ^ key.side;
+}
+
 //
 // PositionMan, helps Engine manage the positions
 //
@@ -31,16 +58,24 @@ public:
     QSet<Position*> &active() { return positions_active; }
     QSet<Position*> &queued() { return positions_queued; }
     QSet<Position*> &all() { return positions_all; }
-    QVector<Position*> activeBySetTime() const;
+    const QSet<Position*> activeByMarket( const QString &market ) const { return positions_active_by_market.value( market ); }
+    QSet<QString> takeActivatedMarkets();
+    QVector<Position*> activeByStrategy( const qint32 strategy_id, const QString &market, const quint8 side ) const;
+
+    qint32 getStrategyId( const QString &strategy_tag );
+    qint32 findStrategyId( const QString &strategy_tag ) const { return strategy_ids.value( strategy_tag, -1 ); }
+    void setStrategyTag( Position *const &pos, const QString &strategy_tag );
 
     bool hasActivePositions() const;
     bool hasQueuedPositions() const;
     bool isActive( Position *const &pos ) const;
     bool isQueued( Position *const &pos ) const;
     bool isValid( Position *const &pos ) const;
+    bool isValid( const PositionHandle &handle ) const { return pool.isValid( handle ); }
     bool isValidOrderID( const QString &order_id ) const;
 
     Position *getByOrderID( const QString &order_id ) const;
+    Position *getByHandle( const PositionHandle &handle ) const { return pool.get( handle ); }
     Position *getByIndex( const QString &market, const qint32 idx ) const;
     Position *getHighestBuyAll( const QString &market ) const;
     Position *getLowestSellAll( const QString &market ) const;
@@ -73,6 +108,8 @@ public:
 
     Coin getActiveSpruceEquityTotal( const Market &market, const QString &strategy, quint8 side, const Coin &price_threshold );
 
+    PositionPool &getPool() { return pool; }
+
     void add( Position *const &pos );
     void activate( Position *const &pos, const QString &order_number );
     void remove( Position *const &pos );
@@ -103,15 +140,25 @@ private:
     void setNextLowest( const QString &market, quint8 side = SIDE_BUY, bool landmark = false );
     void setNextHighest( const QString &market, quint8 side = SIDE_SELL, bool landmark = false );
     void removeFromDC( Position *const &pos );
+    void addToStrategyIndex( Position *const &pos );
+    void removeFromStrategyIndex( Position *const &pos );
 
     void converge( QMap<QString/*market*/,QVector<qint32>> &market_map, quint8 side );
     void diverge( QMap<QString/*market*/,QVector<qint32>> &market_map );
 
+    // backing storage for every position we own
+    PositionPool pool;
+
     // maintain a map of queued positions and set positions
     QHash<QString /* orderNumber */, Position*> positions_by_number;
     QSet<Position*> positions_active; // ptr list of active positions
     QSet<Position*> positions_queued; // ptr list of queued positions
     QSet<Position*> positions_all; // active and queued
+    QHash<QString /* market */, QSet<Position*>> positions_active_by_market; // active positions indexed by market
+    QHash<QString /* market */, qint32> market_order_totals; // active and queued order count per market
+    QSet<QString> markets_activated; // markets with newly set orders since the last takeActivatedMarkets()
+    QHash<StrategyIndexKey, QVector<Position*>> positions_active_by_strategy; // active positions in activation order
+    QHash<QString /* strategy tag */, qint32> strategy_ids; // interned strategy tags
 
     // internal dc stuff
     QMap<QVector<Position*>/*waiting for cancel*/, QPair<bool/*is_landmark*/,QVector<qint32>/*indices*/>> diverge_converge;
@@ -0,0 +1,90 @@
+#include "positionpool.h"
+#include "position.h"
+#include "global.h"
+
+#include <new>
+
+PositionPool::PositionPool()
+{
+}
+
+PositionPool::~PositionPool()
+{
+    // destroy anything still alive, then free the slabs
+    for ( int i = 0; i < slots.size(); i++ )
+        if ( slots.at( i ).pos != nullptr )
+            slots.at( i ).pos->~Position();
+
+    for ( int i = 0; i < slabs.size(); i++ )
+        ::operator delete( slabs.at( i ) );
+}
+
+Position *PositionPool::create( QString market, quint8 side, QString buy_price, QString sell_price, QString order_size,
+                                QString strategy_tag, QVector<qint32> market_indices, bool landmark, Engine *engine )
+{
+    if ( free_slots.isEmpty() )
+        addSlab();
+
+    const quint32 index = free_slots.takeLast();
+    Slot &slot = slots[ index ];
+
+    slot.pos = new ( slotAddress( index ) ) Position( market, side, buy_price, sell_price, order_size,
+                                                      strategy_tag, market_indices, landmark, engine );
+    slot.pos->handle.index = index;
+    slot.pos->handle.generation = slot.generation;
+    live_count++;
+
+    return slot.pos;
+}
+
+void PositionPool::release( Position *const &pos )
+{
+    // make sure the position belongs to us and is still live
+    if ( pos == nullptr || get( pos->handle ) != pos )
+    {
+        kDebug() << "local error: tried to release position not owned by pool at" << pos;
+        return;
+    }
+
+    const quint32 index = pos->handle.index;
+    Slot &slot = slots[ index ];
+
+    pos->~Position();
+    slot.pos = nullptr;
+
+    // invalidate outstanding handles, skipping the null generation on wraparound
+    if ( ++slot.generation == 0 )
+        slot.generation = 1;
+
+    free_slots.append( index );
+    live_count--;
+}
+
+Position *PositionPool::get( const PositionHandle &handle ) const
+{
+    if ( handle.isNull() || handle.index >= quint32( slots.size() ) )
+        return nullptr;
+
+    const Slot &slot = slots.at( handle.index );
+
+    return slot.generation == handle.generation ? slot.pos : nullptr;
+}
+
+void PositionPool::addSlab()
+{
+    const quint32 first = slots.size();
+
+    slabs.append( ::operator new( sizeof( Position ) * SLAB_SIZE ) );
+    slots.resize( first + SLAB_SIZE );
+
+    // push in reverse so low indices are handed out first
+    for ( quint32 i = first + SLAB_SIZE; i > first; i-- )
+        free_slots.append( i - 1 );
+}
+
+Position *PositionPool::slotAddress( const quint32 index ) const
+{
+    char *const slab = static_cast<char*>( slabs.at( index / SLAB_SIZE ) );
+
+    return reinterpret_cast<Position*>( slab + sizeof( Position ) * ( index % SLAB_SIZE ) );
+}
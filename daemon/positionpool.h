@@ -0,0 +1,55 @@
+#ifndef POSITIONPOOL_H
+#define POSITIONPOOL_H
+
+#include "misctypes.h"
+
+#include <QString>
+#include <QVector>
+
+class Position;
+class Engine;
+
+//
+// PositionPool, slab allocator for Position objects
+//
+// positions are constructed in place inside fixed-size slabs and referenced by PositionHandle. each slot carries
+// a generation that is bumped on release, so a stale handle held by a request resolves to nullptr in O(1) even
+// after the slot (and its address) has been handed to a new position.
+//
+class PositionPool
+{
+    Q_DISABLE_COPY( PositionPool )
+
+public:
+    explicit PositionPool();
+    ~PositionPool();
+
+    Position *create( QString market, quint8 side, QString buy_price, QString sell_price, QString order_size,
+                      QString strategy_tag, QVector<qint32> market_indices, bool landmark, Engine *engine );
+    void release( Position *const &pos );
+
+    Position *get( const PositionHandle &handle ) const;
+    bool isValid( const PositionHandle &handle ) const { return get( handle ) != nullptr; }
+
+    qint32 size() const { return live_count; }
+    qint32 capacity() const { return slots.size(); }
+
+private:
+    static const quint32 SLAB_SIZE = 256; // positions per slab
+
+    struct Slot
+    {
+        Position *pos{ nullptr };
+        quint32 generation{ 1 };
+    };
+
+    void addSlab();
+    Position *slotAddress( const quint32 index ) const;
+
+    QVector<void*> slabs; // raw storage, never moves once allocated
+    QVector<Slot> slots;
+    QVector<quint32> free_slots; // stack of unused slot indices
+    qint32 live_count{ 0 };
+};
+
+#endif // POSITIONPOOL_H
@@ -10,6 +10,9 @@
 #include <QDateTime>
 #include <QTimer>
 
+#include <limits>
+#include <algorithm>
+
 static const bool prices_uses_avg = false; // false = assemble widest combined spread between all exchanges, true = average spreads between all exchanges
 
 PriceAggregatorConfig::PriceAggregatorConfig() {}
@@ -192,28 +195,91 @@ bool PriceAggregator::loadPriceSamples( PriceData &data, const QString &path )
     return true;
 }
 
+void PriceAggregator::onExchangeTicker( const quint8 engine_type, const qint64 time_ms )
+{
+    if ( engine_type >= ENGINE_COUNT )
+        return;
+
+    const qint64 current_time = QDateTime::currentMSecsSinceEpoch();
+    const bool was_stale = isExchangeTickerStale( engine_type, current_time );
+
+    m_exchange_ticker_time[ engine_type ] = time_ms;
+
+    // an exchange coming back (or being marked stale early) changes which exchanges contribute to every market
+    if ( was_stale != isExchangeTickerStale( engine_type, current_time ) )
+        m_freshness_generation++;
+}
+
+void PriceAggregator::onExchangeSpread( const quint8 engine_type, const QString &market, const Spread &spread )
+{
+    if ( engine_type >= ENGINE_COUNT )
+        return;
+
+    AggregatedSpread &agg = m_spreads[ market ];
+    agg.exchange_spread[ engine_type ] = spread;
+    agg.dirty = true;
+}
+
 Spread PriceAggregator::getSpread( const QString &market ) const
+{
+    const AggregatedSpread *agg = getFreshAggregatedSpread( market );
+
+    return ( agg == nullptr ) ? Spread() : agg->spread;
+}
+
+const AggregatedSpread *PriceAggregator::getAggregatedSpread( const QString &market ) const
+{
+    return getFreshAggregatedSpread( market );
+}
+
+AggregatedSpread *PriceAggregator::getFreshAggregatedSpread( const QString &market ) const
+{
+    QHash<QString, AggregatedSpread>::iterator i = m_spreads.find( market );
+    if ( i == m_spreads.end() )
+        return nullptr;
+
+    AggregatedSpread &agg = i.value();
+    const qint64 current_time = QDateTime::currentMSecsSinceEpoch();
+
+    // rebuild if the spreads changed, a contributing ticker went stale, or a ticker changed state
+    if ( agg.dirty ||
+         current_time > agg.valid_until_ms ||
+         agg.freshness_generation != m_freshness_generation )
+        rebuildAggregatedSpread( agg, current_time );
+
+    return &agg;
+}
+
+void PriceAggregator::rebuildAggregatedSpread( AggregatedSpread &agg, const qint64 current_time ) const
 {
     Spread ret;
     quint16 samples = 0;
 
-    for ( EngineMap::const_iterator i = m_engine_map->begin(); i != m_engine_map->end(); i++ )
+    agg.best_bid_exchange = -1;
+    agg.best_ask_exchange = -1;
+    agg.valid_until_ms = std::numeric_limits<qint64>::max();
+
+    for ( quint8 engine_type = 0; engine_type < ENGINE_COUNT; engine_type++ )
     {
-        Engine *engine = i.value();
+        const Spread &spread = agg.exchange_spread[ engine_type ];
 
-        // ensure ticker exists
-        if ( !engine->getMarketInfoStructure().contains( market ) )
+        // ensure prices are valid
+        if ( !spread.isValid() )
             continue;
 
         // ensure ticker isn't stale
-        if ( engine->getRestBase()->isTickerStale() )
+        if ( isExchangeTickerStale( engine_type, current_time ) )
             continue;
 
-        const MarketInfo &info = engine->getMarketInfo( market );
+        // the spread is good until the first contributing ticker goes stale
+        agg.valid_until_ms = std::min( agg.valid_until_ms, m_exchange_ticker_time[ engine_type ] + TICKER_STALE_MS );
 
-        // ensure prices are valid
-        if ( !info.spread.isValid() )
-            continue;
+        // track the best venue for each side
+        if ( agg.best_bid_exchange < 0 || agg.exchange_spread[ agg.best_bid_exchange ].bid < spread.bid )
+            agg.best_bid_exchange = engine_type;
+
+        if ( agg.best_ask_exchange < 0 || agg.exchange_spread[ agg.best_ask_exchange ].ask > spread.ask )
+            agg.best_ask_exchange = engine_type;
 
         // use avg spread
         if ( prices_uses_avg )
@@ -221,42 +287,30 @@ Spread PriceAggregator::getSpread( const QString &market ) const
             samples++;
 
             // incorporate prices of this exchange
-            ret.bid += info.spread.bid;
-            ret.ask += info.spread.ask;
-        }
-        // or, use combined spread edges
-        else
-        {
-            // incorporate bid price of this exchange
-            if ( ret.bid.isZeroOrLess() || // bid doesn't exist yet
-                 ret.bid < info.spread.bid ) // bid is higher than the exchange bid
-                ret.bid = info.spread.bid;
-
-            // incorporate ask price of this exchange
-            if ( ret.ask.isZeroOrLess() || // ask doesn't exist yet
-                 ret.ask > info.spread.ask ) // ask is lower than the exchange ask
-                ret.ask = info.spread.ask;
+            ret.bid += spread.bid;
+            ret.ask += spread.ask;
         }
     }
 
-    if ( prices_uses_avg )
+    // or, use combined spread edges
+    if ( !prices_uses_avg )
     {
-        // on 0 samples, return here
-        if ( samples < 1 )
-            return Spread();
+        if ( agg.best_bid_exchange > -1 )
+            ret.bid = agg.exchange_spread[ agg.best_bid_exchange ].bid;
 
-        // divide by num of samples if necessary
-        if ( samples > 1 )
-        {
-            ret.bid /= samples;
-            ret.ask /= samples;
-        }
+        if ( agg.best_ask_exchange > -1 )
+            ret.ask = agg.exchange_spread[ agg.best_ask_exchange ].ask;
+    }
+    // divide by num of samples if necessary
+    else if ( samples > 1 )
+    {
+        ret.bid /= samples;
+        ret.ask /= samples;
     }
 
-    if ( !ret.isValid() )
-        return Spread();
-
-    return ret;
+    agg.spread = ret.isValid() ? ret : Spread();
+    agg.dirty = false;
+    agg.freshness_generation = m_freshness_generation;
 }
 
 Coin PriceAggregator::getStrategySignal( const QString &market ) /*const*/
@@ -9,6 +9,7 @@
 #include <QString>
 #include <QVector>
 #include <QMap>
+#include <QHash>
 #include <QDateTime>
 #include <QObject>
 
@@ -63,9 +64,27 @@ struct PriceAggregatorConfig
     PriceSignal signal_base, signal_strategy;
 };
 
+/* AggregatedSpread
+ *
+ * Consolidated top of book for a market, and the spread of each exchange it came from.
+ * Rebuilt on read after an exchange pushed a new spread or one of the contributing tickers went stale.
+ *
+ */
+struct AggregatedSpread
+{
+    Spread exchange_spread[ ENGINE_COUNT ]; // last spread pushed by each exchange
+    Spread spread; // consolidated spread of the exchanges with fresh tickers
+    qint8 best_bid_exchange{ -1 }; // exchange with the highest bid, -1 if none
+    qint8 best_ask_exchange{ -1 }; // exchange with the lowest ask, -1 if none
+
+    bool dirty{ true };
+    qint64 valid_until_ms{ 0 }; // when the first contributing ticker goes stale
+    quint64 freshness_generation{ 0 };
+};
+
 /* PriceAggregator
  *
- * Aggregates prices from the engines.
+ * Aggregates prices from the engines, which push spread updates as their tickers come in.
  * Saves/loads price history.
  * Maintains a config of markets to commit to disk.
  * Computes averages, etc. from price history according to config.
@@ -85,7 +104,12 @@ public:
     static void savePriceSamples(const PriceAggregatorConfig &config , const QString filename_override = QString() );
     static bool loadPriceSamples( PriceData &data, const QString &path );
 
+    // spread updates from the engines
+    void onExchangeTicker( const quint8 engine_type, const qint64 time_ms );
+    void onExchangeSpread( const quint8 engine_type, const QString &market, const Spread &spread );
+
     Spread getSpread( const QString &market ) const;
+    const AggregatedSpread *getAggregatedSpread( const QString &market ) const; // per exchange breakdown, nullptr if the market is unknown
     Coin getStrategySignal( const QString &market );
 
     void addPersistentMarket( const PriceAggregatorConfig &config );
@@ -106,6 +130,14 @@ public Q_SLOTS:
 
 private:
     void nextPriceSample();
+    bool isExchangeTickerStale( const quint8 engine_type, const qint64 current_time ) const { return m_exchange_ticker_time[ engine_type ] < current_time - TICKER_STALE_MS; }
+    AggregatedSpread *getFreshAggregatedSpread( const QString &market ) const;
+    void rebuildAggregatedSpread( AggregatedSpread &agg, const qint64 current_time ) const;
+
+    // consolidated spreads, rebuilt lazily on read
+    mutable QHash<QString, AggregatedSpread> m_spreads;
+    qint64 m_exchange_ticker_time[ ENGINE_COUNT ]{};
+    quint64 m_freshness_generation{ 0 }; // bumped when an exchange ticker goes fresh or stale out of turn
 
     QMap<QString, PriceAggregatorConfig> m_config;
     QVector<QString> m_currencies;
@@ -0,0 +1,118 @@
+#include "ratelimiter.h"
+
+#include <QtMath>
+
+void TokenBucket::configure( const qreal _capacity, const qreal _per_second, const qint64 now_ms )
+{
+    capacity = qMax( _capacity, 1. );
+    per_second = _per_second;
+
+    // start full, but don't hand out a fresh burst if we are only being retuned
+    tokens = ( last_refill_ms == 0 ) ? capacity : qMin( tokens, capacity );
+    last_refill_ms = now_ms;
+}
+
+void TokenBucket::refill( const qint64 now_ms )
+{
+    if ( isUnlimited() || now_ms <= last_refill_ms )
+        return;
+
+    tokens = qMin( capacity, tokens + per_second * ( now_ms - last_refill_ms ) / 1000. );
+    last_refill_ms = now_ms;
+}
+
+bool TokenBucket::canTake( const qreal cost, const qint64 now_ms )
+{
+    if ( isUnlimited() )
+        return true;
+
+    refill( now_ms );
+
+    // let oversized requests through once the bucket is full so they can't stall forever
+    return tokens >= qMin( cost, capacity );
+}
+
+void TokenBucket::take( const qreal cost )
+{
+    if ( isUnlimited() )
+        return;
+
+    tokens -= cost;
+}
+
+qint64 TokenBucket::msUntil( const qreal cost, const qint64 now_ms )
+{
+    if ( canTake( cost, now_ms ) )
+        return 0;
+
+    const qreal deficit = qMin( cost, capacity ) - tokens;
+
+    return qCeil( deficit * 1000. / per_second );
+}
+
+void RateLimiter::setExchangeLimit( const qreal capacity, const qreal per_second, const qint64 now_ms )
+{
+    exchange_bucket.configure( capacity, per_second, now_ms );
+}
+
+void RateLimiter::setClassLimit( const RateClass rate_class, const qreal capacity, const qreal per_second, const qint64 now_ms )
+{
+    if ( rate_class >= RATE_CLASS_COUNT )
+        return;
+
+    class_buckets[ rate_class ].configure( capacity, per_second, now_ms );
+}
+
+bool RateLimiter::tryTake( const RateClass rate_class, const qreal weight, const qint64 now_ms )
+{
+    if ( rate_class >= RATE_CLASS_COUNT )
+        return false;
+
+    TokenBucket &class_bucket = class_buckets[ rate_class ];
+
+    if ( !class_bucket.canTake( 1., now_ms ) ||
+         !exchange_bucket.canTake( weight, now_ms ) )
+        return false;
+
+    class_bucket.take( 1. );
+    exchange_bucket.take( weight );
+    return true;
+}
+
+qint64 RateLimiter::msUntilAvailable( const RateClass rate_class, const qreal weight, const qint64 now_ms )
+{
+    if ( rate_class >= RATE_CLASS_COUNT )
+        return 0;
+
+    return qMax( class_buckets[ rate_class ].msUntil( 1., now_ms ),
+                 exchange_bucket.msUntil( weight, now_ms ) );
+}
+
+void RateLimiter::drain( const qint64 now_ms )
+{
+    exchange_bucket.refill( now_ms );
+    exchange_bucket.tokens = qMin( exchange_bucket.tokens, 0. );
+
+    for ( int i = 0; i < RATE_CLASS_COUNT; i++ )
+    {
+        class_buckets[ i ].refill( now_ms );
+        class_buckets[ i ].tokens = qMin( class_buckets[ i ].tokens, 0. );
+    }
+}
+
+const char *RateLimiter::getRateClassStr( const RateClass rate_class )
+{
+    switch ( rate_class )
+    {
+    case RateCancel:
+        return "cancel";
+    case RateOrder:
+        return "order";
+    case RateQuery:
+        return "query";
+    case RatePublic:
+        return "public";
+    default:
+        return "unknown";
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef RATELIMITER_H
+#define RATELIMITER_H
+
+#include <QtGlobal>
+
+// endpoint classes, in send priority order
+enum RateClass : quint8
+{
+    RateCancel = 0,
+    RateOrder,
+    RateQuery,
+    RatePublic,
+    RATE_CLASS_COUNT
+};
+
+//
+// TokenBucket, refills continuously at per_second up to capacity. a bucket with per_second <= 0 is unlimited.
+//
+struct TokenBucket
+{
+    void configure( const qreal _capacity, const qreal _per_second, const qint64 now_ms );
+    bool isUnlimited() const { return per_second <= 0.; }
+
+    void refill( const qint64 now_ms );
+    bool canTake( const qreal cost, const qint64 now_ms );
+    void take( const qreal cost );
+    qint64 msUntil( const qreal cost, const qint64 now_ms );
+
+    qreal capacity{ 0. };
+    qreal per_second{ 0. };
+    qreal tokens{ 0. };
+    qint64 last_refill_ms{ 0 };
+};
+
+//
+// RateLimiter, one bucket per endpoint class plus one exchange-wide bucket
+//
+// a request has to fit in both its class bucket (cost 1 per request) and the exchange bucket (cost is the request
+// weight, which is 1 for exchanges that don't weight requests). tokens are only taken if both buckets can pay.
+//
+class RateLimiter
+{
+public:
+    explicit RateLimiter() {}
+
+    void setExchangeLimit( const qreal capacity, const qreal per_second, const qint64 now_ms );
+    void setClassLimit( const RateClass rate_class, const qreal capacity, const qreal per_second, const qint64 now_ms );
+
+    bool tryTake( const RateClass rate_class, const qreal weight, const qint64 now_ms );
+    qint64 msUntilAvailable( const RateClass rate_class, const qreal weight, const qint64 now_ms );
+
+    // empty all buckets, used when the exchange tells us we are throttled
+    void drain( const qint64 now_ms );
+
+    const TokenBucket &getExchangeBucket() const { return exchange_bucket; }
+    const TokenBucket &getClassBucket( const RateClass rate_class ) const { return class_buckets[ rate_class ]; }
+
+    static const char *getRateClassStr( const RateClass rate_class );
+
+private:
+    TokenBucket exchange_bucket;
+    TokenBucket class_buckets[ RATE_CLASS_COUNT ];
+};
+
+#endif // RATELIMITER_H
@@ -0,0 +1,94 @@
+#include "ratelimiter_test.h"
+#include "ratelimiter.h"
+#include "exchangesession.h"
+
+#include <assert.h>
+
+void RateLimiterTest::test()
+{
+    const qint64 t0 = 1000000;
+
+    /// test exchange bucket burst and refill
+    RateLimiter limiter;
+    limiter.setExchangeLimit( 3., 5., t0 );
+
+    assert( limiter.tryTake( RateOrder, 1., t0 ) );
+    assert( limiter.tryTake( RateOrder, 1., t0 ) );
+    assert( limiter.tryTake( RateCancel, 1., t0 ) );
+    assert( !limiter.tryTake( RateQuery, 1., t0 ) );
+    assert( limiter.msUntilAvailable( RateQuery, 1., t0 ) == 200 );
+
+    // 5 per second refills one token every 200ms
+    assert( !limiter.tryTake( RateQuery, 1., t0 + 100 ) );
+    assert( limiter.tryTake( RateQuery, 1., t0 + 200 ) );
+
+    // refill is capped by capacity
+    assert( limiter.tryTake( RateQuery, 1., t0 + 60000 ) );
+    assert( limiter.tryTake( RateQuery, 1., t0 + 60000 ) );
+    assert( limiter.tryTake( RateQuery, 1., t0 + 60000 ) );
+    assert( !limiter.tryTake( RateQuery, 1., t0 + 60000 ) );
+
+    /// test class bucket limits one class without blocking another
+    RateLimiter classes;
+    classes.setExchangeLimit( 10., 10., t0 );
+    classes.setClassLimit( RateQuery, 1., 1., t0 );
+
+    assert( classes.tryTake( RateQuery, 1., t0 ) );
+    assert( !classes.tryTake( RateQuery, 1., t0 ) );
+    assert( classes.msUntilAvailable( RateQuery, 1., t0 ) == 1000 );
+    assert( classes.tryTake( RateOrder, 1., t0 ) );
+    assert( classes.tryTake( RateCancel, 1., t0 ) );
+
+    // a failed class take doesn't spend exchange tokens
+    assert( classes.getExchangeBucket().tokens == 7. );
+
+    /// test request weight against the exchange bucket
+    RateLimiter weighted;
+    weighted.setExchangeLimit( 10., 1., t0 );
+
+    assert( weighted.tryTake( RateQuery, 8., t0 ) );
+    assert( !weighted.tryTake( RateQuery, 5., t0 ) );
+    assert( weighted.msUntilAvailable( RateQuery, 5., t0 ) == 3000 );
+    assert( weighted.tryTake( RateQuery, 2., t0 ) );
+
+    // oversized requests go through once the bucket is full
+    assert( weighted.tryTake( RateQuery, 50., t0 + 10000 ) );
+
+    /// test drain
+    RateLimiter drained;
+    drained.setExchangeLimit( 5., 5., t0 );
+    drained.drain( t0 );
+
+    assert( !drained.tryTake( RateOrder, 1., t0 ) );
+    assert( drained.tryTake( RateOrder, 1., t0 + 200 ) );
+
+    /// test unlimited buckets
+    RateLimiter unlimited;
+
+    for ( int i = 0; i < 1000; i++ )
+        assert( unlimited.tryTake( RateCancel, 100., t0 ) );
+
+    assert( unlimited.msUntilAvailable( RatePublic, 100., t0 ) == 0 );
+
+    /// test session in-flight limits per class
+    ExchangeSession session;
+    session.setInFlightLimit( RateOrder, 2 );
+
+    assert( session.canSend( RateOrder ) );
+    session.onRequestSent( RateOrder );
+    session.onRequestSent( RateOrder );
+    assert( !session.canSend( RateOrder ) );
+    assert( session.getInFlight( RateOrder ) == 2 );
+
+    // other classes are unlimited by default
+    assert( session.canSend( RateCancel ) );
+
+    session.onRequestFinished( RateOrder );
+    assert( session.canSend( RateOrder ) );
+
+    // finishing more than we sent doesn't go negative
+    session.onRequestFinished( RateOrder );
+    session.onRequestFinished( RateOrder );
+    assert( session.getInFlight( RateOrder ) == 0 );
+    assert( !session.canSend( RATE_CLASS_COUNT ) );
+}
@@ -0,0 +1,9 @@
+#ifndef RATELIMITER_TEST_H
+#define RATELIMITER_TEST_H
+
+struct RateLimiterTest
+{
+    void test();
+};
+
+#endif // RATELIMITER_TEST_H
@@ -0,0 +1,56 @@
+#include "replyparser.h"
+
+#include <QtConcurrent/QtConcurrentRun>
+
+ReplyParser::ReplyParser( QObject *parent )
+    : QObject( parent )
+{
+    // one worker keeps replies in order
+    pool.setMaxThreadCount( 1 );
+}
+
+ReplyParser::~ReplyParser()
+{
+    waitForDone();
+}
+
+void ReplyParser::queue( const QString &api_command, const qint64 request_time_sent_ms, const QByteArray &data, ReplyDecoder decoder )
+{
+    QFutureWatcher<ParsedReply> *watcher = new QFutureWatcher<ParsedReply>( this );
+    jobs.insert( watcher );
+
+    connect( watcher, &QFutureWatcher<ParsedReply>::finished, this, &ReplyParser::onJobFinished );
+    watcher->setFuture( QtConcurrent::run( &pool, &ReplyParser::decode, decoder, api_command, request_time_sent_ms, data ) );
+}
+
+ParsedReply ReplyParser::decode( ReplyDecoder decoder, const QString &api_command, const qint64 request_time_sent_ms, const QByteArray &data )
+{
+    ParsedReply reply;
+    reply.api_command = api_command;
+    reply.request_time_sent_ms = request_time_sent_ms;
+    reply.ok = decoder( data, reply );
+
+    // keep the body around for the error message
+    if ( !reply.ok )
+        reply.data = data;
+
+    return reply;
+}
+
+void ReplyParser::waitForDone()
+{
+    pool.waitForDone();
+}
+
+void ReplyParser::onJobFinished()
+{
+    QFutureWatcher<ParsedReply> *watcher = static_cast<QFutureWatcher<ParsedReply>*>( sender() );
+
+    if ( !jobs.remove( watcher ) )
+        return;
+
+    const ParsedReply reply = watcher->result();
+    watcher->deleteLater();
+
+    emit replyParsed( reply );
+}
@@ -0,0 +1,78 @@
+#ifndef REPLYPARSER_H
+#define REPLYPARSER_H
+
+#include "coinamount.h"
+#include "misctypes.h"
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+#include <QMap>
+#include <QSet>
+#include <QFuture>
+#include <QFutureWatcher>
+#include <QThreadPool>
+
+struct ParsedOrder
+{
+    QString market; // the exchange's market string
+    QString order_number;
+    quint8 side{ 0 };
+    Coin price;
+    Coin amount;
+};
+
+//
+// ParsedReply, a reply body decoded into typed fields
+//
+// a decoder fills it in on a parser thread and the exchange applies it to the engine on the exchange's thread. prices
+// stay as Coin, they're converted to OrderInfo strings when applied so the decoders never format them.
+//
+struct ParsedReply
+{
+    QString api_command;
+    qint64 request_time_sent_ms{ 0 };
+    bool ok{ false };
+
+    qint32 market_count{ 0 };
+    QVector<ParsedOrder> orders;
+    QMap<QString, Spread> spreads; // keyed by the exchange's market string
+    QByteArray data; // the reply body, only kept if decoding failed
+};
+
+// decodes a reply body into out, returns false on an error or malformed reply. must not touch anything but its args.
+typedef bool (*ReplyDecoder)( const QByteArray &data, ParsedReply &out );
+
+//
+// ReplyParser, decodes large reply bodies on a worker so the event loop isn't stalled
+//
+// each exchange owns one with a single worker, so replies are parsed and handed back in the order they arrived.
+// replyParsed() is emitted on the thread the exchange lives on.
+//
+class ReplyParser : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ReplyParser( QObject *parent = nullptr );
+    ~ReplyParser();
+
+    void queue( const QString &api_command, const qint64 request_time_sent_ms, const QByteArray &data, ReplyDecoder decoder );
+    static ParsedReply decode( ReplyDecoder decoder, const QString &api_command, const qint64 request_time_sent_ms, const QByteArray &data );
+
+    int getPendingCount() const { return jobs.size(); }
+    void waitForDone();
+
+signals:
+    void replyParsed( const ParsedReply &reply );
+
+private slots:
+    void onJobFinished();
+
+private:
+    QThreadPool pool;
+    QSet<QFutureWatcher<ParsedReply>*> jobs;
+};
+
+#endif // REPLYPARSER_H
@@ -0,0 +1,108 @@
+#include "replyparser_test.h"
+#include "replyparser.h"
+#include "bncrest.h"
+#include "polorest.h"
+#include "trexrest.h"
+#include "global.h"
+
+#include <QCoreApplication>
+#include <QVector>
+
+#include <assert.h>
+
+void ReplyParserTest::test()
+{
+    /// test binance open orders, amount is price * origQty
+    {
+        const QByteArray data( "[{\"symbol\":\"LTCBTC\",\"orderId\":12,\"price\":\"0.1\",\"origQty\":\"2.0\",\"side\":\"BUY\"},"
+                               "{\"symbol\":\"ETHBTC\",\"orderId\":13,\"price\":\"0\",\"origQty\":\"1.0\",\"side\":\"SELL\"}]" );
+        const ParsedReply reply = ReplyParser::decode( &BncREST::decodeOpenOrders, BNC_COMMAND_GETORDERS, 5, data );
+
+        assert( reply.ok );
+        assert( reply.api_command == BNC_COMMAND_GETORDERS );
+        assert( reply.request_time_sent_ms == 5 );
+        assert( reply.data.isEmpty() );
+        assert( reply.orders.size() == 1 ); // zero price is skipped
+        assert( reply.orders[ 0 ].market == "LTCBTC" );
+        assert( reply.orders[ 0 ].order_number == "LTCBTC12" );
+        assert( reply.orders[ 0 ].side == SIDE_BUY );
+        assert( reply.orders[ 0 ].price == "0.1" );
+        assert( reply.orders[ 0 ].amount == "0.2" );
+    }
+
+    /// test binance ticker, every symbol is kept for the alias check
+    {
+        const QByteArray data( "[{\"symbol\":\"LTCBTC\",\"bidPrice\":\"4.0\",\"askPrice\":\"4.2\"},{\"symbol\":\"XYZBTC\",\"bidPrice\":\"0\",\"askPrice\":\"0\"}]" );
+        const ParsedReply reply = ReplyParser::decode( &BncREST::decodeTicker, BNC_COMMAND_GETTICKER, 0, data );
+
+        assert( reply.ok );
+        assert( reply.market_count == 2 );
+        assert( reply.spreads.size() == 2 );
+        assert( reply.spreads.value( "LTCBTC" ).bid == "4" );
+        assert( reply.spreads.value( "LTCBTC" ).ask == "4.2" );
+    }
+
+    /// test a truncated reply fails and keeps the body for the error message
+    {
+        const QByteArray data( "[{\"symbol\":\"LTCBTC\",\"orderId\":12,\"price\":\"0.1\"" );
+        const ParsedReply reply = ReplyParser::decode( &BncREST::decodeOpenOrders, BNC_COMMAND_GETORDERS, 0, data );
+
+        assert( !reply.ok );
+        assert( reply.data == data );
+    }
+
+    /// test poloniex books and errors
+    {
+        const QByteArray data( "{\"BTC_ETH\":{\"asks\":[[\"0.031\",1],[\"0.03\",2]],\"bids\":[[\"0.02\",3],[\"0.021\",1]],\"seq\":1},"
+                               "\"BTC_XMR\":{\"asks\":[],\"bids\":[]}}" );
+        const ParsedReply reply = ReplyParser::decode( &PoloREST::decodeOrderBook, POLO_COMMAND_GETBOOKS, 0, data );
+
+        assert( reply.ok );
+        assert( reply.market_count == 2 );
+        assert( reply.spreads.size() == 1 ); // empty books are skipped
+        assert( reply.spreads.value( "BTC_ETH" ).bid == "0.021" );
+        assert( reply.spreads.value( "BTC_ETH" ).ask == "0.03" );
+
+        assert( !ReplyParser::decode( &PoloREST::decodeOrderBook, POLO_COMMAND_GETBOOKS, 0, "{\"error\":\"Please do not make more than 8 API calls per second.\"}" ).ok );
+        assert( !ReplyParser::decode( &PoloREST::decodeOpenOrders, POLO_COMMAND_GETORDERS, 0, "{}" ).ok );
+    }
+
+    /// test bittrex open orders
+    {
+        const QByteArray data( "{\"success\":true,\"message\":\"\",\"result\":[{\"Exchange\":\"BTC-LTC\",\"OrderUuid\":\"abc\","
+                               "\"OrderType\":\"LIMIT_SELL\",\"Limit\":0.5,\"Quantity\":2}]}" );
+        const ParsedReply reply = ReplyParser::decode( &TrexREST::decodeOpenOrders, TREX_COMMAND_GET_ORDERS, 0, data );
+
+        assert( reply.ok );
+        assert( reply.orders.size() == 1 );
+        assert( reply.orders[ 0 ].side == SIDE_SELL );
+        assert( reply.orders[ 0 ].amount == "1" );
+
+        assert( !ReplyParser::decode( &TrexREST::decodeOpenOrders, TREX_COMMAND_GET_ORDERS, 0, "{\"success\":false,\"message\":\"APIKEY_INVALID\"}" ).ok );
+    }
+
+    /// test queued replies come back in order on this thread
+    {
+        ReplyParser parser;
+        QVector<qint64> times;
+
+        QObject::connect( &parser, &ReplyParser::replyParsed, [&times]( const ParsedReply &reply )
+        {
+            assert( reply.ok );
+            times += reply.request_time_sent_ms;
+        });
+
+        for ( qint64 i = 0; i < 8; i++ )
+            parser.queue( BNC_COMMAND_GETTICKER, i, "[{\"symbol\":\"LTCBTC\",\"bidPrice\":\"1\",\"askPrice\":\"2\"}]", &BncREST::decodeTicker );
+
+        assert( parser.getPendingCount() == 8 );
+
+        parser.waitForDone();
+        while ( parser.getPendingCount() > 0 )
+            QCoreApplication::processEvents();
+
+        assert( times.size() == 8 );
+        for ( qint64 i = 0; i < 8; i++ )
+            assert( times[ i ] == i );
+    }
+}
@@ -0,0 +1,197 @@
+#include "requestqueue.h"
+#include "misctypes.h"
+#include "global.h"
+
+void RequestQueue::push( Request *const &request, const RateClass rate_class, const Coin &priority )
+{
+    if ( request == nullptr || rate_class >= RATE_CLASS_COUNT )
+    {
+        kDebug() << "local error: tried to queue invalid request";
+        return;
+    }
+
+    // already queued, requeue with the new class and priority
+    if ( request->queue_index > -1 )
+        removeOne( request );
+
+    request->queue_class = rate_class;
+    request->queue_sequence = next_sequence++;
+    request->priority = priority;
+
+    QVector<Request*> &heap = heaps[ rate_class ];
+    heap.append( request );
+    request->queue_index = heap.size() -1;
+    siftUp( heap, request->queue_index );
+
+    command_index[ request->api_command ].insert( request->body, request );
+    total_size++;
+}
+
+Request *RequestQueue::top( const RateClass rate_class ) const
+{
+    const QVector<Request*> &heap = heaps[ rate_class ];
+    return heap.isEmpty() ? nullptr : heap.first();
+}
+
+Request *RequestQueue::pop( const RateClass rate_class )
+{
+    Request *request = top( rate_class );
+
+    if ( request != nullptr )
+        removeOne( request );
+
+    return request;
+}
+
+bool RequestQueue::removeOne( Request *const &request )
+{
+    if ( !contains( request ) )
+        return false;
+
+    QVector<Request*> &heap = heaps[ request->queue_class ];
+    const qint32 index = request->queue_index;
+
+    // move the last element into the hole and restore the heap from there
+    Request *last = heap.takeLast();
+    if ( last != request )
+    {
+        place( heap, index, last );
+        siftUp( heap, index );
+        siftDown( heap, last->queue_index );
+    }
+
+    unindex( request );
+    request->queue_index = -1;
+    request->queue_class = RATE_CLASS_COUNT;
+    total_size--;
+
+    return true;
+}
+
+Request *RequestQueue::takeAny()
+{
+    for ( int i = 0; i < RATE_CLASS_COUNT; i++ )
+    {
+        if ( heaps[ i ].isEmpty() )
+            continue;
+
+        Request *request = heaps[ i ].last();
+        removeOne( request );
+        return request;
+    }
+
+    return nullptr;
+}
+
+bool RequestQueue::contains( Request *const &request ) const
+{
+    return request != nullptr &&
+           request->queue_class < RATE_CLASS_COUNT &&
+           request->queue_index > -1 &&
+           request->queue_index < heaps[ request->queue_class ].size() &&
+           heaps[ request->queue_class ].at( request->queue_index ) == request;
+}
+
+bool RequestQueue::containsCommand( const QString &api_command ) const
+{
+    return command_index.contains( api_command );
+}
+
+QVector<Request*> RequestQueue::getByCommand( const QString &api_command ) const
+{
+    const QMultiHash<QString, Request*> by_body = command_index.value( api_command );
+
+    QVector<Request*> ret;
+    ret.reserve( by_body.size() );
+
+    for ( QMultiHash<QString, Request*>::const_iterator i = by_body.begin(); i != by_body.end(); i++ )
+        ret += i.value();
+
+    return ret;
+}
+
+QVector<Request*> RequestQueue::takeByCommandAndBody( const QString &api_command, const QString &body )
+{
+    QVector<Request*> ret;
+
+    QHash<QString, QMultiHash<QString, Request*>>::const_iterator by_command = command_index.find( api_command );
+    if ( by_command == command_index.end() )
+        return ret;
+
+    ret = by_command.value().values( body ).toVector();
+
+    for ( QVector<Request*>::const_iterator i = ret.begin(); i != ret.end(); i++ )
+        removeOne( *i );
+
+    return ret;
+}
+
+bool RequestQueue::isHigher( const Request *const &a, const Request *const &b )
+{
+    if ( a->priority != b->priority )
+        return a->priority > b->priority;
+
+    return a->queue_sequence < b->queue_sequence;
+}
+
+void RequestQueue::siftUp( QVector<Request*> &heap, qint32 index )
+{
+    Request *request = heap.at( index );
+
+    while ( index > 0 )
+    {
+        const qint32 parent = ( index -1 ) / 2;
+
+        if ( !isHigher( request, heap.at( parent ) ) )
+            break;
+
+        place( heap, index, heap.at( parent ) );
+        index = parent;
+    }
+
+    place( heap, index, request );
+}
+
+void RequestQueue::siftDown( QVector<Request*> &heap, qint32 index )
+{
+    Request *request = heap.at( index );
+    const qint32 size = heap.size();
+
+    while ( true )
+    {
+        qint32 child = index * 2 +1;
+
+        if ( child >= size )
+            break;
+
+        // pick the higher child
+        if ( child +1 < size && isHigher( heap.at( child +1 ), heap.at( child ) ) )
+            child++;
+
+        if ( !isHigher( heap.at( child ), request ) )
+            break;
+
+        place( heap, index, heap.at( child ) );
+        index = child;
+    }
+
+    place( heap, index, request );
+}
+
+void RequestQueue::place( QVector<Request*> &heap, const qint32 index, Request *const &request )
+{
+    heap[ index ] = request;
+    request->queue_index = index;
+}
+
+void RequestQueue::unindex( Request *const &request )
+{
+    QHash<QString, QMultiHash<QString, Request*>>::iterator by_command = command_index.find( request->api_command );
+    if ( by_command == command_index.end() )
+        return;
+
+    by_command.value().remove( request->body, request );
+
+    if ( by_command.value().isEmpty() )
+        command_index.erase( by_command );
+}
@@ -0,0 +1,59 @@
+#ifndef REQUESTQUEUE_H
+#define REQUESTQUEUE_H
+
+#include "coinamount.h"
+#include "ratelimiter.h"
+
+#include <QString>
+#include <QVector>
+#include <QHash>
+#include <QMultiHash>
+
+struct Request;
+
+//
+// RequestQueue, indexed priority queue for requests waiting to be sent
+//
+// there is one binary heap per rate class, ordered by priority (highest first) and then by queue order. requests
+// are also indexed by api command and body, so lookups and removals don't have to walk the queue. each request
+// remembers its heap slot, which makes removing an arbitrary request O(log n).
+//
+// the queue doesn't own the requests.
+//
+class RequestQueue
+{
+public:
+    explicit RequestQueue() {}
+
+    void push( Request *const &request, const RateClass rate_class, const Coin &priority );
+    Request *top( const RateClass rate_class ) const;
+    Request *pop( const RateClass rate_class );
+    bool removeOne( Request *const &request );
+    Request *takeAny();
+
+    bool contains( Request *const &request ) const;
+    bool containsCommand( const QString &api_command ) const;
+    QVector<Request*> getByCommand( const QString &api_command ) const;
+    QVector<Request*> takeByCommandAndBody( const QString &api_command, const QString &body );
+
+    // heap storage order, not send order
+    const QVector<Request*> &getClassRequests( const RateClass rate_class ) const { return heaps[ rate_class ]; }
+
+    qint32 size() const { return total_size; }
+    qint32 size( const RateClass rate_class ) const { return heaps[ rate_class ].size(); }
+    bool isEmpty() const { return total_size == 0; }
+
+private:
+    static bool isHigher( const Request *const &a, const Request *const &b );
+    void siftUp( QVector<Request*> &heap, qint32 index );
+    void siftDown( QVector<Request*> &heap, qint32 index );
+    void place( QVector<Request*> &heap, const qint32 index, Request *const &request );
+    void unindex( Request *const &request );
+
+    QVector<Request*> heaps[ RATE_CLASS_COUNT ];
+    QHash<QString /*api_command*/, QMultiHash<QString /*body*/, Request*>> command_index;
+    quint64 next_sequence{ 1 };
+    qint32 total_size{ 0 };
+};
+
+#endif // REQUESTQUEUE_H
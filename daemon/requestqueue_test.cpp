@@ -0,0 +1,103 @@
+#include "requestqueue_test.h"
+#include "requestqueue.h"
+#include "misctypes.h"
+
+#include <assert.h>
+
+#include <QVector>
+
+void RequestQueueTest::test()
+{
+    QVector<Request*> requests;
+    for ( int i = 0; i < 8; i++ )
+    {
+        Request *request = new Request();
+        request->api_command = ( i % 2 == 0 ) ? "cancel" : "order";
+        request->body = QString( "id=%1" ).arg( i );
+        requests += request;
+    }
+
+    /// test priority order, highest first and fifo for equal priority
+    RequestQueue queue;
+    queue.push( requests[ 1 ], RateOrder, CoinAmount::SATOSHI * 5 );
+    queue.push( requests[ 3 ], RateOrder, CoinAmount::SATOSHI * 9 );
+    queue.push( requests[ 5 ], RateOrder, CoinAmount::SATOSHI * 5 );
+    queue.push( requests[ 7 ], RateOrder, Coin() );
+    queue.push( requests[ 0 ], RateCancel, Coin() );
+    queue.push( requests[ 2 ], RateCancel, CoinAmount::COIN );
+
+    assert( queue.size() == 6 );
+    assert( queue.size( RateOrder ) == 4 );
+    assert( queue.size( RateQuery ) == 0 );
+    assert( queue.top( RateQuery ) == nullptr );
+    assert( queue.top( RateCancel ) == requests[ 2 ] );
+
+    assert( queue.pop( RateOrder ) == requests[ 3 ] );
+    assert( queue.pop( RateOrder ) == requests[ 1 ] );
+    assert( queue.pop( RateOrder ) == requests[ 5 ] );
+    assert( queue.pop( RateOrder ) == requests[ 7 ] );
+    assert( queue.pop( RateOrder ) == nullptr );
+    assert( !queue.contains( requests[ 3 ] ) );
+    assert( requests[ 3 ]->queue_index == -1 );
+
+    /// test removal from the middle of the heap
+    for ( int i = 1; i < 8; i += 2 )
+        queue.push( requests[ i ], RateOrder, CoinAmount::SATOSHI * quint64( i ) );
+
+    assert( queue.removeOne( requests[ 3 ] ) );
+    assert( !queue.removeOne( requests[ 3 ] ) );
+    assert( queue.pop( RateOrder ) == requests[ 7 ] );
+    assert( queue.pop( RateOrder ) == requests[ 5 ] );
+    assert( queue.pop( RateOrder ) == requests[ 1 ] );
+
+    /// test command and body index
+    assert( queue.containsCommand( "cancel" ) );
+    assert( !queue.containsCommand( "order" ) );
+    assert( queue.getByCommand( "cancel" ).size() == 2 );
+
+    const QVector<Request*> taken = queue.takeByCommandAndBody( "cancel", "id=0" );
+    assert( taken.size() == 1 && taken.first() == requests[ 0 ] );
+    assert( queue.takeByCommandAndBody( "cancel", "id=0" ).isEmpty() );
+    assert( queue.size() == 1 );
+
+    // requeueing moves the request instead of duplicating it
+    queue.push( requests[ 2 ], RateQuery, Coin() );
+    assert( queue.size() == 1 );
+    assert( queue.size( RateCancel ) == 0 );
+    assert( queue.top( RateQuery ) == requests[ 2 ] );
+
+    assert( queue.takeAny() == requests[ 2 ] );
+    assert( queue.isEmpty() );
+    assert( !queue.containsCommand( "cancel" ) );
+
+    /// test heap order with many equal and random priorities
+    QVector<Request*> many;
+    for ( int i = 0; i < 200; i++ )
+    {
+        Request *request = new Request();
+        request->api_command = "order";
+        many += request;
+        queue.push( request, RateOrder, CoinAmount::SATOSHI * quint64( ( i * 37 ) % 11 ) );
+    }
+
+    for ( int i = 0; i < 200; i += 3 )
+        queue.removeOne( many[ i ] );
+
+    Request *previous = nullptr;
+    while ( !queue.isEmpty() )
+    {
+        Request *request = queue.pop( RateOrder );
+
+        if ( previous != nullptr )
+            assert( previous->priority > request->priority ||
+                    ( previous->priority == request->priority && previous->queue_sequence < request->queue_sequence ) );
+
+        previous = request;
+    }
+
+    while ( !many.isEmpty() )
+        delete many.takeLast();
+
+    while ( !requests.isEmpty() )
+        delete requests.takeLast();
+}
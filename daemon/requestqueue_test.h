@@ -0,0 +1,9 @@
+#ifndef REQUESTQUEUE_TEST_H
+#define REQUESTQUEUE_TEST_H
+
+struct RequestQueueTest
+{
+    void test();
+};
+
+#endif // REQUESTQUEUE_TEST_H
@@ -0,0 +1,1027 @@
+#include "simexchange.h"
+#include "market.h"
+#include "global.h"
+
+#include <string.h>
+
+#include <QTimer>
+#include <QFile>
+#include <QDateTime>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QJsonValue>
+
+namespace
+{
+
+static const int SIM_REPLAY_TICK_MS = 250;
+static const int SIM_REPORT_INTERVAL_MS = 60000;
+static const int SIM_QUOTE_DEPTH = 1000; // displayed size of the replayed quote, the matcher treats it as unlimited
+static const int SIM_ORDER_HISTORY_MAX = 500;
+
+static inline QByteArray toJson( const QJsonObject &obj )
+{
+    return QJsonDocument( obj ).toJson( QJsonDocument::Compact );
+}
+
+static inline QByteArray toJson( const QJsonArray &arr )
+{
+    return QJsonDocument( arr ).toJson( QJsonDocument::Compact );
+}
+
+// bittrex sends numbers instead of strings
+static inline double toJsonNumber( const Coin &c )
+{
+    return c.toAmountString().toDouble();
+}
+
+static inline QString toJsonDate( const qint64 time_ms )
+{
+    return QDateTime::fromMSecsSinceEpoch( time_ms, Qt::UTC ).toString( "yyyy-MM-ddTHH:mm:ss.zzz" );
+}
+
+static inline Coin readCoin( const QUrlQuery &params, const QString &key )
+{
+    const QString value = params.queryItemValue( key );
+    return value.isEmpty() ? Coin() : Coin( value );
+}
+
+} // namespace
+
+SimReply::SimReply( const QNetworkAccessManager::Operation op, const QNetworkRequest &request, QObject *parent )
+  : QNetworkReply( parent )
+{
+    setRequest( request );
+    setUrl( request.url() );
+    setOperation( op );
+    open( QIODevice::ReadOnly | QIODevice::Unbuffered );
+}
+
+void SimReply::setResponse( const int http_status, const QByteArray &data )
+{
+    content = data;
+    offset = 0;
+
+    setAttribute( QNetworkRequest::HttpStatusCodeAttribute, http_status );
+    setHeader( QNetworkRequest::ContentTypeHeader, data.startsWith( '<' ) ? "text/html" : "application/json" );
+    setHeader( QNetworkRequest::ContentLengthHeader, content.size() );
+
+    if ( http_status == 503 )
+        setError( QNetworkReply::ServiceUnavailableError, "Service Unavailable" );
+    else if ( http_status >= 500 )
+        setError( QNetworkReply::InternalServerError, "Internal Server Error" );
+    else if ( http_status >= 400 )
+        setError( QNetworkReply::ProtocolInvalidOperationError, "Bad Request" );
+}
+
+void SimReply::setHostNotFound()
+{
+    content.clear();
+    setError( QNetworkReply::HostNotFoundError, QString( "Host %1 not found" ).arg( url().host() ) );
+}
+
+void SimReply::deliverIn( const qint32 delay_ms )
+{
+    QTimer::singleShot( delay_ms, this, &SimReply::deliver );
+}
+
+void SimReply::abort()
+{
+    if ( isFinished() )
+        return;
+
+    setError( QNetworkReply::OperationCanceledError, "Operation canceled" );
+    setFinished( true );
+    emit finished();
+}
+
+qint64 SimReply::bytesAvailable() const
+{
+    const qint64 available = is_delivered ? content.size() - offset : 0;
+    return available + QIODevice::bytesAvailable();
+}
+
+qint64 SimReply::readData( char *data, qint64 max_size )
+{
+    if ( !is_delivered )
+        return 0;
+
+    if ( offset >= content.size() )
+        return -1;
+
+    const qint64 count = qMin( max_size, content.size() - offset );
+    memcpy( data, content.constData() + offset, size_t( count ) );
+    offset += count;
+
+    return count;
+}
+
+void SimReply::deliver()
+{
+    // aborted while in flight
+    if ( isFinished() )
+        return;
+
+    is_delivered = true;
+
+    emit metaDataChanged();
+
+    if ( !content.isEmpty() )
+        emit readyRead();
+
+    setFinished( true );
+    emit finished();
+}
+
+SimExchange::SimExchange( QObject *parent )
+  : QNetworkAccessManager( parent ),
+    rng( 1 )
+{
+    start_time = QDateTime::currentMSecsSinceEpoch();
+    spread_ratio = QString( "0.001" );
+
+    venues[ ENGINE_BITTREX ].name = BITTREX_EXCHANGE_STR;
+    venues[ ENGINE_BINANCE ].name = BINANCE_EXCHANGE_STR;
+    venues[ ENGINE_POLONIEX ].name = POLONIEX_EXCHANGE_STR;
+
+    for ( QMap<quint8, SimVenue>::iterator i = venues.begin(); i != venues.end(); i++ )
+        i.value().matcher.setFees( QString( "0.001" ), QString( "0.002" ) );
+
+    engine_by_host.insert( QUrl( TREX_REST_URL ).host(), ENGINE_BITTREX );
+    engine_by_host.insert( QUrl( BNC_URL ).host(), ENGINE_BINANCE );
+    engine_by_host.insert( QUrl( POLO_URL_TRADE ).host(), ENGINE_POLONIEX );
+
+    loadSettings( getSettingsPath() );
+
+    replay_timer = new QTimer( this );
+    replay_timer->setTimerType( Qt::PreciseTimer );
+    connect( replay_timer, &QTimer::timeout, this, &SimExchange::onReplayTimer );
+    replay_timer->start( SIM_REPLAY_TICK_MS );
+
+    report_timer = new QTimer( this );
+    connect( report_timer, &QTimer::timeout, this, &SimExchange::onReportTimer );
+    report_timer->start( SIM_REPORT_INTERVAL_MS );
+
+    // apply the first samples right away
+    replay_last_tick_ms = start_time;
+    onReplayTimer();
+
+    kDebug() << "[Sim] exchange simulator enabled with" << replay_markets.size() << "replayed markets, latency"
+             << latency_ms << "+" << latency_jitter_ms << "ms, error rate" << error_rate << "drop rate" << drop_rate;
+}
+
+SimExchange::~SimExchange()
+{
+    const QStringList report = getReport();
+
+    for ( QStringList::const_iterator i = report.begin(); i != report.end(); i++ )
+        kDebug() << *i;
+}
+
+QString SimExchange::getSettingsPath()
+{
+    return Global::getTraderPath() + QDir::separator() + "sim.settings";
+}
+
+bool SimExchange::loadSettings( const QString &path )
+{
+    QFile settings_file( path );
+    if ( !settings_file.open( QIODevice::ReadOnly | QIODevice::Text ) )
+    {
+        kDebug() << "[Sim] warning: couldn't load simulator settings" << path;
+        return false;
+    }
+
+    const QStringList lines = QString( settings_file.readAll() ).split( QChar( '\n' ) );
+    settings_file.close();
+
+    for ( QStringList::const_iterator i = lines.begin(); i != lines.end(); i++ )
+    {
+        // strip comments
+        const QString line = (*i).section( QChar( '#' ), 0, 0 ).simplified();
+
+        if ( line.isEmpty() )
+            continue;
+
+        const QStringList args = line.split( QChar( ' ' ) );
+        const QString &option = args.first();
+
+        if ( option == "seed" && args.size() == 2 )
+        {
+            rng.seed( args.at( 1 ).toUInt() );
+        }
+        else if ( option == "latency" && args.size() >= 2 )
+        {
+            latency_ms = qMax( args.at( 1 ).toInt(), 0 );
+            latency_jitter_ms = qMax( args.value( 2 ).toInt(), 0 );
+        }
+        else if ( option == "errors" && args.size() >= 2 )
+        {
+            error_rate = qBound( 0., args.at( 1 ).toDouble(), 1. );
+            drop_rate = qBound( 0., args.value( 2 ).toDouble(), 1. );
+        }
+        else if ( option == "fees" && args.size() == 3 )
+        {
+            for ( QMap<quint8, SimVenue>::iterator j = venues.begin(); j != venues.end(); j++ )
+                j.value().matcher.setFees( args.at( 1 ), args.at( 2 ) );
+        }
+        else if ( option == "spread" && args.size() == 2 )
+        {
+            spread_ratio = args.at( 1 );
+        }
+        else if ( option == "speed" && args.size() == 2 )
+        {
+            replay_speed = qMax( args.at( 1 ).toDouble(), 0. );
+        }
+        else if ( option == "balance" && args.size() == 3 )
+        {
+            for ( QMap<quint8, SimVenue>::iterator j = venues.begin(); j != venues.end(); j++ )
+                j.value().matcher.setBalance( args.at( 1 ), args.at( 2 ) );
+
+            has_balances = true;
+        }
+        else if ( option == "market" && args.size() == 4 && Market( args.at( 1 ) ).isValid() )
+        {
+            addMarket( args.at( 1 ), args.at( 2 ), args.at( 3 ) );
+        }
+        else if ( option == "replay" && args.size() >= 3 )
+        {
+            SimReplayMarket replay;
+            replay.market = args.at( 1 );
+            replay.interval_secs = args.at( 2 ).toLongLong();
+
+            const QString samples_path = args.size() > 3 ? args.at( 3 ) :
+                                                           PriceAggregator::getSamplesPath( replay.market, replay.interval_secs );
+
+            if ( replay.interval_secs < 1 ||
+                 !Market( replay.market ).isValid() ||
+                 !PriceAggregator::loadPriceSamples( replay.samples, samples_path ) ||
+                 replay.samples.data.isEmpty() )
+            {
+                kDebug() << "[Sim] error: couldn't load replay for" << replay.market << "from" << samples_path;
+                continue;
+            }
+
+            if ( !venues[ ENGINE_BINANCE ].matcher.hasMarket( replay.market ) )
+                addMarket( replay.market );
+
+            replay_markets += replay;
+        }
+        else
+        {
+            kDebug() << "[Sim] warning: bad settings line:" << line;
+        }
+    }
+
+    // without balances, let the bot trade freely
+    for ( QMap<quint8, SimVenue>::iterator i = venues.begin(); i != venues.end(); i++ )
+        i.value().matcher.setUnlimitedFunds( !has_balances );
+
+    return true;
+}
+
+void SimExchange::addMarket( const QString &market, const Coin &price_ticksize, const Coin &quantity_ticksize )
+{
+    for ( QMap<quint8, SimVenue>::iterator i = venues.begin(); i != venues.end(); i++ )
+    {
+        const quint8 engine_type = i.key();
+        SimVenue &venue = i.value();
+
+        // only binance reads ticksizes from the exchange, the others trade in satoshis
+        if ( engine_type == ENGINE_BINANCE )
+            venue.matcher.addMarket( market, price_ticksize, quantity_ticksize );
+        else
+            venue.matcher.addMarket( market, CoinAmount::SATOSHI, CoinAmount::SATOSHI );
+
+        venue.markets_by_symbol.insert( Market( market ).toExchangeString( engine_type ), market );
+    }
+}
+
+void SimExchange::applyQuote( const QString &market, const Coin &price, const qint64 current_time )
+{
+    for ( QMap<quint8, SimVenue>::iterator i = venues.begin(); i != venues.end(); i++ )
+    {
+        SimVenue &venue = i.value();
+
+        if ( !venue.matcher.hasMarket( market ) )
+            continue;
+
+        const Coin ticksize = venue.matcher.getPriceTicksize( market );
+        const Coin half_spread = price * spread_ratio;
+
+        // round the spread outwards onto the ticksize
+        Coin bid = price - half_spread;
+        bid.truncateByTicksize( ticksize );
+
+        const Coin ask_raw = price + half_spread;
+        Coin ask = ask_raw;
+        ask.truncateByTicksize( ticksize );
+
+        if ( ask < ask_raw )
+            ask += ticksize;
+
+        if ( bid >= ask )
+            ask = bid + ticksize;
+
+        if ( bid.isZeroOrLess() )
+            continue;
+
+        const Spread previous = venue.matcher.getExternalSpread( market );
+
+        if ( venue.matcher.setQuote( market, bid, ask, current_time ) < 0 )
+            continue;
+
+        // measure reaction from the first quote change the bot hasn't acted on yet
+        if ( ( previous.bid != bid || previous.ask != ask ) &&
+             !venue.quote_change_times.contains( market ) )
+            venue.quote_change_times.insert( market, current_time );
+    }
+}
+
+QStringList SimExchange::getReport() const
+{
+    QStringList ret;
+    const qreal uptime_secs = qMax( ( QDateTime::currentMSecsSinceEpoch() - start_time ) / 1000., 1. );
+
+    for ( QMap<quint8, SimVenue>::const_iterator i = venues.begin(); i != venues.end(); i++ )
+    {
+        const SimVenue &venue = i.value();
+        const SimMatcher &matcher = venue.matcher;
+
+        if ( venue.requests == 0 )
+            continue;
+
+        ret += QString( "[Sim] %1 requests: %2 orders: %3 rejected: %4 cancelled: %5 fills: %6 maker %7 taker, injected errors: %8 drops: %9" )
+               .arg( venue.name )
+               .arg( venue.requests )
+               .arg( matcher.getOrdersPlaced() )
+               .arg( matcher.getOrdersRejected() )
+               .arg( matcher.getOrdersCancelled() )
+               .arg( matcher.getMakerFills() )
+               .arg( matcher.getTakerFills() )
+               .arg( venue.errors_injected )
+               .arg( venue.drops_injected );
+
+        // the rate is order throughput, orders and cancels per second
+        const qreal throughput = ( matcher.getOrdersPlaced() + matcher.getOrdersRejected() + matcher.getOrdersCancelled() ) / uptime_secs;
+        ret += LatencyStats::formatLine( QString( "[Sim] %1 reaction" ).arg( venue.name ), venue.reaction, throughput );
+    }
+
+    return ret;
+}
+
+QString SimExchange::getBittrexOrderId( const qint64 order_id )
+{
+    return QString( "00000000-0000-4000-8000-%1" ).arg( order_id, 12, 10, QChar( '0' ) );
+}
+
+qint64 SimExchange::getOrderIdFromBittrex( const QString &uuid )
+{
+    if ( !uuid.startsWith( "00000000-0000-4000-8000-" ) )
+        return -1;
+
+    bool ok = false;
+    const qint64 order_id = uuid.section( QChar( '-' ), 4 ).toLongLong( &ok );
+
+    return ok ? order_id : -1;
+}
+
+QNetworkReply *SimExchange::createRequest( Operation op, const QNetworkRequest &request, QIODevice *outgoing_data )
+{
+    const qint64 current_time = QDateTime::currentMSecsSinceEpoch();
+    const QUrl url = request.url();
+
+    SimReply *reply = new SimReply( op, request, this );
+    const qint32 delay_ms = latency_ms + ( latency_jitter_ms > 0 ? rng.bounded( latency_jitter_ms +1 ) : 0 );
+
+    // nothing leaves the box
+    if ( !engine_by_host.contains( url.host() ) )
+    {
+        reply->setHostNotFound();
+        reply->deliverIn( delay_ms );
+        return reply;
+    }
+
+    const quint8 engine_type = engine_by_host.value( url.host() );
+    SimVenue &venue = venues[ engine_type ];
+    venue.requests++;
+
+    // dropped requests never finish, the request timeout aborts them
+    if ( drop_rate > 0. && rng.generateDouble() < drop_rate )
+    {
+        venue.drops_injected++;
+        return reply;
+    }
+
+    int http_status = 200;
+    QByteArray data;
+
+    if ( error_rate > 0. && rng.generateDouble() < error_rate )
+    {
+        venue.errors_injected++;
+        data = getInjectedError( engine_type, http_status );
+    }
+    else
+    {
+        // signed params can be in the query or the form body, merge them
+        QUrlQuery params( url );
+
+        if ( outgoing_data != nullptr )
+        {
+            const QUrlQuery body_params( QString::fromUtf8( outgoing_data->readAll() ) );
+            params.setQueryItems( params.queryItems() + body_params.queryItems() );
+        }
+
+        const QString verb = op == GetOperation    ? QString( "GET" ) :
+                             op == PostOperation   ? QString( "POST" ) :
+                             op == PutOperation    ? QString( "PUT" ) :
+                             op == DeleteOperation ? QString( "DELETE" ) :
+                                                     request.attribute( QNetworkRequest::CustomVerbAttribute ).toString();
+
+        // poloniex puts the command in the params, the others in the path after /api/<version>/
+        const QString command = engine_type == ENGINE_POLONIEX ? params.queryItemValue( "command" ) :
+                                                                 url.path().section( QChar( '/' ), 3, -1 );
+
+        data = engine_type == ENGINE_BINANCE  ? replyBinance( venue, verb, command, params, current_time, http_status ) :
+               engine_type == ENGINE_POLONIEX ? replyPoloniex( venue, command, params, current_time, http_status ) :
+                                                replyBittrex( venue, command, params, current_time, http_status );
+    }
+
+    reply->setResponse( http_status, data );
+    reply->deliverIn( delay_ms );
+    return reply;
+}
+
+QByteArray SimExchange::replyBinance( SimVenue &venue, const QString &verb, const QString &command, const QUrlQuery &params, const qint64 current_time, int &http_status )
+{
+    SimMatcher &matcher = venue.matcher;
+
+    auto error = [&]( const int code, const QString &msg )
+    {
+        http_status = 400;
+        return toJson( QJsonObject{ { "code", code }, { "msg", msg } } );
+    };
+
+    auto orderJson = []( const SimOrder &order )
+    {
+        const QString status = order.is_open ? ( order.filled_quantity.isGreaterThanZero() ? "PARTIALLY_FILLED" : "NEW" ) :
+                               order.is_cancelled ? "CANCELED" : "FILLED";
+
+        return QJsonObject{ { "symbol", Market( order.market ).toExchangeString( ENGINE_BINANCE ) },
+                            { "orderId", order.id },
+                            { "price", order.price.toAmountString() },
+                            { "origQty", order.quantity.toAmountString() },
+                            { "executedQty", order.filled_quantity.toAmountString() },
+                            { "cummulativeQuoteQty", order.filled_total.toAmountString() },
+                            { "status", status },
+                            { "timeInForce", "GTC" },
+                            { "type", "LIMIT" },
+                            { "side", order.side == SIDE_BUY ? "BUY" : "SELL" },
+                            { "time", order.time_created_ms } };
+    };
+
+    const QString symbol = params.queryItemValue( "symbol" );
+    const QString market = venue.markets_by_symbol.value( symbol );
+
+    if ( !symbol.isEmpty() && market.isEmpty() )
+        return error( -1121, "Invalid symbol." );
+
+    if ( command == "exchangeInfo" )
+    {
+        QJsonArray symbols;
+        const QList<QString> markets = matcher.getMarkets();
+
+        for ( QList<QString>::const_iterator i = markets.begin(); i != markets.end(); i++ )
+        {
+            const Market m( *i );
+            const QString price_ticksize = matcher.getPriceTicksize( *i ).toAmountString();
+            const QString quantity_ticksize = matcher.getQuantityTicksize( *i ).toAmountString();
+
+            QJsonArray filters;
+            filters.append( QJsonObject{ { "filterType", "PRICE_FILTER" }, { "minPrice", price_ticksize }, { "maxPrice", "100000.00000000" }, { "tickSize", price_ticksize } } );
+            filters.append( QJsonObject{ { "filterType", "PERCENT_PRICE" }, { "multiplierUp", "5" }, { "multiplierDown", "0.2" }, { "avgPriceMins", 5 } } );
+            filters.append( QJsonObject{ { "filterType", "LOT_SIZE" }, { "minQty", quantity_ticksize }, { "maxQty", "9000000.00000000" }, { "stepSize", quantity_ticksize } } );
+
+            symbols.append( QJsonObject{ { "symbol", m.toExchangeString( ENGINE_BINANCE ) },
+                                         { "status", "TRADING" },
+                                         { "baseAsset", m.getQuote() },
+                                         { "quoteAsset", m.getBase() },
+                                         { "filters", filters } } );
+        }
+
+        QJsonArray rate_limits;
+        rate_limits.append( QJsonObject{ { "rateLimitType", "REQUEST_WEIGHT" }, { "interval", "MINUTE" }, { "limit", 1200 } } );
+        rate_limits.append( QJsonObject{ { "rateLimitType", "ORDERS" }, { "interval", "SECOND" }, { "limit", 10 } } );
+        rate_limits.append( QJsonObject{ { "rateLimitType", "ORDERS" }, { "interval", "DAY" }, { "limit", 200000 } } );
+
+        return toJson( QJsonObject{ { "timezone", "UTC" },
+                                    { "serverTime", current_time },
+                                    { "rateLimits", rate_limits },
+                                    { "symbols", symbols } } );
+    }
+    else if ( command == "ticker/bookTicker" )
+    {
+        QJsonArray tickers;
+        const QList<QString> markets = matcher.getMarkets();
+
+        for ( QList<QString>::const_iterator i = markets.begin(); i != markets.end(); i++ )
+        {
+            const Spread spread = matcher.getSpread( *i );
+
+            if ( !spread.isValid() )
+                continue;
+
+            tickers.append( QJsonObject{ { "symbol", Market( *i ).toExchangeString( ENGINE_BINANCE ) },
+                                         { "bidPrice", spread.bid.toAmountString() },
+                                         { "bidQty", QString::number( SIM_QUOTE_DEPTH ) },
+                                         { "askPrice", spread.ask.toAmountString() },
+                                         { "askQty", QString::number( SIM_QUOTE_DEPTH ) } } );
+        }
+
+        return toJson( tickers );
+    }
+    else if ( command == "openOrders" && verb == "GET" )
+    {
+        QJsonArray ret;
+        const QVector<const SimOrder*> open_orders = matcher.getOpenOrders();
+
+        for ( QVector<const SimOrder*>::const_iterator i = open_orders.begin(); i != open_orders.end(); i++ )
+            if ( market.isEmpty() || (*i)->market == market )
+                ret.append( orderJson( **i ) );
+
+        return toJson( ret );
+    }
+    else if ( command == "openOrders" && verb == "DELETE" )
+    {
+        if ( market.isEmpty() )
+            return error( -1102, "Mandatory parameter 'symbol' was not sent, was empty/null, or malformed." );
+
+        recordReaction( venue, market, current_time );
+
+        const QVector<qint64> cancelled = matcher.cancelAll( market, current_time );
+
+        if ( cancelled.isEmpty() )
+            return error( -2011, "Unknown order sent." );
+
+        QJsonArray ret;
+        for ( QVector<qint64>::const_iterator i = cancelled.begin(); i != cancelled.end(); i++ )
+        {
+            const SimOrder *order = matcher.getOrder( *i );
+
+            if ( order != nullptr )
+                ret.append( orderJson( *order ) );
+        }
+
+        return toJson( ret );
+    }
+    else if ( command == "order" && verb == "POST" )
+    {
+        if ( market.isEmpty() )
+            return error( -1102, "Mandatory parameter 'symbol' was not sent, was empty/null, or malformed." );
+
+        const QString side_str = params.queryItemValue( "side" );
+        const quint8 side = side_str == "BUY"  ? SIDE_BUY :
+                            side_str == "SELL" ? SIDE_SELL : 0;
+        const bool post_only = params.queryItemValue( "type" ) == "LIMIT_MAKER";
+
+        recordReaction( venue, market, current_time );
+
+        qint64 order_id = 0;
+        const SimOrderResult result = matcher.placeOrder( market, side, readCoin( params, "price" ), readCoin( params, "quantity" ), post_only, current_time, order_id );
+
+        if ( result == SimOrderWouldTake )
+            return error( -2010, "Order would immediately match and take." );
+        else if ( result == SimOrderInsufficientFunds )
+            return error( -2010, "Account has insufficient balance for requested action." );
+        else if ( result != SimOrderOk )
+            return error( -1013, "Filter failure: PRICE_FILTER or LOT_SIZE" );
+
+        return toJson( orderJson( *matcher.getOrder( order_id ) ) );
+    }
+    else if ( command == "order" && ( verb == "DELETE" || verb == "GET" ) )
+    {
+        bool ok = false;
+        const qint64 order_id = params.queryItemValue( "orderId" ).toLongLong( &ok );
+        const SimOrder *order = ok ? matcher.getOrder( order_id ) : nullptr;
+
+        if ( order == nullptr || order->market != market )
+            return verb == "GET" ? error( -2013, "Order does not exist." ) :
+                                   error( -2011, "Unknown order sent." );
+
+        if ( verb == "GET" )
+            return toJson( orderJson( *order ) );
+
+        if ( !order->is_open )
+            return error( -2011, "Unknown order sent." );
+
+        recordReaction( venue, market, current_time );
+        matcher.cancelOrder( order_id, current_time );
+
+        return toJson( orderJson( *order ) );
+    }
+    else if ( command == "account" )
+    {
+        QJsonArray balances;
+        const QMap<QString, SimBalance> &matcher_balances = matcher.getBalances();
+
+        for ( QMap<QString, SimBalance>::const_iterator i = matcher_balances.begin(); i != matcher_balances.end(); i++ )
+            balances.append( QJsonObject{ { "asset", i.key() },
+                                          { "free", i.value().available.toAmountString() },
+                                          { "locked", i.value().on_orders.toAmountString() } } );
+
+        return toJson( QJsonObject{ { "canTrade", true },
+                                    { "updateTime", current_time },
+                                    { "balances", balances } } );
+    }
+    else if ( command == "userDataStream" )
+    {
+        // the simulator doesn't stream, hand out a key so the rest client is happy
+        if ( verb == "POST" )
+            return toJson( QJsonObject{ { "listenKey", "sim" } } );
+
+        return toJson( QJsonObject() );
+    }
+
+    return error( -1000, QString( "Unsupported request %1 %2" ).arg( verb ).arg( command ) );
+}
+
+QByteArray SimExchange::replyPoloniex( SimVenue &venue, const QString &command, const QUrlQuery &params, const qint64 current_time, int &http_status )
+{
+    Q_UNUSED( http_status )
+
+    SimMatcher &matcher = venue.matcher;
+
+    auto error = []( const QString &msg )
+    {
+        return toJson( QJsonObject{ { "error", msg } } );
+    };
+
+    auto orderJson = []( const SimOrder &order )
+    {
+        return QJsonObject{ { "orderNumber", QString::number( order.id ) },
+                            { "type", order.side == SIDE_BUY ? BUY : SELL },
+                            { "rate", order.price.toAmountString() },
+                            { "startingAmount", order.quantity.toAmountString() },
+                            { "amount", order.getRemaining().toAmountString() },
+                            { "total", ( order.price * order.getRemaining() ).toAmountString() },
+                            { "date", toJsonDate( order.time_created_ms ) },
+                            { "margin", 0 } };
+    };
+
+    const QList<QString> markets = matcher.getMarkets();
+
+    if ( command == POLO_COMMAND_GETBOOKS )
+    {
+        QJsonObject ret;
+
+        for ( QList<QString>::const_iterator i = markets.begin(); i != markets.end(); i++ )
+        {
+            const Spread spread = matcher.getSpread( *i );
+
+            if ( !spread.isValid() )
+                continue;
+
+            QJsonArray asks, bids;
+            asks.append( QJsonArray{ spread.ask.toAmountString(), SIM_QUOTE_DEPTH } );
+            bids.append( QJsonArray{ spread.bid.toAmountString(), SIM_QUOTE_DEPTH } );
+
+            ret.insert( Market( *i ).toExchangeString( ENGINE_POLONIEX ),
+                        QJsonObject{ { "asks", asks },
+                                     { "bids", bids },
+                                     { "isFrozen", "0" },
+                                     { "seq", qint64( venue.requests ) } } );
+        }
+
+        return toJson( ret );
+    }
+    else if ( command == BUY || command == SELL )
+    {
+        const QString market = venue.markets_by_symbol.value( params.queryItemValue( "currencyPair" ) );
+
+        if ( market.isEmpty() )
+            return error( "Invalid currency pair." );
+
+        recordReaction( venue, market, current_time );
+
+        const quint8 side = command == BUY ? SIDE_BUY : SIDE_SELL;
+        qint64 order_id = 0;
+        const SimOrderResult result = matcher.placeOrder( market, side, readCoin( params, "rate" ), readCoin( params, "amount" ),
+                                                          params.queryItemValue( "postOnly" ) == "1", current_time, order_id );
+
+        if ( result == SimOrderWouldTake )
+            return error( "Unable to place post-only order at this price." );
+        else if ( result == SimOrderInsufficientFunds )
+            return error( QString( "Not enough %1." ).arg( side == SIDE_BUY ? Market( market ).getBase() : Market( market ).getQuote() ) );
+        else if ( result != SimOrderOk )
+            return error( "Invalid rate or amount parameter." );
+
+        const SimOrder *order = matcher.getOrder( order_id );
+        QJsonArray trades;
+
+        if ( order->filled_quantity.isGreaterThanZero() )
+            trades.append( QJsonObject{ { "amount", order->filled_quantity.toAmountString() },
+                                        { "date", toJsonDate( current_time ) },
+                                        { "rate", ( order->filled_total / order->filled_quantity ).toAmountString() },
+                                        { "total", order->filled_total.toAmountString() },
+                                        { "tradeID", QString::number( order->id ) },
+                                        { "type", command } } );
+
+        return toJson( QJsonObject{ { "orderNumber", QString::number( order->id ) },
+                                    { "resultingTrades", trades } } );
+    }
+    else if ( command == POLO_COMMAND_CANCEL )
+    {
+        bool ok = false;
+        const qint64 order_id = params.queryItemValue( "orderNumber" ).toLongLong( &ok );
+        const SimOrder *order = ok ? matcher.getOrder( order_id ) : nullptr;
+
+        if ( order == nullptr || !order->is_open )
+            return error( "Invalid order number, or you are not the person who placed the order." );
+
+        recordReaction( venue, order->market, current_time );
+
+        const Coin remaining = order->getRemaining();
+        matcher.cancelOrder( order_id, current_time );
+
+        return toJson( QJsonObject{ { "success", 1 },
+                                    { "amount", remaining.toAmountString() },
+                                    { "message", QString( "Order #%1 canceled." ).arg( order_id ) } } );
+    }
+    else if ( command == POLO_COMMAND_GETORDERS )
+    {
+        // every market is listed, with an empty array if there are no orders
+        QMap<QString, QJsonArray> by_market;
+
+        for ( QList<QString>::const_iterator i = markets.begin(); i != markets.end(); i++ )
+            by_market.insert( *i, QJsonArray() );
+
+        const QVector<const SimOrder*> open_orders = matcher.getOpenOrders();
+
+        for ( QVector<const SimOrder*>::const_iterator i = open_orders.begin(); i != open_orders.end(); i++ )
+            by_market[ (*i)->market ].append( orderJson( **i ) );
+
+        QJsonObject ret;
+        for ( QMap<QString, QJsonArray>::const_iterator i = by_market.begin(); i != by_market.end(); i++ )
+            ret.insert( Market( i.key() ).toExchangeString( ENGINE_POLONIEX ), i.value() );
+
+        return toJson( ret );
+    }
+    else if ( command == POLO_COMMAND_GETBALANCES )
+    {
+        QJsonObject ret;
+        const QMap<QString, SimBalance> &balances = matcher.getBalances();
+
+        for ( QMap<QString, SimBalance>::const_iterator i = balances.begin(); i != balances.end(); i++ )
+        {
+            const Coin total = i.value().available + i.value().on_orders;
+            const QString btc_market = QString( "BTC_%1" ).arg( i.key() );
+
+            Coin btc_value;
+            if ( i.key() == "BTC" )
+                btc_value = total;
+            else if ( matcher.hasMarket( btc_market ) )
+                btc_value = total * matcher.getSpread( btc_market ).bid;
+
+            ret.insert( i.key(), QJsonObject{ { "available", i.value().available.toAmountString() },
+                                              { "onOrders", i.value().on_orders.toAmountString() },
+                                              { "btcValue", btc_value.toAmountString() } } );
+        }
+
+        return toJson( ret );
+    }
+    else if ( command == POLO_COMMAND_GETFEE )
+    {
+        return toJson( QJsonObject{ { "makerFee", matcher.getMakerFee().toAmountString() },
+                                    { "takerFee", matcher.getTakerFee().toAmountString() },
+                                    { "thirtyDayVolume", "0.00000000" },
+                                    { "nextTier", 0 } } );
+    }
+
+    return error( "Invalid command." );
+}
+
+QByteArray SimExchange::replyBittrex( SimVenue &venue, const QString &command, const QUrlQuery &params, const qint64 current_time, int &http_status )
+{
+    Q_UNUSED( http_status )
+
+    SimMatcher &matcher = venue.matcher;
+
+    auto envelope = []( const bool success, const QString &message, const QJsonValue &result )
+    {
+        return toJson( QJsonObject{ { "success", success }, { "message", message }, { "result", result } } );
+    };
+
+    auto orderJson = []( const SimOrder &order )
+    {
+        const QString type = order.side == SIDE_BUY ? "LIMIT_BUY" : "LIMIT_SELL";
+        const bool has_fill = order.filled_quantity.isGreaterThanZero();
+
+        return QJsonObject{ { "OrderUuid", getBittrexOrderId( order.id ) },
+                            { "Exchange", Market( order.market ).toExchangeString( ENGINE_BITTREX ) },
+                            { "OrderType", type },
+                            { "Type", type },
+                            { "Quantity", toJsonNumber( order.quantity ) },
+                            { "QuantityRemaining", toJsonNumber( order.getRemaining() ) },
+                            { "Limit", toJsonNumber( order.price ) },
+                            { "Price", toJsonNumber( order.filled_total ) },
+                            { "PricePerUnit", has_fill ? QJsonValue( toJsonNumber( order.filled_total / order.filled_quantity ) ) : QJsonValue() },
+                            { "CommissionPaid", toJsonNumber( order.commission ) },
+                            { "Commission", toJsonNumber( order.commission ) },
+                            { "IsOpen", order.is_open },
+                            { "CancelInitiated", order.is_cancelled },
+                            { "Opened", toJsonDate( order.time_created_ms ) },
+                            { "TimeStamp", toJsonDate( order.time_created_ms ) },
+                            { "Closed", order.is_open ? QJsonValue() : QJsonValue( toJsonDate( order.time_closed_ms ) ) } };
+    };
+
+    const QString market = venue.markets_by_symbol.value( params.queryItemValue( "market" ) );
+
+    if ( command == TREX_COMMAND_GET_MARKET_SUMS )
+    {
+        QJsonArray ret;
+        const QList<QString> markets = matcher.getMarkets();
+
+        for ( QList<QString>::const_iterator i = markets.begin(); i != markets.end(); i++ )
+        {
+            const Spread spread = matcher.getSpread( *i );
+
+            if ( !spread.isValid() )
+                continue;
+
+            ret.append( QJsonObject{ { "MarketName", Market( *i ).toExchangeString( ENGINE_BITTREX ) },
+                                     { "Bid", toJsonNumber( spread.bid ) },
+                                     { "Ask", toJsonNumber( spread.ask ) },
+                                     { "Last", toJsonNumber( spread.getMidPrice() ) },
+                                     { "TimeStamp", toJsonDate( current_time ) } } );
+        }
+
+        return envelope( true, QString(), ret );
+    }
+    else if ( command == TREX_COMMAND_BUY || command == TREX_COMMAND_SELL )
+    {
+        if ( market.isEmpty() )
+            return envelope( false, "INVALID_MARKET", QJsonValue() );
+
+        recordReaction( venue, market, current_time );
+
+        qint64 order_id = 0;
+        const SimOrderResult result = matcher.placeOrder( market, command == TREX_COMMAND_BUY ? SIDE_BUY : SIDE_SELL,
+                                                          readCoin( params, "rate" ), readCoin( params, "quantity" ),
+                                                          false, current_time, order_id );
+
+        if ( result == SimOrderInsufficientFunds )
+            return envelope( false, "INSUFFICIENT_FUNDS", QJsonValue() );
+        else if ( result != SimOrderOk )
+            return envelope( false, "MIN_TRADE_REQUIREMENT_NOT_MET", QJsonValue() );
+
+        return envelope( true, QString(), QJsonObject{ { "uuid", getBittrexOrderId( order_id ) } } );
+    }
+    else if ( command == TREX_COMMAND_CANCEL )
+    {
+        const qint64 order_id = getOrderIdFromBittrex( params.queryItemValue( "uuid" ) );
+        const SimOrder *order = matcher.getOrder( order_id );
+
+        if ( order == nullptr )
+            return envelope( false, "INVALID_ORDER", QJsonValue() );
+        else if ( !order->is_open )
+            return envelope( false, "ORDER_NOT_OPEN", QJsonValue() );
+
+        recordReaction( venue, order->market, current_time );
+        matcher.cancelOrder( order_id, current_time );
+
+        return envelope( true, QString(), QJsonValue() );
+    }
+    else if ( command == TREX_COMMAND_GET_ORDERS )
+    {
+        QJsonArray ret;
+        const QVector<const SimOrder*> open_orders = matcher.getOpenOrders();
+
+        for ( QVector<const SimOrder*>::const_iterator i = open_orders.begin(); i != open_orders.end(); i++ )
+            if ( market.isEmpty() || (*i)->market == market )
+                ret.append( orderJson( **i ) );
+
+        return envelope( true, QString(), ret );
+    }
+    else if ( command == TREX_COMMAND_GET_ORDER )
+    {
+        const SimOrder *order = matcher.getOrder( getOrderIdFromBittrex( params.queryItemValue( "uuid" ) ) );
+
+        if ( order == nullptr )
+            return envelope( false, "INVALID_ORDER", QJsonValue() );
+
+        return envelope( true, QString(), orderJson( *order ) );
+    }
+    else if ( command == TREX_COMMAND_GET_ORDER_HIST )
+    {
+        // closed orders that traded, newest first
+        QJsonArray ret;
+        const QVector<const SimOrder*> closed_orders = matcher.getClosedOrders();
+
+        for ( QVector<const SimOrder*>::const_iterator i = closed_orders.begin(); i != closed_orders.end() && ret.size() < SIM_ORDER_HISTORY_MAX; i++ )
+            if ( (*i)->filled_quantity.isGreaterThanZero() && ( market.isEmpty() || (*i)->market == market ) )
+                ret.append( orderJson( **i ) );
+
+        return envelope( true, QString(), ret );
+    }
+    else if ( command == TREX_COMMAND_GET_BALANCES )
+    {
+        QJsonArray ret;
+        const QMap<QString, SimBalance> &balances = matcher.getBalances();
+
+        for ( QMap<QString, SimBalance>::const_iterator i = balances.begin(); i != balances.end(); i++ )
+            ret.append( QJsonObject{ { "Currency", i.key() },
+                                     { "Balance", toJsonNumber( i.value().available + i.value().on_orders ) },
+                                     { "Available", toJsonNumber( i.value().available ) },
+                                     { "Pending", 0. },
+                                     { "CryptoAddress", QJsonValue() } } );
+
+        return envelope( true, QString(), ret );
+    }
+
+    return envelope( false, "INVALID_METHOD", QJsonValue() );
+}
+
+QByteArray SimExchange::getInjectedError( const quint8 engine_type, int &http_status )
+{
+    // half of the failures look like the proxy in front of the exchange, the rest are the exchange's own retryable errors
+    if ( rng.bounded( 2 ) == 0 )
+    {
+        http_status = 503;
+        return QByteArray( "<html><head><title>503 Service Temporarily Unavailable</title></head>"
+                           "<body><center><h1>503 Service Temporarily Unavailable</h1></center></body></html>" );
+    }
+
+    if ( engine_type == ENGINE_BINANCE )
+    {
+        http_status = 500;
+        return toJson( QJsonObject{ { "code", -1001 }, { "msg", "Internal error; unable to process your request. Please try again." } } );
+    }
+    else if ( engine_type == ENGINE_POLONIEX )
+    {
+        return toJson( QJsonObject{ { "error", "Internal error. Please try again." } } );
+    }
+
+    return toJson( QJsonObject{ { "success", false }, { "message", "" }, { "result", QJsonValue() } } );
+}
+
+void SimExchange::recordReaction( SimVenue &venue, const QString &market, const qint64 current_time )
+{
+    QHash<QString, qint64>::iterator i = venue.quote_change_times.find( market );
+
+    if ( i == venue.quote_change_times.end() )
+        return;
+
+    venue.reaction.record( ( current_time - i.value() ) * 1000 );
+    venue.quote_change_times.erase( i );
+}
+
+void SimExchange::onReplayTimer()
+{
+    const qint64 current_time = QDateTime::currentMSecsSinceEpoch();
+
+    replay_elapsed_ms += qint64( ( current_time - replay_last_tick_ms ) * replay_speed );
+    replay_last_tick_ms = current_time;
+
+    bool all_finished = !replay_markets.isEmpty();
+
+    for ( QVector<SimReplayMarket>::iterator i = replay_markets.begin(); i != replay_markets.end(); i++ )
+    {
+        SimReplayMarket &replay = *i;
+        const qint32 last_index = replay.samples.data.size() -1;
+        const qint32 index = qint32( qMin<qint64>( replay_elapsed_ms / ( replay.interval_secs * 1000 ), last_index ) );
+
+        if ( index < last_index )
+            all_finished = false;
+
+        if ( index == replay.index )
+            continue;
+
+        replay.index = index;
+        applyQuote( replay.market, replay.samples.data.at( index ), current_time );
+    }
+
+    if ( all_finished && !replay_finished )
+    {
+        replay_finished = true;
+        kDebug() << "[Sim] replay finished, holding the last prices";
+    }
+}
+
+void SimExchange::onReportTimer()
+{
+    quint64 requests = 0;
+    for ( QMap<quint8, SimVenue>::const_iterator i = venues.begin(); i != venues.end(); i++ )
+        requests += i.value().requests;
+
+    // stay quiet when idle
+    if ( requests == reported_requests )
+        return;
+
+    reported_requests = requests;
+
+    const QStringList report = getReport();
+
+    for ( QStringList::const_iterator i = report.begin(); i != report.end(); i++ )
+        kDebug() << *i;
+}
@@ -0,0 +1,153 @@
+#ifndef SIMEXCHANGE_H
+#define SIMEXCHANGE_H
+
+#include "simmatcher.h"
+#include "latencystats.h"
+#include "priceaggregator.h"
+
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QRandomGenerator>
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QMap>
+#include <QHash>
+#include <QUrl>
+#include <QUrlQuery>
+
+class QTimer;
+
+//
+// SimReply, canned reply that finishes after a simulated network delay
+//
+class SimReply : public QNetworkReply
+{
+    Q_OBJECT
+
+public:
+    explicit SimReply( const QNetworkAccessManager::Operation op, const QNetworkRequest &request, QObject *parent = nullptr );
+
+    void setResponse( const int http_status, const QByteArray &data );
+    void setHostNotFound();
+    void deliverIn( const qint32 delay_ms );
+
+    void abort() override;
+    qint64 bytesAvailable() const override;
+    bool isSequential() const override { return true; }
+
+public slots:
+    void deliver(); // finish now, the replay driver calls this directly
+
+protected:
+    qint64 readData( char *data, qint64 max_size ) override;
+
+private:
+    QByteArray content;
+    qint64 offset{ 0 };
+    bool is_delivered{ false };
+};
+
+struct SimReplayMarket
+{
+    QString market;
+    qint64 interval_secs{ 0 };
+    PriceData samples;
+    qint32 index{ -1 };
+};
+
+struct SimVenue
+{
+    QString name;
+    SimMatcher matcher;
+    QHash<QString, QString> markets_by_symbol; // exchange market string to universal market
+
+    quint64 requests{ 0 };
+    quint64 errors_injected{ 0 };
+    quint64 drops_injected{ 0 };
+
+    LatencyHistogram reaction; // first unanswered quote change to the next order or cancel on that market
+    QHash<QString, qint64> quote_change_times;
+};
+
+//
+// SimExchange, local exchange simulator for offline end-to-end runs (see EXCHANGE_SIM_ENABLED)
+//
+// it's a drop-in QNetworkAccessManager: requests to the Binance, Poloniex and Bittrex hosts are answered in-process
+// with the same json the exchange would send, anything else fails with host not found, so nothing leaves the box.
+// each exchange gets its own SimMatcher. quotes are replayed from price sample files recorded by the
+// PriceAggregator, and every reply is delayed by a configurable latency, with optional error and drop injection
+// from a seeded generator.
+//
+// settings are read from sim.settings in the trader path, one option per line:
+//   seed <n>
+//   latency <ms> [jitter_ms]
+//   errors <error_rate> [drop_rate]
+//   fees <maker> <taker>
+//   spread <ratio> (half of the replayed spread, as a ratio of price)
+//   speed <factor> (replay speed)
+//   balance <currency> <amount> (if no balances are set, funds are unlimited)
+//   market <market> <price_ticksize> <quantity_ticksize> (binance ticksizes, the others use satoshis)
+//   replay <market> <interval_secs> [samples_path]
+//
+class SimExchange : public QNetworkAccessManager
+{
+    Q_OBJECT
+
+public:
+    explicit SimExchange( QObject *parent = nullptr );
+    ~SimExchange();
+
+    static QString getSettingsPath();
+    bool loadSettings( const QString &path );
+
+    void addMarket( const QString &market, const Coin &price_ticksize = CoinAmount::SATOSHI, const Coin &quantity_ticksize = CoinAmount::SATOSHI );
+    void applyQuote( const QString &market, const Coin &price, const qint64 current_time );
+
+    SimMatcher &getMatcher( const quint8 engine_type ) { return venues[ engine_type ].matcher; }
+    QStringList getReport() const;
+
+    static QString getBittrexOrderId( const qint64 order_id );
+    static qint64 getOrderIdFromBittrex( const QString &uuid );
+
+protected:
+    QNetworkReply *createRequest( Operation op, const QNetworkRequest &request, QIODevice *outgoing_data = nullptr ) override;
+
+private slots:
+    void onReplayTimer();
+    void onReportTimer();
+
+private:
+    QByteArray replyBinance( SimVenue &venue, const QString &verb, const QString &command, const QUrlQuery &params, const qint64 current_time, int &http_status );
+    QByteArray replyPoloniex( SimVenue &venue, const QString &command, const QUrlQuery &params, const qint64 current_time, int &http_status );
+    QByteArray replyBittrex( SimVenue &venue, const QString &command, const QUrlQuery &params, const qint64 current_time, int &http_status );
+    QByteArray getInjectedError( const quint8 engine_type, int &http_status );
+
+    void recordReaction( SimVenue &venue, const QString &market, const qint64 current_time );
+
+    QMap<quint8, SimVenue> venues;
+    QHash<QString, quint8> engine_by_host;
+    QVector<SimReplayMarket> replay_markets;
+
+    QRandomGenerator rng;
+    qint32 latency_ms{ 50 };
+    qint32 latency_jitter_ms{ 20 };
+    qreal error_rate{ 0. };
+    qreal drop_rate{ 0. };
+    qreal replay_speed{ 1. };
+    Coin spread_ratio;
+    bool has_balances{ false };
+
+    QTimer *replay_timer{ nullptr };
+    QTimer *report_timer{ nullptr };
+    qint64 replay_elapsed_ms{ 0 };
+    qint64 replay_last_tick_ms{ 0 };
+    bool replay_finished{ false };
+
+    qint64 start_time{ 0 };
+    quint64 reported_requests{ 0 };
+};
+
+#endif // SIMEXCHANGE_H
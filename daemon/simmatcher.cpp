@@ -0,0 +1,360 @@
+#include "simmatcher.h"
+#include "market.h"
+#include "global.h"
+
+void SimMatcher::addMarket( const QString &market, const Coin &price_ticksize, const Coin &quantity_ticksize )
+{
+    SimBook &book = books[ market ];
+    book.price_ticksize = price_ticksize;
+    book.quantity_ticksize = quantity_ticksize;
+}
+
+void SimMatcher::setBalance( const QString &currency, const Coin &amount )
+{
+    balances[ currency ].available = amount;
+}
+
+qint32 SimMatcher::setQuote( const QString &market, const Coin &bid, const Coin &ask, const qint64 current_time )
+{
+    QMap<QString, SimBook>::iterator book_it = books.find( market );
+
+    if ( book_it == books.end() ||
+         bid.isZeroOrLess() ||
+         ask.isZeroOrLess() ||
+         bid >= ask )
+        return -1;
+
+    SimBook &book = book_it.value();
+    book.external = Spread( bid, ask );
+
+    qint32 filled_count = 0;
+
+    // the quote traded through our resting buys, fill them at their own price
+    while ( !book.bids.isEmpty() && book.bids.lastKey() >= ask )
+    {
+        const QVector<qint64> ids = book.bids.take( book.bids.lastKey() );
+
+        for ( QVector<qint64>::const_iterator i = ids.begin(); i != ids.end(); i++ )
+        {
+            SimOrder &order = orders[ *i ];
+            fill( order, order.price, order.getRemaining(), true );
+            close( order, current_time );
+            filled_count++;
+        }
+    }
+
+    // same for resting sells
+    while ( !book.asks.isEmpty() && book.asks.firstKey() <= bid )
+    {
+        const QVector<qint64> ids = book.asks.take( book.asks.firstKey() );
+
+        for ( QVector<qint64>::const_iterator i = ids.begin(); i != ids.end(); i++ )
+        {
+            SimOrder &order = orders[ *i ];
+            fill( order, order.price, order.getRemaining(), true );
+            close( order, current_time );
+            filled_count++;
+        }
+    }
+
+    return filled_count;
+}
+
+Spread SimMatcher::getSpread( const QString &market ) const
+{
+    QMap<QString, SimBook>::const_iterator book_it = books.find( market );
+
+    if ( book_it == books.end() )
+        return Spread();
+
+    const SimBook &book = book_it.value();
+    Spread ret = book.external;
+
+    if ( !book.bids.isEmpty() && ( ret.bid.isZeroOrLess() || book.bids.lastKey() > ret.bid ) )
+        ret.bid = book.bids.lastKey();
+
+    if ( !book.asks.isEmpty() && ( ret.ask.isZeroOrLess() || book.asks.firstKey() < ret.ask ) )
+        ret.ask = book.asks.firstKey();
+
+    return ret;
+}
+
+SimOrderResult SimMatcher::placeOrder( const QString &market, const quint8 side, const Coin &price, const Coin &quantity, const bool post_only, const qint64 current_time, qint64 &order_id )
+{
+    order_id = 0;
+
+    QMap<QString, SimBook>::iterator book_it = books.find( market );
+
+    if ( book_it == books.end() )
+    {
+        orders_rejected++;
+        return SimOrderUnknownMarket;
+    }
+
+    SimBook &book = book_it.value();
+
+    if ( ( side != SIDE_BUY && side != SIDE_SELL ) ||
+         price.isZeroOrLess() ||
+         quantity.isZeroOrLess() ||
+         !isOnTicksize( price, book.price_ticksize ) ||
+         !isOnTicksize( quantity, book.quantity_ticksize ) )
+    {
+        orders_rejected++;
+        return SimOrderBadParams;
+    }
+
+    const bool is_buy = side == SIDE_BUY;
+    QMap<Coin, QVector<qint64>> &opposite = is_buy ? book.asks : book.bids;
+
+    // does the price cross the other side of the book?
+    auto crosses = [&]( const Coin &other_price )
+    {
+        return is_buy ? other_price <= price : other_price >= price;
+    };
+
+    auto hasOwn = [&]()
+    {
+        return !opposite.isEmpty() && crosses( is_buy ? opposite.firstKey() : opposite.lastKey() );
+    };
+
+    auto hasExternal = [&]()
+    {
+        return book.external.isValid() && crosses( is_buy ? book.external.ask : book.external.bid );
+    };
+
+    if ( post_only && ( hasOwn() || hasExternal() ) )
+    {
+        orders_rejected++;
+        return SimOrderWouldTake;
+    }
+
+    SimOrder order;
+    order.market = market;
+    order.side = side;
+    order.price = price;
+    order.quantity = quantity;
+    order.time_created_ms = current_time;
+
+    if ( !reserve( order ) )
+    {
+        orders_rejected++;
+        return SimOrderInsufficientFunds;
+    }
+
+    order.id = next_order_id++;
+    orders.insert( order.id, order );
+    orders_placed++;
+
+    SimOrder &placed = orders[ order.id ];
+
+    // take liquidity, our resting orders were there before the external quote at the same price
+    while ( placed.getRemaining().isGreaterThanZero() )
+    {
+        const bool has_own = hasOwn();
+        const bool has_external = hasExternal();
+
+        if ( !has_own && !has_external )
+            break;
+
+        const Coin own_price = has_own ? ( is_buy ? opposite.firstKey() : opposite.lastKey() ) : Coin();
+        const Coin external_price = is_buy ? book.external.ask : book.external.bid;
+
+        if ( has_own && ( !has_external || ( is_buy ? own_price <= external_price : own_price >= external_price ) ) )
+        {
+            SimOrder &resting = orders[ opposite.value( own_price ).first() ];
+            const Coin fill_quantity = qMin( placed.getRemaining(), resting.getRemaining() );
+
+            fill( resting, own_price, fill_quantity, true );
+            fill( placed, own_price, fill_quantity, false );
+
+            if ( resting.getRemaining().isZeroOrLess() )
+            {
+                unrest( book, resting );
+                close( resting, current_time );
+            }
+        }
+        else
+        {
+            fill( placed, external_price, placed.getRemaining(), false );
+        }
+    }
+
+    if ( placed.getRemaining().isGreaterThanZero() )
+        rest( book, placed );
+    else
+        close( placed, current_time );
+
+    order_id = placed.id;
+    return SimOrderOk;
+}
+
+bool SimMatcher::cancelOrder( const qint64 order_id, const qint64 current_time )
+{
+    QMap<qint64, SimOrder>::iterator order_it = orders.find( order_id );
+
+    if ( order_it == orders.end() || !order_it.value().is_open )
+        return false;
+
+    SimOrder &order = order_it.value();
+    const Market market( order.market );
+    const Coin remaining = order.getRemaining();
+
+    // release the rest of the reservation
+    if ( order.side == SIDE_BUY )
+    {
+        SimBalance &balance = balances[ market.getBase() ];
+        balance.on_orders -= order.price * remaining;
+        balance.available += order.price * remaining;
+    }
+    else
+    {
+        SimBalance &balance = balances[ market.getQuote() ];
+        balance.on_orders -= remaining;
+        balance.available += remaining;
+    }
+
+    unrest( books[ order.market ], order );
+    order.is_cancelled = true;
+    close( order, current_time );
+    orders_cancelled++;
+
+    return true;
+}
+
+QVector<qint64> SimMatcher::cancelAll( const QString &market, const qint64 current_time )
+{
+    QVector<qint64> ids;
+
+    for ( QMap<qint64, SimOrder>::const_iterator i = orders.begin(); i != orders.end(); i++ )
+        if ( i.value().is_open && i.value().market == market )
+            ids += i.key();
+
+    for ( QVector<qint64>::const_iterator i = ids.begin(); i != ids.end(); i++ )
+        cancelOrder( *i, current_time );
+
+    return ids;
+}
+
+const SimOrder *SimMatcher::getOrder( const qint64 order_id ) const
+{
+    QMap<qint64, SimOrder>::const_iterator order_it = orders.find( order_id );
+    return order_it == orders.end() ? nullptr : &order_it.value();
+}
+
+QVector<const SimOrder*> SimMatcher::getOpenOrders() const
+{
+    QVector<const SimOrder*> ret;
+
+    for ( QMap<qint64, SimOrder>::const_iterator i = orders.begin(); i != orders.end(); i++ )
+        if ( i.value().is_open )
+            ret += &i.value();
+
+    return ret;
+}
+
+QVector<const SimOrder*> SimMatcher::getClosedOrders() const
+{
+    QVector<const SimOrder*> ret;
+    ret.reserve( closed_order_ids.size() );
+
+    for ( int i = closed_order_ids.size() -1; i >= 0; i-- )
+    {
+        const SimOrder *order = getOrder( closed_order_ids.at( i ) );
+
+        if ( order != nullptr )
+            ret += order;
+    }
+
+    return ret;
+}
+
+bool SimMatcher::isOnTicksize( const Coin &value, const Coin &ticksize )
+{
+    if ( ticksize.isZeroOrLess() )
+        return true;
+
+    Coin truncated = value;
+    truncated.truncateByTicksize( ticksize );
+
+    return truncated == value;
+}
+
+bool SimMatcher::reserve( const SimOrder &order )
+{
+    const Market market( order.market );
+    const bool is_buy = order.side == SIDE_BUY;
+    const Coin amount = is_buy ? order.price * order.quantity : order.quantity;
+
+    SimBalance &balance = balances[ is_buy ? market.getBase() : market.getQuote() ];
+
+    if ( !unlimited_funds && balance.available < amount )
+        return false;
+
+    balance.available -= amount;
+    balance.on_orders += amount;
+    return true;
+}
+
+void SimMatcher::fill( SimOrder &order, const Coin &fill_price, const Coin &fill_quantity, const bool is_maker )
+{
+    const Market market( order.market );
+    const Coin total = fill_price * fill_quantity;
+    const Coin commission = total * ( is_maker ? maker_fee : taker_fee );
+
+    SimBalance &base = balances[ market.getBase() ];
+    SimBalance &quote = balances[ market.getQuote() ];
+
+    if ( order.side == SIDE_BUY )
+    {
+        // funds were reserved at the limit price, refund any price improvement
+        const Coin reserved = order.price * fill_quantity;
+        base.on_orders -= reserved;
+        base.available += reserved - total - commission;
+        quote.available += fill_quantity;
+    }
+    else
+    {
+        quote.on_orders -= fill_quantity;
+        base.available += total - commission;
+    }
+
+    order.filled_quantity += fill_quantity;
+    order.filled_total += total;
+    order.commission += commission;
+
+    if ( is_maker )
+        fills_maker++;
+    else
+        fills_taker++;
+}
+
+void SimMatcher::rest( SimBook &book, const SimOrder &order )
+{
+    QMap<Coin, QVector<qint64>> &side = order.side == SIDE_BUY ? book.bids : book.asks;
+    side[ order.price ] += order.id;
+}
+
+void SimMatcher::unrest( SimBook &book, const SimOrder &order )
+{
+    QMap<Coin, QVector<qint64>> &side = order.side == SIDE_BUY ? book.bids : book.asks;
+    QMap<Coin, QVector<qint64>>::iterator level = side.find( order.price );
+
+    if ( level == side.end() )
+        return;
+
+    level.value().removeOne( order.id );
+
+    if ( level.value().isEmpty() )
+        side.erase( level );
+}
+
+void SimMatcher::close( SimOrder &order, const qint64 current_time )
+{
+    order.is_open = false;
+    order.time_closed_ms = current_time;
+    closed_order_ids.enqueue( order.id );
+
+    // forget the oldest closed orders
+    while ( closed_order_ids.size() > closed_orders_max )
+        orders.remove( closed_order_ids.dequeue() );
+}
@@ -0,0 +1,124 @@
+#ifndef SIMMATCHER_H
+#define SIMMATCHER_H
+
+#include "coinamount.h"
+#include "misctypes.h"
+
+#include <QString>
+#include <QVector>
+#include <QList>
+#include <QMap>
+#include <QQueue>
+
+struct SimOrder
+{
+    Coin getRemaining() const { return quantity - filled_quantity; }
+
+    qint64 id{ 0 };
+    QString market;
+    quint8 side{ 0 };
+    Coin price, quantity;
+    Coin filled_quantity, filled_total, commission; // filled_total is in the base (price) currency
+    bool is_open{ true };
+    bool is_cancelled{ false };
+    qint64 time_created_ms{ 0 };
+    qint64 time_closed_ms{ 0 };
+};
+
+struct SimBalance
+{
+    Coin available, on_orders;
+};
+
+enum SimOrderResult : quint8
+{
+    SimOrderOk = 0,
+    SimOrderWouldTake, // post-only order would have matched
+    SimOrderUnknownMarket,
+    SimOrderBadParams, // bad side, non-positive size or not on the ticksize
+    SimOrderInsufficientFunds
+};
+
+//
+// SimMatcher, deterministic matching engine for the local exchange simulator
+//
+// each market has a book of our own resting orders with price-time priority, plus an external top of book that
+// is replayed from recorded prices. the external quote has unlimited size, so an order that crosses it fills
+// completely at the quote price as taker, and a resting order fills at its own price as maker once the quote
+// moves through it. order ids are handed out sequentially, so the same inputs always produce the same outputs.
+//
+// funds are reserved at the limit price when an order is placed and settled on fill or cancel. fees are taken
+// from the base currency.
+//
+class SimMatcher
+{
+public:
+    explicit SimMatcher( const qint64 first_order_id = 1 ) : next_order_id( first_order_id ) {}
+
+    void addMarket( const QString &market, const Coin &price_ticksize, const Coin &quantity_ticksize );
+    bool hasMarket( const QString &market ) const { return books.contains( market ); }
+    QList<QString> getMarkets() const { return books.keys(); }
+    Coin getPriceTicksize( const QString &market ) const { return books.value( market ).price_ticksize; }
+    Coin getQuantityTicksize( const QString &market ) const { return books.value( market ).quantity_ticksize; }
+
+    void setFees( const Coin &maker, const Coin &taker ) { maker_fee = maker; taker_fee = taker; }
+    const Coin &getMakerFee() const { return maker_fee; }
+    const Coin &getTakerFee() const { return taker_fee; }
+
+    void setBalance( const QString &currency, const Coin &amount );
+    void setUnlimitedFunds( const bool unlimited ) { unlimited_funds = unlimited; }
+    const QMap<QString, SimBalance> &getBalances() const { return balances; }
+
+    // returns the number of resting orders that were filled, or -1 if the quote was rejected
+    qint32 setQuote( const QString &market, const Coin &bid, const Coin &ask, const qint64 current_time );
+    Spread getExternalSpread( const QString &market ) const { return books.value( market ).external; }
+    Spread getSpread( const QString &market ) const; // best of the external quote and our resting orders
+
+    SimOrderResult placeOrder( const QString &market, const quint8 side, const Coin &price, const Coin &quantity, const bool post_only, const qint64 current_time, qint64 &order_id );
+    bool cancelOrder( const qint64 order_id, const qint64 current_time );
+    QVector<qint64> cancelAll( const QString &market, const qint64 current_time );
+
+    const SimOrder *getOrder( const qint64 order_id ) const;
+    QVector<const SimOrder*> getOpenOrders() const; // oldest first
+    QVector<const SimOrder*> getClosedOrders() const; // newest first
+
+    quint64 getOrdersPlaced() const { return orders_placed; }
+    quint64 getOrdersRejected() const { return orders_rejected; }
+    quint64 getOrdersCancelled() const { return orders_cancelled; }
+    quint64 getMakerFills() const { return fills_maker; }
+    quint64 getTakerFills() const { return fills_taker; }
+
+    static const qint32 closed_orders_max = 10000;
+
+private:
+    struct SimBook
+    {
+        Spread external;
+        QMap<Coin, QVector<qint64>> bids, asks; // resting order ids at each price, in time order
+        Coin price_ticksize, quantity_ticksize;
+    };
+
+    static bool isOnTicksize( const Coin &value, const Coin &ticksize );
+    bool reserve( const SimOrder &order );
+    void fill( SimOrder &order, const Coin &fill_price, const Coin &fill_quantity, const bool is_maker );
+    void rest( SimBook &book, const SimOrder &order );
+    void unrest( SimBook &book, const SimOrder &order );
+    void close( SimOrder &order, const qint64 current_time );
+
+    QMap<QString, SimBook> books;
+    QMap<qint64, SimOrder> orders; // open and recently closed
+    QQueue<qint64> closed_order_ids;
+    QMap<QString, SimBalance> balances;
+
+    Coin maker_fee, taker_fee;
+    bool unlimited_funds{ false };
+    qint64 next_order_id{ 1 };
+
+    quint64 orders_placed{ 0 };
+    quint64 orders_rejected{ 0 };
+    quint64 orders_cancelled{ 0 };
+    quint64 fills_maker{ 0 };
+    quint64 fills_taker{ 0 };
+};
+
+#endif // SIMMATCHER_H
@@ -0,0 +1,134 @@
+#include "simmatcher_test.h"
+#include "simmatcher.h"
+#include "coinamount.h"
+#include "global.h"
+
+#include <assert.h>
+
+void SimMatcherTest::test()
+{
+    const QString market = "BTC_ETH";
+    const Coin price_ticksize = QString( "0.00001000" );
+    const Coin quantity_ticksize = QString( "0.01000000" );
+
+    SimMatcher matcher;
+    matcher.addMarket( market, price_ticksize, quantity_ticksize );
+    matcher.setFees( QString( "0.001" ), QString( "0.002" ) );
+    matcher.setBalance( "BTC", QString( "1.00000000" ) );
+    matcher.setBalance( "ETH", QString( "100.00000000" ) );
+
+    assert( matcher.hasMarket( market ) );
+    assert( !matcher.hasMarket( "BTC_XMR" ) );
+
+    /// test quote validation
+    assert( matcher.setQuote( market, QString( "0.03000000" ), QString( "0.02000000" ), 1000 ) == -1 );
+    assert( matcher.setQuote( "BTC_XMR", QString( "0.02000000" ), QString( "0.03000000" ), 1000 ) == -1 );
+    assert( matcher.setQuote( market, QString( "0.02000000" ), QString( "0.02010000" ), 1000 ) == 0 );
+
+    qint64 order_id = 0;
+
+    /// test parameter rejection
+    assert( matcher.placeOrder( "BTC_XMR", SIDE_BUY, QString( "0.01" ), QString( "1" ), false, 1000, order_id ) == SimOrderUnknownMarket );
+    assert( matcher.placeOrder( market, SIDE_BUY, QString( "0.019999999" ), QString( "1" ), false, 1000, order_id ) == SimOrderBadParams );
+    assert( matcher.placeOrder( market, SIDE_BUY, QString( "0.019" ), QString( "1.001" ), false, 1000, order_id ) == SimOrderBadParams );
+    assert( matcher.placeOrder( market, 0, QString( "0.019" ), QString( "1" ), false, 1000, order_id ) == SimOrderBadParams );
+    assert( order_id == 0 );
+
+    /// test post-only orders that would take are rejected without reserving funds
+    assert( matcher.placeOrder( market, SIDE_BUY, QString( "0.02010000" ), QString( "1" ), true, 1000, order_id ) == SimOrderWouldTake );
+    assert( matcher.placeOrder( market, SIDE_SELL, QString( "0.02000000" ), QString( "1" ), true, 1000, order_id ) == SimOrderWouldTake );
+    assert( matcher.getBalances().value( "BTC" ).available == QString( "1.00000000" ) );
+    assert( matcher.getOrdersRejected() == 6 );
+
+    /// test insufficient funds
+    assert( matcher.placeOrder( market, SIDE_BUY, QString( "0.01900000" ), QString( "100" ), false, 1000, order_id ) == SimOrderInsufficientFunds );
+    assert( matcher.placeOrder( market, SIDE_SELL, QString( "0.02100000" ), QString( "101" ), false, 1000, order_id ) == SimOrderInsufficientFunds );
+
+    /// test resting orders reserve funds and get sequential ids
+    qint64 buy_a = 0, buy_b = 0;
+    assert( matcher.placeOrder( market, SIDE_BUY, QString( "0.01900000" ), QString( "10" ), true, 1000, buy_a ) == SimOrderOk );
+    assert( matcher.placeOrder( market, SIDE_BUY, QString( "0.01900000" ), QString( "5" ), true, 1001, buy_b ) == SimOrderOk );
+    assert( buy_a == 1 && buy_b == 2 );
+    assert( matcher.getOpenOrders().size() == 2 );
+    assert( matcher.getOpenOrders().first()->id == buy_a );
+    assert( matcher.getBalances().value( "BTC" ).on_orders == QString( "0.28500000" ) );
+    assert( matcher.getBalances().value( "BTC" ).available == QString( "0.71500000" ) );
+
+    // our bid is behind the external bid
+    assert( matcher.getSpread( market ).bid == QString( "0.02000000" ) );
+
+    /// test a crossing sell takes our resting buys in time order before the external bid
+    qint64 sell = 0;
+    assert( matcher.placeOrder( market, SIDE_SELL, QString( "0.01900000" ), QString( "12" ), false, 1002, sell ) == SimOrderOk );
+
+    // the external bid is better, so the whole sell fills there as taker
+    const SimOrder *sell_order = matcher.getOrder( sell );
+    assert( sell_order != nullptr );
+    assert( !sell_order->is_open );
+    assert( sell_order->filled_quantity == QString( "12" ) );
+    assert( sell_order->filled_total == QString( "0.24000000" ) );
+    assert( sell_order->commission == QString( "0.00048000" ) );
+    assert( matcher.getTakerFills() == 1 );
+    assert( matcher.getOrder( buy_a )->filled_quantity.isZeroOrLess() );
+
+    // move the external bid under ours, now our buys are the best bid
+    assert( matcher.setQuote( market, QString( "0.01800000" ), QString( "0.01950000" ), 1003 ) == 0 );
+    assert( matcher.getSpread( market ).bid == QString( "0.01900000" ) );
+    assert( matcher.getSpread( market ).ask == QString( "0.01950000" ) );
+
+    assert( matcher.placeOrder( market, SIDE_SELL, QString( "0.01800000" ), QString( "12" ), false, 1004, sell ) == SimOrderOk );
+    sell_order = matcher.getOrder( sell );
+    assert( !sell_order->is_open );
+    assert( sell_order->filled_quantity == QString( "12" ) );
+    assert( sell_order->filled_total == QString( "0.22800000" ) ); // 12 @ 0.019 from our own orders
+    assert( !matcher.getOrder( buy_a )->is_open );
+    assert( matcher.getOrder( buy_a )->filled_quantity == QString( "10" ) );
+    assert( matcher.getOrder( buy_b )->is_open );
+    assert( matcher.getOrder( buy_b )->getRemaining() == QString( "3" ) );
+    assert( matcher.getMakerFills() == 2 );
+
+    /// test cancel releases the rest of the reservation
+    const Coin btc_before = matcher.getBalances().value( "BTC" ).available;
+    assert( matcher.cancelOrder( buy_b, 1005 ) );
+    assert( !matcher.cancelOrder( buy_b, 1005 ) );
+    assert( !matcher.cancelOrder( 999, 1005 ) );
+    assert( matcher.getOrder( buy_b )->is_cancelled );
+    assert( matcher.getBalances().value( "BTC" ).available == btc_before + QString( "0.05700000" ) );
+    assert( matcher.getBalances().value( "BTC" ).on_orders.isZeroOrLess() );
+    assert( matcher.getOrdersCancelled() == 1 );
+    assert( matcher.getClosedOrders().first()->id == buy_b );
+
+    /// test a resting sell fills as maker when the quote moves through it
+    qint64 rest_sell = 0;
+    assert( matcher.placeOrder( market, SIDE_SELL, QString( "0.02000000" ), QString( "2" ), true, 1006, rest_sell ) == SimOrderOk );
+    assert( matcher.getSpread( market ).ask == QString( "0.01950000" ) );
+    assert( matcher.setQuote( market, QString( "0.02050000" ), QString( "0.02060000" ), 1007 ) == 1 );
+    assert( !matcher.getOrder( rest_sell )->is_open );
+    assert( matcher.getOrder( rest_sell )->filled_total == QString( "0.04000000" ) );
+    assert( matcher.getOrder( rest_sell )->time_closed_ms == 1007 );
+
+    /// test a crossing buy fills at the external ask and refunds the price improvement
+    const Coin btc_before_buy = matcher.getBalances().value( "BTC" ).available;
+    qint64 buy = 0;
+    assert( matcher.placeOrder( market, SIDE_BUY, QString( "0.03000000" ), QString( "1" ), false, 1008, buy ) == SimOrderOk );
+    assert( matcher.getOrder( buy )->filled_total == QString( "0.02060000" ) );
+    assert( matcher.getBalances().value( "BTC" ).available == btc_before_buy - QString( "0.02060000" ) - QString( "0.00004120" ) );
+    assert( matcher.getBalances().value( "BTC" ).on_orders.isZeroOrLess() );
+
+    /// test cancel all
+    qint64 a = 0, b = 0;
+    assert( matcher.placeOrder( market, SIDE_BUY, QString( "0.01000000" ), QString( "1" ), true, 1009, a ) == SimOrderOk );
+    assert( matcher.placeOrder( market, SIDE_SELL, QString( "0.03000000" ), QString( "1" ), true, 1009, b ) == SimOrderOk );
+    assert( b == a +1 );
+    assert( matcher.cancelAll( market, 1010 ).size() == 2 );
+    assert( matcher.getOpenOrders().isEmpty() );
+    assert( matcher.cancelAll( market, 1010 ).isEmpty() );
+
+    /// test unlimited funds
+    SimMatcher unlimited( 100 );
+    unlimited.addMarket( market, CoinAmount::SATOSHI, CoinAmount::SATOSHI );
+    unlimited.setUnlimitedFunds( true );
+    assert( unlimited.placeOrder( market, SIDE_BUY, QString( "0.01" ), QString( "1000" ), false, 0, order_id ) == SimOrderOk );
+    assert( order_id == 100 );
+    assert( unlimited.getOpenOrders().size() == 1 );
+}
@@ -0,0 +1,9 @@
+#ifndef SIMMATCHER_TEST_H
+#define SIMMATCHER_TEST_H
+
+struct SimMatcherTest
+{
+    void test();
+};
+
+#endif // SIMMATCHER_TEST_H
@@ -7,6 +7,7 @@
 #include "market.h"
 #include "enginemap.h"
 #include "engine.h"
+#include "enginethread.h"
 #include "positionman.h"
 #include "priceaggregator.h"
 
@@ -61,19 +62,48 @@ void SpruceOverseer::onSpruceUp()
     if ( !spruce->isActive() )
         return;
 
-    // save midspread prices to set m_current_prices to after (so getBaseCapital uses midspread prices)
-    QMap<QString, Coin> midspread_prices;
-
     m_last_midspread_output.clear();
 
-    // cache mid spread for each market (needed for noflux phase optimization)
-    QMap<QString, Coin> spread_midprice;
-
     // cache markets. if we altered the market count, update markets
     const QVector<QString> alpha_markets = spruce->getMarketsAlpha();
     if ( m_phase_man.getMarketCount() < alpha_markets.size() )
         m_phase_man.setMarkets( alpha_markets );
 
+    /// build the state every phase shares once per tick, flux phases only move their own market from here
+    static const Coin UNDERCUT_BUY = Coin( "1.000001" );
+    static const Coin UNDERCUT_SELL = Coin( "0.999999" );
+
+    // cache mid spread for each market (needed for noflux phase optimization)
+    QMap<QString, Coin> spread_midprice;
+
+    // diffusion prices for each side by currency, undercut slightly *for markets with only one price source like BTC_USDN
+    QMap<QString, Coin> side_prices_buys, side_prices_sells;
+
+    for ( QVector<QString>::const_iterator i = alpha_markets.begin(); i != alpha_markets.end(); i++ )
+    {
+        const Market market = *i;
+        const QString currency = market.getQuote();
+
+        // check spread midprice
+        const Coin midprice = price_aggregator->getSpread( market ).getMidPrice();
+        if ( midprice.isZeroOrLess() )
+        {
+            kDebug() << "spruceoverseer error:" << market << "midprice" << midprice << "was invalid";
+            return;
+        }
+
+        spread_midprice[ market ] = midprice;
+        side_prices_buys[ currency ] = midprice * UNDERCUT_BUY;
+        side_prices_sells[ currency ] = midprice * UNDERCUT_SELL;
+    }
+
+    // base capital for each side's prices
+    spruce->clearCache();
+    spruce->setCurrentPrices( side_prices_buys );
+    const Coin base_capital_buys = spruce->getBaseCapital();
+    spruce->setCurrentPrices( side_prices_sells );
+    const Coin base_capital_sells = spruce->getBaseCapital();
+
     // go through each phase for each side for each market relevant to each phase
     for ( m_phase_man.begin(); !m_phase_man.atEnd(); m_phase_man.next() )
     {
@@ -99,51 +129,33 @@ void SpruceOverseer::onSpruceUp()
             }
         }
 
-        spruce->clearCurrentPrices();
-//        kDebug() << "alpha markets" << alpha_markets;
-        for ( QVector<QString>::const_iterator i = alpha_markets.begin(); i != alpha_markets.end(); i++ )
-        {
-            const Market market = *i;
-            const QString currency = market.getQuote();
+        // start from the shared prices and base capital for this side
+        const QMap<QString, Coin> &side_prices = ( side == SIDE_BUY ) ? side_prices_buys : side_prices_sells;
+        Coin base_capital = ( side == SIDE_BUY ) ? base_capital_buys : base_capital_sells;
+        spruce->setCurrentPrices( side == SIDE_BUY ? side_prices_buys : side_prices_sells );
 
-            // check spread midprice
-            const Coin midprice = price_aggregator->getSpread( market ).getMidPrice();
-            if ( midprice.isZeroOrLess() )
-            {
-                kDebug() << "spruceoverseer error:" << market << "midprice" << midprice << "was invalid for phase" << phase_name;
-                return;
-            }
+        // for flux phases, apply the flux market delta
+        if ( !is_midspread_phase && spread_midprice.contains( flux_market ) )
+        {
+            const QString flux_currency = Market( flux_market ).getQuote();
+            const Coin &midprice = spread_midprice[ flux_market ];
 
-            spread_midprice[ market ] = midprice;
+            // set the most optimistic price to use, either the midprice or duplicity price
+            const Coin diffusion_price = ( side == SIDE_BUY ) ? std::min( midprice, spread_duplicity.bid ) :
+                                                                std::max( midprice, spread_duplicity.ask );
 
-            // for noflux phase, if market matches selected market, select best price from duplicity price or mid price
-            Coin diffusion_price;
-            if ( !is_midspread_phase && market == flux_market )
-            {
-                // set the most optimistic price to use, either the midprice or duplicity price
-                diffusion_price = ( side == SIDE_BUY ) ? std::min( midprice, spread_duplicity.bid ) :
-                                                         std::max( midprice, spread_duplicity.ask );
-            }
-            else
+            // base capital is a sum of qty * price, swap out this currency's term (zero means a price was invalid)
+            if ( base_capital.isGreaterThanZero() )
             {
-                diffusion_price = midprice;
-
-                // undercut slightly *for markets with only one price source like BTC_USDN
-                if ( side == SIDE_SELL )
-                    diffusion_price *= Coin( "0.999999" );
-                else if ( side == SIDE_BUY )
-                    diffusion_price *= Coin( "1.000001" );
+                const Coin flux_qty = spruce->getCurrentQtyMap().value( flux_currency );
+                base_capital = base_capital - flux_qty * side_prices.value( flux_currency ) + flux_qty * diffusion_price;
             }
 
-            spruce->setCurrentPrice( currency, diffusion_price );
+            spruce->setCurrentPrice( flux_currency, diffusion_price );
         }
 
-        // after we set the prices, build cache for base capital and other things for each phase
-        spruce->buildCache();
-
-        // copy prices to set back at the end of this function
-        if ( is_midspread_phase )
-            midspread_prices = spruce->getCurrentPrices();
+        // after we set the prices, cache base capital for this phase
+        spruce->setBaseCapitalCache( base_capital );
 
         // on the sell side of the midspread phase, the result is the same as the buy side, so skip it
         if ( !( side == SIDE_SELL && is_midspread_phase ) )
@@ -163,6 +175,10 @@ void SpruceOverseer::onSpruceUp()
         {
             Engine *engine = e.value();
 
+            // with engine threads, park only this engine while we go through its markets for this phase. it's read from
+            // here, and changed on its own thread, the other engines keep running
+            EngineParkLock engine_lock( engine );
+
             // if the exchange doesn't have a key set, don't make order requests
             if ( engine->getRestBase()->isKeyOrSecretUnset() )
                 continue;
@@ -231,7 +247,12 @@ void SpruceOverseer::onSpruceUp()
                 // run cancellors for this phase every iteration
                 const Coin cancel_thresh_price = ( is_midspread_phase ) ? Coin() :
                                                  ( side == SIDE_BUY ) ? buy_price : sell_price;
-                runCancellors( engine, market, side, phase_name, cancel_thresh_price );
+                // the limits read the aggregator, work them out here only if this phase has set anything
+                if ( engine->positions->findStrategyId( phase_name ) >= 0 )
+                {
+                    const Spread cancellor_limits = getCancellorLimits( market, is_midspread_phase );
+                    engine->runOnEngineThread( [&]() { runCancellors( engine, market, side, phase_name, cancel_thresh_price, cancellor_limits ); } );
+                }
 
                 const Coin qty_to_shortlong = quantity * market_alloc_ratio;
                 const bool is_buy = qty_to_shortlong.isZeroOrLess();
@@ -275,43 +296,21 @@ void SpruceOverseer::onSpruceUp()
                 const Coin qty_to_shortlong_effective = is_buy ? amount_to_shortlong_effective / current_market_price :
                                                                  std::min( amount_to_shortlong_effective / current_market_price, spruce->getCurrentQty( market.getQuote() ) ); // if we're selling, clamp effective sell amount to how much we actually have
 
-                // measure how close amount_to_sl is to hitting the limit, also prevent div0 if the limit is 0
-                const Coin pct_progress = ( order_size_limit.isZero() ) ? Coin() : amount_to_shortlong_abs / order_size_limit.abs() * 100;
-
                 // check amount active
                 const Coin spruce_active_for_side = engine->positions->getActiveSpruceEquityTotal( market, phase_name, side, Coin() );
 
-                // cache snapback states to print which side is active
-                const bool is_snapback_buys_enabled = spruce->getSnapbackState( market, SIDE_BUY );
-                const bool is_snapback_sells_enabled = spruce->getSnapbackState( market, SIDE_SELL );
-
-                QString message_out = QString( "%1 %2 %3 | q %4 | a %5/%6 (%7%) | act %8" )
-                        // print the market name in the color of the position to be taken
-                        .arg( QString( "%1%2%3" ).arg( amount_to_shortlong.isGreaterThanZero() ? COLOR_RED : COLOR_GREEN )
-                                                 .arg( market, -MARKET_STRING_WIDTH )
-                                                 .arg( COLOR_NONE ) )
-                        // if flux phase, print nothing. if midstate, print spaces if snapback disabled,
-                        // if snapback is enabled, print "snap" with the color of the side with snapback active
-                        .arg( !is_midspread_phase ? QString( "    " ) :
-                              QString( "%1%2%3" ).arg( is_snapback_buys_enabled  ? COLOR_GREEN :
-                                                       is_snapback_sells_enabled ? COLOR_RED :
-                                                                                   COLOR_NONE )
-                                                 .arg( is_snapback_buys_enabled || is_snapback_sells_enabled ? "snap" : "    " )
-                                                 .arg( COLOR_NONE ) )
-                        .arg( side == SIDE_BUY ? buy_price : sell_price )
-                        .arg( Coin( qty_to_shortlong_effective ).toString( 4 ), 12 ) // note: two toString() to workaround a nit display bug
-                        .arg( Coin( amount_to_shortlong.toString( 4 ) ).toString( 4 ), 9 ) // print amount to s/l
-                        .arg( ( is_buy ? -order_size_limit : order_size_limit ).toString( 4 ), -13 ) // print amount to s/l less the nice buffer (the actionable amount)
-                        .arg( pct_progress.toString( 1 ), 7 )
-                        .arg( spruce_active_for_side.toString( 4 ), 8 );
+                // keep the status line inputs, the prices below are adjusted in place
+                const Coin status_price = ( side == SIDE_BUY ) ? buy_price : sell_price;
+                const Coin order_size_limit_signed = is_buy ? -order_size_limit : order_size_limit;
 
+                // the midspread status is kept for the status command, otherwise only format it if we'll print it
+                QString status_line;
                 if ( is_midspread_phase )
-                    m_last_midspread_output += message_out + "\n";
-
-                // prepend phase name for debug output
-                message_out = QString( "%1 %2" )
-                               .arg( phase_name, -MARKET_STRING_WIDTH - 9 )
-                               .arg( message_out );
+                {
+                    status_line = getPhaseStatusLine( market, is_midspread_phase, status_price, amount_to_shortlong,
+                                                      qty_to_shortlong_effective, order_size_limit_signed, spruce_active_for_side );
+                    m_last_midspread_output += status_line + "\n";
+                }
 
                 const bool snapback_state = spruce->getSnapbackState( market, side );
 
@@ -326,7 +325,7 @@ void SpruceOverseer::onSpruceUp()
                     spruce->setSnapbackState( market, side, false, buy_price );
 
                     // cancel orders related to this strategy that are now stale
-                    engine->getPositionMan()->cancelStrategy( phase_name );
+                    engine->runOnEngineThread( [&]() { engine->getPositionMan()->cancelStrategy( phase_name ); } );
                 }
 
                 const bool under_the_limit = amount_to_shortlong_abs < order_size_limit;
@@ -397,7 +396,7 @@ void SpruceOverseer::onSpruceUp()
                         if ( (  is_buy && buy_price >= pos->sell_price * spread_distance_limit ) ||
                              ( !is_buy && sell_price * spread_distance_limit <= pos->buy_price ) )
                         {
-                            engine->positions->cancel( pos, false, CANCELLING_FOR_SPRUCE_CONFLICT );
+                            engine->runOnEngineThread( [&]() { engine->positions->cancel( pos, false, CANCELLING_FOR_SPRUCE_CONFLICT ); } );
                         }
                     }
                 }
@@ -422,13 +421,19 @@ void SpruceOverseer::onSpruceUp()
                 if ( spruce_active_for_side + order_size > amount_to_shortlong_abs - order_size_limit )
                     continue;
 
-                if ( is_midspread_phase )
-                    kDebug() << message_out;
-                // append minimum spread distance to message (there is no distance for the midspread phase)
-                else // ( !is_midspread_phase )
+                if ( engine->getVerbosity() > 0 )
                 {
-                    message_out += QString( " | dst %1" )
-                                    .arg( spread_distance_limit.toString( 4 ) );
+                    // prepend phase name for debug output
+                    QString message_out = QString( "%1 %2" )
+                                           .arg( phase_name, -MARKET_STRING_WIDTH - 9 )
+                                           .arg( is_midspread_phase ? status_line :
+                                                 getPhaseStatusLine( market, is_midspread_phase, status_price, amount_to_shortlong,
+                                                                     qty_to_shortlong_effective, order_size_limit_signed, spruce_active_for_side ) );
+
+                    // append minimum spread distance to message (there is no distance for the midspread phase)
+                    if ( !is_midspread_phase )
+                        message_out += QString( " | dst %1" )
+                                        .arg( spread_distance_limit.toString( 4 ) );
 
                     kDebug() << message_out;
                 }
@@ -441,8 +446,11 @@ void SpruceOverseer::onSpruceUp()
 
                 // queue the order if we aren't paper trading
 #if !defined(PAPER_TRADE)
-                engine->addPosition( market, is_buy ? SIDE_BUY : SIDE_SELL, buy_price, sell_price, order_size,
-                                     order_type, phase_name, QVector<qint32>(), false, true );
+                engine->runOnEngineThread( [&]()
+                {
+                    engine->addPosition( market, is_buy ? SIDE_BUY : SIDE_SELL, buy_price, sell_price, order_size,
+                                         order_type, phase_name, QVector<qint32>(), false, true );
+                } );
 #endif
             }
         }
@@ -451,8 +459,8 @@ void SpruceOverseer::onSpruceUp()
         spruce->clearCache();
     }
 
-    // set spruce prices to midspread so getBaseCapital is consistent with the spread
-    spruce->setCurrentPrices( midspread_prices );
+    // set spruce prices to midspread so getBaseCapital is consistent with the spread (the last midspread phase is the sell side)
+    spruce->setCurrentPrices( side_prices_sells );
 }
 
 void SpruceOverseer::adjustSpread( Spread &spread, Coin limit, quint8 side, Coin &minimum_ticksize, bool expand )
@@ -619,12 +627,46 @@ Spread SpruceOverseer::getSpreadForSide( const QString &market, quint8 side, boo
     return ret;
 }
 
+QString SpruceOverseer::getPhaseStatusLine( const Market &market, const bool is_midspread_phase, const Coin &price, const Coin &amount_to_shortlong,
+                                            const Coin &qty_to_shortlong_effective, const Coin &order_size_limit_signed, const Coin &spruce_active_for_side ) const
+{
+    // measure how close amount_to_sl is to hitting the limit, also prevent div0 if the limit is 0
+    const Coin pct_progress = ( order_size_limit_signed.isZero() ) ? Coin() : amount_to_shortlong.abs() / order_size_limit_signed.abs() * 100;
+
+    // cache snapback states to print which side is active
+    const bool is_snapback_buys_enabled = is_midspread_phase && spruce->getSnapbackState( market, SIDE_BUY );
+    const bool is_snapback_sells_enabled = is_midspread_phase && spruce->getSnapbackState( market, SIDE_SELL );
+
+    return QString( "%1 %2 %3 | q %4 | a %5/%6 (%7%) | act %8" )
+            // print the market name in the color of the position to be taken
+            .arg( QString( "%1%2%3" ).arg( amount_to_shortlong.isGreaterThanZero() ? COLOR_RED : COLOR_GREEN )
+                                     .arg( market, -MARKET_STRING_WIDTH )
+                                     .arg( COLOR_NONE ) )
+            // if flux phase, print nothing. if midstate, print spaces if snapback disabled,
+            // if snapback is enabled, print "snap" with the color of the side with snapback active
+            .arg( !is_midspread_phase ? QString( "    " ) :
+                  QString( "%1%2%3" ).arg( is_snapback_buys_enabled  ? COLOR_GREEN :
+                                           is_snapback_sells_enabled ? COLOR_RED :
+                                                                       COLOR_NONE )
+                                     .arg( is_snapback_buys_enabled || is_snapback_sells_enabled ? "snap" : "    " )
+                                     .arg( COLOR_NONE ) )
+            .arg( price )
+            .arg( Coin( qty_to_shortlong_effective ).toString( 4 ), 12 ) // note: two toString() to workaround a nit display bug
+            .arg( Coin( amount_to_shortlong.toString( 4 ) ).toString( 4 ), 9 ) // print amount to s/l
+            .arg( order_size_limit_signed.toString( 4 ), -13 ) // print amount to s/l less the nice buffer (the actionable amount)
+            .arg( pct_progress.toString( 1 ), 7 )
+            .arg( spruce_active_for_side.toString( 4 ), 8 );
+}
+
 Coin SpruceOverseer::getPriceTicksizeForMarket( const Market &market ) const
 {
     for ( QMap<quint8, Engine*>::const_iterator i = engine_map->begin(); i != engine_map->end(); i++ )
     {
         Engine *engine = i.value();
 
+        // park each engine only while we read its ticksize
+        EngineParkLock engine_lock( engine );
+
         // ensure ticker exists
         if ( !engine->market_info.contains( market ) )
             continue;
@@ -771,102 +813,105 @@ void SpruceOverseer::onBackupAndSave()
     kDebug() << "info: settings and stats have been backed up and saved";
 }
 
-void SpruceOverseer::runCancellors( Engine *engine, const QString &market, const quint8 side, const QString &phase_name, const Coin &flux_price )
+Spread SpruceOverseer::getCancellorLimits( const QString &market, const bool is_midspread_phase )
 {
-    const bool is_midspread_phase = phase_name.contains( "noflux" );
+    // get possible spread price vibration limits for new spruce order on this side
+    if ( is_midspread_phase )
+    {
+        const Coin midspread_price = price_aggregator->getSpread( market ).getMidPrice();
+        return Spread( midspread_price * Coin("0.99"), midspread_price * Coin("1.01") );
+    }
 
-    // sort active positions by longest active first, shortest active last
-    const QVector<Position*> active_by_set_time = engine->positions->activeBySetTime();
+    const Spread spread_limit = getSpreadLimit( market, true );
+    return Spread( spread_limit.bid * Coin("0.99"), spread_limit.ask * Coin("1.01") );
+}
 
-    // look for spruce positions we should cancel on this side
-    const QVector<Position*>::const_iterator begin = active_by_set_time.begin(),
-                                             end = active_by_set_time.end();
-    for ( QVector<Position*>::const_iterator j = begin; j != end; j++ )
-    {
-        Position *const &pos = *j;
-        bool is_inverse = false;
-
-        // don't skip inverse markets matching this side (the inverse side)
-        if (  pos->side != side &&
-             !pos->is_cancelling &&
-              pos->strategy_tag == phase_name &&
-              pos->market.getInverse() == market )
-        {
-            //kDebug() << "found inverse market for cancellor for pos" << pos->stringifyOrder();
-            is_inverse = true;
-        }
-        // skip non-qualifying position
-        else if ( pos->side != side ||
-                  pos->is_cancelling ||
-                  pos->market != market ||
-                  pos->strategy_tag != phase_name )
-        {
-            continue;
-        }
+void SpruceOverseer::runCancellors( Engine *engine, const QString &market, const quint8 side, const QString &phase_name, const Coin &flux_price,
+                                    const Spread &price_limits )
+{
+    const qint32 strategy_id = engine->positions->findStrategyId( phase_name );
 
-        // get possible spread price vibration limits for new spruce order on this side
-        const Spread spread_limit = getSpreadLimit( market, true );
+    // no position has been set for this phase yet
+    if ( strategy_id < 0 )
+        return;
 
-        // set sp1 price
-        Coin buy_price_limit, sell_price_limit;
-        if ( is_midspread_phase )
-        {
-            const Coin midspread_price = price_aggregator->getSpread( market ).getMidPrice();
-            buy_price_limit = midspread_price * Coin("0.99");
-            sell_price_limit = midspread_price * Coin("1.01");
-        }
-        else
-        {
-            buy_price_limit = spread_limit.bid * Coin("0.99");
-            sell_price_limit = spread_limit.ask * Coin("1.01");
-        }
+    // look for spruce positions we should cancel on this side, and on the inverse side of the inverse market
+    const QVector<Position*> positions = engine->positions->activeByStrategy( strategy_id, market, side );
+    const QVector<Position*> inverse_positions = engine->positions->activeByStrategy( strategy_id, Market( market ).getInverse(),
+                                                                                      ( side == SIDE_BUY ) ? SIDE_SELL : SIDE_BUY );
 
-        // cache actual side/price
+    if ( positions.isEmpty() && inverse_positions.isEmpty() )
+        return;
+
+    // the spread price vibration limits for new spruce orders on this side
+    const Coin &buy_price_limit = price_limits.bid;
+    const Coin &sell_price_limit = price_limits.ask;
+
+    const bool is_ticker_valid = buy_price_limit.isGreaterThanZero() && sell_price_limit.isGreaterThanZero();
+    const Coin flux_price_inverse = flux_price.isGreaterThanZero() ? CoinAmount::COIN / flux_price : Coin();
+
+    for ( int pass = 0; pass < 2; pass++ )
+    {
+        const bool is_inverse = pass == 1;
+        const QVector<Position*> &candidates = is_inverse ? inverse_positions : positions;
+
+        // cache actual side/flux price
         const quint8 side_actual = is_inverse ? ( ( side == SIDE_BUY ) ? SIDE_SELL : SIDE_BUY ) : side;
-        const Coin price_actual = is_inverse ? ( CoinAmount::COIN / pos->price ) : pos->price;
+        const Coin &flux_price_actual = is_inverse ? flux_price_inverse : flux_price;
 
-        /// cancellor 1: look for prices that are trailing the spread too far
-        if ( buy_price_limit.isGreaterThanZero() && sell_price_limit.isGreaterThanZero() && // ticker is valid
-             ( ( side_actual == SIDE_BUY  && price_actual < buy_price_limit ) ||
-               ( side_actual == SIDE_SELL && price_actual > sell_price_limit ) ) )
+        // newest first
+        for ( int j = candidates.size() -1; j >= 0; j-- )
         {
-            engine->positions->cancel( pos, false, CANCELLING_FOR_SPRUCE_PRICE_BOUNDS );
-            continue;
-        }
+            Position *const &pos = candidates.at( j );
 
-        // skip orders outside flux price
-        if ( flux_price.isGreaterThanZero() )
-        {
-            const Coin flux_price_actual = is_inverse ? ( CoinAmount::COIN / flux_price ) : flux_price;
+            // skip positions we are already cancelling
+            if ( pos->is_cancelling )
+                continue;
 
-            // for cancellor 2, only try to cancel positions within the flux bounds
-            if ( ( side_actual == SIDE_BUY  && price_actual < flux_price_actual ) ||
-                 ( side_actual == SIDE_SELL && price_actual > flux_price_actual ) )
+            // cache actual price
+            const Coin price_actual = is_inverse ? ( CoinAmount::COIN / pos->price ) : pos->price;
+
+            /// cancellor 1: look for prices that are trailing the spread too far
+            if ( is_ticker_valid &&
+                 ( ( side_actual == SIDE_BUY  && price_actual < buy_price_limit ) ||
+                   ( side_actual == SIDE_SELL && price_actual > sell_price_limit ) ) )
+            {
+                engine->positions->cancel( pos, false, CANCELLING_FOR_SPRUCE_PRICE_BOUNDS );
                 continue;
-        }
+            }
 
-        // note: skipped sp2 for now
-//        const QString exchange_market_key = QString( "%1-%2" )
-//                                            .arg( engine->engine_type )
-//                                            .arg( market );
-
-//        // get market allocation
-//        const QString &currency = Market( market ).getQuote();
-//        const Coin active_amount = engine->positions->getActiveSpruceEquityTotal( market, phase_name, side_actual, flux_price );
-//        const Coin amount_to_shortlong = spruce->getExchangeAllocation( exchange_market_key, is_midspread_phase ) * spruce->getCurrentPrice( currency ) * spruce->getQuantityToShortLongByCurrency( currency );
-
-//        // get active tolerance
-//        const Coin nice_zero_bound = spruce->getOrderNiceZeroBound( currency, side_actual, is_midspread_phase );
-//        const Coin zero_bound_tolerance = spruce->getOrderSize() * nice_zero_bound;
-
-//        /// cancellor 2: look for active amount > amount_to_shortlong + order_size_limit
-//        if ( ( side_actual == SIDE_BUY  && amount_to_shortlong.isZeroOrLess() &&
-//               active_amount - zero_bound_tolerance > amount_to_shortlong.abs() ) ||
-//             ( side_actual == SIDE_SELL && amount_to_shortlong.isGreaterThanZero() &&
-//               active_amount - zero_bound_tolerance > amount_to_shortlong.abs() ) )
-//        {
-//            engine->positions->cancel( pos, false, CANCELLING_FOR_SPRUCE_2 );
-//            continue;
-//        }
+            // skip orders outside flux price
+            if ( flux_price.isGreaterThanZero() )
+            {
+                // for cancellor 2, only try to cancel positions within the flux bounds
+                if ( ( side_actual == SIDE_BUY  && price_actual < flux_price_actual ) ||
+                     ( side_actual == SIDE_SELL && price_actual > flux_price_actual ) )
+                    continue;
+            }
+
+            // note: skipped sp2 for now
+//            const QString exchange_market_key = QString( "%1-%2" )
+//                                                .arg( engine->engine_type )
+//                                                .arg( market );
+
+//            // get market allocation
+//            const QString &currency = Market( market ).getQuote();
+//            const Coin active_amount = engine->positions->getActiveSpruceEquityTotal( market, phase_name, side_actual, flux_price );
+//            const Coin amount_to_shortlong = spruce->getExchangeAllocation( exchange_market_key, is_midspread_phase ) * spruce->getCurrentPrice( currency ) * spruce->getQuantityToShortLongByCurrency( currency );
+
+//            // get active tolerance
+//            const Coin nice_zero_bound = spruce->getOrderNiceZeroBound( currency, side_actual, is_midspread_phase );
+//            const Coin zero_bound_tolerance = spruce->getOrderSize() * nice_zero_bound;
+
+//            /// cancellor 2: look for active amount > amount_to_shortlong + order_size_limit
+//            if ( ( side_actual == SIDE_BUY  && amount_to_shortlong.isZeroOrLess() &&
+//                   active_amount - zero_bound_tolerance > amount_to_shortlong.abs() ) ||
+//                 ( side_actual == SIDE_SELL && amount_to_shortlong.isGreaterThanZero() &&
+//                   active_amount - zero_bound_tolerance > amount_to_shortlong.abs() ) )
+//            {
+//                engine->positions->cancel( pos, false, CANCELLING_FOR_SPRUCE_2 );
+//                continue;
+//            }
+        }
     }
 }
@@ -53,13 +53,17 @@ public Q_SLOTS:
     void onBackupAndSave();
 
 private:
-    void runCancellors( Engine *engine, const QString &market, const quint8 side, const QString &strategy, const Coin &flux_price );
+    Spread getCancellorLimits( const QString &market, const bool is_midspread_phase ); // reads the aggregator, call it here
+    void runCancellors( Engine *engine, const QString &market, const quint8 side, const QString &strategy, const Coin &flux_price,
+                        const Spread &price_limits ); // only touches the engine, runs on its thread
 
     void adjustSpread( Spread &spread, Coin limit, quint8 side, Coin &default_ticksize, bool expand = true );
     void adjustTicksizeToSpread( Coin &ticksize, Spread &spread, const Coin &ticksize_minimum );
     Spread getSpreadLimit( const QString &market, bool order_duplicity = false );
     Spread getSpreadForSide( const QString &market, quint8 side, bool order_duplicity = false, bool taker_mode = false, bool include_greed_random = false, bool is_randomized = false, Coin greed_reduce = Coin() );
     Coin getPriceTicksizeForMarket( const Market &market ) const;
+    QString getPhaseStatusLine( const Market &market, const bool is_midspread_phase, const Coin &price, const Coin &amount_to_shortlong,
+                                const Coin &qty_to_shortlong_effective, const Coin &order_size_limit_signed, const Coin &spruce_active_for_side ) const;
 
     QMap<QString,Coin> m_last_spread_distance_buys;
     QMap<QString,Coin> m_last_spread_distance_sells;
@@ -2,6 +2,7 @@
 #include "engine.h"
 #include "sprucev2.h"
 #include "spruceoverseer.h"
+#include "priceaggregator.h"
 
 //#include <QDebug>
 
@@ -9,15 +10,25 @@ void SpruceOverseerTest::test( SpruceOverseer *o, Engine *engine )
 {
     const QString TEST_MARKET = "TEST_1";
 
-    /// imitate ticker
-    engine->market_info[ TEST_MARKET ].spread.bid = "0.00010000";
-    engine->market_info[ TEST_MARKET ].spread.ask = "0.00010100";
+    /// imitate ticker, the engine pushes it to the price aggregator
+    QMap<QString, Spread> ticker;
+    ticker.insert( TEST_MARKET, Spread( Coin( "0.00010000" ), Coin( "0.00010100" ) ) );
+    engine->processTicker( engine->getRestBase(), ticker );
 
     // update ticker update time
     for ( quint8 type = 0; type < 4; type++ )
         if ( engine->rest_arr.value( type ) != nullptr )
             engine->rest_arr.value( type )->ticker_update_time = QDateTime::currentMSecsSinceEpoch();
 
+    /// ensure the aggregated spread came from this exchange
+    assert( o->price_aggregator->getSpread( TEST_MARKET ).bid == engine->market_info[ TEST_MARKET ].spread.bid );
+    assert( o->price_aggregator->getSpread( TEST_MARKET ).ask == engine->market_info[ TEST_MARKET ].spread.ask );
+
+    const AggregatedSpread *aggregated = o->price_aggregator->getAggregatedSpread( TEST_MARKET );
+    assert( aggregated != nullptr );
+    assert( aggregated->best_bid_exchange == engine->engine_type &&
+            aggregated->best_ask_exchange == engine->engine_type );
+
     /// ensure that getSpreadLimit() ratio == regular spread ratio
     // override some settings
     const Coin order_random_buy = o->spruce->getOrderRandomBuy();
@@ -113,8 +124,55 @@ void SpruceOverseerTest::test( SpruceOverseer *o, Engine *engine )
     // clear TEST_1 from alpha markets
     o->spruce->clear();
 
+    /// test calculateAmountToShortLong() on a fresh spruce
+    SpruceV2 spruce;
+    spruce.setBaseCurrency( "BTC" );
+    spruce.setCurrencyLongtermSignal( "USDN", Coin( "0.0001" ) );
+    spruce.setCurrencyLongtermSignal( "WAVES", Coin( "0.0002" ) );
+    spruce.setCurrencyFavorability( "BTC", CoinAmount::COIN );
+    spruce.setCurrencyFavorability( "WAVES", CoinAmount::COIN );
+    spruce.setCurrentPrice( "USDN", Coin( "0.0001" ) );
+    spruce.setCurrentPrice( "WAVES", Coin( "0.0001" ) );
+    spruce.setCurrentQty( "BTC", CoinAmount::COIN );
+    spruce.setCurrentQty( "WAVES", Coin( "10000" ) );
+    spruce.setCurrentQty( "USDN", Coin() );
+
+    // WAVES is rated 2x the dollar (rated as BTC), so it gets 2/3 of the 2 BTC of capital
+    assert( spruce.calculateAmountToShortLong( true ) );
+    assert( spruce.getQuantityToShortLongMap().size() == 2 );
+    assert( spruce.getQuantityToShortLongByCurrency( "BTC_USDN" ).isZero() );
+    assert( spruce.getQuantityToShortLongByCurrency( "BTC_WAVES" ) < Coin( "-3333.33" ) &&
+            spruce.getQuantityToShortLongByCurrency( "BTC_WAVES" ) > Coin( "-3333.34" ) );
+    assert( spruce.getTargetAmounts().size() == 3 );
+
+    // with the rating squared, WAVES gets 4/5, and the map is updated in place
+    spruce.setAllocPower( 2 );
+    assert( spruce.calculateAmountToShortLong() );
+    assert( spruce.getQuantityToShortLongMap().size() == 2 );
+    assert( spruce.getQuantityToShortLongByCurrency( "BTC_WAVES" ) == Coin( "-6000" ) );
+
+    // a new currency changes the layout, without a price it isn't rated and gets no target
+    spruce.setCurrencyLongtermSignal( "DOGE", Coin( "0.0001" ) );
+    assert( spruce.calculateAmountToShortLong() );
+    assert( spruce.getQuantityToShortLongMap().size() == 2 );
+
+    spruce.setCurrencyFavorability( "DOGE", CoinAmount::COIN );
+    spruce.setCurrentPrice( "DOGE", Coin( "0.0001" ) );
+    assert( spruce.calculateAmountToShortLong() );
+    assert( spruce.getQuantityToShortLongMap().size() == 3 );
+    assert( spruce.getQuantityToShortLongByCurrency( "BTC_DOGE" ).isLessThanZero() );
+
+    // failures clear the signals
+    spruce.setCurrentPrice( "USDN", Coin() );
+    assert( !spruce.calculateAmountToShortLong() );
+    assert( spruce.getQuantityToShortLongMap().isEmpty() );
+
     // clean dirty engine stuff
     for ( quint8 type = 0; type < 4; type++ )
         if ( engine->rest_arr.value( type ) != nullptr )
             engine->rest_arr.value( type )->ticker_update_time = 0;
+
+    // a stale ticker drops out of the aggregated spread
+    o->price_aggregator->onExchangeTicker( engine->engine_type, 0 );
+    assert( !o->price_aggregator->getSpread( TEST_MARKET ).isValid() );
 }
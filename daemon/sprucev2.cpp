@@ -110,9 +110,18 @@ void SpruceV2::clearCurrentPrices()
 
 bool SpruceV2::calculateAmountToShortLong( bool is_midspread_phase )
 {
-    // clear qty_to_sl. incase we fail, it should not give any signals.
-    m_qty_to_sl.clear();
+    // clear qty_to_sl if we fail, it should not give any signals
+    if ( !calculateAmountToShortLongDense( is_midspread_phase ) )
+    {
+        m_qty_to_sl.clear();
+        return false;
+    }
+
+    return true;
+}
 
+bool SpruceV2::calculateAmountToShortLongDense( bool is_midspread_phase )
+{
     // check if there are no averages
     if ( m_average.isEmpty() )
     {
@@ -142,9 +151,9 @@ bool SpruceV2::calculateAmountToShortLong( bool is_midspread_phase )
 
 //    kDebug() << "prices:" << m_current_price;
 
-    const QString dollar_currency = "USDN";
-    const Coin dollar_avg = m_average[ dollar_currency ];
-    const Coin dollar_price = m_current_price[ dollar_currency ];
+    static const QString dollar_currency = "USDN";
+    const Coin dollar_avg = m_average.value( dollar_currency );
+    const Coin dollar_price = m_current_price.value( dollar_currency );
 
     if ( dollar_avg.isZeroOrLess() )
     {
@@ -158,106 +167,69 @@ bool SpruceV2::calculateAmountToShortLong( bool is_midspread_phase )
         return false;
     }
 
-    // recompute btc pair averages in dollar terms
-    QMap<QString, Coin> average_dollar_terms;
-    for ( QMap<QString, Coin>::const_iterator i = m_average.begin(); i != m_average.end(); i++ )
-    {
-        const QString &currency = i.key();
-        const Coin &avg = i.value();
+    // rebuild the layout if the currency set changed
+    if ( m_dense_layout_dirty || m_dense_input_target.size() != m_average.size() || m_dense_dollar_currency != dollar_currency )
+        buildDenseLayout( dollar_currency );
 
-        if ( currency == dollar_currency )
-            average_dollar_terms[ dollar_currency ] = CoinAmount::COIN / avg;
-        else
-            average_dollar_terms[ currency ] = avg / dollar_avg;
-    }
-//    kDebug() << "avg dollar terms" << average_dollar_terms;
-
-    // recompute prices in dollar terms
-    QMap<QString, Coin> price_dollar_terms;
-    for ( QMap<QString, Coin>::const_iterator i = m_current_price.begin(); i != m_current_price.end(); i++ )
-    {
-        const QString &currency = i.key();
-        const Coin &price = i.value();
+    const int target_count = m_dense_target_currency.size();
+    m_dense_rated.fill( false );
 
-        if ( currency == dollar_currency )
-            price_dollar_terms[ dollar_currency ] = CoinAmount::COIN / price;
-        else
-            price_dollar_terms[ currency ] = price / dollar_price;
-    }
-//    kDebug() << "price dollar terms" << price_dollar_terms;
-
-    // iterate each currency we have, construct a rating
-    QMap<QString/*currency*/, Coin> rating;
+    // iterate each currency we have, construct a rating from the average and price in dollar terms
     Coin lowest_rating;
-    for ( QMap<QString/*currency*/, Coin>::const_iterator i = average_dollar_terms.begin(); i != average_dollar_terms.end(); i++ )
+    int input_idx = 0;
+    for ( QMap<QString, Coin>::const_iterator i = m_average.begin(); i != m_average.end(); i++, input_idx++ )
     {
         const QString &currency = i.key();
-        const Coin &dollar_avg = i.value();
-        const Coin &dollar_price = price_dollar_terms[ currency ];
+        const Coin &avg = i.value();
+        const Coin price = m_current_price.value( currency );
+        const bool is_dollar = ( currency == dollar_currency );
+
+        const Coin dollar_avg_current = is_dollar ? CoinAmount::COIN / avg : avg / dollar_avg;
+        const Coin dollar_price_current = is_dollar ? CoinAmount::COIN / price : price / dollar_price;
 
         // throw warning message on invalid dollar_avg
-        if ( dollar_avg.isZeroOrLess() )
+        if ( dollar_avg_current.isZeroOrLess() )
         {
-            kDebug() << "local warning: invalid dollar_avg:" << currency << dollar_avg;
+            kDebug() << "local warning: invalid dollar_avg:" << currency << dollar_avg_current;
             continue;
         }
 
         // throw warning message on invalid dollar_price
-        if ( dollar_price.isZeroOrLess() )
+        if ( dollar_price_current.isZeroOrLess() )
         {
-            kDebug() << "local warning: invalid dollar_price:" << currency << dollar_price;
+            kDebug() << "local warning: invalid dollar_price:" << currency << dollar_price_current;
             continue;
         }
 
-        const Coin current_rating = dollar_avg / dollar_price;
+        const Coin current_rating = dollar_avg_current / dollar_price_current;
 
-        // if dollars, set BTC rating
-        if ( currency == dollar_currency )
-            rating[ getBaseCurrency() ] = current_rating;
-        else
-            rating[ currency ] = current_rating;
+        // if dollars, this is the base currency rating
+        const int t = m_dense_input_target[ input_idx ];
+        m_dense_rating[ t ] = current_rating;
+        m_dense_rated[ t ] = true;
 
         // store lowest rating
         if ( lowest_rating.isZero() || current_rating < lowest_rating )
             lowest_rating = current_rating;
     }
 
-//    kDebug() << "ratings:" << rating;
-
-    QMap<QString/*currency*/, Coin> rating_over_lowest;
-    for ( QMap<QString/*currency*/, Coin>::const_iterator i = rating.begin(); i != rating.end(); i++ )
-    {
-        const QString &currency = i.key();
-        const Coin &rating = i.value();
-
-        const Coin rol = ( rating / lowest_rating ).pow( m_alloc_power );
-
-        rating_over_lowest[ currency ] = rol;
-    }
-
-//    kDebug() << "rating_over_lowest:" << rating_over_lowest;
-
-    // compute rol * favorability = RLF, and total RLF
-    QMap<QString/*currency*/, Coin> rlf;
+    // compute rating over lowest * favorability = RLF, and total RLF
     Coin rlft;
-    Coin ft;
-    for ( QMap<QString/*currency*/, Coin>::const_iterator i = rating_over_lowest.begin(); i != rating_over_lowest.end(); i++ )
+    for ( int t = 0; t < target_count; t++ )
     {
-        const QString &currency = i.key();
-        const Coin &rl = i.value();
-        const Coin &favorability = m_favorability[ currency ];
+        if ( !m_dense_rated[ t ] )
+            continue;
 
-        const Coin rlf_current = rl * favorability;
+        Coin &rlf = m_dense_rlf[ t ];
+        rlf = m_dense_rating[ t ] / lowest_rating;
 
-        rlf[ currency ] = rlf_current;
+        if ( m_alloc_power > 1 )
+            rlf = rlf.pow( m_alloc_power );
 
-        // record RLFT and FT
-        rlft += rlf_current;
-        ft += favorability;
+        rlf *= m_favorability.value( m_dense_target_currency[ t ] );
+        rlft += rlf;
     }
 
-//    kDebug() << "rlf:" << rlf;
-
     // get BTCVT
     const Coin btcvt = getBaseCapital();
     if ( btcvt.isZeroOrLess() )
@@ -266,50 +238,42 @@ bool SpruceV2::calculateAmountToShortLong( bool is_midspread_phase )
         return false;
     }
 
-    QMap<QString/*currency*/, Coin> target_amounts, target_percentages;
-
     // calculate dollar short ratio, btcvt less dsr, usd alloc
     const Coin &dsr = m_dollar_short_ratio;
     const Coin btcvtldr = btcvt * ( CoinAmount::COIN - dsr );
-    const Coin usda = dsr * btcvt;
-
-    target_amounts[ dollar_currency ] = usda;
-    target_percentages[ dollar_currency ] = dsr;
 
-//    kDebug() << "btcvt:" << btcvt;
+    m_dense_target_amount[ m_dense_dollar_target ] = dsr * btcvt;
+    m_dense_target_pct[ m_dense_dollar_target ] = dsr;
 
     // compute BTCVT*RLF[currency]/RLFT = base currency alloc
-    for ( QMap<QString/*currency*/, Coin>::const_iterator i = rlf.begin(); i != rlf.end(); i++ )
+    for ( int t = 0; t < target_count; t++ )
     {
-        const QString &currency = i.key();
-        const Coin &rlf = i.value();
-
-        const Coin target_amount = btcvtldr * rlf / rlft;
+        if ( !m_dense_rated[ t ] )
+            continue;
 
-        // save to member map
-        target_amounts[ currency ] = target_amount;
-        target_percentages[ currency ] = target_amount / btcvt;
+        m_dense_target_amount[ t ] = btcvtldr * m_dense_rlf[ t ] / rlft;
+        m_dense_target_pct[ t ] = m_dense_target_amount[ t ] / btcvt;
     }
 
-    // compute target = x / price
-    for ( QMap<QString/*currency*/, Coin>::const_iterator i = target_amounts.begin(); i != target_amounts.end(); i++ )
-    {
-        const QString &currency = i.key();
+    // the dollar always has a target
+    m_dense_rated[ m_dense_dollar_target ] = true;
 
-        if ( currency == getBaseCurrency() )
-            continue;
-
-        const Coin &amount = i.value();
-        const Coin target_qty = amount / m_current_price[ currency ];
-
-        m_qty_to_sl[ Market( m_base_currency, currency ) ] = getCurrentQty( currency ) - target_qty;
-    }
+    writeDenseQtyToShortLong();
 
     // if noflux phase, record end status
     if ( is_midspread_phase )
     {
-        m_target_amounts = target_amounts;
-        m_target_percentages = target_percentages;
+        m_target_amounts.clear();
+        m_target_percentages.clear();
+
+        for ( int t = 0; t < target_count; t++ )
+        {
+            if ( !m_dense_rated[ t ] )
+                continue;
+
+            m_target_amounts.insert( m_dense_target_currency[ t ], m_dense_target_amount[ t ] );
+            m_target_percentages.insert( m_dense_target_currency[ t ], m_dense_target_pct[ t ] );
+        }
 
 //        kDebug() << "target amounts:" << m_target_amounts;
 //        kDebug() << "target percentages:" << m_target_percentages;
@@ -319,6 +283,97 @@ bool SpruceV2::calculateAmountToShortLong( bool is_midspread_phase )
     return true;
 }
 
+void SpruceV2::setCurrencyLongtermSignal( const QString &currency, const Coin &signal )
+{
+    // a new currency changes the dense layout
+    if ( !m_average.contains( currency ) )
+        m_dense_layout_dirty = true;
+
+    m_average[ currency ] = signal;
+}
+
+void SpruceV2::buildDenseLayout( const QString &dollar_currency )
+{
+    // collect the targets, the dollar is rated as the base currency
+    QMap<QString/*currency*/, int> targets;
+    targets.insert( dollar_currency, -1 );
+    for ( QMap<QString, Coin>::const_iterator i = m_average.begin(); i != m_average.end(); i++ )
+        targets.insert( ( i.key() == dollar_currency ) ? getBaseCurrency() : i.key(), -1 );
+
+    // assign target indices in map order
+    m_dense_target_currency.clear();
+    m_dense_target_market.clear();
+    for ( QMap<QString, int>::iterator i = targets.begin(); i != targets.end(); i++ )
+    {
+        const QString &currency = i.key();
+
+        i.value() = m_dense_target_currency.size();
+        m_dense_target_currency += currency;
+        m_dense_target_market += ( currency == getBaseCurrency() ) ? QString() : QString( Market( m_base_currency, currency ) );
+    }
+
+    m_dense_input_target.clear();
+    for ( QMap<QString, Coin>::const_iterator i = m_average.begin(); i != m_average.end(); i++ )
+        m_dense_input_target += targets.value( ( i.key() == dollar_currency ) ? getBaseCurrency() : i.key() );
+
+    const int target_count = m_dense_target_currency.size();
+    m_dense_dollar_target = targets.value( dollar_currency );
+    m_dense_rated.resize( target_count );
+    m_dense_rating.resize( target_count );
+    m_dense_rlf.resize( target_count );
+    m_dense_target_amount.resize( target_count );
+    m_dense_target_pct.resize( target_count );
+
+    m_dense_dollar_currency = dollar_currency;
+    m_dense_layout_dirty = false;
+}
+
+void SpruceV2::writeDenseQtyToShortLong()
+{
+    const int target_count = m_dense_target_currency.size();
+
+    // the targets are in the same order as the map keys, so if the key set didn't change, update the values in place
+    bool in_place = true;
+    QMap<QString, Coin>::iterator it = m_qty_to_sl.begin();
+    for ( int t = 0; t < target_count && in_place; t++ )
+    {
+        if ( !m_dense_rated[ t ] || m_dense_target_market[ t ].isEmpty() )
+            continue;
+
+        if ( it == m_qty_to_sl.end() || it.key() != m_dense_target_market[ t ] )
+            in_place = false;
+        else
+            it++;
+    }
+
+    if ( !in_place || it != m_qty_to_sl.end() )
+    {
+        in_place = false;
+        m_qty_to_sl.clear();
+    }
+
+    // compute target = x / price
+    it = m_qty_to_sl.begin();
+    for ( int t = 0; t < target_count; t++ )
+    {
+        if ( !m_dense_rated[ t ] || m_dense_target_market[ t ].isEmpty() )
+            continue;
+
+        const QString &currency = m_dense_target_currency[ t ];
+        const Coin qty_to_sl = getCurrentQty( currency ) - m_dense_target_amount[ t ] / m_current_price.value( currency );
+
+        if ( in_place )
+        {
+            it.value() = qty_to_sl;
+            it++;
+        }
+        else
+        {
+            m_qty_to_sl.insert( m_dense_target_market[ t ], qty_to_sl );
+        }
+    }
+}
+
 void SpruceV2::adjustCurrentQty( const QString &currency, const Coin &qty )
 {
     m_current_qty[ currency ] += qty;
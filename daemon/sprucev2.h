@@ -39,6 +39,7 @@ public:
     void clear();
 
     void buildCache();
+    void setBaseCapitalCache( const Coin &base_capital ) { m_base_capital_cached = base_capital; }
     void clearCache();
 
     void clearCurrentQtys();
@@ -65,13 +66,13 @@ public:
     void setCurrencyFavorability( const QString &currency, const Coin &favorability_multiple ) { m_favorability [ currency ] = favorability_multiple; }
     Coin getCurrencyFavorability( const QString &currency ) { return m_favorability[ currency ]; }
 
-    void setCurrencyLongtermSignal( const QString &currency, const Coin &signal ) { m_average[ currency ] = signal; }
+    void setCurrencyLongtermSignal( const QString &currency, const Coin &signal );
     Coin getCurrencyLongtermSignal( const QString &currency ) { return m_average[ currency ]; }
 
     void setIntervalSecs( const qint64 secs ) { m_interval_secs = secs; }
     qint64 getIntervalSecs() const { return m_interval_secs; }
 
-    void setBaseCurrency( QString currency ) { m_base_currency = currency; }
+    void setBaseCurrency( QString currency ) { m_base_currency = currency; m_dense_layout_dirty = true; }
     QString getBaseCurrency() const { return m_base_currency.isEmpty() ? "disabled" : m_base_currency; }
     Coin getBaseCapital() const;
     QMap<QString, Coin> getTargetAmounts() { return m_target_amounts; }
@@ -174,6 +175,10 @@ public:
     }
 
 private:
+    bool calculateAmountToShortLongDense( bool is_midspread_phase );
+    void buildDenseLayout( const QString &dollar_currency );
+    void writeDenseQtyToShortLong();
+
     /// new essential
 //    Coin allocationFunc0( const Coin &rp ) { return rp; } // y=x
 //    Coin allocationFunc1( const Coin &rp ) { return rp * rp; } // y=x^2
@@ -218,6 +223,18 @@ private:
 
     Coin m_base_capital_cached;
 
+    // dense scratch for calculateAmountToShortLong(), laid out once per currency set in map order.
+    // inputs are the m_average currencies, targets are the rated currencies (the dollar is rated as the
+    // base currency) plus the dollar itself, sorted the same as the QMap outputs they fill.
+    bool m_dense_layout_dirty{ true };
+    QString m_dense_dollar_currency;
+    QVector<int> m_dense_input_target; // input index -> target index of its rating
+    QVector<QString> m_dense_target_currency;
+    QVector<QString> m_dense_target_market; // m_qty_to_sl key, empty for the base currency
+    int m_dense_dollar_target{ -1 };
+    QVector<bool> m_dense_rated;
+    QVector<Coin> m_dense_rating, m_dense_rlf, m_dense_target_amount, m_dense_target_pct;
+
     // for output only
     QMap<QString/*currency*/, Coin> m_target_amounts;
     QMap<QString/*currency*/, Coin> m_target_percentages;
@@ -22,8 +22,21 @@
 #include "diffusionphaseman_test.h"
 #include "wavesutil_test.h"
 #include "wavesaccount_test.h"
+#include "wavesorderbook_test.h"
 #include "../qbase58/qbase58_test.h"
 #include "pricesignal_test.h"
+#include "ratelimiter_test.h"
+#include "jsonreader_test.h"
+#include "latencystats_test.h"
+#include "hmacutil_test.h"
+#include "requestqueue_test.h"
+#include "simmatcher_test.h"
+#include "trafficlog_test.h"
+#include "tradingsnapshot.h"
+#include "tradingsnapshot_test.h"
+#include "replyparser_test.h"
+#include "simexchange.h"
+#include "enginethread.h"
 
 #include <QByteArray>
 #include <QTimer>
@@ -31,6 +44,10 @@
 #include <QCoreApplication>
 #include <QNetworkAccessManager>
 
+#if defined( ENGINE_THREADS_ENABLED ) && defined( EXCHANGE_SIM_ENABLED )
+#error "the exchange simulator is shared by every engine, it can't be used with ENGINE_THREADS_ENABLED"
+#endif
+
 Trader::Trader( QObject *parent )
   : QObject( parent )
 {
@@ -49,15 +66,21 @@ Trader::Trader( QObject *parent )
     spruce = new SpruceV2();
     spruce_overseer = new SpruceOverseer( engine_map, price_aggregator, spruce );
     spruce_overseer->alpha = alpha;
+    snapshot_reader = new SnapshotReader();
 
+#if defined( EXCHANGE_SIM_ENABLED )
+    nam = new SimExchange();
+#elif !defined( NETWORK_PER_EXCHANGE_ENABLED ) && !defined( ENGINE_THREADS_ENABLED )
     nam = new QNetworkAccessManager();
+#endif
 
     // engine init
 #ifdef BITTREX_ENABLED
     engine_trex = new Engine( ENGINE_BITTREX );
-    rest_trex = new TrexREST( engine_trex, nam );
+    rest_trex = new TrexREST( engine_trex, getNetworkAccessManager() );
     engine_trex->alpha = alpha;
     engine_trex->spruce = spruce;
+    engine_trex->price_aggregator = price_aggregator;
 
     engine_map->insert( ENGINE_BITTREX, engine_trex );
 
@@ -66,9 +89,10 @@ Trader::Trader( QObject *parent )
 
 #ifdef BINANCE_ENABLED
     engine_bnc = new Engine( ENGINE_BINANCE );
-    rest_bnc = new BncREST( engine_bnc, nam );
+    rest_bnc = new BncREST( engine_bnc, getNetworkAccessManager() );
     engine_bnc->alpha = alpha;
     engine_bnc->spruce = spruce;
+    engine_bnc->price_aggregator = price_aggregator;
 
     engine_map->insert( ENGINE_BINANCE, engine_bnc );
 
@@ -77,9 +101,10 @@ Trader::Trader( QObject *parent )
 
 #ifdef POLONIEX_ENABLED
     engine_polo = new Engine( ENGINE_POLONIEX );
-    rest_polo = new PoloREST( engine_polo, nam );
+    rest_polo = new PoloREST( engine_polo, getNetworkAccessManager() );
     engine_polo->alpha = alpha;
     engine_polo->spruce = spruce;
+    engine_polo->price_aggregator = price_aggregator;
 
     engine_map->insert( ENGINE_POLONIEX, engine_polo );
 
@@ -88,9 +113,10 @@ Trader::Trader( QObject *parent )
 
 #ifdef WAVES_ENABLED
     engine_waves = new Engine( ENGINE_WAVES );
-    rest_waves = new WavesREST( engine_waves, nam );
+    rest_waves = new WavesREST( engine_waves, getNetworkAccessManager() );
     engine_waves->alpha = alpha;
     engine_waves->spruce = spruce;
+    engine_waves->price_aggregator = price_aggregator;
 
     engine_map->insert( ENGINE_WAVES, engine_waves );
 
@@ -103,15 +129,17 @@ Trader::Trader( QObject *parent )
     rest_arr += rest_polo;
     rest_arr += rest_waves;
 
-    // create command runner
+    // create command runner. the settings chunk is passed by reference so it can't be queued. with engine threads, the
+    // runner keeps a chunk emitted on the engine's thread until runDeferredChunks()
     if ( bittrex )
     {
         engine_trex->rest_arr = rest_arr;
         command_runner_trex = new CommandRunner( ENGINE_BITTREX, engine_trex, rest_arr );
         command_runner_trex->spruce_overseer = spruce_overseer;
         command_runner_trex->price_aggregator = price_aggregator;
+        command_runner_trex->snapshot_reader = snapshot_reader;
         connect( command_runner_trex, &CommandRunner::exitSignal, this, &Trader::handleExitSignal );
-        connect( engine_trex, &Engine::gotUserCommandChunk, command_runner_trex, &CommandRunner::runCommandChunk );
+        connect( engine_trex, &Engine::gotUserCommandChunk, command_runner_trex, &CommandRunner::runCommandChunk, Qt::DirectConnection );
     }
     if ( binance )
     {
@@ -119,8 +147,9 @@ Trader::Trader( QObject *parent )
         command_runner_bnc = new CommandRunner( ENGINE_BINANCE, engine_bnc, rest_arr );
         command_runner_bnc->spruce_overseer = spruce_overseer;
         command_runner_bnc->price_aggregator = price_aggregator;
+        command_runner_bnc->snapshot_reader = snapshot_reader;
         connect( command_runner_bnc,  &CommandRunner::exitSignal, this, &Trader::handleExitSignal );
-        connect( engine_bnc, &Engine::gotUserCommandChunk, command_runner_bnc, &CommandRunner::runCommandChunk );
+        connect( engine_bnc, &Engine::gotUserCommandChunk, command_runner_bnc, &CommandRunner::runCommandChunk, Qt::DirectConnection );
     }
     if ( poloniex )
     {
@@ -128,8 +157,9 @@ Trader::Trader( QObject *parent )
         command_runner_polo = new CommandRunner( ENGINE_POLONIEX, engine_polo, rest_arr );
         command_runner_polo->spruce_overseer = spruce_overseer;
         command_runner_polo->price_aggregator = price_aggregator;
+        command_runner_polo->snapshot_reader = snapshot_reader;
         connect( command_runner_polo, &CommandRunner::exitSignal, this, &Trader::handleExitSignal );
-        connect( engine_polo, &Engine::gotUserCommandChunk, command_runner_polo, &CommandRunner::runCommandChunk );
+        connect( engine_polo, &Engine::gotUserCommandChunk, command_runner_polo, &CommandRunner::runCommandChunk, Qt::DirectConnection );
     }
     if ( waves )
     {
@@ -137,8 +167,9 @@ Trader::Trader( QObject *parent )
         command_runner_waves = new CommandRunner( ENGINE_WAVES, engine_waves, rest_arr );
         command_runner_waves->spruce_overseer = spruce_overseer;
         command_runner_waves->price_aggregator = price_aggregator;
+        command_runner_waves->snapshot_reader = snapshot_reader;
         connect( command_runner_waves, &CommandRunner::exitSignal, this, &Trader::handleExitSignal );
-        connect( engine_waves, &Engine::gotUserCommandChunk, command_runner_waves, &CommandRunner::runCommandChunk );
+        connect( engine_waves, &Engine::gotUserCommandChunk, command_runner_waves, &CommandRunner::runCommandChunk, Qt::DirectConnection );
     }
 
     // runtime tests
@@ -153,12 +184,42 @@ Trader::Trader( QObject *parent )
     WavesAccountTest wavesaccount_test;
     wavesaccount_test.test();
 
+    WavesOrderBookTest wavesorderbook_test;
+    wavesorderbook_test.test();
+
     CoinAmountTest coin_test;
     coin_test.test();
 
     PriceSignalTest signal_test;
     signal_test.test();
 
+    RateLimiterTest ratelimiter_test;
+    ratelimiter_test.test();
+
+    JsonReaderTest jsonreader_test;
+    jsonreader_test.test();
+
+    LatencyStatsTest latency_test;
+    latency_test.test();
+
+    HmacUtilTest hmac_test;
+    hmac_test.test();
+
+    RequestQueueTest requestqueue_test;
+    requestqueue_test.test();
+
+    SimMatcherTest simmatcher_test;
+    simmatcher_test.test();
+
+    TrafficLogTest trafficlog_test;
+    trafficlog_test.test();
+
+    TradingSnapshotTest snapshot_test;
+    snapshot_test.test();
+
+    ReplyParserTest replyparser_test;
+    replyparser_test.test();
+
     DiffusionPhaseManTest phaseman_test;
     phaseman_test.test();
 
@@ -177,6 +238,11 @@ Trader::Trader( QObject *parent )
     qint64 t1 = QDateTime::currentMSecsSinceEpoch();
     kDebug() << "[Trader] Tests passed in" << t1 - t0 << "ms.";
 
+#if defined( PRINT_STARTUP_BENCHMARKS )
+    qbase58_test.benchmark();
+    wavesutil_test.benchmark();
+#endif
+
     // print build info
     kDebug() << "[Trader] Startup success." << Global::getBuildString();
 
@@ -203,10 +269,38 @@ Trader::Trader( QObject *parent )
 //    listener_fallback = new FallbackListener();
 //    connect( listener_fallback, &FallbackListener::gotDataChunk, runner, &CommandRunner::runCommandChunk );
 
+#if defined( ENGINE_THREADS_ENABLED )
+    // tests passed. move each engine and rest module to its own thread
+    for ( int i = 0; i < rest_arr.size(); i++ )
+        if ( rest_arr.at( i ) != nullptr )
+            engine_thread_arr += new EngineThread( rest_arr.at( i )->engine, rest_arr.at( i ) );
+
+    // init() creates sockets and timers, so it runs on the engine's thread. hold the engines while it loads settings
+    {
+        EngineThreadLock engine_lock;
+
+        for ( int i = 0; i < rest_arr.size(); i++ )
+        {
+            BaseREST *rest = rest_arr.at( i );
+
+            if ( rest != nullptr )
+                rest->engine->runOnEngineThread( [rest]() { rest->init(); } );
+        }
+    }
+
+    // run the engine settings loaded by init() here, before the aggregator and spruce settings like without threads
+    QVector<CommandRunner*> command_runners = QVector<CommandRunner*>() << command_runner_trex << command_runner_bnc
+                                                                        << command_runner_polo << command_runner_waves;
+
+    for ( QVector<CommandRunner*>::const_iterator i = command_runners.begin(); i != command_runners.end(); i++ )
+        if ( *i != nullptr )
+            (*i)->runDeferredChunks();
+#else
     // tests passed. start rest, load settings and stats, initialize api keys
     for ( int i = 0; i < rest_arr.size(); i++ )
         if ( rest_arr.at( i ) != nullptr )
             rest_arr.at( i )->init();
+#endif
 
     price_aggregator->load();
     spruce_overseer->loadSettings();
@@ -215,6 +309,13 @@ Trader::Trader( QObject *parent )
 
 Trader::~Trader()
 {
+    // stop the snapshot reader before the command runners it reads from
+    delete snapshot_reader;
+#if defined( ENGINE_THREADS_ENABLED )
+    // each thread deletes its engine, rest module and network manager before it stops
+    while ( !engine_thread_arr.isEmpty() )
+        delete engine_thread_arr.takeFirst();
+#else
     delete engine_trex;
     delete engine_bnc;
     delete engine_polo;
@@ -223,6 +324,7 @@ Trader::~Trader()
     delete rest_bnc;
     delete rest_polo;
     delete rest_waves;
+#endif
     delete command_runner_trex;
     delete command_runner_bnc;
     delete command_runner_polo;
@@ -236,14 +338,35 @@ Trader::~Trader()
 
     QCoreApplication::processEvents( QEventLoop::AllEvents, 10000 );
 
-    // force nam to close
-    nam->thread()->exit();
+    // per-exchange managers aren't referenced by anything now
+    while ( !exchange_nam_arr.isEmpty() )
+        delete exchange_nam_arr.takeLast();
+
+    // force the event loop to close, nam is only set if the exchanges shared it
+    thread()->exit();
     delete nam;
     nam = nullptr;
 
     kDebug() << "[Trader] done.";
 }
 
+QNetworkAccessManager *Trader::getNetworkAccessManager()
+{
+#if defined( ENGINE_THREADS_ENABLED )
+    // the engine thread takes it over along with the rest module, and deletes it
+    return new QNetworkAccessManager();
+#elif defined( NETWORK_PER_EXCHANGE_ENABLED ) && !defined( EXCHANGE_SIM_ENABLED )
+    // a manager reads its replies on its own thread, so a large reply from one exchange doesn't hold up the others
+    QNetworkAccessManager *exchange_nam = new QNetworkAccessManager();
+    exchange_nam_arr += exchange_nam;
+
+    return exchange_nam;
+#else
+    // the simulator answers every exchange, so they share it
+    return nam;
+#endif
+}
+
 void Trader::handleCommand( QString &s )
 {
     //kDebug() << "[Trader] got command:" << s;
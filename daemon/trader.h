@@ -2,6 +2,7 @@
 #define TREXTRADER_H
 
 #include <QObject>
+#include <QVector>
 
 class QNetworkAccessManager;
 class CommandListener;
@@ -10,8 +11,10 @@ class AlphaTracker;
 class PriceAggregator;
 class SpruceV2;
 class SpruceOverseer;
+class SnapshotReader;
 class EngineMap;
 class Engine;
+class EngineThread;
 class TrexREST;
 class BncREST;
 class PoloREST;
@@ -30,7 +33,11 @@ public slots:
     void handleExitSignal();
 
 private:
-    QNetworkAccessManager *nam;
+    QNetworkAccessManager *getNetworkAccessManager();
+
+    QNetworkAccessManager *nam{ nullptr }; // only created if the exchanges share it
+    QVector<QNetworkAccessManager*> exchange_nam_arr; // one per exchange with NETWORK_PER_EXCHANGE_ENABLED
+    QVector<EngineThread*> engine_thread_arr; // one per exchange with ENGINE_THREADS_ENABLED, owns the engine and rest module
 
     CommandListener *command_listener{ nullptr };
     CommandRunner *command_runner_trex{ nullptr };
@@ -42,6 +49,7 @@ private:
     PriceAggregator *price_aggregator{ nullptr };
     SpruceV2 *spruce{ nullptr };
     SpruceOverseer *spruce_overseer{ nullptr };
+    SnapshotReader *snapshot_reader{ nullptr };
 
     EngineMap *engine_map{ nullptr };
     Engine *engine_trex{ nullptr };
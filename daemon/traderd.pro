@@ -1,4 +1,4 @@
-QT       = core network websockets
+QT       = core network websockets concurrent
 
 TARGET = traderd
 DESTDIR = ../
@@ -28,11 +28,35 @@ SOURCES += main.cpp \
     fallbacklistener.cpp \
     market.cpp \
     position.cpp \
+    positiondata.cpp \
     engine.cpp \
+    enginethread.cpp \
     positionman.cpp \
+    positionpool.cpp \
     pricesignal.cpp \
     pricesignal_test.cpp \
     priceaggregator.cpp \
+    ratelimiter.cpp \
+    ratelimiter_test.cpp \
+    jsonreader.cpp \
+    exchangesession.cpp \
+    latencystats.cpp \
+    latencystats_test.cpp \
+    hmacutil.cpp \
+    hmacutil_test.cpp \
+    requestqueue.cpp \
+    requestqueue_test.cpp \
+    simmatcher.cpp \
+    simmatcher_test.cpp \
+    simexchange.cpp \
+    trafficlog.cpp \
+    trafficlog_test.cpp \
+    trafficreplay.cpp \
+    tradingsnapshot.cpp \
+    tradingsnapshot_test.cpp \
+    replyparser.cpp \
+    replyparser_test.cpp \
+    jsonreader_test.cpp \
     spruceoverseer.cpp \
     spruceoverseer_test.cpp \
     sprucev2.cpp \
@@ -49,6 +73,9 @@ SOURCES += main.cpp \
     wavesutil_test.cpp \
     wavesaccount.cpp \
     wavesaccount_test.cpp \
+    wavesorderbook.cpp \
+    wavesorderbook_test.cpp \
+    wavessigner.cpp \
     ../libbase58/base58.c \
     ../qbase58/qbase58.cpp \
     ../qbase58/qbase58_test.cpp \
@@ -115,11 +142,34 @@ HEADERS += build-config.h \
     market.h \
     position.h \
     engine.h \
+    enginethread.h \
     positiondata.h \
     positionman.h \
+    positionpool.h \
     pricesignal.h \
     pricesignal_test.h \
     priceaggregator.h \
+    ratelimiter.h \
+    ratelimiter_test.h \
+    jsonreader.h \
+    exchangesession.h \
+    latencystats.h \
+    latencystats_test.h \
+    hmacutil.h \
+    hmacutil_test.h \
+    requestqueue.h \
+    requestqueue_test.h \
+    simmatcher.h \
+    simmatcher_test.h \
+    simexchange.h \
+    trafficlog.h \
+    trafficlog_test.h \
+    trafficreplay.h \
+    tradingsnapshot.h \
+    tradingsnapshot_test.h \
+    replyparser.h \
+    replyparser_test.h \
+    jsonreader_test.h \
     spruceoverseer.h \
     spruceoverseer_test.h \
     sprucev2.h \
@@ -138,6 +188,9 @@ HEADERS += build-config.h \
     wavesutil_test.h \
     wavesaccount.h \
     wavesaccount_test.h \
+    wavesorderbook.h \
+    wavesorderbook_test.h \
+    wavessigner.h \
     ../libbase58/libbase58.h \
     ../qbase58/qbase58.h \
     ../qbase58/qbase58_test.h \
@@ -0,0 +1,141 @@
+#include "tradingsnapshot.h"
+#include "global.h"
+
+#include <QThread>
+#include <QDateTime>
+#include <QMetaObject>
+
+SnapshotReader::SnapshotReader( QObject *parent )
+    : QObject( parent )
+{
+    reader_thread = new QThread();
+    reader_thread->setObjectName( "SnapshotReader" );
+
+    reader_context = new QObject();
+    reader_context->moveToThread( reader_thread );
+
+    reader_thread->start( QThread::LowPriority );
+}
+
+SnapshotReader::~SnapshotReader()
+{
+    // finish whatever is queued on the reader, its output is dropped along with us
+    reader_thread->quit();
+    reader_thread->wait();
+
+    delete reader_context;
+    delete reader_thread;
+}
+
+void SnapshotReader::serve( const SnapshotPublisher *publisher, const QStringList &args )
+{
+    QMetaObject::invokeMethod( reader_context, [this, publisher, args]()
+    {
+        const TradingSnapshotPtr snapshot = publisher->acquire();
+
+        if ( !snapshot )
+            return;
+
+        const QStringList lines = format( *snapshot, args );
+
+        QMetaObject::invokeMethod( this, [this, lines]() { printLines( lines ); }, Qt::QueuedConnection );
+    }, Qt::QueuedConnection );
+}
+
+bool SnapshotReader::isReadOnlyCommand( const QString &command )
+{
+    return command == QLatin1String( "getstatus" ) ||
+           command == QLatin1String( "getconfig" ) ||
+           command == QLatin1String( "getinternal" ) ||
+           command == QLatin1String( "getpositions" ) ||
+           command == QLatin1String( "getsprucetargets" ) ||
+           command == QLatin1String( "getalpha" );
+}
+
+bool SnapshotReader::isStateChangingCommand( const QString &command )
+{
+    // queries and saves only read the state
+    return !command.startsWith( QLatin1String( "get" ) ) &&
+           !command.startsWith( QLatin1String( "save" ) );
+}
+
+quint8 SnapshotReader::getSections( const QString &command )
+{
+    return command == QLatin1String( "getstatus" ) ? SnapshotTickerStatus :
+           command == QLatin1String( "getconfig" ) ? SnapshotMarketConfig :
+           command == QLatin1String( "getinternal" ) ? SnapshotInternal :
+           command == QLatin1String( "getpositions" ) ? SnapshotPositions :
+           command == QLatin1String( "getsprucetargets" ) ? SnapshotSpruceTargets :
+           command == QLatin1String( "getalpha" ) ? SnapshotAlpha :
+                                                   0;
+}
+
+QStringList SnapshotReader::format( const TradingSnapshot &snapshot, const QStringList &args )
+{
+    QStringList ret;
+    const QString command = args.value( 0 ).toLower();
+    const QString market = args.value( 1 );
+    const bool all_markets = market.isEmpty() || market == ALL;
+
+    if ( command == QLatin1String( "getstatus" ) )
+    {
+        ret += snapshot.ticker_status;
+    }
+    else if ( command == QLatin1String( "getconfig" ) )
+    {
+        // print only one market if we supplied one
+        if ( !all_markets )
+        {
+            ret += snapshot.markets.value( market ).config;
+            return ret;
+        }
+
+        for ( QMap<QString, MarketSnapshot>::const_iterator i = snapshot.markets.begin(); i != snapshot.markets.end(); i++ )
+            ret += QString( "%1 %2" )
+                   .arg( i.key(), -10 )
+                   .arg( i.value().config );
+    }
+    else if ( command == QLatin1String( "getinternal" ) )
+    {
+        ret += snapshot.internal;
+        ret += QString( "snapshot: %1 age: %2ms" )
+               .arg( snapshot.sequence )
+               .arg( QDateTime::currentMSecsSinceEpoch() - snapshot.time_ms );
+    }
+    else if ( command == QLatin1String( "getpositions" ) )
+    {
+        for ( QMap<QString, MarketSnapshot>::const_iterator i = snapshot.markets.begin(); i != snapshot.markets.end(); i++ )
+        {
+            const MarketSnapshot &m = i.value();
+
+            if ( all_markets ? m.active_buys + m.active_sells + m.queued == 0 : i.key() != market )
+                continue;
+
+            ret += QString( "%1 buys %2 sells %3 queued %4 onetime %5 ping-pong indices %6 hi_buy %7 lo_sell %8" )
+                   .arg( i.key(), -10 )
+                   .arg( m.active_buys, -4 )
+                   .arg( m.active_sells, -4 )
+                   .arg( m.queued, -4 )
+                   .arg( m.onetime, -4 )
+                   .arg( m.ping_pong_indices, -4 )
+                   .arg( m.hi_buy, -16 )
+                   .arg( m.lo_sell );
+        }
+    }
+    else if ( command == QLatin1String( "getsprucetargets" ) )
+    {
+        ret += snapshot.spruce_targets;
+    }
+    else if ( command == QLatin1String( "getalpha" ) )
+    {
+        ret += snapshot.alpha;
+    }
+
+    return ret;
+}
+
+void SnapshotReader::printLines( const QStringList &lines )
+{
+    for ( QStringList::const_iterator i = lines.begin(); i != lines.end(); i++ )
+        kDebug() << *i;
+}
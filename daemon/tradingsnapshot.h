@@ -0,0 +1,100 @@
+#ifndef TRADINGSNAPSHOT_H
+#define TRADINGSNAPSHOT_H
+
+#include <memory>
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QMap>
+
+class QThread;
+
+enum TradingSnapshotSection : quint8
+{
+    SnapshotTickerStatus = 0x01,
+    SnapshotMarketConfig = 0x02,
+    SnapshotPositions = 0x04, // also fills in the ping-pong index counts
+    SnapshotInternal = 0x08,
+    SnapshotSpruceTargets = 0x10,
+    SnapshotAlpha = 0x20
+};
+
+struct MarketSnapshot
+{
+    QString config; // MarketInfo string
+    QString hi_buy, lo_sell; // our best prices
+    qint32 ping_pong_indices{ 0 };
+    qint32 active_buys{ 0 };
+    qint32 active_sells{ 0 };
+    qint32 queued{ 0 };
+    qint32 onetime{ 0 };
+};
+
+//
+// TradingSnapshot, an immutable copy of the state the read-only commands print
+//
+// CommandRunner fills in the sections its pending read-only commands need, after the command chunk has run, and
+// publishes it. after that nobody writes to it. prices are stored as strings, so the reader never formats a Coin.
+//
+struct TradingSnapshot
+{
+    quint8 engine_type{ 0 };
+    quint8 sections{ 0 }; // TradingSnapshotSection flags that were filled in
+    quint64 sequence{ 0 };
+    qint64 time_ms{ 0 };
+
+    QString ticker_status;
+    QMap<QString, MarketSnapshot> markets;
+    QStringList internal;
+    QStringList spruce_targets;
+    QString alpha;
+};
+
+typedef std::shared_ptr<const TradingSnapshot> TradingSnapshotPtr;
+
+//
+// SnapshotPublisher, hands the latest snapshot to any thread
+//
+// publishing swaps the pointer, and a reader keeps whichever snapshot it acquired alive until it's done with it.
+// neither side waits on the other, an old snapshot is freed by its last reader.
+//
+class SnapshotPublisher
+{
+public:
+    void publish( TradingSnapshotPtr snapshot ) { std::atomic_store( &current, std::move( snapshot ) ); }
+    TradingSnapshotPtr acquire() const { return std::atomic_load( &current ); }
+
+private:
+    TradingSnapshotPtr current;
+};
+
+//
+// SnapshotReader, formats read-only commands from a snapshot on its own thread
+//
+// serve() is called by a command runner. the snapshot is acquired and formatted on the reader thread, and the lines
+// come back to the main thread to be logged, because the log handler isn't thread-safe.
+//
+class SnapshotReader : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SnapshotReader( QObject *parent = nullptr );
+    ~SnapshotReader();
+
+    void serve( const SnapshotPublisher *publisher, const QStringList &args );
+
+    static bool isReadOnlyCommand( const QString &command );
+    static bool isStateChangingCommand( const QString &command ); // may change what a snapshot shows
+    static quint8 getSections( const QString &command ); // TradingSnapshotSection flags the command reads
+    static QStringList format( const TradingSnapshot &snapshot, const QStringList &args );
+
+private:
+    void printLines( const QStringList &lines );
+
+    QThread *reader_thread{ nullptr };
+    QObject *reader_context{ nullptr }; // lives on reader_thread
+};
+
+#endif // TRADINGSNAPSHOT_H
@@ -0,0 +1,72 @@
+#include "tradingsnapshot_test.h"
+#include "tradingsnapshot.h"
+
+#include <QString>
+#include <QStringList>
+
+#include <assert.h>
+
+void TradingSnapshotTest::test()
+{
+    /// test read-only command detection
+    assert( SnapshotReader::isReadOnlyCommand( "getstatus" ) );
+    assert( SnapshotReader::isReadOnlyCommand( "getpositions" ) );
+    assert( !SnapshotReader::isReadOnlyCommand( "setorder" ) );
+    assert( !SnapshotReader::isReadOnlyCommand( "getlatency" ) );
+
+    /// test only commands that can change the state dirty the snapshot
+    assert( SnapshotReader::isStateChangingCommand( "setorder" ) );
+    assert( SnapshotReader::isStateChangingCommand( "cancelall" ) );
+    assert( !SnapshotReader::isStateChangingCommand( "getorders" ) );
+    assert( !SnapshotReader::isStateChangingCommand( "getlatency" ) );
+    assert( !SnapshotReader::isStateChangingCommand( "savemarkets" ) );
+
+    /// test each read-only command reads one section
+    assert( SnapshotReader::getSections( "getpositions" ) == SnapshotPositions );
+    assert( SnapshotReader::getSections( "getinternal" ) == SnapshotInternal );
+    assert( SnapshotReader::getSections( "setorder" ) == 0 );
+
+    /// test publishing, a reader keeps its snapshot after a newer one is published
+    SnapshotPublisher publisher;
+    assert( !publisher.acquire() );
+
+    std::shared_ptr<TradingSnapshot> first = std::make_shared<TradingSnapshot>();
+    first->sequence = 1;
+    first->ticker_status = "status 1";
+
+    MarketSnapshot &btc_eth = first->markets[ "BTC_ETH" ];
+    btc_eth.config = "config eth";
+    btc_eth.active_buys = 2;
+    btc_eth.active_sells = 1;
+    btc_eth.hi_buy = "0.03000000";
+    btc_eth.lo_sell = "0.03100000";
+
+    first->markets[ "BTC_LTC" ].config = "config ltc";
+
+    publisher.publish( first );
+
+    const TradingSnapshotPtr held = publisher.acquire();
+    assert( held->sequence == 1 );
+
+    std::shared_ptr<TradingSnapshot> second = std::make_shared<TradingSnapshot>( *held );
+    second->sequence = 2;
+    second->ticker_status = "status 2";
+    publisher.publish( second );
+
+    assert( publisher.acquire()->sequence == 2 );
+    assert( held->ticker_status == "status 1" );
+
+    /// test formatting
+    const TradingSnapshot &snapshot = *publisher.acquire();
+
+    assert( SnapshotReader::format( snapshot, QStringList() << "getstatus" ) == QStringList() << "status 2" );
+    assert( SnapshotReader::format( snapshot, QStringList() << "getconfig" << "BTC_LTC" ) == QStringList() << "config ltc" );
+    assert( SnapshotReader::format( snapshot, QStringList() << "getconfig" ).size() == 2 );
+
+    // markets without positions are skipped unless asked for
+    const QStringList positions = SnapshotReader::format( snapshot, QStringList() << "getpositions" );
+    assert( positions.size() == 1 );
+    assert( positions.first().startsWith( "BTC_ETH" ) );
+    assert( positions.first().contains( "0.03100000" ) );
+    assert( SnapshotReader::format( snapshot, QStringList() << "getpositions" << "BTC_LTC" ).size() == 1 );
+}
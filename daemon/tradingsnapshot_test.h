@@ -0,0 +1,9 @@
+#ifndef TRADINGSNAPSHOT_TEST_H
+#define TRADINGSNAPSHOT_TEST_H
+
+struct TradingSnapshotTest
+{
+    void test();
+};
+
+#endif // TRADINGSNAPSHOT_TEST_H
@@ -0,0 +1,209 @@
+#include "trafficlog.h"
+#include "global.h"
+
+#include <limits>
+
+#include <QUrl>
+#include <QUrlQuery>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+
+bool TrafficLogWriter::open( const QString &path, const QString &exchange, const qint64 _start_time_ms )
+{
+    close();
+
+    file.setFileName( path );
+    if ( !file.open( QIODevice::WriteOnly | QIODevice::Truncate ) )
+    {
+        kDebug() << "local error: couldn't open traffic log" << path;
+        return false;
+    }
+
+    start_time_ms = _start_time_ms;
+    record_count = 0;
+
+    stream.setDevice( &file );
+    stream.setVersion( QDataStream::Qt_5_0 );
+    stream << magic << version << exchange << start_time_ms;
+
+    return true;
+}
+
+void TrafficLogWriter::close()
+{
+    if ( !file.isOpen() )
+        return;
+
+    stream.setDevice( nullptr );
+    file.flush();
+    file.close();
+}
+
+void TrafficLogWriter::recordRequest( const quint64 id, const QString &api_command, const QString &body, const QString &url, const qint64 time_ms )
+{
+    if ( !file.isOpen() )
+        return;
+
+    writeHeader( TrafficRequest, time_ms );
+    stream << id << api_command.toUtf8() << redactBody( body ).toUtf8() << redactUrl( url ).toUtf8();
+}
+
+QString TrafficLogWriter::redactUrl( const QString &url )
+{
+    QUrl ret( url );
+
+    if ( ret.hasQuery() )
+    {
+        // a null query drops the '?' too
+        const QString query = redactQuery( ret.query( QUrl::FullyEncoded ) );
+        ret.setQuery( query.isEmpty() ? QString() : query, QUrl::StrictMode );
+    }
+
+    return ret.toString();
+}
+
+QString TrafficLogWriter::redactBody( const QString &body )
+{
+    // waves sends json, everything else is a form body
+    const QJsonDocument doc = QJsonDocument::fromJson( body.toUtf8() );
+
+    if ( !doc.isObject() )
+        return redactQuery( body );
+
+    QJsonObject obj = doc.object();
+    redactJson( obj );
+
+    return QString::fromUtf8( QJsonDocument( obj ).toJson( QJsonDocument::Compact ) );
+}
+
+bool TrafficLogWriter::isRedactedField( const QString &key )
+{
+    return key.compare( QLatin1String( "apikey" ), Qt::CaseInsensitive ) == 0 ||
+           key.compare( QLatin1String( "signature" ), Qt::CaseInsensitive ) == 0 ||
+           key.compare( QLatin1String( "timestamp" ), Qt::CaseInsensitive ) == 0 ||
+           key.compare( QLatin1String( "listenKey" ), Qt::CaseInsensitive ) == 0 ||
+           key.compare( QLatin1String( "nonce" ), Qt::CaseInsensitive ) == 0 ||
+           key.compare( QLatin1String( "proofs" ), Qt::CaseInsensitive ) == 0;
+}
+
+QString TrafficLogWriter::redactQuery( const QString &query )
+{
+    QUrlQuery ret( query );
+    const QList<QPair<QString, QString>> items = ret.queryItems();
+
+    for ( QList<QPair<QString, QString>>::const_iterator i = items.begin(); i != items.end(); i++ )
+        if ( isRedactedField( i->first ) )
+            ret.removeAllQueryItems( i->first );
+
+    return ret.toString( QUrl::FullyEncoded );
+}
+
+void TrafficLogWriter::redactJson( QJsonObject &obj )
+{
+    const QStringList keys = obj.keys();
+
+    for ( QStringList::const_iterator i = keys.begin(); i != keys.end(); i++ )
+    {
+        if ( isRedactedField( *i ) )
+        {
+            obj.remove( *i );
+            continue;
+        }
+
+        // signed orders nest their fields
+        if ( obj.value( *i ).isObject() )
+        {
+            QJsonObject child = obj.value( *i ).toObject();
+            redactJson( child );
+            obj.insert( *i, child );
+        }
+    }
+}
+
+void TrafficLogWriter::recordReply( const quint64 id, const QByteArray &data, const qint64 time_ms )
+{
+    if ( !file.isOpen() )
+        return;
+
+    writeHeader( TrafficReply, time_ms );
+    stream << id << data;
+}
+
+void TrafficLogWriter::recordWssFrame( const QString &msg, const qint64 time_ms )
+{
+    if ( !file.isOpen() )
+        return;
+
+    writeHeader( TrafficWssFrame, time_ms );
+    stream << msg.toUtf8();
+}
+
+void TrafficLogWriter::writeHeader( const quint8 kind, const qint64 time_ms )
+{
+    // offsets fit in 32 bits for ~49 days of capture
+    const quint32 offset_ms = quint32( qBound<qint64>( 0, time_ms - start_time_ms, std::numeric_limits<quint32>::max() ) );
+
+    stream << kind << offset_ms;
+    record_count++;
+}
+
+bool TrafficLogReader::open( const QString &path )
+{
+    close();
+
+    file.setFileName( path );
+    if ( !file.open( QIODevice::ReadOnly ) )
+    {
+        kDebug() << "local error: couldn't open traffic log" << path;
+        return false;
+    }
+
+    stream.setDevice( &file );
+    stream.setVersion( QDataStream::Qt_5_0 );
+    stream.resetStatus();
+
+    quint32 magic = 0;
+    quint16 version = 0;
+    stream >> magic >> version >> exchange >> start_time_ms;
+
+    if ( stream.status() != QDataStream::Ok ||
+         magic != TrafficLogWriter::magic ||
+         version != TrafficLogWriter::version )
+    {
+        kDebug() << "local error: bad traffic log header" << path;
+        file.close();
+        return false;
+    }
+
+    return true;
+}
+
+bool TrafficLogReader::readNext( TrafficRecord &record )
+{
+    if ( !file.isOpen() || stream.atEnd() )
+        return false;
+
+    quint8 kind = TRAFFIC_RECORD_KIND_COUNT;
+    quint32 offset_ms = 0;
+    stream >> kind >> offset_ms;
+
+    record = TrafficRecord();
+    record.kind = kind;
+    record.time_ms = start_time_ms + offset_ms;
+
+    if ( kind == TrafficRequest )
+        stream >> record.id >> record.api_command >> record.body >> record.url;
+    else if ( kind == TrafficReply )
+        stream >> record.id >> record.data;
+    else if ( kind == TrafficWssFrame )
+        stream >> record.data;
+    else
+    {
+        kDebug() << "local error: unknown traffic record kind" << kind;
+        return false;
+    }
+
+    // a capture that was cut off mid-record ends here
+    return stream.status() == QDataStream::Ok;
+}
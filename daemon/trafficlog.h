@@ -0,0 +1,100 @@
+#ifndef TRAFFICLOG_H
+#define TRAFFICLOG_H
+
+#include <QtGlobal>
+#include <QString>
+#include <QByteArray>
+#include <QFile>
+#include <QDataStream>
+
+class QJsonObject;
+
+enum TrafficRecordKind : quint8
+{
+    TrafficRequest = 0, // request sent, keyed by id
+    TrafficReply, // reply body for the request with the same id
+    TrafficWssFrame, // websocket text frame
+    TRAFFIC_RECORD_KIND_COUNT
+};
+
+struct TrafficRecord
+{
+    quint8 kind{ TRAFFIC_RECORD_KIND_COUNT };
+    qint64 time_ms{ 0 };
+    quint64 id{ 0 };
+    QByteArray api_command; // request only
+    QByteArray body; // request only
+    QByteArray url; // request only
+    QByteArray data; // reply body or wss frame
+};
+
+//
+// TrafficLogWriter, captures exchange traffic to a compact binary log
+//
+// the file starts with a header that holds the exchange name and the capture start time, then one record per
+// event. records store their time as a millisecond offset from the start, and only the fields of their kind.
+// replies reference their request by id (the request queue sequence), so the api command and body aren't repeated.
+//
+class TrafficLogWriter
+{
+public:
+    explicit TrafficLogWriter() {}
+    ~TrafficLogWriter() { close(); }
+
+    bool open( const QString &path, const QString &exchange, const qint64 start_time_ms );
+    void close();
+    bool isOpen() const { return file.isOpen(); }
+
+    void recordRequest( const quint64 id, const QString &api_command, const QString &body, const QString &url, const qint64 time_ms ); // redacts body and url
+    void recordReply( const quint64 id, const QByteArray &data, const qint64 time_ms );
+    void recordWssFrame( const QString &msg, const qint64 time_ms );
+
+    QString getPath() const { return file.fileName(); }
+    quint64 getRecordCount() const { return record_count; }
+    qint64 getSize() const { return file.size(); }
+
+    // drop credentials, signatures and the fields they sign over time (apikey, signature, timestamp, listenKey, nonce,
+    // proofs) from a url's query, a form body or a json body, so a capture never holds anything that authenticates
+    static QString redactUrl( const QString &url );
+    static QString redactBody( const QString &body );
+
+    static const quint32 magic = 0x54524350; // "TRCP"
+    static const quint16 version = 1;
+
+private:
+    void writeHeader( const quint8 kind, const qint64 time_ms );
+
+    static bool isRedactedField( const QString &key );
+    static QString redactQuery( const QString &query );
+    static void redactJson( QJsonObject &obj );
+
+    QFile file;
+    QDataStream stream;
+    qint64 start_time_ms{ 0 };
+    quint64 record_count{ 0 };
+};
+
+//
+// TrafficLogReader, reads records back from a log written by TrafficLogWriter
+//
+class TrafficLogReader
+{
+public:
+    explicit TrafficLogReader() {}
+
+    bool open( const QString &path );
+    void close() { file.close(); }
+
+    bool readNext( TrafficRecord &record ); // false at the end of the log or on a truncated record
+
+    const QString &getExchange() const { return exchange; }
+    qint64 getStartTime() const { return start_time_ms; }
+
+private:
+    QFile file;
+    QDataStream stream;
+    QString exchange;
+    qint64 start_time_ms{ 0 };
+};
+
+#endif // TRAFFICLOG_H
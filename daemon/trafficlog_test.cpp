@@ -0,0 +1,113 @@
+#include "trafficlog_test.h"
+#include "trafficlog.h"
+
+#include <assert.h>
+
+#include <QDir>
+#include <QFile>
+
+void TrafficLogTest::test()
+{
+    const QString path = QDir::tempPath() + QDir::separator() + "trader_trafficlog_test.bin";
+    const qint64 start_time = 1600000000000;
+
+    /// test records round trip
+    TrafficLogWriter writer;
+    assert( writer.open( path, "Binance", start_time ) );
+    assert( writer.isOpen() );
+
+    writer.recordRequest( 7, "sign-post-order", "symbol=ETHBTC&side=BUY", "https://api.binance.com/api/v3/order", start_time + 5 );
+    writer.recordWssFrame( QString::fromUtf8( "{\"stream\":\"ethbtc@bookTicker\",\"data\":{\"b\":\"0.03\"}}" ), start_time + 10 );
+    writer.recordReply( 7, QByteArray( "{\"orderId\":1}" ), start_time + 60 );
+    writer.recordReply( 8, QByteArray(), start_time - 100 ); // clamped to the start
+    assert( writer.getRecordCount() == 4 );
+    writer.close();
+    assert( !writer.isOpen() );
+
+    // closed writers ignore records
+    writer.recordWssFrame( "ignored", start_time );
+    assert( writer.getRecordCount() == 4 );
+
+    TrafficLogReader reader;
+    assert( reader.open( path ) );
+    assert( reader.getExchange() == "Binance" );
+    assert( reader.getStartTime() == start_time );
+
+    TrafficRecord record;
+    assert( reader.readNext( record ) );
+    assert( record.kind == TrafficRequest );
+    assert( record.id == 7 );
+    assert( record.time_ms == start_time + 5 );
+    assert( record.api_command == "sign-post-order" );
+    assert( record.body == "symbol=ETHBTC&side=BUY" );
+    assert( record.url == "https://api.binance.com/api/v3/order" );
+    assert( record.data.isEmpty() );
+
+    assert( reader.readNext( record ) );
+    assert( record.kind == TrafficWssFrame );
+    assert( record.time_ms == start_time + 10 );
+    assert( record.data == "{\"stream\":\"ethbtc@bookTicker\",\"data\":{\"b\":\"0.03\"}}" );
+    assert( record.api_command.isEmpty() );
+
+    assert( reader.readNext( record ) );
+    assert( record.kind == TrafficReply );
+    assert( record.id == 7 );
+    assert( record.time_ms == start_time + 60 );
+    assert( record.data == "{\"orderId\":1}" );
+
+    assert( reader.readNext( record ) );
+    assert( record.kind == TrafficReply );
+    assert( record.id == 8 );
+    assert( record.time_ms == start_time );
+
+    assert( !reader.readNext( record ) );
+    reader.close();
+
+    /// test a truncated capture stops at the last whole record
+    QFile file( path );
+    assert( file.open( QIODevice::ReadWrite ) );
+    assert( file.resize( file.size() - 3 ) );
+    file.close();
+
+    assert( reader.open( path ) );
+    assert( reader.readNext( record ) );
+    assert( reader.readNext( record ) );
+    assert( reader.readNext( record ) );
+    assert( !reader.readNext( record ) );
+    reader.close();
+
+    /// test a file that isn't a capture is rejected
+    assert( file.open( QIODevice::WriteOnly | QIODevice::Truncate ) );
+    file.write( "not a capture" );
+    file.close();
+
+    assert( !reader.open( path ) );
+
+    /// test captured requests carry no keys or signatures
+    TrafficLogWriter redacted_writer;
+    assert( redacted_writer.open( path, "Bittrex", start_time ) );
+    redacted_writer.recordRequest( 1, "getbalances", "", "https://bittrex.com/api/v1.1/account/getbalances?apikey=KEY123&nonce=42", start_time );
+    redacted_writer.recordRequest( 2, "sign-post-order", "symbol=ETHBTC&side=BUY&timestamp=1600000000000&signature=SIG123", "https://api.binance.com/api/v3/order?listenKey=LISTEN123&symbol=ETHBTC", start_time );
+    redacted_writer.recordRequest( 3, "matcher-post-order", "{\"amount\":100,\"timestamp\":1600000000000,\"signature\":\"SIG456\",\"proofs\":[\"PROOF789\"]}", "https://matcher.waves.exchange/matcher/orderbook", start_time );
+    redacted_writer.close();
+
+    assert( reader.open( path ) );
+
+    assert( reader.readNext( record ) );
+    assert( record.url == "https://bittrex.com/api/v1.1/account/getbalances" );
+    assert( !record.url.contains( "KEY123" ) && !record.url.contains( "nonce" ) );
+
+    assert( reader.readNext( record ) );
+    assert( record.url == "https://api.binance.com/api/v3/order?symbol=ETHBTC" );
+    assert( record.body == "symbol=ETHBTC&side=BUY" );
+    assert( !record.url.contains( "LISTEN123" ) && !record.body.contains( "SIG123" ) && !record.body.contains( "timestamp" ) );
+
+    assert( reader.readNext( record ) );
+    assert( record.body == "{\"amount\":100}" );
+    assert( !record.body.contains( "SIG456" ) && !record.body.contains( "PROOF789" ) );
+
+    assert( !reader.readNext( record ) );
+    reader.close();
+
+    QFile::remove( path );
+}
@@ -0,0 +1,9 @@
+#ifndef TRAFFICLOG_TEST_H
+#define TRAFFICLOG_TEST_H
+
+struct TrafficLogTest
+{
+    void test();
+};
+
+#endif // TRAFFICLOG_TEST_H
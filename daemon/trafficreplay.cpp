@@ -0,0 +1,243 @@
+#include "trafficreplay.h"
+#include "baserest.h"
+#include "simexchange.h"
+#include "misctypes.h"
+#include "global.h"
+
+#include <ctime>
+
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QNetworkRequest>
+#include <QUrl>
+
+namespace
+{
+
+static const int TRAFFIC_REPLAY_BATCH = 256; // records per event loop pass when replaying as fast as possible
+
+static inline qint64 getProcessCpuNs()
+{
+    return qint64( double( std::clock() ) * 1e9 / CLOCKS_PER_SEC );
+}
+
+} // namespace
+
+TrafficReplay::TrafficReplay( BaseREST *_rest, QObject *parent )
+    : QObject( parent ),
+      rest( _rest )
+{
+    replay_timer = new QTimer( this );
+    replay_timer->setSingleShot( true );
+    replay_timer->setTimerType( Qt::PreciseTimer );
+    connect( replay_timer, &QTimer::timeout, this, &TrafficReplay::onReplayTimer );
+}
+
+TrafficReplay::~TrafficReplay()
+{
+    stop();
+}
+
+bool TrafficReplay::start( const QString &path, const qreal _speed )
+{
+    if ( running )
+    {
+        kDebug() << "[Replay] local error: a replay is already running";
+        return false;
+    }
+
+    if ( !reader.open( path ) )
+        return false;
+
+    if ( reader.getExchange() != rest->getExchangeStr() )
+        kDebug() << "[Replay] local warning: replaying" << reader.getExchange() << "traffic into" << rest->getExchangeStr();
+
+    speed = qMax( _speed, 0. );
+    pending_requests.clear();
+    counters.clear();
+    records_read = 0;
+    replies_unmatched = 0;
+
+    has_next = reader.readNext( next_record );
+    running = true;
+
+    replay_start_ms = QDateTime::currentMSecsSinceEpoch();
+    cpu_start_ns = getProcessCpuNs();
+
+    kDebug() << "[Replay] replaying" << path << "into" << rest->getExchangeStr()
+             << ( speed > 0. ? QString( "at %1x speed" ).arg( speed ) : QString( "as fast as possible" ) );
+
+    replay_timer->start( 0 );
+    return true;
+}
+
+void TrafficReplay::stop()
+{
+    if ( !running )
+        return;
+
+    replay_timer->stop();
+    finish();
+}
+
+QStringList TrafficReplay::getReport() const
+{
+    QStringList ret;
+
+    quint64 messages = 0;
+    for ( QMap<QString, TrafficReplayCounter>::const_iterator i = counters.begin(); i != counters.end(); i++ )
+        messages += i.value().count;
+
+    const qint64 end_ms = running ? QDateTime::currentMSecsSinceEpoch() : replay_end_ms;
+    const qint64 cpu_ns = ( running ? getProcessCpuNs() : cpu_end_ns ) - cpu_start_ns;
+    const qreal wall_secs = qMax( ( end_ms - replay_start_ms ) / 1000., 0.001 );
+
+    ret += QString( "[Replay] %1 messages (%2 records, %3 unmatched replies) in %4s, process cpu %5ms, %6ns cpu/msg" )
+           .arg( messages )
+           .arg( records_read )
+           .arg( replies_unmatched )
+           .arg( wall_secs, 0, 'f', 3 )
+           .arg( cpu_ns / 1000000 )
+           .arg( messages == 0 ? 0 : cpu_ns / qint64( messages ) );
+
+    for ( QMap<QString, TrafficReplayCounter>::const_iterator i = counters.begin(); i != counters.end(); i++ )
+    {
+        const TrafficReplayCounter &counter = i.value();
+
+        ret += LatencyStats::formatLine( QString( "[Replay] handler %1" ).arg( i.key() ), counter.handler, counter.count / wall_secs ) +
+               QString( " mean: %1ns" ).arg( counter.count == 0 ? 0 : counter.total_ns / qint64( counter.count ) );
+    }
+
+    return ret;
+}
+
+void TrafficReplay::onReplayTimer()
+{
+    // keys were set or positions were added since the last batch
+    if ( !rest->isReplaySafe() )
+    {
+        kDebug() << "[Replay] local error: stopping, the exchange has keys or positions now";
+        finish();
+        return;
+    }
+
+    qint32 dispatched = 0;
+
+    while ( has_next )
+    {
+        if ( speed > 0. )
+        {
+            // wait for the record's turn at the recorded pace
+            const qint64 due_ms = replay_start_ms + qint64( ( next_record.time_ms - reader.getStartTime() ) / speed );
+            const qint64 wait_ms = due_ms - QDateTime::currentMSecsSinceEpoch();
+
+            if ( wait_ms > 0 )
+            {
+                replay_timer->start( wait_ms );
+                return;
+            }
+        }
+        else if ( dispatched >= TRAFFIC_REPLAY_BATCH )
+        {
+            // let deleteLater() and the other timers run between batches
+            replay_timer->start( 0 );
+            return;
+        }
+
+        dispatch( next_record );
+        dispatched++;
+
+        has_next = reader.readNext( next_record );
+    }
+
+    finish();
+}
+
+void TrafficReplay::dispatch( const TrafficRecord &record )
+{
+    records_read++;
+
+    if ( record.kind == TrafficRequest )
+        pending_requests.insert( record.id, record );
+    else if ( record.kind == TrafficReply )
+        dispatchReply( record );
+    else if ( record.kind == TrafficWssFrame )
+        dispatchWssFrame( record );
+}
+
+void TrafficReplay::dispatchReply( const TrafficRecord &record )
+{
+    // the request timed out before the capture started, or the capture missed it
+    if ( !pending_requests.contains( record.id ) )
+    {
+        replies_unmatched++;
+        return;
+    }
+
+    const TrafficRecord request_record = pending_requests.take( record.id );
+    const qint64 current_time = QDateTime::currentMSecsSinceEpoch();
+
+    // rebuild the request, keep the recorded response time so the latency stats look like the real thing
+    Request *request = new Request();
+    request->api_command = QString::fromUtf8( request_record.api_command );
+    request->body = QString::fromUtf8( request_record.body );
+    request->time_sent_ms = current_time - ( record.time_ms - request_record.time_ms );
+    request->queue_sequence = record.id;
+
+    SimReply *reply = new SimReply( QNetworkAccessManager::GetOperation, QNetworkRequest( QUrl( QString::fromUtf8( request_record.url ) ) ) );
+    reply->setResponse( 200, record.data );
+    reply->deliver();
+
+    rest->nam_queue_sent.insert( reply, request );
+
+    // the handler deletes the request
+    const QString label = request->api_command.isEmpty() ? QString( "unknown" ) : request->api_command;
+
+    QElapsedTimer handler_timer;
+    handler_timer.start();
+
+    rest->onNamReply( reply );
+
+    const qint64 elapsed_ns = handler_timer.nsecsElapsed();
+
+    TrafficReplayCounter &counter = counters[ label ];
+    counter.count++;
+    counter.total_ns += elapsed_ns;
+    counter.handler.record( elapsed_ns / 1000 );
+}
+
+void TrafficReplay::dispatchWssFrame( const TrafficRecord &record )
+{
+    // the websocket hands us a QString, convert outside of the timing like it does
+    const QString msg = QString::fromUtf8( record.data );
+
+    QElapsedTimer handler_timer;
+    handler_timer.start();
+
+    rest->wssTextMessageReceived( msg );
+
+    const qint64 elapsed_ns = handler_timer.nsecsElapsed();
+
+    TrafficReplayCounter &counter = counters[ "wss" ];
+    counter.count++;
+    counter.total_ns += elapsed_ns;
+    counter.handler.record( elapsed_ns / 1000 );
+}
+
+void TrafficReplay::finish()
+{
+    running = false;
+    has_next = false;
+    reader.close();
+    pending_requests.clear();
+
+    replay_end_ms = QDateTime::currentMSecsSinceEpoch();
+    cpu_end_ns = getProcessCpuNs();
+
+    const QStringList report = getReport();
+
+    for ( QStringList::const_iterator i = report.begin(); i != report.end(); i++ )
+        kDebug() << *i;
+
+    emit finished();
+}
@@ -0,0 +1,83 @@
+#ifndef TRAFFICREPLAY_H
+#define TRAFFICREPLAY_H
+
+#include "trafficlog.h"
+#include "latencystats.h"
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QMap>
+
+struct BaseREST;
+class QTimer;
+
+struct TrafficReplayCounter
+{
+    quint64 count{ 0 };
+    qint64 total_ns{ 0 };
+    LatencyHistogram handler; // time spent in the handler per message, microseconds
+};
+
+//
+// TrafficReplay, feeds a captured session back through the exchange handlers for offline profiling
+//
+// replies are handed to onNamReply() with a canned reply object and a request rebuilt from the capture, and wss
+// frames go to wssTextMessageReceived(), so the real parsers and order management run on production traffic.
+// with a speed of 0 records are replayed as fast as possible in batches, yielding to the event loop in between
+// so deferred work still runs, otherwise at the recorded pace multiplied by speed.
+//
+// because the live handlers and engine are used, a replay only runs in a simulator build or on an exchange with no
+// keys and no positions (see BaseREST::isReplaySafe()), and it stops if that changes.
+//
+// the report has the time spent in each handler per api command, and the process cpu time per message over the
+// whole replay, which includes the deferred work.
+//
+class TrafficReplay : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit TrafficReplay( BaseREST *_rest, QObject *parent = nullptr );
+    ~TrafficReplay();
+
+    bool start( const QString &path, const qreal _speed );
+    void stop();
+    bool isRunning() const { return running; }
+
+    QStringList getReport() const;
+
+signals:
+    void finished();
+
+private slots:
+    void onReplayTimer();
+
+private:
+    void dispatch( const TrafficRecord &record );
+    void dispatchReply( const TrafficRecord &record );
+    void dispatchWssFrame( const TrafficRecord &record );
+    void finish();
+
+    BaseREST *rest{ nullptr };
+    QTimer *replay_timer{ nullptr };
+
+    TrafficLogReader reader;
+    TrafficRecord next_record;
+    bool has_next{ false };
+    bool running{ false };
+    qreal speed{ 0. };
+
+    QHash<quint64, TrafficRecord> pending_requests; // requests waiting for their reply
+    QMap<QString, TrafficReplayCounter> counters; // by api command, "wss" for frames
+    quint64 records_read{ 0 };
+    quint64 replies_unmatched{ 0 };
+
+    qint64 replay_start_ms{ 0 };
+    qint64 replay_end_ms{ 0 };
+    qint64 cpu_start_ns{ 0 };
+    qint64 cpu_end_ns{ 0 };
+};
+
+#endif // TRAFFICREPLAY_H
@@ -42,9 +42,11 @@ void TrexREST::init()
 {
     BaseREST::market_cancel_thresh = 300; // limit for market order total for weighting cancels to be sent first
 
-    // we use this to send the requests at a predictable rate
-    connect( send_timer, &QTimer::timeout, this, &TrexREST::sendNamQueue );
-    send_timer->start( BITTREX_TIMER_INTERVAL_NAM_SEND ); // minimum threshold 200 or so
+    // send requests as soon as we have tokens, at up to 3 per second
+    BaseREST::send_idle_interval = BITTREX_TIMER_INTERVAL_NAM_SEND;
+    initRateLimits( 1000. / BITTREX_TIMER_INTERVAL_NAM_SEND, 2. );
+    initSession( QStringList() << TREX_REST_URL, true );
+    scheduleSend();
 
     connect( ticker_timer, &QTimer::timeout, this, &TrexREST::onCheckTicker );
     ticker_timer->start( BITTREX_TIMER_INTERVAL_TICKER );
@@ -91,82 +93,104 @@ void TrexREST::sendNamQueue()
     if ( nam_queue.isEmpty() )
         return;
 
-    QMultiMap<Coin/*weight*/,Request*> sorted_nam_queue;
-
-    // insert into auto sorted map sorted by weight
-    for ( QQueue<Request*>::const_iterator i = nam_queue.begin(); i != nam_queue.end(); i++ )
+    // if the orderbook is stale, we can assume the server is down and we let the orders timeout
+    // only poll the order history until the orderbook is responded to
+    if ( yieldToLag() )
     {
-        Request *const &request = *i;
-        Position *const &pos = request->pos;
+        const QVector<Request*> lag_requests = nam_queue.getByCommand( TREX_COMMAND_GET_ORDER_HIST );
 
-        // check for valid pos
-        if ( pos == nullptr || !engine->getPositionMan()->isValid( pos ) )
+        for ( QVector<Request*>::const_iterator i = lag_requests.begin(); i != lag_requests.end(); i++ )
         {
-            sorted_nam_queue.insert( Coin(), request );
-            continue;
-        }
+            if ( dropStaleRequest( *i ) )
+                continue;
 
-        // check if we should prioritize cancel
-        if ( request->api_command == TREX_COMMAND_CANCEL &&
-             engine->getPositionMan()->getMarketOrderTotal( pos->market ) >= market_cancel_thresh )
-        {
-            // expedite the cancel
-            sorted_nam_queue.insert( CoinAmount::COIN, request );
-            continue;
-        }
+            if ( !takeRateTokens( *i ) )
+                break;
 
-        if ( request->api_command == TREX_COMMAND_GET_ORDER_HIST )
-        {
-            sorted_nam_queue.insert( CoinAmount::SATOSHI, request );
-            continue;
-        }
+            sendNamRequest( *i );
 
-        // new hi/lo buy or sell, we should value this at 0 because it's not a reactive order
-        if ( pos->is_new_hilo_order )
-        {
-            sorted_nam_queue.insert( Coin(), request );
-            continue;
-        }
-
-        // check for not buy/sell command
-        if ( request->api_command != TREX_COMMAND_BUY &&
-             request->api_command != TREX_COMMAND_SELL )
-        {
-            sorted_nam_queue.insert( Coin(), request );
-            continue;
+            if ( yieldToFlowControlSent() )
+                return;
         }
 
-        sorted_nam_queue.insert( pos->per_trade_profit, request );
+        return;
     }
 
-    // go through orders, ranked from highest weight to lowest
-    for ( QMultiMap<Coin,Request*>::const_iterator i = sorted_nam_queue.end() -1; i != sorted_nam_queue.begin() -1; i-- )
+    // send everything we have tokens for, highest weight first within each class (cancels, orders, polling)
+    for ( int i = 0; i < RATE_CLASS_COUNT; i++ )
     {
-        Request *const &request = i.value();
+        const RateClass rate_class = RateClass( i );
+        Request *request;
 
-        // check if we received the orderbook in the timeframe of an order timeout grace period
-        // if it's stale, we can assume the server is down and we let the orders timeout
-        if ( yieldToLag() && request->api_command != TREX_COMMAND_GET_ORDER_HIST )
+        while ( ( request = nam_queue.top( rate_class ) ) != nullptr )
         {
-            // let this request hang around until the orderbook is responded to
-            continue;
-        }
+            // the position is gone, drop it before it costs tokens
+            if ( dropStaleRequest( request ) )
+                continue;
 
-        sendNamRequest( request );
-        // the request is added to sent_nam_queue and thus not deleted until the response is met
-        return;
+            if ( !takeRateTokens( request ) )
+                break;
+
+            sendNamRequest( request );
+            // the request is added to sent_nam_queue and thus not deleted until the response is met
+
+            if ( yieldToFlowControlSent() )
+                return;
+
+            // the request couldn't be sent, try again next time
+            if ( nam_queue.contains( request ) )
+                break;
+        }
     }
 }
 
+Coin TrexREST::getRequestPriority( Request *const &request ) const
+{
+    Position *const &pos = request->pos;
+
+    // check for valid pos
+    if ( pos == nullptr || !engine->getPositionMan()->isValid( request->pos_handle ) )
+        return Coin();
+
+    // check if we should prioritize cancel
+    if ( request->api_command == TREX_COMMAND_CANCEL &&
+         engine->getPositionMan()->getMarketOrderTotal( pos->market ) >= market_cancel_thresh )
+        return CoinAmount::COIN; // expedite the cancel
+
+    if ( request->api_command == TREX_COMMAND_GET_ORDER_HIST )
+        return CoinAmount::SATOSHI;
+
+    // new hi/lo buy or sell, we should value this at 0 because it's not a reactive order
+    if ( pos->is_new_hilo_order )
+        return Coin();
+
+    // check for not buy/sell command
+    if ( request->api_command != TREX_COMMAND_BUY &&
+         request->api_command != TREX_COMMAND_SELL )
+        return Coin();
+
+    return pos->per_trade_profit;
+}
+
+RateClass TrexREST::getRateClass( Request *const &request ) const
+{
+    const QString &api_command = request->api_command;
+
+    if ( api_command == TREX_COMMAND_CANCEL )
+        return RateCancel;
+    else if ( api_command == TREX_COMMAND_BUY || api_command == TREX_COMMAND_SELL )
+        return RateOrder;
+    else if ( api_command.startsWith( "public/" ) )
+        return RatePublic;
+
+    return RateQuery;
+}
+
 void TrexREST::sendNamRequest( Request *const &request )
 {
     // check for valid pos
-    if ( request->pos != nullptr && !engine->getPositionMan()->isValid( request->pos ) )
-    {
-        kDebug() << getExchangeFancyStr() << "local warning: caught nam request with invalid position";
-        nam_queue.removeOne( request );
+    if ( dropStaleRequest( request ) )
         return;
-    }
 
     const qint64 current_time = QDateTime::currentMSecsSinceEpoch();
     const QString &api_command = request->api_command;
@@ -205,10 +229,11 @@ void TrexREST::sendNamRequest( Request *const &request )
 
     QNetworkRequest nam_request;
     nam_request.setUrl( url );
+    session->prepareRequest( nam_request );
 
     // add auth header
     if ( !keystore.isKeyOrSecretEmpty() )
-        nam_request.setRawHeader( TREX_APISIGN, Global::getBittrexPoloSignature( nam_request.url().toString().toLocal8Bit(), keystore.getSecret() ) );
+        nam_request.setRawHeader( TREX_APISIGN, keystore.getSignature( nam_request.url().toString().toLocal8Bit(), QCryptographicHash::Sha512 ).toHex() );
 
     // send REST message
     QNetworkReply *const &reply = nam->get( nam_request );
@@ -219,7 +244,7 @@ void TrexREST::sendNamRequest( Request *const &request )
         return;
     }
 
-    nam_queue_sent.insert( reply, request );
+    trackSentRequest( reply, request );
     nam_queue.removeOne( request );
     last_request_sent_ms = current_time;
 }
@@ -269,6 +294,34 @@ void TrexREST::onNamReply( QNetworkReply *const &reply )
     QString path = reply->url().path();
     QByteArray data = reply->readAll();
 
+    Request *const &request = nam_queue_sent.take( reply );
+    const QString &api_command = request->api_command;
+    onReplyReceived( request, data );
+
+    // the hot replies are decoded on their own, large ones on the parser thread. replies that don't decode fall
+    // through to the error handling below.
+    if ( api_command == TREX_COMMAND_GET_ORDERS || api_command == TREX_COMMAND_GET_MARKET_SUMS )
+    {
+        const ReplyDecoder decoder = ( api_command == TREX_COMMAND_GET_ORDERS ) ? &TrexREST::decodeOpenOrders :
+                                                                                  &TrexREST::decodeOrderBook;
+        bool handled = queueReplyParse( request, data, decoder );
+
+        if ( !handled )
+        {
+            const ParsedReply parsed = ReplyParser::decode( decoder, api_command, request->time_sent_ms, data );
+            handled = parsed.ok;
+
+            if ( handled )
+                onReplyParsed( parsed );
+        }
+
+        if ( handled )
+        {
+            deleteReply( reply, request );
+            return;
+        }
+    }
+
     // parse any possible json in the body
     QJsonDocument body_json = QJsonDocument::fromJson( data );
     QJsonObject body_obj = body_json.object();
@@ -287,12 +340,6 @@ void TrexREST::onNamReply( QNetworkReply *const &reply )
     else if ( is_object )
         result_obj = result_value.toObject();
 
-    Request *const &request = nam_queue_sent.take( reply );
-    const QString &api_command = request->api_command;
-    const qint64 response_time = QDateTime::currentMSecsSinceEpoch() - request->time_sent_ms;
-
-    avg_response_time.addResponseTime( response_time );
-
     // handle success=false
     if ( !success )
     {
@@ -409,14 +456,6 @@ void TrexREST::onNamReply( QNetworkReply *const &reply )
     {
         parseOrderHistory( body_obj );
     }
-    else if ( api_command == TREX_COMMAND_GET_ORDERS ) // getorder-fill
-    {
-        parseOpenOrders( result_arr, request->time_sent_ms );
-    }
-    else if ( api_command == TREX_COMMAND_GET_MARKET_SUMS ) // ticker-fill
-    {
-        parseOrderBook( result_arr, request->time_sent_ms );
-    }
     else if ( api_command == TREX_COMMAND_SELL || api_command == TREX_COMMAND_BUY )
     {
         parseBuySell( request, result_obj );
@@ -550,28 +589,16 @@ void TrexREST::parseCancelOrder( Request *const &request, const QJsonObject &res
     engine->processCancelledOrder( pos );
 }
 
-void TrexREST::parseOpenOrders( const QJsonArray &orders, qint64 request_time_sent_ms )
+bool TrexREST::decodeOpenOrders( const QByteArray &data, ParsedReply &out )
 {
-    const qint64 current_time = QDateTime::currentMSecsSinceEpoch(); // cache time
-
-    // is the orderbook is too old to be safe? check the stale tolerance
-    if ( request_time_sent_ms < current_time - orderbook_stale_tolerance )
-    {
-        orders_stale_trip_count++;
-        return;
-    }
-
-    // don't accept responses for requests sooner than the latest response request_time_sent_ms
-    if ( request_time_sent_ms < orderbook_update_request_time )
-        return;
+    const QJsonObject body_obj = QJsonDocument::fromJson( data ).object();
 
-    // set the timestamp of orderbook update if we saw any orders
-    orderbook_update_time = current_time;
-    orderbook_update_request_time = request_time_sent_ms;
+    // let the caller handle errors
+    if ( !body_obj[ "success" ].toBool() )
+        return false;
 
     // parse array of objects
-    QVector<QString> order_numbers; // keep track of order numbers
-    QMultiHash<QString, OrderInfo> order_map; // store map of order numbers/orderinfo
+    const QJsonArray orders = body_obj[ "result" ].toArray();
 
     for ( QJsonArray::const_iterator i = orders.begin(); i != orders.end(); ++i )
     {
@@ -591,9 +618,6 @@ void TrexREST::parseOpenOrders( const QJsonArray &orders, qint64 request_time_se
         const Coin quantity = order.value( "Quantity" ).toDouble();
         const Coin amount = quantity * price;
 
-        //kDebug() << order;
-        //kDebug() << market << side << amount << "@" << price << order_number;
-
         // check for missing information
         if ( market.isEmpty() ||
              order_number.isEmpty() ||
@@ -601,11 +625,54 @@ void TrexREST::parseOpenOrders( const QJsonArray &orders, qint64 request_time_se
              amount.isZeroOrLess() ) // only check amount: if price or quantity is 0, amount is also 0
             continue;
 
+        ParsedOrder parsed_order;
+        parsed_order.market = market;
+        parsed_order.order_number = order_number;
+        parsed_order.side = side;
+        parsed_order.price = price;
+        parsed_order.amount = amount;
+
+        out.orders += parsed_order;
+    }
+
+    return true;
+}
+
+void TrexREST::applyOpenOrders( const ParsedReply &reply )
+{
+    const qint64 current_time = QDateTime::currentMSecsSinceEpoch(); // cache time
+    const qint64 &request_time_sent_ms = reply.request_time_sent_ms;
+
+    // is the orderbook is too old to be safe? check the stale tolerance
+    if ( request_time_sent_ms < current_time - orderbook_stale_tolerance )
+    {
+        orders_stale_trip_count++;
+        return;
+    }
+
+    // don't accept responses for requests sooner than the latest response request_time_sent_ms
+    if ( request_time_sent_ms < orderbook_update_request_time )
+        return;
+
+    // set the timestamp of orderbook update if we saw any orders
+    orderbook_update_time = current_time;
+    orderbook_update_request_time = request_time_sent_ms;
+
+    QVector<QString> order_numbers; // keep track of order numbers
+    QMultiHash<QString, OrderInfo> order_map; // store map of order numbers/orderinfo
+    order_numbers.reserve( reply.orders.size() );
+
+    for ( QVector<ParsedOrder>::const_iterator i = reply.orders.begin(); i != reply.orders.end(); ++i )
+    {
+        const ParsedOrder &order = *i;
+
+        //kDebug() << order.market << order.side << order.amount << "@" << order.price << order.order_number;
+
         // insert into seen orders
-        order_numbers.append( order_number );
+        order_numbers.append( order.order_number );
 
         // insert (market, order)
-        order_map.insert( market, OrderInfo( order_number, side, price, amount ) );
+        order_map.insert( order.market, OrderInfo( order.order_number, order.side, order.price, order.amount ) );
     }
 
     engine->processOpenOrders( order_numbers, order_map, request_time_sent_ms );
@@ -722,30 +789,16 @@ void TrexREST::parseGetOrder( const QJsonObject &order )
     engine->processFilledOrders( QVector<Position*>() << pos, FILL_GETORDER );
 }
 
-void TrexREST::parseOrderBook( const QJsonArray &info, qint64 request_time_sent_ms )
+bool TrexREST::decodeOrderBook( const QByteArray &data, ParsedReply &out )
 {
-    //kDebug() << "order book" << obj;
+    const QJsonObject body_obj = QJsonDocument::fromJson( data ).object();
 
-    // check for data
-    if ( info.isEmpty() )
-        return;
+    // let the caller handle errors
+    if ( !body_obj[ "success" ].toBool() )
+        return false;
 
-    const qint64 current_time = QDateTime::currentMSecsSinceEpoch();
-
-    // is the orderbook is too old to be safe? check the stale tolerance
-    if ( request_time_sent_ms < current_time - orderbook_stale_tolerance )
-    {
-        books_stale_trip_count++;
-        return;
-    }
-
-    // don't accept responses for requests sooner than the latest response request_time_sent_ms
-    if ( request_time_sent_ms < ticker_update_request_time )
-        return;
-
-    ticker_update_request_time = request_time_sent_ms;
-
-    QMap<QString, Spread> ticker_info;
+    const QJsonArray info = body_obj[ "result" ].toArray();
+    out.market_count = info.size();
 
     // iterate through each market object
     for ( QJsonArray::const_iterator i = info.begin(); i != info.end(); i++ )
@@ -755,8 +808,6 @@ void TrexREST::parseOrderBook( const QJsonArray &info, qint64 request_time_sent_
 
         const QJsonObject &info = (*i).toObject();
 
-        //kDebug() << info;
-
         if ( !info.contains( "Ask" ) ||
              !info.contains( "Bid" ) )
             continue;
@@ -765,18 +816,57 @@ void TrexREST::parseOrderBook( const QJsonArray &info, qint64 request_time_sent_
         const Coin ask = info[ "Ask" ].toDouble();
         const Coin bid = info[ "Bid" ].toDouble();
 
-        //kDebug() << market << "bid:" << bid << "ask:" << ask;
-
         // update our maps
         if ( !market.isEmpty() &&
              bid.isGreaterThanZero() &&
              ask.isGreaterThanZero() )
         {
-            ticker_info.insert( market, Spread( bid, ask ) );
+            out.spreads.insert( market, Spread( bid, ask ) );
         }
     }
 
-    engine->processTicker( this, ticker_info, request_time_sent_ms );
+    return true;
+}
+
+void TrexREST::applyOrderBook( const ParsedReply &reply )
+{
+    // check for data
+    if ( reply.market_count == 0 )
+        return;
+
+    const qint64 current_time = QDateTime::currentMSecsSinceEpoch();
+    const qint64 &request_time_sent_ms = reply.request_time_sent_ms;
+
+    // is the orderbook is too old to be safe? check the stale tolerance
+    if ( request_time_sent_ms < current_time - orderbook_stale_tolerance )
+    {
+        books_stale_trip_count++;
+        return;
+    }
+
+    // don't accept responses for requests sooner than the latest response request_time_sent_ms
+    if ( request_time_sent_ms < ticker_update_request_time )
+        return;
+
+    ticker_update_request_time = request_time_sent_ms;
+
+    engine->processTicker( this, reply.spreads, request_time_sent_ms );
+}
+
+void TrexREST::onReplyParsed( const ParsedReply &reply )
+{
+    if ( reply.ok )
+    {
+        if ( reply.api_command == TREX_COMMAND_GET_ORDERS )
+            applyOpenOrders( reply );
+        else if ( reply.api_command == TREX_COMMAND_GET_MARKET_SUMS )
+            applyOrderBook( reply );
+
+        return;
+    }
+
+    // large replies that didn't decode end up here, the hot commands aren't resent
+    printReplyError( reply );
 }
 
 void TrexREST::parseOrderHistory( const QJsonObject &obj )
@@ -34,19 +34,24 @@ public:
     void sendCancel( const QString &order_id, Position *const &pos = nullptr );
     void parseBuySell( Request *const &request, const QJsonObject &response );
     void parseCancelOrder( Request *const &request, const QJsonObject &response );
-    void parseOpenOrders(const QJsonArray &orders, qint64 request_time_sent_ms );
+    static bool decodeOpenOrders( const QByteArray &data, ParsedReply &out );
+    void applyOpenOrders( const ParsedReply &reply );
     void parseReturnBalances( const QJsonArray &balances );
     void parseGetOrder( const QJsonObject &order );
-    void parseOrderBook( const QJsonArray &info, qint64 request_time_sent_ms );
+    static bool decodeOrderBook( const QByteArray &data, ParsedReply &out );
+    void applyOrderBook( const ParsedReply &reply );
     void parseOrderHistory( const QJsonObject &obj );
 
     void wssSendJsonObj( const QJsonObject &obj );
 
     void checkBotOrders( bool ignore_flow_control = false );
+    RateClass getRateClass( Request *const &request ) const override;
+    Coin getRequestPriority( Request *const &request ) const override;
 
 public Q_SLOTS:
-    void sendNamQueue();
-    void onNamReply( QNetworkReply *const &reply );
+    void sendNamQueue() override;
+    void onNamReply( QNetworkReply *const &reply ) override;
+    void onReplyParsed( const ParsedReply &reply ) override;
 
     void onCheckBotOrders();
     void onCheckOrderHistory();
@@ -54,7 +59,7 @@ public Q_SLOTS:
 
     void wssConnected();
     void wssCheckConnection();
-    void wssTextMessageReceived( const QString &msg );
+    void wssTextMessageReceived( const QString &msg ) override;
 
 private:
     qint64 order_history_update_time{ 0 };
@@ -12,6 +12,9 @@
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QDataStream>
+#include <QUrlQuery>
+
+#include <cstring>
 
 WavesAccount::WavesAccount()
 {
@@ -36,6 +39,13 @@ void WavesAccount::setPrivateKey( const QByteArray &new_private_key )
 
     curve25519_keygen( reinterpret_cast<uint8_t*>( public_key.data() ),
                        reinterpret_cast<uint8_t*>( private_key.data() ) );
+
+    // cache the ed25519 pubkey, otherwise each signature derives it again
+    ed_public_key.clear();
+    ed_public_key.resize( 32 );
+
+    curve25519_derive_ed_pubkey( reinterpret_cast<uint8_t*>( ed_public_key.data() ),
+                                 reinterpret_cast<const uint8_t*>( private_key.constData() ) );
 }
 
 void WavesAccount::setPrivateKeyB58( const QByteArray &new_private_key_b58 )
@@ -51,48 +61,49 @@ QByteArray WavesAccount::address( const uint8_t network ) const
         return QByteArray();
     }
 
-    QByteArray pubkey_hash = WavesUtil::hashWaves( public_key );
-    QByteArray addr;
+    uchar pubkey_hash[ WavesUtil::HASH_SIZE ];
+    WavesUtil::hashWaves( public_key.constData(), public_key.size(), pubkey_hash );
 
-    // add entity_type_byte + network_byte + pubkey_hash.left(20)
-    addr.append( uint8_t( 1 ) );
-    addr.append( network );
-    addr.append( pubkey_hash.left( 20 ) );
+    // entity_type_byte + network_byte + pubkey_hash[0..20] + checksum[0..4]
+    char addr_bytes[ 26 ];
+    addr_bytes[ 0 ] = char( 1 );
+    addr_bytes[ 1 ] = char( network );
+    memcpy( addr_bytes + 2, pubkey_hash, 20 );
 
     // reuse pubkey_hash to compute the checksum
-    pubkey_hash = WavesUtil::hashWaves( addr );
-    addr.append( pubkey_hash.left( 4 ) );
+    WavesUtil::hashWaves( addr_bytes, 22, pubkey_hash );
+    memcpy( addr_bytes + 22, pubkey_hash, 4 );
 
-    assert( addr.size() == 26 );
+    const QByteArray addr = QByteArray::fromRawData( addr_bytes, sizeof( addr_bytes ) );
 
     return QBase58::encode( addr );
 }
 
 bool WavesAccount::sign( const QByteArray &message, QByteArray &signature, bool add_random_bytes ) const
 {
-    if ( private_key.size() < 32 )
+    if ( private_key.size() < 32 || ed_public_key.size() < 32 )
     {
         kDebug() << "local error: WavesAccount::sign: private key size <32";
         return false;
     }
 
     // generate random bytes if add_random_bytes is set
-    QByteArray random_bytes;
-    random_bytes.resize( 64 );
+    quint32 random_bytes[ 16 ];
 
     if ( add_random_bytes )
-        QRandomGenerator::global()->generate( random_bytes.begin(), random_bytes.end() );
+        QRandomGenerator::global()->fillRange( random_bytes );
     else
-        random_bytes.fill( 0x00 );
+        memset( random_bytes, 0, sizeof( random_bytes ) );
 
     // assure correct signature buffer size
     signature.resize( 64 );
 
-    const int ret = curve25519_sign( reinterpret_cast<uint8_t*>( signature.data() ),
-                                     reinterpret_cast<const uint8_t*>( private_key.constData() ),
-                                     reinterpret_cast<const uint8_t*>( message.constData() ),
-                                     message.size(),
-                                     reinterpret_cast<const uint8_t*>( random_bytes.constData() ) );
+    const int ret = curve25519_sign_precomputed( reinterpret_cast<uint8_t*>( signature.data() ),
+                                                 reinterpret_cast<const uint8_t*>( private_key.constData() ),
+                                                 reinterpret_cast<const uint8_t*>( ed_public_key.constData() ),
+                                                 reinterpret_cast<const uint8_t*>( message.constData() ),
+                                                 message.size(),
+                                                 reinterpret_cast<const uint8_t*>( random_bytes ) );
 
     return ret == 0;
 }
@@ -150,6 +161,21 @@ void WavesAccount::initAssetMaps()
     // duplicate the above map into reverse access map alias_by_asset
     for ( QMap<QString,QString>::const_iterator i = asset_by_alias.begin(); i != asset_by_alias.end(); i++ )
         alias_by_asset.insert( i.value(), i.key() );
+
+    // decode the asset ids once here, order bodies are built on copies of the account in the signing pool
+    for ( QMap<QString,QString>::const_iterator i = asset_by_alias.begin(); i != asset_by_alias.end(); i++ )
+        if ( !i.key().isEmpty() )
+            asset_bytes_by_alias.insert( i.key(), WavesUtil::getAssetBytes( i.key() ) );
+}
+
+QByteArray WavesAccount::getAssetBytes( const QString &alias ) const
+{
+    QHash<QString,QByteArray>::const_iterator i = asset_bytes_by_alias.find( alias );
+
+    if ( i != asset_bytes_by_alias.end() )
+        return i.value();
+
+    return WavesUtil::getAssetBytes( alias );
 }
 
 QByteArray WavesAccount::createCancelBytes( const QByteArray &order_id_b58 ) const
@@ -194,7 +220,66 @@ QByteArray WavesAccount::createCancelBody( const QByteArray &order_id_b58, bool
     return doc.toJson( QJsonDocument::Compact );
 }
 
+QByteArray WavesAccount::createCancelAllBytes( const qint64 epoch_now ) const
+{
+    QByteArray cancel_all_bytes;
+    cancel_all_bytes += publicKey();
+
+    QDataStream cancel_all_bytes_stream( &cancel_all_bytes, QIODevice::WriteOnly );
+    cancel_all_bytes_stream.device()->seek( cancel_all_bytes.size() );
+    cancel_all_bytes_stream << epoch_now;
+
+    assert( cancel_all_bytes.size() == 40 );
+
+    return cancel_all_bytes;
+}
+
+QByteArray WavesAccount::createCancelAllBody( const qint64 epoch_now, bool random_sign_bytes ) const
+{
+    if ( public_key.size() < 32 )
+    {
+        kDebug() << "local error: WavesAccount::createCancelAllBody: account public key is empty";
+        return QByteArray();
+    }
+
+    const QByteArray cancel_all_bytes = createCancelAllBytes( epoch_now );
+    QByteArray signature;
+    const bool sign_result = sign( cancel_all_bytes, signature, random_sign_bytes );
+
+    assert( sign_result );
+
+    QJsonObject obj;
+    obj[ "sender" ] = QString( publicKeyB58() );
+    obj[ "timestamp" ] = epoch_now;
+    obj[ "signature" ] = QString( QBase58::encode( signature ) );
+
+    // jsonify object
+    QJsonDocument doc;
+    doc.setObject( obj );
+
+    return doc.toJson( QJsonDocument::Compact );
+}
+
+WavesOrderArgs WavesAccount::createOrderArgs( Position * const &pos, const Coin &price_ticksize, const Coin &qty_ticksize, const qint64 epoch_now, const qint64 epoch_expiration ) const
+{
+    WavesOrderArgs args;
+    args.amount_asset = alias_by_asset.value( pos->market.getQuote() );
+    args.price_asset = alias_by_asset.value( pos->market.getBase() );
+    args.side = pos->side;
+    args.price = Coin( CoinAmount::SATOSHI * ( pos->price / price_ticksize ) ).toIntSatoshis();
+    args.amount = Coin( CoinAmount::SATOSHI * ( pos->quantity / qty_ticksize ) ).toIntSatoshis();
+    args.epoch_now = epoch_now;
+    args.epoch_expiration = epoch_expiration;
+
+    return args;
+}
+
 QByteArray WavesAccount::createOrderBytes( Position * const &pos, const Coin &price_ticksize, const Coin &qty_ticksize, const qint64 epoch_now, const qint64 epoch_expiration ) const
+{
+    return createOrderBytes( createOrderArgs( pos, price_ticksize, qty_ticksize, epoch_now, epoch_expiration ) );
+}
+
+QByteArray WavesAccount::createOrderBytes( const WavesOrderArgs &args ) const
 {
     if ( matcher_public_key.size() < 32 ||
          public_key.size() < 32 ||
@@ -208,9 +293,9 @@ QByteArray WavesAccount::createOrderBytes( Position * const &pos, const Coin &pr
     order_v2 += 0x02; // version byte
     order_v2 += publicKey();
     order_v2 += matcher_public_key;
-    order_v2 += WavesUtil::getAssetBytes( alias_by_asset.value( pos->market.getQuote() ) );
-    order_v2 += WavesUtil::getAssetBytes( alias_by_asset.value( pos->market.getBase() ) );
-    order_v2 += pos->side == SIDE_SELL ? WavesUtil::SELL : WavesUtil::BUY;
+    order_v2 += getAssetBytes( args.amount_asset );
+    order_v2 += getAssetBytes( args.price_asset );
+    order_v2 += args.side == SIDE_SELL ? WavesUtil::SELL : WavesUtil::BUY;
 
     // the size is 1 + 32 + 32 + [ 1/33 ] + [ 1/33 ] + 1
     // both assets cannot be size 1 but can be size 33, so the size is now either 100 or 132
@@ -218,10 +303,10 @@ QByteArray WavesAccount::createOrderBytes( Position * const &pos, const Coin &pr
     QDataStream order_v2_stream( &order_v2, QIODevice::WriteOnly );
     order_v2_stream.device()->seek( order_v2.size() );
 
-    order_v2_stream << Coin( CoinAmount::SATOSHI * ( pos->price / price_ticksize ) ).toIntSatoshis(); // price = 1000000
-    order_v2_stream << Coin( CoinAmount::SATOSHI * ( pos->quantity / qty_ticksize ) ).toIntSatoshis(); // amount = 9700000
-    order_v2_stream << epoch_now; // order set time +1 minute
-    order_v2_stream << epoch_expiration; // expiration time
+    order_v2_stream << args.price; // price = 1000000
+    order_v2_stream << args.amount; // amount = 9700000
+    order_v2_stream << args.epoch_now; // order set time +1 minute
+    order_v2_stream << args.epoch_expiration; // expiration time
     order_v2_stream << qint64( 300000 ); // matcher fee = 300000
 
     // make sure the stream only appended 40 more bytes ( size = 100 + 40 or 132 + 40 )
@@ -232,10 +317,18 @@ QByteArray WavesAccount::createOrderBytes( Position * const &pos, const Coin &pr
 
 QByteArray WavesAccount::createOrderId( const QByteArray &order_bytes ) const
 {
-    return QBase58::encode( WavesUtil::hashBlake2b( order_bytes ) );
+    uchar order_hash[ WavesUtil::HASH_SIZE ];
+    WavesUtil::hashBlake2b( order_bytes.constData(), order_bytes.size(), order_hash );
+
+    return QBase58::encode( QByteArray::fromRawData( reinterpret_cast<const char*>( order_hash ), WavesUtil::HASH_SIZE ) );
 }
 
 QByteArray WavesAccount::createOrderBody( Position * const &pos, const Coin &price_ticksize, const Coin &qty_ticksize, const qint64 epoch_now, const qint64 epoch_expiration, bool random_sign_bytes ) const
+{
+    return createOrderBody( createOrderArgs( pos, price_ticksize, qty_ticksize, epoch_now, epoch_expiration ), random_sign_bytes );
+}
+
+QByteArray WavesAccount::createOrderBody( const WavesOrderArgs &args, bool random_sign_bytes ) const
 {
     if ( matcher_public_key.size() < 32 ||
          public_key.size() < 32 ||
@@ -245,7 +338,7 @@ QByteArray WavesAccount::createOrderBody( Position * const &pos, const Coin &pri
         return QByteArray();
     }
 
-    const QByteArray order_bytes_v2 = createOrderBytes( pos, price_ticksize, qty_ticksize, epoch_now, epoch_expiration );
+    const QByteArray order_bytes_v2 = createOrderBytes( args );
     const QByteArray order_id_v2_b58 = createOrderId( order_bytes_v2 );
     QByteArray signature;
 
@@ -253,21 +346,16 @@ QByteArray WavesAccount::createOrderBody( Position * const &pos, const Coin &pri
 
     assert( sign_result );
 
-//    kDebug() << "price ticksize" << price_ticksize;
-//    kDebug() << "  qty ticksize" << qty_ticksize;
-//    kDebug() << "price parts" << Coin( CoinAmount::SATOSHI * ( pos->price / price_ticksize ) ).toIntSatoshis();
-//    kDebug() << "  qty parts" << Coin( CoinAmount::SATOSHI * ( pos->quantity / qty_ticksize ) ).toIntSatoshis();
-
     QJsonObject order_body_v2;
     // put transaction bytes
-    order_body_v2[ "orderType" ] = pos->side == SIDE_BUY ? "buy" : "sell";
+    order_body_v2[ "orderType" ] = args.side == SIDE_BUY ? "buy" : "sell";
     order_body_v2[ "version" ] = 2;
-    order_body_v2[ "assetPair" ] = QJsonObject{ { "amountAsset", alias_by_asset.value( pos->market.getQuote() ) },
-                                                { "priceAsset", alias_by_asset.value( pos->market.getBase() ) } };
-    order_body_v2[ "price" ] = Coin( CoinAmount::SATOSHI * ( pos->price / price_ticksize ) ).toIntSatoshis();
-    order_body_v2[ "amount" ] = Coin( CoinAmount::SATOSHI * ( pos->quantity / qty_ticksize ) ).toIntSatoshis();
-    order_body_v2[ "timestamp" ] = epoch_now;
-    order_body_v2[ "expiration" ] = epoch_expiration;
+    order_body_v2[ "assetPair" ] = QJsonObject{ { "amountAsset", args.amount_asset },
+                                                { "priceAsset", args.price_asset } };
+    order_body_v2[ "price" ] = args.price;
+    order_body_v2[ "amount" ] = args.amount;
+    order_body_v2[ "timestamp" ] = args.epoch_now;
+    order_body_v2[ "expiration" ] = args.epoch_expiration;
     order_body_v2[ "matcherFee" ] = 300000;
     order_body_v2[ "matcherPublicKey" ] = QString( QBase58::encode( matcher_public_key ) );
     order_body_v2[ "senderPublicKey" ] = QString( QBase58::encode( public_key ) );
@@ -283,7 +371,7 @@ QByteArray WavesAccount::createOrderBody( Position * const &pos, const Coin &pri
     return doc.toJson( QJsonDocument::Compact );
 }
 
-QByteArray WavesAccount::createGetOrdersBytes( const qint64 epoch_now )
+QByteArray WavesAccount::createGetOrdersBytes( const qint64 epoch_now ) const
 {
     QByteArray get_orders_bytes;
     get_orders_bytes += publicKey();
@@ -296,3 +384,39 @@ QByteArray WavesAccount::createGetOrdersBytes( const qint64 epoch_now )
 
     return get_orders_bytes;
 }
+
+QByteArray WavesAccount::createTokenBytes( const qint64 expiration_secs, const uint8_t network ) const
+{
+    // custom data prefix, then "<chain id>:<client id>:<expiration>"
+    QByteArray token_bytes = QByteArray::fromHex( "ffffff01" );
+    token_bytes += char( network );
+    token_bytes += ':';
+    token_bytes += WAVES_OAUTH_CLIENT_ID.latin1();
+    token_bytes += ':';
+    token_bytes += QByteArray::number( expiration_secs );
+
+    return token_bytes;
+}
+
+QByteArray WavesAccount::createTokenBody( const qint64 expiration_secs, bool random_sign_bytes ) const
+{
+    if ( public_key.size() < 32 )
+    {
+        kDebug() << "local error: WavesAccount::createTokenBody: account public key is empty";
+        return QByteArray();
+    }
+
+    QByteArray signature;
+    const bool sign_result = sign( createTokenBytes( expiration_secs ), signature, random_sign_bytes );
+
+    assert( sign_result );
+
+    QUrlQuery query;
+    query.addQueryItem( "grant_type", "password" );
+    query.addQueryItem( "scope", "general" );
+    query.addQueryItem( "username", publicKeyB58() );
+    query.addQueryItem( "password", QString( "%1:%2" ).arg( expiration_secs ).arg( QString( QBase58::encode( signature ) ) ) );
+    query.addQueryItem( "client_id", WAVES_OAUTH_CLIENT_ID );
+
+    return query.toString( QUrl::FullyEncoded ).toLocal8Bit();
+}
@@ -5,12 +5,24 @@
 #include "coinamount.h"
 
 #include <QByteArray>
+#include <QHash>
 #include <QMap>
 #include <QStringList>
 
 class Position;
 class WavesREST;
 
+// order fields copied out of a position on the main thread, so the order body can be built on a worker
+struct WavesOrderArgs
+{
+    QString amount_asset, price_asset; // asset aliases
+    quint8 side{ 0 };
+    qint64 price{ 0 }; // in price ticksize parts
+    qint64 amount{ 0 }; // in quantity ticksize parts
+    qint64 epoch_now{ 0 };
+    qint64 epoch_expiration{ 0 };
+};
+
 class WavesAccount
 {
 public:
@@ -39,22 +51,33 @@ public:
     QString getAliasByAsset( const QString &asset ) const { return alias_by_asset.value( asset ); }
     QString getAssetByAlias( const QString &asset ) const { return asset_by_alias.value( asset ); }
     const QStringList &getPriceAssets() const { return price_assets; }
+    QByteArray getAssetBytes( const QString &alias ) const;
 
     QByteArray createCancelBytes( const QByteArray &order_id_b58 ) const;
     QByteArray createCancelBody( const QByteArray &order_id_b58, bool random_sign_bytes = true ) const;
+    QByteArray createCancelAllBytes( const qint64 epoch_now ) const;
+    QByteArray createCancelAllBody( const qint64 epoch_now, bool random_sign_bytes = true ) const;
 
+    WavesOrderArgs createOrderArgs( Position *const &pos, const Coin &price_ticksize, const Coin &qty_ticksize, const qint64 epoch_now, const qint64 epoch_expiration ) const;
     QByteArray createOrderBytes( Position *const &pos, const Coin &price_ticksize, const Coin &qty_ticksize, const qint64 epoch_now, const qint64 epoch_expiration ) const;
+    QByteArray createOrderBytes( const WavesOrderArgs &args ) const;
     QByteArray createOrderId( const QByteArray &order_bytes ) const;
     QByteArray createOrderBody( Position *const &pos, const Coin &price_ticksize, const Coin &qty_ticksize, const qint64 epoch_now, const qint64 epoch_expiration, bool random_sign_bytes = true ) const;
+    QByteArray createOrderBody( const WavesOrderArgs &args, bool random_sign_bytes = true ) const;
+
+    QByteArray createGetOrdersBytes( const qint64 epoch_now ) const;
 
-    QByteArray createGetOrdersBytes( const qint64 epoch_now );
+    QByteArray createTokenBytes( const qint64 expiration_secs, const uint8_t network = MAINNET ) const;
+    QByteArray createTokenBody( const qint64 expiration_secs, bool random_sign_bytes = true ) const;
 
 private:
     QByteArray private_key, public_key, matcher_public_key;
+    QByteArray ed_public_key; // derived from the private key once, for signing
 
     // asset mappings
     QMap<QString,QString> asset_by_alias, alias_by_asset;
     QStringList price_assets;
+    QHash<QString,QByteArray> asset_bytes_by_alias; // decoded once in initAssetMaps(), read-only afterwards
 };
 
 #endif // WAVESACCOUNT_H
@@ -1,8 +1,13 @@
 #include "wavesaccount_test.h"
 #include "wavesaccount.h"
+#include "wavessigner.h"
+#include "wavesutil.h"
 #include "position.h"
 
 #include <QByteArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
 
 void WavesAccountTest::test()
 {
@@ -74,6 +79,11 @@ void WavesAccountTest::test()
     acc.initAssetMaps(); // init asset aliases
     acc.setMatcherPublicKeyB58( "9cpfKN9suPNvfeUNphzxXMjcnn974eme8ZhWUjaktzU5" );
 
+    // cached asset bytes match a fresh decode, unknown aliases still decode
+    assert( acc.getAssetBytes( "WAVES" ) == WavesUtil::getAssetBytes( "WAVES" ) );
+    assert( acc.getAssetBytes( "8LQW8f7P5d5PZM7GtZEBgaqRPGSzS3DfPuiXrURJ4AJS" ) == WavesUtil::getAssetBytes( "8LQW8f7P5d5PZM7GtZEBgaqRPGSzS3DfPuiXrURJ4AJS" ) );
+    assert( acc.getAssetBytes( "Gtb1WRznfchDnTh37ezoDTJ4wcoKaRsKqKjJjy7nm2zU" ) == WavesUtil::getAssetBytes( "Gtb1WRznfchDnTh37ezoDTJ4wcoKaRsKqKjJjy7nm2zU" ) );
+
     Position pos = Position( "BTC_WAVES", SIDE_SELL, "", "0.01000000", "0.00097" );
 
     QByteArray order_bytes_v2 = acc.createOrderBytes( &pos, CoinAmount::SATOSHI, CoinAmount::SATOSHI, quint64( 1580472938469 ), quint64( 1582978538468 ) );
@@ -83,6 +93,17 @@ void WavesAccountTest::test()
     /// test creating order body from the order byes above
     assert( acc.createOrderBody( &pos, CoinAmount::SATOSHI, CoinAmount::SATOSHI, quint64( 1580472938469 ), quint64( 1582978538468 ) , false ) == "{\"amount\":9700000,\"assetPair\":{\"amountAsset\":\"WAVES\",\"priceAsset\":\"8LQW8f7P5d5PZM7GtZEBgaqRPGSzS3DfPuiXrURJ4AJS\"},\"expiration\":1582978538468,\"id\":\"DH2Uyfdoj2pj1t1EEbLPYJMVRcWYqw6kBgQkVZjNiE2o\",\"matcherFee\":300000,\"matcherPublicKey\":\"9cpfKN9suPNvfeUNphzxXMjcnn974eme8ZhWUjaktzU5\",\"orderType\":\"sell\",\"price\":1000000,\"proofs\":[\"DCKsiyJu1avWRDe3Zr5Wxt2T1A352T1TosxwUiaQEaTDqYoNC7D9N3fa6fDjGLL3QRbxKnovKchrMCJb6fv1d5y\"],\"senderPublicKey\":\"27YM9icwd6TwfZD3KEJpYsj7rLwPAShJdYXrCt8QRo6L\",\"timestamp\":1580472938469,\"version\":2}" );
 
+    /// test that an order body signed on the worker pool matches and verifies
+    WavesSigner signer;
+    QFuture<QByteArray> signed_body = signer.queueOrderBody( WAVES_COMMAND_POST_ORDER_NEW, acc,
+                                                             acc.createOrderArgs( &pos, CoinAmount::SATOSHI, CoinAmount::SATOSHI, quint64( 1580472938469 ), quint64( 1582978538468 ) ),
+                                                             nullptr );
+    signed_body.waitForFinished();
+
+    const QJsonObject signed_obj = QJsonDocument::fromJson( signed_body.result() ).object();
+    assert( signed_obj.value( "id" ).toString() == "DH2Uyfdoj2pj1t1EEbLPYJMVRcWYqw6kBgQkVZjNiE2o" );
+    assert( acc.verify( order_bytes_v2, QBase58::decode( signed_obj.value( "proofs" ).toArray().at( 0 ).toString().toLatin1() ) ) );
+
     /// test creating get orders bytes
     QByteArray get_orders_bytes = acc.createGetOrdersBytes( qint64( 0 ) );
 
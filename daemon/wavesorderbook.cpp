@@ -0,0 +1,76 @@
+#include "wavesorderbook.h"
+#include "global.h"
+
+void WavesOrderBook::clear()
+{
+    bids.clear();
+    asks.clear();
+    last_update_id = -1;
+}
+
+bool WavesOrderBook::beginUpdate( const qint64 update_id )
+{
+    // the first update is the snapshot, take whatever id it has
+    if ( last_update_id < 0 )
+    {
+        bids.clear();
+        asks.clear();
+        last_update_id = update_id;
+        return true;
+    }
+
+    if ( update_id != last_update_id + 1 )
+    {
+        clear();
+        return false;
+    }
+
+    last_update_id = update_id;
+    return true;
+}
+
+void WavesOrderBook::setLevel( const quint8 side, const Coin &price, const Coin &amount )
+{
+    if ( price.isZeroOrLess() )
+        return;
+
+    QMap<Coin, Coin> &levels = side == SIDE_BUY ? bids : asks;
+
+    if ( amount.isZeroOrLess() )
+        levels.remove( price );
+    else
+        levels.insert( price, amount );
+}
+
+void WavesOrderBook::endUpdate()
+{
+    if ( max_depth < 1 )
+        return;
+
+    // bids are best at the end, asks at the beginning
+    while ( bids.size() > max_depth )
+        bids.erase( bids.begin() );
+
+    while ( asks.size() > max_depth )
+        asks.erase( --asks.end() );
+}
+
+bool WavesOrderBook::getSpread( Spread &spread ) const
+{
+    if ( !isValid() || bids.isEmpty() || asks.isEmpty() )
+        return false;
+
+    const Coin &bid = bids.lastKey();
+    const Coin &ask = asks.firstKey();
+
+    if ( bid >= ask )
+        return false;
+
+    spread = Spread( bid, ask );
+    return true;
+}
+
+qint32 WavesOrderBook::getDepth( const quint8 side ) const
+{
+    return side == SIDE_BUY ? bids.size() : asks.size();
+}
@@ -0,0 +1,39 @@
+#ifndef WAVESORDERBOOK_H
+#define WAVESORDERBOOK_H
+
+#include "coinamount.h"
+#include "misctypes.h"
+
+#include <QMap>
+
+//
+// WavesOrderBook, local copy of the top of a matcher order book kept up to date from the websocket feed
+//
+// the first message after a subscribe is a snapshot, and every message after that carries the next update id and
+// only the levels that changed. a level with a zero amount is removed. a gap in the update ids means we missed a
+// message, so the book is cleared and the caller should resubscribe. levels beyond the subscribed depth are trimmed,
+// the matcher sends levels again when they move back into view.
+//
+class WavesOrderBook
+{
+public:
+    explicit WavesOrderBook( const qint32 _max_depth = 10 ) : max_depth( _max_depth ) {}
+
+    void clear();
+    bool isValid() const { return last_update_id >= 0; }
+    qint64 getLastUpdateId() const { return last_update_id; }
+
+    bool beginUpdate( const qint64 update_id ); // false on a gap, the book is cleared
+    void setLevel( const quint8 side, const Coin &price, const Coin &amount );
+    void endUpdate();
+
+    bool getSpread( Spread &spread ) const; // false if a side is empty or the book is crossed
+    qint32 getDepth( const quint8 side ) const;
+
+private:
+    QMap<Coin, Coin> bids, asks; // price -> amount, both ascending
+    qint64 last_update_id{ -1 };
+    qint32 max_depth{ 10 };
+};
+
+#endif // WAVESORDERBOOK_H
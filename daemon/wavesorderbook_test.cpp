@@ -0,0 +1,87 @@
+#include "wavesorderbook_test.h"
+#include "wavesorderbook.h"
+#include "global.h"
+
+#include <assert.h>
+
+void WavesOrderBookTest::test()
+{
+    WavesOrderBook book( 3 );
+    Spread spread;
+
+    /// test empty book
+    assert( !book.isValid() );
+    assert( !book.getSpread( spread ) );
+
+    /// test snapshot takes any update id
+    assert( book.beginUpdate( 100 ) );
+    book.setLevel( SIDE_BUY, QString( "0.00010000" ), QString( "5" ) );
+    book.setLevel( SIDE_BUY, QString( "0.00011000" ), QString( "2" ) );
+    book.setLevel( SIDE_SELL, QString( "0.00013000" ), QString( "1" ) );
+    book.setLevel( SIDE_SELL, QString( "0.00012000" ), QString( "4" ) );
+    book.endUpdate();
+
+    assert( book.isValid() );
+    assert( book.getSpread( spread ) );
+    assert( spread.bid == QString( "0.00011000" ) );
+    assert( spread.ask == QString( "0.00012000" ) );
+
+    /// test deltas, a zero amount removes the level
+    assert( book.beginUpdate( 101 ) );
+    book.setLevel( SIDE_BUY, QString( "0.00011000" ), QString( "0" ) );
+    book.setLevel( SIDE_SELL, QString( "0.00011500" ), QString( "3" ) );
+    book.endUpdate();
+
+    assert( book.getSpread( spread ) );
+    assert( spread.bid == QString( "0.00010000" ) );
+    assert( spread.ask == QString( "0.00011500" ) );
+
+    /// test removing a level that isn't there
+    assert( book.beginUpdate( 102 ) );
+    book.setLevel( SIDE_SELL, QString( "0.00020000" ), QString( "0" ) );
+    book.endUpdate();
+    assert( book.getDepth( SIDE_SELL ) == 3 );
+
+    /// test trimming to depth keeps the best levels
+    assert( book.beginUpdate( 103 ) );
+    book.setLevel( SIDE_SELL, QString( "0.00011200" ), QString( "1" ) );
+    book.setLevel( SIDE_BUY, QString( "0.00009000" ), QString( "1" ) );
+    book.setLevel( SIDE_BUY, QString( "0.00008000" ), QString( "1" ) );
+    book.setLevel( SIDE_BUY, QString( "0.00007000" ), QString( "1" ) );
+    book.endUpdate();
+
+    assert( book.getDepth( SIDE_SELL ) == 3 );
+    assert( book.getDepth( SIDE_BUY ) == 3 );
+    assert( book.getSpread( spread ) );
+    assert( spread.bid == QString( "0.00010000" ) );
+    assert( spread.ask == QString( "0.00011200" ) );
+
+    // the worst ask was trimmed, removing the others empties the side
+    assert( book.beginUpdate( 104 ) );
+    book.setLevel( SIDE_SELL, QString( "0.00011200" ), QString( "0" ) );
+    book.setLevel( SIDE_SELL, QString( "0.00011500" ), QString( "0" ) );
+    book.setLevel( SIDE_SELL, QString( "0.00012000" ), QString( "0" ) );
+    book.endUpdate();
+    assert( book.getDepth( SIDE_SELL ) == 0 );
+    assert( !book.getSpread( spread ) );
+
+    /// test crossed book has no spread
+    assert( book.beginUpdate( 105 ) );
+    book.setLevel( SIDE_SELL, QString( "0.00009500" ), QString( "1" ) );
+    book.endUpdate();
+    assert( !book.getSpread( spread ) );
+
+    /// test a gap clears the book
+    assert( !book.beginUpdate( 107 ) );
+    assert( !book.isValid() );
+    assert( book.getDepth( SIDE_BUY ) == 0 );
+    assert( book.getDepth( SIDE_SELL ) == 0 );
+
+    // and the next snapshot starts it again
+    assert( book.beginUpdate( 200 ) );
+    book.setLevel( SIDE_BUY, QString( "1" ), QString( "1" ) );
+    book.setLevel( SIDE_SELL, QString( "2" ), QString( "1" ) );
+    book.endUpdate();
+    assert( book.getSpread( spread ) );
+    assert( book.getLastUpdateId() == 200 );
+}
@@ -0,0 +1,9 @@
+#ifndef WAVESORDERBOOK_TEST_H
+#define WAVESORDERBOOK_TEST_H
+
+struct WavesOrderBookTest
+{
+    void test();
+};
+
+#endif // WAVESORDERBOOK_TEST_H
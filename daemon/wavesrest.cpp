@@ -7,6 +7,7 @@
 #include "wavesaccount.h"
 #include "wavesutil.h"
 #include "enginesettings.h"
+#include "jsonreader.h"
 
 #include <QChar>
 #include <QString>
@@ -28,6 +29,36 @@
 #include <QDebug>
 #include <QDateTime>
 
+namespace
+{
+
+static inline bool readOrderBookLevels( JsonReader &reader, QVector<Coin> &levels )
+{
+    // [["price","amount"],...], flattened into price, amount pairs
+    if ( !reader.beginArray() )
+        return false;
+
+    while ( reader.nextElement() )
+    {
+        Coin price, amount;
+
+        if ( !reader.beginArray() ||
+             !reader.nextElement() || !reader.readCoin( price ) ||
+             !reader.nextElement() || !reader.readCoin( amount ) )
+            return false;
+
+        // skip anything after the amount
+        while ( reader.nextElement() )
+            reader.skipValue();
+
+        levels << price << amount;
+    }
+
+    return !reader.hasError();
+}
+
+} // namespace
+
 WavesREST::WavesREST( Engine *_engine, QNetworkAccessManager *_nam )
     : BaseREST( _engine )
 {
@@ -36,14 +67,32 @@ WavesREST::WavesREST( Engine *_engine, QNetworkAccessManager *_nam )
 
     nam = _nam;
     connect( nam, &QNetworkAccessManager::finished, this, &WavesREST::onNamReply );
+
+    signer = new WavesSigner( this );
+    connect( signer, &WavesSigner::bodySigned, this, &WavesREST::onBodySigned );
 }
 
 WavesREST::~WavesREST()
 {
     market_data_timer->stop();
+    wss_timer->stop();
 
     delete market_data_timer;
+    delete wss_timer;
+
     market_data_timer = nullptr;
+    wss_timer = nullptr;
+
+    // dispose of websocket
+    if ( wss )
+    {
+        // disconnect wss so we don't call wssCheckConnection()
+        disconnect( wss, &QWebSocket::disconnected, this, &WavesREST::wssCheckConnection );
+
+        wss->abort();
+        delete wss;
+        wss = nullptr;
+    }
 
     kDebug() << getExchangeFancyStr() << "done.";
 }
@@ -55,9 +104,11 @@ void WavesREST::init()
     // init asset maps
     account.initAssetMaps();
 
-    // we use this to send the requests at a predictable rate
-    connect( send_timer, &QTimer::timeout, this, &WavesREST::sendNamQueue );
-    send_timer->start( WAVES_TIMER_INTERVAL_NAM_SEND ); // minimum threshold 200 or so
+    // send requests as soon as we have tokens, at up to 5 per second
+    BaseREST::send_idle_interval = WAVES_TIMER_INTERVAL_NAM_SEND;
+    initRateLimits( 1000. / WAVES_TIMER_INTERVAL_NAM_SEND, 3. );
+    initSession( QStringList() << WAVES_MATCHER_URL, true );
+    scheduleSend();
 
     // this timer requests market data
     market_data_timer = new QTimer( this );
@@ -68,6 +119,18 @@ void WavesREST::init()
     connect( ticker_timer, &QTimer::timeout, this, &WavesREST::onCheckTicker );
     ticker_timer->start( WAVES_TIMER_INTERVAL_TICKER );
 
+    // create websocket for the order book and account streams
+    wss = new QWebSocket( QString(), QWebSocketProtocol::VersionLatest, this );
+    connect( wss, &QWebSocket::connected, this, &WavesREST::wssConnected );
+    connect( wss, &QWebSocket::disconnected, this, &WavesREST::wssCheckConnection );
+    connect( wss, &QWebSocket::textMessageReceived, this, &WavesREST::wssTextMessageReceived );
+    connect( wss, &QWebSocket::pong, this, &WavesREST::wssPong );
+
+    // check websocket frequently (started after we have market data)
+    wss_timer = new QTimer( this );
+    connect( wss_timer, &QTimer::timeout, this, &WavesREST::wssCheckConnection );
+    wss_timer->setTimerType( Qt::VeryCoarseTimer );
+
 #if !defined( WAVES_TICKER_ONLY )
     account.setPrivateKeyB58( WAVES_SECRET );
 
@@ -113,41 +176,62 @@ void WavesREST::sendNamQueue()
     if ( nam_queue.isEmpty() )
         return;
 
-    // go through requests
-    for ( QQueue<Request*>::const_iterator i = nam_queue.begin(); i != nam_queue.end(); i++ )
+    // coalesce cancels for the same pair into one matcher cancel-all
+    batchQueuedCancels( "oc-" );
+
+    // go through requests in queue order grouped by rate class
+    for ( int i = 0; i < RATE_CLASS_COUNT; i++ )
     {
-        Request *const &request = *i;
+        const RateClass rate_class = RateClass( i );
+        Request *request;
 
-//        // if 2 or more new order commands are in flight, wait for them
-//        if ( request->api_command.startsWith( "on-" ) && isCommandSent( "on-", MAX_NEW_ORDERS_IN_FLIGHT ) )
-//        {
-//            // print something every 2 mins
-//            static qint64 last_print_time = 0;
-//            const qint64 current_time = QDateTime::currentMSecsSinceEpoch();
-//            if ( last_print_time < current_time - 120000 )
-//            {
-//                //kDebug() << "local" << engine->engine_type << "info: too many new orders in flight, waiting.";
-//                last_print_time = current_time;
-//            }
+        while ( ( request = nam_queue.top( rate_class ) ) != nullptr )
+        {
+            // the position is gone, drop it before it costs tokens
+            if ( dropStaleRequest( request ) )
+                continue;
 
-//            continue;
-//        }
+            if ( !takeRateTokens( request ) )
+                break;
 
-        sendNamRequest( request );
-        // the request is added to sent_nam_queue and thus not deleted until the response is met
-        return;
+            sendNamRequest( request );
+            // the request is added to sent_nam_queue and thus not deleted until the response is met
+
+            if ( yieldToFlowControlSent() )
+                return;
+
+            // the request couldn't be sent, try again next time
+            if ( nam_queue.contains( request ) )
+                break;
+        }
     }
 }
 
+RateClass WavesREST::getRateClass( Request *const &request ) const
+{
+    const QString &api_command = request->api_command;
+
+    if ( api_command.startsWith( "oc-" ) || api_command.startsWith( "ob-" ) )
+        return RateCancel;
+    else if ( api_command.startsWith( "on-" ) )
+        return RateOrder;
+    else if ( api_command.startsWith( "os-" ) || api_command.startsWith( "om-" ) || api_command.startsWith( "jt-" ) )
+        return RateQuery;
+
+    return RatePublic;
+}
+
+QString WavesREST::getLatencyLabel( Request *const &request ) const
+{
+    // api commands carry asset ids and order ids, group them by their tag
+    return request->api_command.left( 2 );
+}
+
 void WavesREST::sendNamRequest( Request * const &request )
 {
     // check for valid pos
-    if ( request->pos != nullptr && !engine->getPositionMan()->isValid( request->pos ) )
-    {
-        kDebug() << getExchangeFancyStr() << "local warning: caught nam request with invalid position";
-        nam_queue.removeOne( request );
+    if ( dropStaleRequest( request ) )
         return;
-    }
 
     const qint64 current_time = QDateTime::currentMSecsSinceEpoch();
     QString api_command = request->api_command;
@@ -155,6 +239,7 @@ void WavesREST::sendNamRequest( Request * const &request )
     request_nonce++; // bump nonce for baserest stats
 
     bool is_my_orders_request = false;
+    const bool is_token_request = api_command.startsWith( "jt" );
 
     // set the order request time for new order
     if ( api_command.startsWith( "on" ) )
@@ -180,7 +265,8 @@ void WavesREST::sendNamRequest( Request * const &request )
     else if ( is_post )
         api_command.remove( 0, 5 );
 
-    const QLatin1String &base_url_str = WAVES_MATCHER_URL;
+    // the token comes from the waves.exchange api, everything else goes to the matcher
+    const QLatin1String &base_url_str = is_token_request ? WAVES_API_URL : WAVES_MATCHER_URL;
 
     // create url which will hold 'url'+'query_args'
     QUrl url = QUrl( base_url_str + api_command );
@@ -206,6 +292,11 @@ void WavesREST::sendNamRequest( Request * const &request )
         nam_request.setRawHeader( "Signature", QBase58::encode( signature ) );
         nam_request.setRawHeader( "Timestamp", QString::number( current_time ).toLocal8Bit() );
     }
+    else if ( is_token_request )
+    {
+        // the token endpoint takes a form
+        nam_request.setRawHeader( "Content-Type", "application/x-www-form-urlencoded" );
+    }
     else
     {
         // add http content json header
@@ -217,6 +308,7 @@ void WavesREST::sendNamRequest( Request * const &request )
 
     // set the url
     nam_request.setUrl( url );
+    session->prepareRequest( nam_request );
 
     // send REST message
     QNetworkReply *const &reply = is_get  ? nam->get( nam_request ) :
@@ -229,7 +321,7 @@ void WavesREST::sendNamRequest( Request * const &request )
         return;
     }
 
-    nam_queue_sent.insert( reply, request );
+    trackSentRequest( reply, request );
     nam_queue.removeOne( request );
     last_request_sent_ms = current_time;
 }
@@ -244,8 +336,6 @@ void WavesREST::getOrderStatus( Position * const &pos )
 
 void WavesREST::sendCancel( const QString &order_id, Position * const &pos, const Market &market )
 {
-    const QByteArray body = account.createCancelBody( order_id.toLocal8Bit() );
-
     const QString command = QString( WAVES_COMMAND_POST_ORDER_CANCEL )
                              .arg( account.getAliasByAsset( market.getQuote() ) )
                              .arg( account.getAliasByAsset( market.getBase() ) );
@@ -259,19 +349,43 @@ void WavesREST::sendCancel( const QString &order_id, Position * const &pos, cons
         pos->order_cancel_time = QDateTime::currentMSecsSinceEpoch();
     }
 
-    sendRequest( command, body, pos );
+    // the request is queued when the body is signed
+    signer->queueCancelBody( command, account, order_id.toLocal8Bit(), pos );
 }
 
-void WavesREST::sendCancelNonLocal( const QString &order_id, const QString &amount_asset_alias, const QString &price_asset_alias )
+bool WavesREST::sendBatchCancel( const Market &market, const QVector<Request*> &cancels )
 {
-    const QByteArray body = account.createCancelBody( order_id.toLocal8Bit() );
+    const qint64 current_time = QDateTime::currentMSecsSinceEpoch();
+    const QByteArray body = account.createCancelAllBody( current_time );
+
+    if ( body.isEmpty() )
+        return false;
+
+    const QString command = QString( WAVES_COMMAND_POST_CANCEL_ALL )
+                             .arg( account.getAliasByAsset( market.getQuote() ) )
+                             .arg( account.getAliasByAsset( market.getBase() ) );
+
+    // flag the positions as cancelling, the same way a single cancel would on send
+    for ( QVector<Request*>::const_iterator i = cancels.begin(); i != cancels.end(); i++ )
+    {
+        Position *const &pos = (*i)->pos;
+
+        pos->is_cancelling = true;
+        pos->order_cancel_time = current_time;
+    }
+
+    sendRequest( command, body );
+    return true;
+}
 
+void WavesREST::sendCancelNonLocal( const QString &order_id, const QString &amount_asset_alias, const QString &price_asset_alias )
+{
     const QString command = QString( WAVES_COMMAND_POST_ORDER_CANCEL )
                              .arg( amount_asset_alias )
                              .arg( price_asset_alias );
 
     kDebug() << getExchangeFancyStr() << "local info: sending manual cancel request for order" << order_id;
-    sendRequest( command, body );
+    signer->queueCancelBody( command, account, order_id.toLocal8Bit(), nullptr );
 }
 
 void WavesREST::sendBuySell( Position * const &pos, bool quiet )
@@ -283,8 +397,8 @@ void WavesREST::sendBuySell( Position * const &pos, bool quiet )
 
     MarketInfo &info = engine->getMarketInfo( pos->market );
 
-    // create order body for expiration in 29 days
-    const QByteArray body = account.createOrderBody( pos, info.price_ticksize, info.quantity_ticksize, now, future_29d );
+    // copy the order out of the position for expiration in 29 days, the body is built and signed off the main thread
+    const WavesOrderArgs args = account.createOrderArgs( pos, info.price_ticksize, info.quantity_ticksize, now, future_29d );
 
     // if the order is already set to expire, keep that time, otherwise set to cancel in 28 days
     if ( pos->max_age_epoch == 0 )
@@ -294,8 +408,29 @@ void WavesREST::sendBuySell( Position * const &pos, bool quiet )
         kDebug() << QString( "queued          %1" )
                     .arg( pos->stringifyOrderWithoutOrderID() );
 
-    //kDebug() << "sending new order request:" << body;
-    sendRequest( WAVES_COMMAND_POST_ORDER_NEW, body, pos );
+    signer->queueOrderBody( WAVES_COMMAND_POST_ORDER_NEW, account, args, pos );
+}
+
+void WavesREST::onBodySigned( const QString &api_command, const QByteArray &body, Position *pos, const PositionHandle &pos_handle )
+{
+    // the position could have been removed while we were signing
+    if ( pos != nullptr && !engine->getPositionMan()->isValid( pos_handle ) )
+    {
+        kDebug() << getExchangeFancyStr() << "local info: dropped signed request for a removed position" << api_command;
+        return;
+    }
+
+    // an empty body still goes out for positions so the reply error path cleans them up
+    if ( body.isEmpty() )
+    {
+        kDebug() << getExchangeFancyStr() << "local error: failed to create signed body for" << api_command;
+
+        if ( pos == nullptr )
+            return;
+    }
+
+    //kDebug() << "sending signed request:" << body;
+    sendRequest( api_command, body, pos );
 }
 
 void WavesREST::onNamReply( QNetworkReply * const &reply )
@@ -307,6 +442,10 @@ void WavesREST::onNamReply( QNetworkReply * const &reply )
     const QString path = reply->url().path();
     QByteArray data = reply->readAll();
 
+    Request *const &request = nam_queue_sent.take( reply );
+    const QString &api_command = request->api_command;
+    onReplyReceived( request, data );
+
     // parse any possible json in the body
     QJsonDocument body_json = QJsonDocument::fromJson( data );
     QJsonObject result_obj;
@@ -321,12 +460,6 @@ void WavesREST::onNamReply( QNetworkReply * const &reply )
     else if ( is_object )
         result_obj = body_json.object();
 
-    Request *const &request = nam_queue_sent.take( reply );
-    const QString &api_command = request->api_command;
-    const qint64 response_time = QDateTime::currentMSecsSinceEpoch() - request->time_sent_ms;
-
-    avg_response_time.addResponseTime( response_time );
-
     // print unknown reply
     if ( !is_array && !is_object )
     {
@@ -360,6 +493,11 @@ void WavesREST::onNamReply( QNetworkReply * const &reply )
     {
         parseCancelOrder( result_obj, request );
     }
+    // handle batch cancel response
+    else if ( api_command.startsWith( "ob" ) )
+    {
+        parseCancelAll( result_obj );
+    }
     // handle order new response
     else if ( api_command.startsWith( "on" ) )
     {
@@ -370,6 +508,11 @@ void WavesREST::onNamReply( QNetworkReply * const &reply )
     {
         parseMyOrders( result_arr, request->time_sent_ms );
     }
+    // handle websocket token response
+    else if ( api_command.startsWith( "jt" ) )
+    {
+        parseToken( result_obj );
+    }
     else
     {
         kDebug() << getExchangeFancyStr() << "local warning: unknown nam reply for command:" << api_command << "path:" << path << ":" << data;
@@ -437,6 +580,23 @@ void WavesREST::onCheckBotOrders()
     checkBotOrders();
 }
 
+void WavesREST::checkToken()
+{
+#if !defined( WAVES_TICKER_ONLY )
+    const qint64 current_time = QDateTime::currentMSecsSinceEpoch();
+
+    // keep the token we have until it's about to run out, and don't pile up requests for a new one
+    if ( isKeyOrSecretUnset() ||
+         token_expire_time > current_time + WAVES_TOKEN_RENEW_MARGIN ||
+         token_request_time > current_time - 30000 ||
+         isCommandQueued( WAVES_COMMAND_POST_TOKEN ) )
+        return;
+
+    signer->queueTokenBody( WAVES_COMMAND_POST_TOKEN, account, current_time / 1000 + WAVES_TOKEN_LIFETIME_SECS );
+    token_request_time = current_time;
+#endif
+}
+
 void WavesREST::onCheckCancellingOrders()
 {
     if ( yieldToFlowControlQueue() || yieldToFlowControlSent() )
@@ -451,12 +611,19 @@ void WavesREST::onCheckCancellingOrders()
 
     Position *order_to_check = cancelling_orders_to_query.value( last_cancelling_index_checked );
 
-    // prevent bad access, check if address is still alive
-    if ( engine->getPositionMan()->isValid( order_to_check ) )
-        getOrderStatus( order_to_check );
     // if it's not valid, remove it from the query list
-    else
+    if ( !engine->getPositionMan()->isValid( order_to_check ) )
+    {
         cancelling_orders_to_query.removeAt( last_cancelling_index_checked );
+        return;
+    }
+
+    // while the account stream is up it tells us when the cancel lands, only poll orders it seems to have missed
+    if ( isWssAccountFeedUpToDate() &&
+         order_to_check->order_cancel_time > QDateTime::currentMSecsSinceEpoch() - WAVES_WSS_CANCEL_QUERY_DELAY )
+        return;
+
+    getOrderStatus( order_to_check );
 }
 
 void WavesREST::parseMarketData( const QJsonObject &info )
@@ -530,6 +697,8 @@ void WavesREST::parseMarketData( const QJsonObject &info )
             market_info.price_ticksize = CoinAmount::SATOSHI *100;
         else if ( market == "USDN_USDT" )
             market_info.price_ticksize = CoinAmount::SATOSHI;
+
+        market_info.position_index.setPriceTicksize( market_info.price_ticksize );
     }
 
     // update all tickers initially
@@ -539,6 +708,12 @@ void WavesREST::parseMarketData( const QJsonObject &info )
             checkTicker( true ); // check ticker, ignore flow control = true
 
         initial_ticker_update_done = true;
+
+#if !defined( EXCHANGE_SIM_ENABLED )
+        // now that we have markets, start the websocket
+        wss_timer->start( WAVES_TIMER_INTERVAL_WSS_CHECK );
+        wssCheckConnection();
+#endif
     }
 }
 
@@ -657,15 +832,20 @@ void WavesREST::parseOrderStatus( const QJsonObject &info, Request *const &reque
     MarketInfo &market_info = engine->getMarketInfo( pos->market );
 
     const QString &order_status = info.value( "status" ).toString();
-    Coin filled_quantity = market_info.quantity_ticksize * info.value( "filledAmount" ).toVariant().toULongLong();
+    const Coin filled_quantity = market_info.quantity_ticksize * info.value( "filledAmount" ).toVariant().toULongLong();
     //const Coin filled_fee = CoinAmount::SATOSHI * info.value( "filledFee" ).toVariant().toULongLong();
 
     //kDebug() << "order status" << order_id << ":" << order_status;
 
+    processOrderStatus( pos, order_status, filled_quantity, FILL_GETORDER );
+}
+
+void WavesREST::processOrderStatus( Position *const &pos, const QString &order_status, Coin filled_quantity, const qint8 fill_type )
+{
     // clamp qty to original amount
     if ( filled_quantity > pos->quantity )
     {
-        kDebug() << getExchangeFancyStr() << "local warning: processed filled quantity" << filled_quantity << "greater than position quantity" << pos->quantity << ", clamping to position quantity. ticksize" << market_info.quantity_ticksize << "filled_amount" << info.value( "filledAmount" ).toVariant().toULongLong();
+        kDebug() << getExchangeFancyStr() << "local warning: processed filled quantity" << filled_quantity << "greater than position quantity" << pos->quantity << ", clamping to position quantity";
         filled_quantity = pos->quantity;
     }
 
@@ -676,14 +856,14 @@ void WavesREST::parseOrderStatus( const QJsonObject &info, Request *const &reque
     if ( order_status == "Filled" )
     {
         // do single order fill
-        engine->processFilledOrders( QVector<Position*>() << pos, FILL_GETORDER );
+        engine->processFilledOrders( QVector<Position*>() << pos, fill_type );
     }
     // we cancelled the order out but it got filled or cancelled
     else if ( order_status == "Cancelled" )
     {
         // process partially filled amount
         if ( filled_quantity.isGreaterThanZero() )
-            engine->updateStatsAndPrintFill( "getorder", pos->market, pos->order_number, pos->side, pos->strategy_tag, Coin(), filled_quantity, pos->price, Coin() );
+            engine->updateStatsAndPrintFill( fill_type == FILL_WSS ? "wss" : "getorder", pos->market, pos->order_number, pos->side, pos->strategy_tag, Coin(), filled_quantity, pos->price, Coin() );
 
         engine->processCancelledOrder( pos );
     }
@@ -716,6 +896,47 @@ void WavesREST::parseCancelOrder( const QJsonObject &info, Request *const &reque
         cancelling_orders_to_query += pos;
 }
 
+void WavesREST::parseCancelAll( const QJsonObject &info )
+{
+    if ( info.value( "status" ).toString() != "BatchCancelCompleted" )
+    {
+        kDebug() << getExchangeFancyStr() << "local warning: bad batch cancel reply:" << info;
+        return;
+    }
+
+    // message is an array of arrays of per-order results
+    const QJsonArray &message = info.value( "message" ).toArray();
+    qint32 cancelled_count = 0;
+
+    for ( QJsonArray::const_iterator i = message.begin(); i != message.end(); i++ )
+    {
+        const QJsonArray &results = (*i).toArray();
+
+        for ( QJsonArray::const_iterator j = results.begin(); j != results.end(); j++ )
+        {
+            const QJsonObject &result = (*j).toObject();
+            const QString &status = result.value( "status" ).toString();
+
+            if ( status != "OrderCanceled" &&
+                 status != "OrderCancelRejected" )
+                continue;
+
+            cancelled_count++;
+
+            Position *const &pos = engine->getPositionMan()->getByOrderID( result.value( "orderId" ).toString() );
+
+            if ( pos == nullptr || !engine->getPositionMan()->isActive( pos ) )
+                continue;
+
+            // queue getstatus command, same as a single cancel
+            if ( !cancelling_orders_to_query.contains( pos ) )
+                cancelling_orders_to_query += pos;
+        }
+    }
+
+    kDebug() << getExchangeFancyStr() << "batch cancel finished for" << cancelled_count << "orders";
+}
+
 void WavesREST::parseNewOrder( const QJsonObject &info, Request *const &request )
 {
     // check if we have a position recorded for this request
@@ -829,10 +1050,12 @@ void WavesREST::parseMyOrders( const QJsonArray &orders, qint64 request_time_sen
     // set the timestamp of orderbook update if we saw any orders
     orderbook_update_time = current_time;
     orderbook_update_request_time = request_time_sent_ms;
+    open_orders_request_time = request_time_sent_ms;
 
     // parse array of objects
     QVector<QString> order_numbers; // keep track of order numbers
     QMultiHash<QString, OrderInfo> order_map; // store map of order numbers/orderinfo
+    open_orders_by_market.clear();
 
     for ( QJsonArray::const_iterator i = orders.begin(); i != orders.end(); i++ )
     {
@@ -854,6 +1077,10 @@ void WavesREST::parseMyOrders( const QJsonArray &orders, qint64 request_time_sen
         Market market = Market( account.getAssetByAlias( price_asset ),
                                 account.getAssetByAlias( amount_asset ) );
 
+        // remember every order id for the batch cancel check, even ones we skip below
+        if ( !id.isEmpty() )
+            open_orders_by_market[ market ].insert( id );
+
         // process price/base amounts
         MarketInfo &local_market_info = engine->getMarketInfo( market );
         const Coin price = local_market_info.price_ticksize * price_raw;
@@ -880,3 +1107,378 @@ void WavesREST::parseMyOrders( const QJsonArray &orders, qint64 request_time_sen
 
     engine->processOpenOrders( order_numbers, order_map, request_time_sent_ms );
 }
+
+void WavesREST::parseToken( const QJsonObject &info )
+{
+    const QString new_token = info.value( "access_token" ).toString();
+    qint64 expires_in_secs = info.value( "expires_in" ).toVariant().toLongLong();
+
+    if ( new_token.isEmpty() )
+    {
+        kDebug() << getExchangeFancyStr() << "local warning: failed to get websocket token:" << info;
+        return;
+    }
+
+    if ( expires_in_secs < 1 )
+        expires_in_secs = WAVES_TOKEN_LIFETIME_SECS;
+
+    token = new_token;
+    token_expire_time = QDateTime::currentMSecsSinceEpoch() + expires_in_secs * 1000;
+
+    // subscribe again with the new token, the matcher sends a fresh snapshot
+    wss_account_state = false;
+    wss_account_subscribe_try_time = 0;
+
+    wssSendSubscriptions();
+}
+
+void WavesREST::wssConnected()
+{
+    kDebug() << getExchangeFancyStr() << "(wss) connected";
+
+    wssSendSubscriptions();
+}
+
+void WavesREST::wssSendSubscriptions()
+{
+    if ( wss == nullptr || !wss->isValid() )
+        return;
+
+    const qint64 current_time = QDateTime::currentMSecsSinceEpoch();
+
+#if !defined( WAVES_TICKER_ONLY )
+    // subscribe to the account stream
+    if ( !wss_account_state &&
+         !token.isEmpty() &&
+         wss_account_subscribe_try_time < current_time - 30000 )
+    {
+        const QJsonObject subscribe_account
+        {
+            { "T", "aus" },
+            { "S", QString( account.address() ) },
+            { "t", "jwt" },
+            { "j", token }
+        };
+
+        kDebug() << getExchangeFancyStr() << "(wss) sending account subscribe";
+        wssSendJsonObj( subscribe_account );
+
+        wss_account_subscribe_try_time = current_time;
+    }
+#else
+    Q_UNUSED( current_time )
+#endif
+
+    // subscribe to the order book of any tracked market we haven't subscribed to
+    qint32 new_subscriptions = 0;
+
+    for ( QStringList::const_iterator i = tracked_markets.begin(); i != tracked_markets.end(); i++ )
+    {
+        const Market market = *i;
+        const QString symbol = account.getAliasByAsset( market.getQuote() ) + QChar( '-' ) + account.getAliasByAsset( market.getBase() );
+
+        if ( wss_books.contains( symbol ) )
+            continue;
+
+        wss_books.insert( symbol, WavesOrderBook( WAVES_WSS_ORDERBOOK_DEPTH ) );
+        wss_book_markets.insert( symbol, market );
+
+        const QJsonObject subscribe_book
+        {
+            { "T", "obs" },
+            { "S", symbol },
+            { "d", WAVES_WSS_ORDERBOOK_DEPTH }
+        };
+
+        wssSendJsonObj( subscribe_book );
+        new_subscriptions++;
+    }
+
+    if ( new_subscriptions > 0 )
+        kDebug() << getExchangeFancyStr() << "(wss) sent order book subscribe for" << new_subscriptions << "markets";
+}
+
+void WavesREST::wssSendJsonObj( const QJsonObject &obj )
+{
+    const QJsonDocument doc = QJsonDocument( obj );
+    const QString data_str = doc.toJson( QJsonDocument::Compact );
+
+    //kDebug() << "(wss) sending" << data_str;
+
+    wss->sendTextMessage( data_str );
+}
+
+bool WavesREST::isWssAccountFeedUpToDate() const
+{
+    return wss_account_state &&
+           wss_heartbeat_time > QDateTime::currentMSecsSinceEpoch() - 30000;
+}
+
+bool WavesREST::isWssBookFeedUpToDate() const
+{
+    if ( tracked_markets.isEmpty() ||
+         wss_books.size() < tracked_markets.size() ||
+         wss_heartbeat_time < QDateTime::currentMSecsSinceEpoch() - 30000 )
+        return false;
+
+    // every book needs its snapshot
+    for ( QHash<QString, WavesOrderBook>::const_iterator i = wss_books.begin(); i != wss_books.end(); i++ )
+        if ( !i.value().isValid() )
+            return false;
+
+    return true;
+}
+
+void WavesREST::wssCheckConnection()
+{
+    if ( wss == nullptr || tracked_markets.isEmpty() )
+        return;
+
+    const qint64 current_time = QDateTime::currentMSecsSinceEpoch();
+    const qint64 wss_timeout = 30000;
+
+    checkToken();
+
+    // check for connected, and back off exponentially while the connection keeps failing
+    if ( ( !wss->isValid() ||  // socket is invalid OR
+           wss_heartbeat_time < current_time - wss_timeout ) && // we stopped receiving data
+         wss_connect_try_time < current_time - wss_reconnect_backoff ) // last time we tried to connect is stale
+    {
+        kDebug() << getExchangeFancyStr() << "(wss-reconnect) next retry in" << wss_reconnect_backoff * 2 << "ms";
+
+        // update the time now incase open() is blocking when another disconnected() event fires
+        wss_connect_try_time = current_time;
+        wss_reconnect_backoff = qMin<qint64>( wss_reconnect_backoff * 2, WAVES_WSS_BACKOFF_MAX );
+        wss_account_state = false;
+        wss_account_subscribe_try_time = 0;
+        wss_books.clear();
+        wss_book_markets.clear();
+
+        wss->abort();
+        wss->open( QUrl( WAVES_URL_WSS ) );
+    }
+    else if ( wss->isValid() )
+    {
+        // if we are connected, keep the connection alive and make sure feeds are active
+        wss->ping();
+        wssSendSubscriptions();
+    }
+
+    // the order book stream replaces most of the ticker polling, keep a slow rotation going to catch a bad book
+    const bool wss_book_feed_is_up_to_date = isWssBookFeedUpToDate();
+
+    if ( wss_book_feed_is_up_to_date &&
+         ticker_timer->interval() < WAVES_TIMER_INTERVAL_TICKER * 10 )
+    {
+        ticker_timer->setInterval( WAVES_TIMER_INTERVAL_TICKER * 10 );
+        kDebug() << getExchangeFancyStr() << "(wss) slowed down ticker timer";
+    }
+    else if ( !wss_book_feed_is_up_to_date &&
+              ticker_timer->interval() > WAVES_TIMER_INTERVAL_TICKER )
+    {
+        ticker_timer->setInterval( WAVES_TIMER_INTERVAL_TICKER );
+        kDebug() << getExchangeFancyStr() << "(wss) restored ticker timer";
+    }
+}
+
+void WavesREST::wssPong( quint64 elapsed_time )
+{
+    Q_UNUSED( elapsed_time )
+
+    wss_heartbeat_time = QDateTime::currentMSecsSinceEpoch();
+}
+
+void WavesREST::wssTextMessageReceived( const QString &msg )
+{
+    captureWssFrame( msg );
+
+    const QByteArray msg_utf8 = msg.toUtf8();
+
+    //kDebug() << "wss in:" << msg;
+
+    // order book updates are most of the traffic, try them first without building a document
+    const bool is_order_book = wssParseOrderBook( msg_utf8 );
+
+    if ( is_order_book )
+    {
+        wss_heartbeat_time = QDateTime::currentMSecsSinceEpoch();
+        wss_reconnect_backoff = WAVES_WSS_BACKOFF_MIN;
+        return;
+    }
+
+    const QJsonDocument doc = QJsonDocument::fromJson( msg_utf8 );
+
+    if ( !doc.isObject() )
+        return;
+
+    const QJsonObject obj = doc.object();
+    const QString &type = obj.value( "T" ).toString();
+
+    // any message means the connection is healthy
+    wss_heartbeat_time = QDateTime::currentMSecsSinceEpoch();
+    wss_reconnect_backoff = WAVES_WSS_BACKOFF_MIN;
+
+    // the matcher drops us if we don't echo its pings {"T":"pp","_":1582213340001}
+    if ( type == "pp" )
+    {
+        if ( wss->isValid() )
+            wss->sendTextMessage( msg );
+
+        return;
+    }
+
+    // account update
+    if ( type == "au" )
+    {
+        wssParseAccountUpdate( obj );
+        return;
+    }
+
+    // connection info {"T":"i","_":1582213340001,"i":"<connection id>"}
+    if ( type == "i" )
+        return;
+
+    // error {"T":"e","_":1582213340001,"c":<code>,"m":"<message>"}
+    if ( type == "e" )
+    {
+        kDebug() << getExchangeFancyStr() << "(wss) error:" << msg;
+        return;
+    }
+
+    // print unhandled message
+    kDebug() << getExchangeFancyStr() << "unhandled wss:" << msg;
+}
+
+bool WavesREST::wssParseOrderBook( const QByteArray &msg )
+{
+    // {"T":"ob","_":1582213340001,"U":2,"S":"WAVES-8LQW8f7P5d5PZM7GtZEBgaqRPGSzS3DfPuiXrURJ4AJS","a":[["0.00020000","10.00000000"]],"b":[["0.00010000","0"]]}
+    JsonReader reader( msg );
+    QLatin1String key, type, symbol_view;
+    qint64 update_id = -1;
+    QVector<Coin> ask_levels, bid_levels;
+
+    if ( !reader.beginObject() )
+        return false;
+
+    while ( reader.nextKey( key ) )
+    {
+        // the type comes first, bail out early on anything that isn't an order book update
+        if ( key == QLatin1String( "T" ) )
+        {
+            if ( !reader.readStringView( type ) || type != QLatin1String( "ob" ) )
+                return false;
+        }
+        else if ( type.size() == 0 )
+        {
+            return false;
+        }
+        else if ( key == QLatin1String( "U" ) )
+        {
+            reader.readInt64( update_id );
+        }
+        else if ( key == QLatin1String( "S" ) )
+        {
+            reader.readStringView( symbol_view );
+        }
+        else if ( key == QLatin1String( "a" ) )
+        {
+            if ( !readOrderBookLevels( reader, ask_levels ) )
+                return false;
+        }
+        else if ( key == QLatin1String( "b" ) )
+        {
+            if ( !readOrderBookLevels( reader, bid_levels ) )
+                return false;
+        }
+        else if ( !reader.skipValue() )
+        {
+            return false;
+        }
+    }
+
+    if ( reader.hasError() || type.size() == 0 )
+        return false;
+
+    // the message was an order book update, even if we can't use it
+    const QString symbol = QString( symbol_view );
+
+    if ( update_id < 0 || !wss_books.contains( symbol ) )
+        return true;
+
+    WavesOrderBook &book = wss_books[ symbol ];
+
+    // we missed an update, drop the subscription and pick it up again on the next check
+    if ( !book.beginUpdate( update_id ) )
+    {
+        kDebug() << getExchangeFancyStr() << "(wss) order book gap for" << symbol << ", resubscribing";
+
+        wss_books.remove( symbol );
+        wss_book_markets.remove( symbol );
+
+        const QJsonObject unsubscribe_book
+        {
+            { "T", "u" },
+            { "S", symbol }
+        };
+
+        if ( wss->isValid() )
+            wssSendJsonObj( unsubscribe_book );
+
+        return true;
+    }
+
+    for ( int i = 0; i + 1 < ask_levels.size(); i += 2 )
+        book.setLevel( SIDE_SELL, ask_levels.at( i ), ask_levels.at( i + 1 ) );
+
+    for ( int i = 0; i + 1 < bid_levels.size(); i += 2 )
+        book.setLevel( SIDE_BUY, bid_levels.at( i ), bid_levels.at( i + 1 ) );
+
+    book.endUpdate();
+
+    Spread spread;
+    if ( !book.getSpread( spread ) )
+        return true;
+
+    QMap<QString, Spread> ticker_info;
+    ticker_info.insert( wss_book_markets.value( symbol ), spread );
+    engine->processTicker( this, ticker_info );
+    return true;
+}
+
+void WavesREST::wssParseAccountUpdate( const QJsonObject &obj )
+{
+    // {"T":"au","_":1582213340001,"U":3,"S":"<address>","b":{...},"o":[{"i":"<order id>","s":"FILLED","q":"10.00000000",...}]}
+    wss_account_update_time = QDateTime::currentMSecsSinceEpoch();
+
+    // the first update after subscribing is the snapshot, the stream is live from here
+    if ( !wss_account_state )
+    {
+        wss_account_state = true;
+        kDebug() << getExchangeFancyStr() << "(wss) account feed active";
+    }
+
+    const QJsonArray &orders = obj.value( "o" ).toArray();
+
+    for ( QJsonArray::const_iterator i = orders.begin(); i != orders.end(); i++ )
+    {
+        const QJsonObject &order = (*i).toObject();
+        const QString &status = order.value( "s" ).toString();
+
+        // partial fills are picked up when the order finishes
+        if ( status != "FILLED" && status != "CANCELLED" )
+            continue;
+
+        Position *const &pos = engine->getPositionMan()->getByOrderID( order.value( "i" ).toString() );
+
+        // the order isn't ours, or the new order reply hasn't activated it yet (the open orders snapshot will catch it)
+        if ( pos == nullptr || !engine->getPositionMan()->isActive( pos ) )
+            continue;
+
+        // the quantity is usually quoted, but format a bare number with fixed decimals so it never comes out as "1e-05"
+        const QJsonValue quantity = order.value( "q" );
+        const Coin filled_quantity = quantity.isString() ? quantity.toString() :
+                                                           CoinAmount::toSatoshiFormatExpr( quantity.toDouble() );
+
+        processOrderStatus( pos, status == "FILLED" ? "Filled" : "Cancelled", filled_quantity, FILL_WSS );
+    }
+}
@@ -8,9 +8,14 @@
 #include "keystore.h"
 #include "baserest.h"
 #include "wavesaccount.h"
+#include "wavesorderbook.h"
+#include "wavessigner.h"
+
+#include <QHash>
 
 class QNetworkReply;
 class QTimer;
+class QWebSocket;
 
 class WavesREST : public BaseREST
 {
@@ -29,30 +34,53 @@ public:
     void getOrderStatus( Position *const &pos );
 
     void sendCancel( const QString &order_id, Position *const &pos , const Market &market );
+    bool sendBatchCancel( const Market &market, const QVector<Request*> &cancels ) override;
     void sendCancelNonLocal( const QString &order_id , const QString &amount_asset_alias, const QString &price_asset_alias );
     void sendBuySell( Position *const &pos, bool quiet = true );
 
     void checkTicker( bool ignore_flow_control = false );
     void checkBotOrders( bool ignore_flow_control = false );
+    void checkToken();
+    RateClass getRateClass( Request *const &request ) const override;
+    QString getLatencyLabel( Request *const &request ) const override;
 
 public Q_SLOTS:
-    void sendNamQueue();
-    void onNamReply( QNetworkReply *const &reply );
+    void sendNamQueue() override;
+    void onNamReply( QNetworkReply *const &reply ) override;
 
     void onCheckMarketData();
     void onCheckTicker();
     void onCheckBotOrders();
     void onCheckCancellingOrders();
 
+    void wssConnected();
+    void wssCheckConnection();
+    void wssTextMessageReceived( const QString &msg ) override;
+    void wssSendSubscriptions();
+    void wssPong( quint64 elapsed_time );
+
+    void onBodySigned( const QString &api_command, const QByteArray &body, Position *pos, const PositionHandle &pos_handle );
+
 private:
+    void wssSendJsonObj( const QJsonObject &obj );
+    bool wssParseOrderBook( const QByteArray &msg );
+    void wssParseAccountUpdate( const QJsonObject &obj );
+    bool isWssAccountFeedUpToDate() const;
+    bool isWssBookFeedUpToDate() const;
+
+    void processOrderStatus( Position *const &pos, const QString &order_status, Coin filled_quantity, const qint8 fill_type );
+
     void parseMarketData( const QJsonObject &info );
     void parseMarketStatus( const QJsonObject &info, Request *const &request );
     void parseOrderStatus( const QJsonObject &info, Request *const &request );
     void parseCancelOrder( const QJsonObject &info, Request *const &request );
+    void parseCancelAll( const QJsonObject &info );
     void parseNewOrder( const QJsonObject &info, Request *const &request );
     void parseMyOrders( const QJsonArray &orders, qint64 request_time_sent_ms );
+    void parseToken( const QJsonObject &info );
 
     WavesAccount account;
+    WavesSigner *signer{ nullptr }; // order, cancel, and token bodies are signed off the main thread
 
     QStringList tracked_markets;
 
@@ -62,6 +90,23 @@ private:
     qint32 next_ticker_index_to_query{ 0 };
     qint32 last_cancelling_index_checked{ 0 };
     QTimer *market_data_timer{ nullptr };
+
+    qint64 wss_connect_try_time{ 0 },
+           wss_heartbeat_time{ 0 },
+           wss_account_update_time{ 0 },
+           wss_account_subscribe_try_time{ 0 },
+           wss_reconnect_backoff{ WAVES_WSS_BACKOFF_MIN },
+           token_request_time{ 0 },
+           token_expire_time{ 0 }; // when the matcher websocket token runs out
+
+    bool wss_account_state{ false }; // account subscription got its snapshot
+
+    QString token; // oauth token for the account stream
+    QHash<QString, WavesOrderBook> wss_books; // by "amount-price" alias pair, one per order book subscription
+    QHash<QString, QString> wss_book_markets; // "amount-price" alias pair -> market
+
+    QTimer *wss_timer{ nullptr };
+    QWebSocket *wss{ nullptr };
 };
 
 #endif // WAVESREST_H
@@ -0,0 +1,71 @@
+#include "wavessigner.h"
+#include "position.h"
+#include "global.h"
+
+#include <QtConcurrent/QtConcurrentRun>
+#include <QThread>
+
+WavesSigner::WavesSigner( QObject *parent )
+    : QObject( parent )
+{
+    pool.setMaxThreadCount( qBound( 1, QThread::idealThreadCount(), WAVES_SIGNING_THREADS ) );
+}
+
+WavesSigner::~WavesSigner()
+{
+    waitForDone();
+}
+
+QFuture<QByteArray> WavesSigner::queueOrderBody( const QString &api_command, const WavesAccount &account, const WavesOrderArgs &args, Position *const &pos )
+{
+    QByteArray ( WavesAccount::*create_order_body )( const WavesOrderArgs &, bool ) const = &WavesAccount::createOrderBody;
+
+    return addJob( api_command, QtConcurrent::run( &pool, account, create_order_body, args, true ), pos );
+}
+
+QFuture<QByteArray> WavesSigner::queueCancelBody( const QString &api_command, const WavesAccount &account, const QByteArray &order_id_b58, Position *const &pos )
+{
+    return addJob( api_command, QtConcurrent::run( &pool, account, &WavesAccount::createCancelBody, order_id_b58, true ), pos );
+}
+
+QFuture<QByteArray> WavesSigner::queueTokenBody( const QString &api_command, const WavesAccount &account, const qint64 expiration_secs )
+{
+    return addJob( api_command, QtConcurrent::run( &pool, account, &WavesAccount::createTokenBody, expiration_secs, true ), nullptr );
+}
+
+void WavesSigner::waitForDone()
+{
+    pool.waitForDone();
+}
+
+void WavesSigner::onJobFinished()
+{
+    QFutureWatcher<QByteArray> *watcher = static_cast<QFutureWatcher<QByteArray>*>( sender() );
+
+    if ( !jobs.contains( watcher ) )
+        return;
+
+    const WavesSignJob job = jobs.take( watcher );
+    const QByteArray body = watcher->result();
+    watcher->deleteLater();
+
+    emit bodySigned( job.api_command, body, job.pos, job.pos_handle );
+}
+
+QFuture<QByteArray> WavesSigner::addJob( const QString &api_command, const QFuture<QByteArray> &body, Position *const &pos )
+{
+    WavesSignJob job;
+    job.api_command = api_command;
+    job.pos = pos;
+
+    if ( pos != nullptr )
+        job.pos_handle = pos->handle;
+
+    QFutureWatcher<QByteArray> *watcher = new QFutureWatcher<QByteArray>( this );
+    jobs.insert( watcher, job );
+
+    connect( watcher, &QFutureWatcher<QByteArray>::finished, this, &WavesSigner::onJobFinished );
+    watcher->setFuture( body );
+
+    return body;
+}
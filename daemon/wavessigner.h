@@ -0,0 +1,61 @@
+#ifndef WAVESSIGNER_H
+#define WAVESSIGNER_H
+
+#include "misctypes.h"
+#include "wavesaccount.h"
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QHash>
+#include <QFuture>
+#include <QFutureWatcher>
+#include <QThreadPool>
+
+class Position;
+
+struct WavesSignJob
+{
+    QString api_command;
+    Position *pos{ nullptr };
+    PositionHandle pos_handle; // checked before pos is dereferenced
+};
+
+//
+// WavesSigner, builds and signs waves request bodies on a small worker pool
+//
+// each job runs on a copy of the account, which shares the key material implicitly, so the account can pick up a
+// new matcher key or asset maps without racing the workers. everything a job needs from a position is copied out
+// on the main thread first (see WavesOrderArgs), the workers never touch positions or Coin.
+//
+// queue*() returns the future of the body, and bodySigned() delivers it on the main thread when it's done.
+//
+class WavesSigner : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit WavesSigner( QObject *parent = nullptr );
+    ~WavesSigner();
+
+    QFuture<QByteArray> queueOrderBody( const QString &api_command, const WavesAccount &account, const WavesOrderArgs &args, Position *const &pos );
+    QFuture<QByteArray> queueCancelBody( const QString &api_command, const WavesAccount &account, const QByteArray &order_id_b58, Position *const &pos );
+    QFuture<QByteArray> queueTokenBody( const QString &api_command, const WavesAccount &account, const qint64 expiration_secs );
+
+    int getPendingCount() const { return jobs.size(); }
+    void waitForDone();
+
+signals:
+    void bodySigned( const QString &api_command, const QByteArray &body, Position *pos, const PositionHandle &pos_handle );
+
+private slots:
+    void onJobFinished();
+
+private:
+    QFuture<QByteArray> addJob( const QString &api_command, const QFuture<QByteArray> &body, Position *const &pos );
+
+    QThreadPool pool;
+    QHash<QFutureWatcher<QByteArray>*, WavesSignJob> jobs;
+};
+
+#endif // WAVESSIGNER_H
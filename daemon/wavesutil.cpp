@@ -4,25 +4,147 @@
 
 #include <QByteArray>
 #include <QString>
-#include <QCryptographicHash>
 
-QByteArray WavesUtil::hashBlake2b( const QByteArray &in )
+#include <cstring>
+
+namespace
 {
-    QByteArray blake_out;
-    blake_out.resize( 32 );
 
-    blake2b_state S[1];
+static const int KECCAK_256_RATE = 136; // 1600 bit state minus 2x 256 bit capacity, in bytes
+
+static const quint64 keccak_round_constants[ 24 ] =
+{
+    Q_UINT64_C( 0x0000000000000001 ), Q_UINT64_C( 0x0000000000008082 ), Q_UINT64_C( 0x800000000000808a ),
+    Q_UINT64_C( 0x8000000080008000 ), Q_UINT64_C( 0x000000000000808b ), Q_UINT64_C( 0x0000000080000001 ),
+    Q_UINT64_C( 0x8000000080008081 ), Q_UINT64_C( 0x8000000000008009 ), Q_UINT64_C( 0x000000000000008a ),
+    Q_UINT64_C( 0x0000000000000088 ), Q_UINT64_C( 0x0000000080008009 ), Q_UINT64_C( 0x000000008000000a ),
+    Q_UINT64_C( 0x000000008000808b ), Q_UINT64_C( 0x800000000000008b ), Q_UINT64_C( 0x8000000000008089 ),
+    Q_UINT64_C( 0x8000000000008003 ), Q_UINT64_C( 0x8000000000008002 ), Q_UINT64_C( 0x8000000000000080 ),
+    Q_UINT64_C( 0x000000000000800a ), Q_UINT64_C( 0x800000008000000a ), Q_UINT64_C( 0x8000000080008081 ),
+    Q_UINT64_C( 0x8000000000008080 ), Q_UINT64_C( 0x0000000080000001 ), Q_UINT64_C( 0x8000000080008008 )
+};
+
+static const int keccak_rotations[ 24 ] = { 1, 3, 6, 10, 15, 21, 28, 36, 45, 55, 2, 14, 27, 41, 56, 8, 25, 43, 62, 18, 39, 61, 20, 44 };
+static const int keccak_pi_lanes[ 24 ] = { 10, 7, 11, 17, 18, 3, 5, 16, 8, 21, 24, 4, 15, 23, 19, 13, 12, 2, 20, 14, 22, 9, 6, 1 };
+
+static inline quint64 rotl64( const quint64 x, const int n )
+{
+    return ( x << n ) | ( x >> ( 64 - n ) );
+}
+
+static void keccakF1600( quint64 state[ 25 ] )
+{
+    quint64 c[ 5 ];
+
+    for ( int round = 0; round < 24; round++ )
+    {
+        // theta
+        for ( int i = 0; i < 5; i++ )
+            c[ i ] = state[ i ] ^ state[ i + 5 ] ^ state[ i + 10 ] ^ state[ i + 15 ] ^ state[ i + 20 ];
 
-    blake2b_init( S, 32 );
-    blake2b_update( S, in.data(), in.length() );
-    blake2b_final( S, blake_out.data(), 32 );
+        for ( int i = 0; i < 5; i++ )
+        {
+            const quint64 t = c[ ( i + 4 ) % 5 ] ^ rotl64( c[ ( i + 1 ) % 5 ], 1 );
+
+            for ( int j = 0; j < 25; j += 5 )
+                state[ j + i ] ^= t;
+        }
+
+        // rho and pi
+        quint64 t = state[ 1 ];
+        for ( int i = 0; i < 24; i++ )
+        {
+            const int lane = keccak_pi_lanes[ i ];
+            const quint64 next = state[ lane ];
+            state[ lane ] = rotl64( t, keccak_rotations[ i ] );
+            t = next;
+        }
+
+        // chi
+        for ( int j = 0; j < 25; j += 5 )
+        {
+            for ( int i = 0; i < 5; i++ )
+                c[ i ] = state[ j + i ];
+
+            for ( int i = 0; i < 5; i++ )
+                state[ j + i ] ^= ~c[ ( i + 1 ) % 5 ] & c[ ( i + 2 ) % 5 ];
+        }
+
+        // iota
+        state[ 0 ] ^= keccak_round_constants[ round ];
+    }
+}
+
+static inline void keccakAbsorbBlock( quint64 state[ 25 ], const uchar *block )
+{
+    // lanes are little endian
+    for ( int i = 0; i < KECCAK_256_RATE / 8; i++ )
+    {
+        quint64 lane = 0;
+        for ( int k = 7; k >= 0; k-- )
+            lane = ( lane << 8 ) | block[ i * 8 + k ];
+
+        state[ i ] ^= lane;
+    }
+
+    keccakF1600( state );
+}
+
+} // namespace
+
+QByteArray WavesUtil::hashBlake2b( const QByteArray &in )
+{
+    QByteArray blake_out( HASH_SIZE, Qt::Uninitialized );
+    hashBlake2b( in.constData(), in.size(), reinterpret_cast<uchar*>( blake_out.data() ) );
 
     return blake_out;
 }
 
 QByteArray WavesUtil::hashWaves( const QByteArray &in )
 {
-    return QCryptographicHash::hash( hashBlake2b( in ), QCryptographicHash::Keccak_256 );
+    QByteArray waves_out( HASH_SIZE, Qt::Uninitialized );
+    hashWaves( in.constData(), in.size(), reinterpret_cast<uchar*>( waves_out.data() ) );
+
+    return waves_out;
+}
+
+void WavesUtil::hashBlake2b( const void *in, const int size, uchar *out )
+{
+    blake2b_state S[1];
+
+    blake2b_init( S, HASH_SIZE );
+    blake2b_update( S, in, size );
+    blake2b_final( S, out, HASH_SIZE );
+}
+
+void WavesUtil::hashKeccak256( const void *in, const int size, uchar *out )
+{
+    // original keccak padding (0x01), which is what QCryptographicHash::Keccak_256 does, not sha3
+    quint64 state[ 25 ] = { 0 };
+
+    const uchar *src = static_cast<const uchar*>( in );
+    int remaining = size;
+
+    for ( ; remaining >= KECCAK_256_RATE; remaining -= KECCAK_256_RATE, src += KECCAK_256_RATE )
+        keccakAbsorbBlock( state, src );
+
+    uchar last_block[ KECCAK_256_RATE ] = { 0 };
+    memcpy( last_block, src, remaining );
+    last_block[ remaining ] ^= 0x01;
+    last_block[ KECCAK_256_RATE -1 ] ^= 0x80;
+
+    keccakAbsorbBlock( state, last_block );
+
+    for ( int i = 0; i < HASH_SIZE; i++ )
+        out[ i ] = uchar( state[ i / 8 ] >> ( 8 * ( i % 8 ) ) );
+}
+
+void WavesUtil::hashWaves( const void *in, const int size, uchar *out )
+{
+    uchar blake_out[ HASH_SIZE ];
+
+    hashBlake2b( in, size, blake_out );
+    hashKeccak256( blake_out, HASH_SIZE, out );
 }
 
 void WavesUtil::clampPrivateKey( QByteArray &key )
@@ -8,9 +8,16 @@ namespace WavesUtil
     const uint8_t BUY = 0;
     const uint8_t SELL = 1;
 
+    const int HASH_SIZE = 32;
+
     QByteArray hashBlake2b( const QByteArray &in );
     QByteArray hashWaves( const QByteArray &in );
 
+    // fixed buffer versions, out must hold HASH_SIZE bytes. these don't allocate.
+    void hashBlake2b( const void *in, const int size, uchar *out );
+    void hashKeccak256( const void *in, const int size, uchar *out );
+    void hashWaves( const void *in, const int size, uchar *out );
+
     void clampPrivateKey( QByteArray &key );
 
     QByteArray getAssetBytes( const QString &asset );
@@ -4,6 +4,9 @@
 
 #include <QByteArray>
 #include <QString>
+#include <QCryptographicHash>
+#include <QElapsedTimer>
+#include <QDebug>
 
 void WavesUtilTest::test()
 {
@@ -22,7 +25,58 @@ void WavesUtilTest::test()
     /// test waves hash
     assert( WavesUtil::hashWaves( QByteArray( "A nice, long test to make the day great! :-)" ) ).toHex() == "5df3cf20205d75e09ae46d13a8d99a16174d71c84ffcc00387fec3d81e39dcbe" );
 
+    /// test fixed buffer hashes against QCryptographicHash across keccak block boundaries
+    uchar out[ WavesUtil::HASH_SIZE ];
+    QByteArray payload;
+    for ( int len = 0; len <= 300; len++ )
+    {
+        payload.resize( len );
+        for ( int i = 0; i < len; i++ )
+            payload[ i ] = char( i * 31 + len );
+
+        WavesUtil::hashKeccak256( payload.constData(), payload.size(), out );
+        assert( QByteArray( reinterpret_cast<const char*>( out ), WavesUtil::HASH_SIZE ) == QCryptographicHash::hash( payload, QCryptographicHash::Keccak_256 ) );
+
+        WavesUtil::hashWaves( payload.constData(), payload.size(), out );
+        assert( QByteArray( reinterpret_cast<const char*>( out ), WavesUtil::HASH_SIZE ) == QCryptographicHash::hash( WavesUtil::hashBlake2b( payload ), QCryptographicHash::Keccak_256 ) );
+    }
+
     /// test binary serialization of assets
     assert( WavesUtil::getAssetBytes( "WAVES" ) == QByteArray::fromHex( "00" ) );
     assert( WavesUtil::getAssetBytes( "8LQW8f7P5d5PZM7GtZEBgaqRPGSzS3DfPuiXrURJ4AJS" ) == QByteArray::fromHex( "01" ) + QBase58::decode( "8LQW8f7P5d5PZM7GtZEBgaqRPGSzS3DfPuiXrURJ4AJS" ) );
 }
+
+void WavesUtilTest::benchmark()
+{
+    /// benchmark an order-sized payload, fixed buffers vs the QByteArray and QCryptographicHash path
+    uchar out[ WavesUtil::HASH_SIZE ];
+    QByteArray payload;
+    payload.resize( 172 );
+    for ( int i = 0; i < payload.size(); i++ )
+        payload[ i ] = char( i * 31 );
+
+    const qint32 iterations = 2000;
+    quint32 checksum = 0;
+    QElapsedTimer timer;
+
+    timer.start();
+    for ( qint32 i = 0; i < iterations; i++ )
+    {
+        WavesUtil::hashWaves( payload.constData(), payload.size(), out );
+        checksum += out[ 0 ];
+    }
+    const qint64 fixed_ns = timer.nsecsElapsed();
+
+    timer.restart();
+    for ( qint32 i = 0; i < iterations; i++ )
+        checksum -= uchar( QCryptographicHash::hash( WavesUtil::hashBlake2b( payload ), QCryptographicHash::Keccak_256 ).at( 0 ) );
+    const qint64 qt_ns = timer.nsecsElapsed();
+
+    // the checksum is read here so the loops can't be optimized away
+    if ( checksum != 0 )
+        qDebug() << "local error: fixed buffer and QCryptographicHash waves hashes differ";
+
+    qDebug() << QString( "[WavesUtil] 172 byte waves hash: %1ns, QCryptographicHash %2ns" )
+                .arg( fixed_ns / iterations )
+                .arg( qt_ns / iterations );
+}
@@ -4,6 +4,7 @@
 struct WavesUtilTest
 {
     void test();
+    void benchmark();
 };
 
 #endif // WAVESUTIL_TEST_H
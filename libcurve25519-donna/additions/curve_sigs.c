@@ -38,6 +38,46 @@ int curve25519_sign(unsigned char* signature_out,
    return 0;
 }
 
+void curve25519_derive_ed_pubkey(unsigned char* ed_pubkey_out,
+                                 const unsigned char* curve25519_privkey)
+{
+  ge_p3 ed_pubkey_point; /* Ed25519 pubkey point */
+
+  /* Convert the Curve25519 privkey to an Ed25519 public key */
+  ge_scalarmult_base(&ed_pubkey_point, curve25519_privkey);
+  ge_p3_tobytes(ed_pubkey_out, &ed_pubkey_point);
+}
+
+int curve25519_sign_precomputed(unsigned char* signature_out,
+                                const unsigned char* curve25519_privkey,
+                                const unsigned char* ed_pubkey,
+                                const unsigned char* msg, const unsigned long msg_len,
+                                const unsigned char* random)
+{
+  unsigned char stackbuf[256 + 128]; /* working buffer for messages up to 256 bytes */
+  unsigned char *sigbuf = stackbuf;
+  const unsigned char sign_bit = ed_pubkey[31] & 0x80;
+
+  if (msg_len + 128 > sizeof(stackbuf) && (sigbuf = malloc(msg_len + 128)) == 0) {
+    memset(signature_out, 0, 64);
+    return -1;
+  }
+
+  /* Perform an Ed25519 signature with explicit private key */
+  crypto_sign_modified(sigbuf, msg, msg_len, curve25519_privkey,
+                       ed_pubkey, random);
+  memmove(signature_out, sigbuf, 64);
+
+  /* Encode the sign bit into signature (in unused high bit of S) */
+  signature_out[63] &= 0x7F; /* bit should be zero already, but just in case */
+  signature_out[63] |= sign_bit;
+
+  if (sigbuf != stackbuf)
+    free(sigbuf);
+
+  return 0;
+}
+
 int curve25519_verify(const unsigned char* signature,
                       const unsigned char* curve25519_pubkey,
                       const unsigned char* msg, const unsigned long msg_len)
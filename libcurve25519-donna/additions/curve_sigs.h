@@ -12,6 +12,18 @@ int curve25519_sign(unsigned char* signature_out, /* 64 bytes */
                      const unsigned char* msg, const unsigned long msg_len, /* <= 256 bytes */
                      const unsigned char* random); /* 64 bytes */
 
+/* Derives the Ed25519 public key (with the sign bit) once, for curve25519_sign_precomputed() */
+void curve25519_derive_ed_pubkey(unsigned char* ed_pubkey_out, /* 32 bytes */
+                                 const unsigned char* curve25519_privkey); /* 32 bytes */
+
+/* Same as curve25519_sign() with the Ed25519 public key from curve25519_derive_ed_pubkey(),
+   skips the base point multiplication for the public key. returns 0 on success */
+int curve25519_sign_precomputed(unsigned char* signature_out, /* 64 bytes */
+                                const unsigned char* curve25519_privkey, /* 32 bytes */
+                                const unsigned char* ed_pubkey, /* 32 bytes */
+                                const unsigned char* msg, const unsigned long msg_len, /* <= 256 bytes */
+                                const unsigned char* random); /* 64 bytes */
+
 /* returns 0 on success */
 int curve25519_verify(const unsigned char* signature, /* 64 bytes */
                       const unsigned char* curve25519_pubkey, /* 32 bytes */
@@ -1,48 +1,185 @@
 #include "qbase58.h"
 
-#include "../libbase58/libbase58.h"
-
 #include <QByteArray>
+#include <QVarLengthArray>
 #include <QDebug>
 
+namespace
+{
+
+static const char b58_digits[] = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
+
+static const qint8 b58_digit_map[ 128 ] =
+{
+    -1,-1,-1,-1,-1,-1,-1,-1, -1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1, -1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1, -1,-1,-1,-1,-1,-1,-1,-1,
+    -1, 0, 1, 2, 3, 4, 5, 6,  7, 8,-1,-1,-1,-1,-1,-1,
+    -1, 9,10,11,12,13,14,15, 16,-1,17,18,19,20,21,-1,
+    22,23,24,25,26,27,28,29, 30,31,32,-1,-1,-1,-1,-1,
+    -1,33,34,35,36,37,38,39, 40,41,42,43,-1,44,45,46,
+    47,48,49,50,51,52,53,54, 55,56,57,-1,-1,-1,-1,-1,
+};
+
+// powers of 58 up to 58^5, which is the largest that fits in 30 bits. a limb in base 58^5 shifted by 32 bits
+// plus a carry still fits in 64 bits, so the encoder folds in 4 bytes per pass and the decoder 5 digits.
+static const quint32 b58_pow[ 6 ] = { 1, 58, 3364, 195112, 11316496, 656356768 };
+static const quint32 B58_LIMB_BASE = b58_pow[ 5 ];
+static const int B58_LIMB_DIGITS = 5;
+
+// enough for a 256 byte input without touching the heap
+typedef QVarLengthArray<quint32, 72> B58Limbs;
+
+} // namespace
+
 QByteArray QBase58::encode( const QByteArray &in )
 {
-    QByteArray out;
-    out.resize( in.size() *2 ); // note: surely there is something better than size*2, but it's better than static
-    size_t out_size = out.size();
+    const uchar *src = reinterpret_cast<const uchar*>( in.constData() );
+    const int size = in.size();
 
-    const bool result = b58enc( out.data(), &out_size, in.data(), in.size() );
+    // leading zero bytes map to leading '1's
+    int zeroes = 0;
+    while ( zeroes < size && src[ zeroes ] == 0 )
+        zeroes++;
 
-    if ( !result )
+    // convert to little endian limbs in base 58^5, each byte adds ~1.37 digits
+    B58Limbs limbs;
+    limbs.reserve( ( ( size - zeroes ) * 138 / 100 + 1 ) / B58_LIMB_DIGITS + 1 );
+
+    const int head = ( size - zeroes ) % 4;
+    for ( int pos = zeroes; pos < size; )
     {
-        qDebug() << "local error: base58 encoding failed";
-        return QByteArray();
+        // fold in the odd leading bytes first, then 4 bytes at a time
+        const int take = ( pos == zeroes && head > 0 ) ? head : 4;
+
+        quint64 carry = 0;
+        for ( int k = 0; k < take; k++ )
+            carry = ( carry << 8 ) | src[ pos + k ];
+
+        pos += take;
+
+        const int shift = take * 8;
+        for ( int j = 0; j < limbs.size(); j++ )
+        {
+            const quint64 t = ( quint64( limbs[ j ] ) << shift ) + carry;
+            limbs[ j ] = quint32( t % B58_LIMB_BASE );
+            carry = t / B58_LIMB_BASE;
+        }
+
+        while ( carry > 0 )
+        {
+            limbs.append( quint32( carry % B58_LIMB_BASE ) );
+            carry /= B58_LIMB_BASE;
+        }
     }
 
-    // shrink the buffer to get rid of the trailing bytes and zero byte
-    if ( (size_t) out.size() > out_size )
-        out.resize( out_size -1 ); // -1 for zero byte
+    // count the digits in the top limb to size the output exactly
+    int top_digits = 0;
+    if ( !limbs.isEmpty() )
+        while ( top_digits < B58_LIMB_DIGITS && limbs.last() >= b58_pow[ top_digits ] )
+            top_digits++;
+
+    const int digits = limbs.isEmpty() ? 0 : ( limbs.size() -1 ) * B58_LIMB_DIGITS + top_digits;
+
+    QByteArray out( zeroes + digits, Qt::Uninitialized );
+    char *dst = out.data();
+
+    for ( int i = 0; i < zeroes; i++ )
+        dst[ i ] = '1';
+
+    // write the digits from the end, least significant limb first
+    char *digit = dst + out.size();
+    for ( int j = 0; j < limbs.size(); j++ )
+    {
+        quint32 limb = limbs[ j ];
+        const int limb_digits = ( j == limbs.size() -1 ) ? top_digits : B58_LIMB_DIGITS;
+
+        for ( int k = 0; k < limb_digits; k++ )
+        {
+            *--digit = b58_digits[ limb % 58 ];
+            limb /= 58;
+        }
+    }
 
     return out;
 }
 
 QByteArray QBase58::decode( const QByteArray &in )
 {
-    QByteArray out;
-    out.resize( in.size() *2 );
-    size_t out_size = out.size();
+    const uchar *src = reinterpret_cast<const uchar*>( in.constData() );
+    const int size = in.size();
 
-    const bool result = b58tobin( out.data(), &out_size, in.data(), in.size() );
+    // leading '1's map to leading zero bytes
+    int ones = 0;
+    while ( ones < size && src[ ones ] == '1' )
+        ones++;
 
-    if ( !result )
+    // convert to little endian 32-bit limbs, each digit adds ~5.86 bits
+    B58Limbs limbs;
+    limbs.reserve( ( size - ones ) * 733 / 4000 + 1 );
+
+    const int head = ( size - ones ) % B58_LIMB_DIGITS;
+    for ( int pos = ones; pos < size; )
     {
-        qDebug() << "local error: base58 decoding failed";
-        return QByteArray();
+        // fold in the odd leading digits first, then 5 digits at a time
+        const int take = ( pos == ones && head > 0 ) ? head : B58_LIMB_DIGITS;
+
+        quint64 carry = 0;
+        for ( int k = 0; k < take; k++ )
+        {
+            const uchar c = src[ pos + k ];
+
+            if ( c & 0x80 || b58_digit_map[ c ] < 0 )
+            {
+                qDebug() << "local error: base58 decoding failed";
+                return QByteArray();
+            }
+
+            carry = carry * 58 + quint64( b58_digit_map[ c ] );
+        }
+
+        pos += take;
+
+        const quint64 multiplier = b58_pow[ take ];
+        for ( int j = 0; j < limbs.size(); j++ )
+        {
+            const quint64 t = quint64( limbs[ j ] ) * multiplier + carry;
+            limbs[ j ] = quint32( t );
+            carry = t >> 32;
+        }
+
+        // the carry is below the multiplier here, so it fits in one limb
+        if ( carry > 0 )
+            limbs.append( quint32( carry ) );
     }
 
-    // shrink the buffer to get rid of the preceeding bytes
-    if ( out_size < (size_t) out.size() )
-        out.remove( 0, ( in.size() *2 ) - out_size );
+    // count the bytes in the top limb to size the output exactly
+    int top_bytes = 0;
+    if ( !limbs.isEmpty() )
+        while ( top_bytes < 4 && ( limbs.last() >> ( top_bytes * 8 ) ) > 0 )
+            top_bytes++;
+
+    const int bytes = limbs.isEmpty() ? 0 : ( limbs.size() -1 ) * 4 + top_bytes;
+
+    QByteArray out( ones + bytes, Qt::Uninitialized );
+    uchar *dst = reinterpret_cast<uchar*>( out.data() );
+
+    for ( int i = 0; i < ones; i++ )
+        dst[ i ] = 0;
+
+    // write big endian from the end, least significant limb first
+    uchar *byte = dst + out.size();
+    for ( int j = 0; j < limbs.size(); j++ )
+    {
+        quint32 limb = limbs[ j ];
+        const int limb_bytes = ( j == limbs.size() -1 ) ? top_bytes : 4;
+
+        for ( int k = 0; k < limb_bytes; k++ )
+        {
+            *--byte = uchar( limb );
+            limb >>= 8;
+        }
+    }
 
     return out;
 }
@@ -1,7 +1,44 @@
 #include "qbase58_test.h"
 #include "qbase58.h"
 
+#include "../libbase58/libbase58.h"
+
 #include <QByteArray>
+#include <QString>
+#include <QElapsedTimer>
+#include <QDebug>
+
+namespace
+{
+
+// libbase58 reference, the way QBase58 wrapped it before
+static QByteArray referenceEncode( const QByteArray &in )
+{
+    QByteArray out;
+    out.resize( in.size() *2 +1 );
+    size_t out_size = out.size();
+
+    if ( !b58enc( out.data(), &out_size, in.data(), in.size() ) )
+        return QByteArray();
+
+    out.resize( out_size -1 );
+    return out;
+}
+
+static QByteArray referenceDecode( const QByteArray &in )
+{
+    QByteArray out;
+    out.resize( in.size() *2 );
+    size_t out_size = out.size();
+
+    if ( !b58tobin( out.data(), &out_size, in.data(), in.size() ) )
+        return QByteArray();
+
+    out.remove( 0, out.size() - out_size );
+    return out;
+}
+
+} // namespace
 
 void QBase58Test::test()
 {
@@ -16,4 +53,52 @@ void QBase58Test::test()
     assert( QBase58::encode( QByteArray::fromHex( "0x0000287fb4cd" ) ) == "111233QC4" );
     assert( QBase58::encode( "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa" )
             == "3KkDZnpqFNhbEP9UY6aEka7Y7GeXv5ewVw2aoE3Y3mTG3Rgyu97ZzZwmFyGDc1F4AjwzpVPHqN4pceKnyRTRarHg7K3rP4ny2FvoMcmmR17B1H9Jmr2GQ4AFZAswHjEZDitDq2U2S2jcERKzU3UmbVtfA7Ct3XAExCBoHnNXMPt6t7HsABanmpf6tkfTGzNELUVQ5hPDswWYp5zYnAb45koPVQs2gnrmn925Sgox6Dkb2h6dbK2iBKfeKQsV9umbTLmW8Ddbpfcm657hHB8kCiYCDKFnYFynE38UrWS6qemoqVZhqD1XJyZiWZrp1YquobcAUwh8eZZaCna9Uqz8hktsZD3jnZXEkcLhvqTVQzKTDUsLMtcVTaticcYWR9iYz8wBaAdecXtdjsgREmKfb9mVddt9Uk4VgTwci3xBDV7Qf8TrxAyGouAXadzufsxU6B6U8tSigDoLyhfuNKPe6hRVXNGsRB1JwQrwTZ73GVv7UV74nC71Z4kV7Kv52AgCGjacVPHyaxSa227PH2XxrPFGp27Aq2yH8Y1yddUNUpAFbVkyHhG3wGp74pkayFmRMTZL5UJSFQBCprC99hx3uQs99wa5x67pzv2mbR3rxdMdxSBajwZ5189tpNj4BPHia3j2huwahSobYARcjCu6rg2Q8pLLWYMADHxzvM3dvEPJL49sSZh7HMtKJRphzdsWhf6SSgKrsAEYczmh78adk2ua3z8fhmDu2DFsewc3wUgrNAp8ts8DwQ8N2GTKbkDPJz2GcRupxgwX6Ckb3Q1wCjJiY5ZbQNfLmN3YkudCx3whQFJZzZKBuUHiwwHfmX6pfSmBZyrF8dmvh7XiuXAKxh61bT4u8ctL7eE4eFVsxxHj9ivbGQN5CuyJFNsQJNnDSYeLz62AD38QcE7NaxrXkpuQYhdT63M2BcL8BVbtpPQhenquNTSJNmy3bUhky2qLH9oU5py7rpfwWpggg" );
+
+    // invalid digits fail
+    assert( QBase58::decode( "0OIl" ).isEmpty() );
+    assert( QBase58::encode( QByteArray() ).isEmpty() );
+    assert( QBase58::decode( "111" ) == QByteArray( 3, '\x00' ) );
+
+    /// test against libbase58 with leading zeroes and every length up to 80
+    QByteArray input;
+    for ( int len = 1; len <= 80; len++ )
+    {
+        input.resize( len );
+        for ( int i = 0; i < len; i++ )
+            input[ i ] = i < len % 4 ? '\x00' : char( ( i * 151 + len * 7 ) & 0xff );
+
+        const QByteArray b58 = QBase58::encode( input );
+        assert( b58 == referenceEncode( input ) );
+        assert( QBase58::decode( b58 ) == input );
+        assert( referenceDecode( b58 ) == input );
+    }
+}
+
+void QBase58Test::benchmark()
+{
+    const QByteArray encoded = "CMLwxbMZJMztyTJ6Zkos66cgU7DybfFJfyJtTVpme54t";
+    const QByteArray decoded = QByteArray::fromHex( "a8a6ba2678d1983ad78cfd1aff049367a91c4274b46674ea51d99fc4a3f3c159" );
+
+    /// benchmark a 32 byte key, like asset ids and order ids
+    const qint32 iterations = 2000;
+    qint64 checksum = 0;
+    QElapsedTimer timer;
+
+    timer.start();
+    for ( qint32 i = 0; i < iterations; i++ )
+        checksum += QBase58::decode( encoded ).size() + QBase58::encode( decoded ).size();
+    const qint64 qbase58_ns = timer.nsecsElapsed();
+
+    timer.restart();
+    for ( qint32 i = 0; i < iterations; i++ )
+        checksum -= referenceDecode( encoded ).size() + referenceEncode( decoded ).size();
+    const qint64 libbase58_ns = timer.nsecsElapsed();
+
+    // the checksum is read here so the loops can't be optimized away
+    if ( checksum != 0 )
+        qDebug() << "local error: qbase58 and libbase58 output sizes differ by" << checksum;
+
+    qDebug() << QString( "[QBase58] 32 byte round-trip: %1ns, libbase58 %2ns" )
+                .arg( qbase58_ns / iterations )
+                .arg( libbase58_ns / iterations );
 }
@@ -4,6 +4,7 @@
 struct QBase58Test
 {
     void test();
+    void benchmark();
 };
 
 #endif // QBASE58_TEST_H